@@ -4,12 +4,34 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <elf.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 #define STANDARD_BLOCK_SIZE 500
 
 int DEVELOPER_OPTIONS = 0;
 int WARNINGS = 1;
 int GENERATE_CODE = 0;
+int MMAP_LEXER = 1;
+int STATISTICS = 0;
+int TRACE = 0;
+int DUMP_TRACE = 0;
+int JIT = 0;
+int TIERED = 0;
+int ASSEMBLY = 0;
+int ELF_EXECUTABLE = 0;
+int EMIT_C = 0;
+int OPTIMIZE = 0;
+int REGISTERS = 1;
 
 /*						*
  *	Core Functions and Functionalities	*
@@ -17,22 +39,60 @@ int GENERATE_CODE = 0;
 
 FILE* source;
 
+char* src_map = NULL; // the whole input file mapped in memory (NULL when reading line by line)
+size_t src_size = 0; // the size of the mapped input file
+
 typedef struct Token {
     int code; // code (Atom name)
+    int line; // the input file line
     union {
-	char* text; // used for ID, CT_STRING (dynamically allocated)
+	char* text; // used for ID (interned name), CT_STRING (span in src_map or dynamically allocated)
 	long int i; // used for CT_INT, CT_CHAR
 	double r; // used for CT_REAL
     };
-    int line; // the input file line
-    struct Token* next; // link to the next token
-    struct Token* prev; //link to the previous token
-
+    int len; // length of the span for CT_STRING when lexing from src_map
+    int name_id; // used for ID, the handle of the interned name
 }Token;
 
+/* the tokens are stored one after another in a single growable arena, so the next/previous
+   token is just the neighbour in the array; NULL is returned outside of the list, like the
+   ends of a linked list */
+Token* tokens=NULL; // the arena
+int nr_tokens=0; // the number of tokens in the arena
+int cap_tokens=0; // the capacity of the arena
+
 Token* curr_token=NULL;
 Token* root=NULL;
 
+//the token at a certain distance from the given one (negative for previous tokens)
+static inline Token* Tk_at(Token* tk, int distance)
+{
+    if(tk == NULL)
+	return NULL;
+    long int index = (tk - tokens) + distance;
+    if(index < 0 || index >= nr_tokens)
+	return NULL;
+    return tokens + index;
+}
+
+//the next token
+static inline Token* Tk_next(Token* tk)
+{
+    return Tk_at(tk, 1);
+}
+
+//the previous token
+static inline Token* Tk_prev(Token* tk)
+{
+    return Tk_at(tk, -1);
+}
+
+//the position of a token in the arena
+static inline int Tk_index(Token* tk)
+{
+    return (int)(tk - tokens);
+}
+
 void err(const char *fmt,...)
 {
     va_list va;
@@ -60,23 +120,21 @@ void tkerr(const Token *tk,const char *fmt,...)
 Token *addTk(int code, int line)
 {
     Token *tk;
-    //SAFE ALLOC
-    tk = (Token*)malloc(sizeof(Token));
-    if(tk == NULL)
-	err("not enough memory");
-    tk->code=code;
-    tk->line=line;
-    tk->next=NULL;
-    if(curr_token==NULL)
+    //grow the arena, the tokens are stored one after another
+    if(nr_tokens == cap_tokens)
     {
-	tk->prev=NULL;
-	root = tk;
+	cap_tokens = cap_tokens ? cap_tokens * 2 : 4096;
+	tk = (Token*)realloc(tokens, sizeof(Token) * cap_tokens);
+	if(tk == NULL)
+	    err("not enough memory");
+	tokens = tk;
+	root = tokens;
     }
-    else
-	{
-	    tk->prev=curr_token;
-	    curr_token->next=tk;
-	}
+    tk = &tokens[nr_tokens++];
+    tk->code=code;
+    tk->line=line;
+    tk->len=0;
+    tk->name_id=-1;
     curr_token = tk;
     return tk;
 }
@@ -128,8 +186,12 @@ long long OctalToDecimal(int octal_nr) {
 
 
 /* function to read the next characters in the buffer and in case is not empty to just concatenate the new values */
-char* ReadNext(char* block, char* new_start, int size)
+char* ReadNext(char* block, char* new_start)
 {
+    //the mapped file is already in memory, we just continue after the newline
+    if(src_map != NULL)
+	return new_start;
+
     if(fgets(block, STANDARD_BLOCK_SIZE-1, source)==NULL)
 	return (char*)0;
 
@@ -154,6 +216,168 @@ char* createString(char *start, char *end)
     return str;
 }
 
+/* function to map the whole input file in memory so the lexer can scan it in a single pass
+   the mapping is followed by at least one page of zeroes, so the file is '\0' terminated and
+   the lookahead of the lexer (up to 3 chars) never leaves the mapping */
+char* map_source(const char* file)
+{
+    struct stat st;
+    int fd = open(file, O_RDONLY);
+    if(fd < 0)
+	return NULL;
+    if(fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size == 0)
+    {
+	close(fd);
+	return NULL;
+    }
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t file_pages = ((size_t)st.st_size + page - 1) / page * page;
+
+    //we reserve the zero pages first and then we put the file over them
+    char* map = mmap(NULL, file_pages + page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(map == MAP_FAILED)
+    {
+	close(fd);
+	return NULL;
+    }
+    if(mmap(map, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+	munmap(map, file_pages + page);
+	close(fd);
+	return NULL;
+    }
+    close(fd);
+    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    src_size = (size_t)st.st_size;
+    return map;
+}
+
+//function to release the mapped input file
+void unmap_source()
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    if(src_map != NULL)
+	munmap(src_map, (src_size + page - 1) / page * page + page);
+    src_map = NULL;
+}
+
+/*					*
+ *	Table of interned names		*
+ *					*/
+
+/* every identifier is stored only once in this table and it is referred by its index (handle),
+   so two names are equal only if their handles are equal */
+typedef struct Name{
+    char* text; // the name, '\0' terminated (after close_spans() for spans)
+    int len; // the length of the name
+    unsigned int hash; // the hash of the name
+    int is_span; // the text is a span in src_map which still needs to be terminated
+}Name;
+
+Name* names=NULL; // the names, indexed by handle
+int nr_names=0;
+int cap_names=0;
+int* name_slots=NULL; // open addressing hash table with the handles (-1 = empty)
+int nr_name_slots=0;
+
+//handles of the names used by the compiler itself, interned first in this order by init_names()
+enum PredefinedName { NAME_PUT_S, NAME_GET_S, NAME_PUT_I, NAME_GET_I, NAME_PUT_D, NAME_GET_D, NAME_PUT_C, NAME_GET_C, NAME_SECONDS, NAME_MAIN };
+
+//FNV-1a hash of a name
+unsigned int hash_name(const char* start, int len)
+{
+    unsigned int h = 2166136261u;
+    for(int i=0; i<len; i++)
+    {
+	h ^= (unsigned char)start[i];
+	h *= 16777619u;
+    }
+    return h;
+}
+
+//double the hash table and put back the handles
+void grow_name_slots()
+{
+    int new_size = nr_name_slots ? nr_name_slots * 2 : 4096;
+    int* slots = (int*)malloc(sizeof(int) * new_size);
+    if(slots == NULL)
+	err("not enough memory");
+    memset(slots, -1, sizeof(int) * new_size);
+    for(int i=0; i<nr_names; i++)
+    {
+	unsigned int pos = names[i].hash & (new_size - 1);
+	while(slots[pos] != -1)
+	    pos = (pos + 1) & (new_size - 1);
+	slots[pos] = i;
+    }
+    free(name_slots);
+    name_slots = slots;
+    nr_name_slots = new_size;
+}
+
+/* returns the handle of the name found between start and start+len, adding it if it is new
+   if is_span the text is kept where it is (in src_map), otherwise a copy is made */
+int intern(char* start, int len, int is_span)
+{
+    if(2 * (nr_names + 1) > nr_name_slots)
+	grow_name_slots();
+
+    unsigned int h = hash_name(start, len);
+    unsigned int pos = h & (nr_name_slots - 1);
+    while(name_slots[pos] != -1)
+    {
+	Name* n = &names[name_slots[pos]];
+	if(n->hash == h && n->len == len && memcmp(n->text, start, len) == 0)
+	    return name_slots[pos];
+	pos = (pos + 1) & (nr_name_slots - 1);
+    }
+
+    //new name
+    if(nr_names == cap_names)
+    {
+	cap_names = cap_names ? cap_names * 2 : 1024;
+	names = (Name*)realloc(names, sizeof(Name) * cap_names);
+	if(names == NULL)
+	    err("not enough memory");
+    }
+    Name* n = &names[nr_names];
+    n->text = is_span ? start : createString(start, start + len);
+    n->len = len;
+    n->hash = h;
+    n->is_span = is_span;
+    name_slots[pos] = nr_names;
+    return nr_names++;
+}
+
+//handle of a '\0' terminated name
+int intern_string(char* name)
+{
+    return intern(name, strlen(name), 0);
+}
+
+//the text of a handle
+char* name_text(int name_id)
+{
+    return names[name_id].text;
+}
+
+//the names used by the compiler get the first handles (see PredefinedName)
+void init_names()
+{
+    intern_string("put_s");
+    intern_string("get_s");
+    intern_string("put_i");
+    intern_string("get_i");
+    intern_string("put_d");
+    intern_string("get_d");
+    intern_string("put_c");
+    intern_string("get_c");
+    intern_string("seconds");
+    intern_string("main");
+}
+
 enum Atom {
     ID,		//identifiers
     BREAK, CHAR, DOUBLE, ELSE, FOR, IF, INT, RETURN, STRUCT, VOID, WHILE, END,		//keywords
@@ -163,10 +387,6 @@ enum Atom {
     SPACE, LINECOMMENT, COMMENT	//not important
 }; // tokens codes
 
-#define None COMMENT+1
-#define COMPARE COMMENT+2
-#define DECLARATION COMMENT+3
-
 enum IntType { ZECIMAL, OCTAL, HEXA, REAL };
 
 
@@ -293,7 +513,7 @@ void print_Tokens()
 	    printf(" -> ");
 	else
 	    printf("\n");
-	tk=tk->next;
+	tk=Tk_next(tk);
     }
 }
 
@@ -318,7 +538,7 @@ void print_from_Token(Token *tk)
 	    printf(" -> ");
 	else
 	    printf("\n");
-	tk=tk->next;
+	tk=Tk_next(tk);
     }
 }
 
@@ -330,8 +550,15 @@ void print_from_Token(Token *tk)
 
 int getNextToken()
 {
-    char *block = SafeAlloc(STANDARD_BLOCK_SIZE);
-    fgets(block, STANDARD_BLOCK_SIZE - 1, source);
+    char *block;
+    if(src_map != NULL) // the whole file is the buffer
+	block = src_map;
+    else
+    {
+	block = SafeAlloc(STANDARD_BLOCK_SIZE);
+	if(fgets(block, STANDARD_BLOCK_SIZE - 1, source) == NULL)
+	    block[0] = '\0';
+    }
 
     int state=0,nCh;
     char ch;
@@ -386,7 +613,7 @@ int getNextToken()
 		{
 		    line++;
 		    // we read the next line in a safe way ready to put an END token if needed
-		    pCrtCh=ReadNext(block,pCrtCh+1,STANDARD_BLOCK_SIZE);
+		    pCrtCh=ReadNext(block,pCrtCh+1);
 		    if(pCrtCh==(char *)0)
 		    {
 			    addTk(END,line);
@@ -631,7 +858,10 @@ int getNextToken()
 
 		else{ // if no keyword, then it is an ID
 		    tk = addTk(ID,line);
-		    tk->text=createString(pStartCh,pCrtCh); //using the start we recorded in state=0(pStartCh) and the end in state=1(pCrtCh)
+		    //using the start we recorded in state=0(pStartCh) and the end in state=1(pCrtCh)
+		    //a new name from the mapped file stays there as a span, terminated after the scan
+		    tk->name_id=intern(pStartCh,nCh,src_map != NULL);
+		    tk->text=name_text(tk->name_id);
 		}
 		state=0;
 		break;
@@ -646,7 +876,7 @@ int getNextToken()
 	//assemble CT_INT octal and add the token
 	case 4:
 	    tk = addTk(CT_INT,line);
-	    tk->i = OctalToDecimal(atoi(createString(pStartCh,pCrtCh)));
+	    tk->i = OctalToDecimal(atoi(pStartCh)); // atoi stops at the first non digit
 	    state=0;
 	    break;
 
@@ -671,7 +901,12 @@ int getNextToken()
 	    */
 	    int flag=0,end_of_e_coef=0;
 	    char* string;
-	    string = createString(pStartCh,pCrtCh);
+	    char number[100];
+	    if(pCrtCh-pStartCh >= 100)
+		tkerr(addTk(END,line),"constant too long");
+	    memcpy(number,pStartCh,pCrtCh-pStartCh); // numbers are short, no need to allocate them
+	    number[pCrtCh-pStartCh]='\0';
+	    string = number;
 	    for(int i=0; string[i]!='\0';i++)
 	    {
 		if(string[i]=='.')
@@ -744,12 +979,14 @@ int getNextToken()
 	//assemble CT_INT hex and add the token
 	case 8:
 	    tk = addTk(CT_INT,line);
-	    tk->i = strtol(createString(pStartCh,pCrtCh),NULL,16); //convert and add hex value to token
+	    tk->i = strtol(pStartCh,NULL,16); //convert and add hex value to token (strtol stops after the hex digits)
 	    state = 0;
 	    break;
 
 	//consume char and ready to create CT_STRING
 	case 9:
+	    if(ch==0)
+		tkerr(addTk(END,line),"unterminated string");
 	    if(!(ch=='\"' && *(pCrtCh-1)!='\\'))
 		pCrtCh++;
 	    else
@@ -762,6 +999,13 @@ int getNextToken()
 	//assemble CT_STRING and add the token
 	case 10:
 	    tk = addTk(CT_STRING,line);
+	    if(src_map != NULL) // span in the mapped file, ESC chars are replaced after the scan
+	    {
+		tk->text=pStartCh;
+		tk->len=pCrtCh-1-pStartCh;
+		state=0;
+		break;
+	    }
 	    string = createString(pStartCh,pCrtCh-1);
 	    for(int i=0; string[i]!=0; i++)
 	    {
@@ -777,7 +1021,7 @@ int getNextToken()
 
 	//consume char until newline to ignore single-line comment
 	case 11:
-	    if(ch!='\n')
+	    if(ch!='\n' && ch!=0)
 		pCrtCh++;
 	    else
 		state=0; //we do not eat \n and use it to read more data in the buffer
@@ -787,8 +1031,15 @@ int getNextToken()
 	case 12:
 	    if(!(ch=='/' && *(pCrtCh-1)=='*'))
 	    {
+		if(ch==0)
+		    tkerr(addTk(END,line),"unterminated comment");
 		if(ch=='\n') //since is a multi-line the end will be in another line maybe
-		    pCrtCh=ReadNext(block,pCrtCh+1,STANDARD_BLOCK_SIZE);
+		{
+		    line++;
+		    pCrtCh=ReadNext(block,pCrtCh+1);
+		    if(pCrtCh==(char *)0)
+			tkerr(addTk(END,line),"unterminated comment");
+		}
 		else
 		    pCrtCh++;
 	    }
@@ -804,68 +1055,144 @@ int getNextToken()
     }
 }
 
+/* after the single pass over the mapped file the spans of names and CT_STRING tokens are turned into
+   strings in place: the char after each span was already scanned so we can put the '\0' over it */
+void close_spans()
+{
+    if(src_map == NULL)
+	return;
+    for(int i=0; i<nr_names; i++)
+    {
+	if(names[i].is_span)
+	{
+	    names[i].text[names[i].len]='\0';
+	    names[i].is_span=0;
+	}
+    }
+    for(Token *tk=root; tk!=NULL; tk=Tk_next(tk))
+    {
+	if(tk->code == CT_STRING)
+	{
+	    tk->text[tk->len]='\0';
+	    // identify and switch ESC char with their char values
+	    char *src=tk->text, *dst=tk->text;
+	    while(*src)
+	    {
+		if(*src=='\\' && src[1]!='\0')
+		{
+		    src++;
+		    *dst++=char_to_ESC(*src++);
+		}
+		else
+		    *dst++=*src++;
+	    }
+	    *dst='\0';
+	    tk->len=dst-tk->text;
+	}
+    }
+}
+
 
 
 /*				*
- *	Syntactical Analyzer	*
+ *	Syntax Tree		*
  *				*/
 
-Token* crtTk=NULL;
+enum Class { FUNCTION, VARIABLE, VECTOR, FUNCTION_ARGUMENT, STRUCT_FIELD, STRUCT_FIELD_VECTOR, FUNCTION_ARGUMENT_VECTOR };
+enum Type { _INT, _DOUBLE, _CHAR, _STRUCT, _VOID };
 
-int consume(int code)
+/* the syntactical analyzer builds the tree while it checks the syntax, the nodes are stored in
+   an arena like the tokens and refer to each other (and to the tokens) by index; node 0 is not
+   used, so 0 means "no node" and a parsing function can return the node it built as success */
+enum NodeKind {
+    N_NONE,
+    N_STRUCT, // tk=name, a=fields (N_VAR list)
+    N_FUNC, // tk=name, type=return type, c=name of the returned struct, a=arguments (N_VAR list), b=body (N_BLOCK)
+    N_VAR, // tk=name, type, c=struct name token, d=class (VARIABLE/VECTOR), a=vector size, b=initial value
+    N_BLOCK, // a=instructions
+    N_ASSIGN, // tk=ASSIGN, a=destination, b=value (N_ASSIGN for 'x=y=z')
+    N_RETURN, // tk=RETURN, a=value
+    N_IF, // tk=IF, a=condition, b=if-true branch, c=else branch
+    N_WHILE, // tk=WHILE, a=condition, b=body
+    N_FOR, // tk=FOR, a=initialization, b=condition, c=modification, d=body
+    N_BREAK, // tk=BREAK
+    N_EXPR, // tk=first token, a=root of the expression, b=first node of the expression, c=the token after the last one
+
+    //the nodes of an expression are added in postfix order (the operands before their operator),
+    //so the whole expression is the range of nodes from N_EXPR.b to N_EXPR.a
+    N_CONST, // tk=the constant
+    N_NAME, // tk=the name of a variable
+    N_CALL, // tk=function name, a=arguments (list of roots), b=first node of the arguments, c=number of arguments
+    N_INDEX, // tk=LBRACKET, a=vector, b=index
+    N_FIELD, // tk=name of the field, a=structure
+    N_UNARY, // tk=SUB or NOT, a=operand
+    N_CAST, // tk=the type, type, c=struct name token, a=operand
+    N_BINARY, // tk=the operator, a=left operand, b=right operand
+};
+
+typedef struct Node{
+    int kind; // what the node is (NodeKind)
+    int tk; // the main token of the node (index in the tokens arena)
+    int type; // the declared type (N_VAR, N_FUNC, N_CAST), the type of the value for the nodes of an expression
+    int a, b, c, d; // the children, their meaning depends on the kind
+    int next; // the next node in a list (instructions, arguments, fields)
+}Node;
+
+Node* nodes=NULL; // the arena
+int nr_nodes=0;
+int cap_nodes=0;
+
+int program=0; // the list of the global declarations
+
+Token* crtTk=NULL; // the current token of the analyzers
+
+//adding a node, its children are set by the caller
+int addNode(int kind, Token* tk)
 {
-    if(crtTk->code==code)
+    if(nr_nodes == cap_nodes)
     {
-	crtTk=crtTk->next;
-	return 1;
+	cap_nodes = cap_nodes ? cap_nodes * 2 : 4096;
+	nodes = (Node*)realloc(nodes, sizeof(Node) * cap_nodes);
+	if(nodes == NULL)
+	    err("not enough memory");
+	if(nr_nodes == 0) // node 0 is "no node"
+	{
+	    memset(&nodes[0], 0, sizeof(Node));
+	    nr_nodes = 1;
+	}
     }
-    return 0;
+    Node *n = &nodes[nr_nodes];
+    memset(n, 0, sizeof(Node));
+    n->kind = kind;
+    n->tk = Tk_index(tk);
+    return nr_nodes++;
 }
 
-//consume ordinary mathematical operators
-int consume_operator()
+//the last node of a list
+int last_node(int n)
 {
-    if(crtTk->code == ADD || crtTk->code == SUB || crtTk->code == MUL || crtTk->code == DIV)
-    {
-	crtTk=crtTk->next;
-	return 1;
-    }
-    return 0;
+    while(nodes[n].next != 0)
+	n = nodes[n].next;
+    return n;
 }
 
-int simple_expr();
-int typecast();
-
-//simple conditions ex: 'i==0' or 'x>=i' or '!i' or 'i' or '-i'
-int simple_cond()
+//the token of a node
+Token* node_tk(int n)
 {
-    Token *startTk=crtTk;
-
-    if(simple_expr(COMPARE,None)){
-	if(consume(EQUAL) || consume(NOTEQ) || consume(LESS) || consume(LESSEQ) || consume(GREATER) || consume(GREATEREQ)){
-	    if(simple_expr(COMPARE,None)){
-		return 1;
-	    }else tkerr(crtTk,"Missing variable or constant in the condition after the equal");
-	}
-	return 1;
-    }else tkerr(crtTk,"Missing variable in the condition");
-    crtTk=startTk;
-    return 0;
+    return &tokens[nodes[n].tk];
 }
 
-//multiple simple conditions
-int cond()
+/*				*
+ *	Syntactical Analyzer	*
+ *				*/
+
+int consume(int code)
 {
-    Token *startTk=crtTk;
-    if(simple_cond()){
-	while(consume(AND) || consume(OR)) //if there is another simple condition
-	{
-	    if(!simple_cond())
-		return 0;
-	}
+    if(crtTk->code==code)
+    {
+	crtTk=Tk_next(crtTk);
 	return 1;
-    }else tkerr(crtTk,"Missing condition");
-    crtTk=startTk;
+    }
     return 0;
 }
 
@@ -873,7 +1200,7 @@ int cond()
 int struct_type()
 {
     Token *startTk=crtTk;
-    if(crtTk->code == STRUCT && crtTk->next->code == ID)
+    if(crtTk->code == STRUCT && Tk_next(crtTk)->code == ID)
     {
 	consume(STRUCT);
 	consume(ID);
@@ -895,479 +1222,445 @@ int type()
     return 0;
 }
 
-//typecast helper function
-int typecast()
+//verify the return type of the function
+int return_type()
 {
     Token *startTk=crtTk;
-    if(consume(LPAR))
+    if(consume(INT) || consume(DOUBLE) || consume(CHAR) || consume(VOID) || struct_type())
     {
-	if(type()){
-	    if(consume(RPAR))
-		return 1;
-	    else
-		tkerr(crtTk,"Error in typecast");
-	}
-    }
+	return 1;
+    }else tkerr(crtTk,"Missing or invalid type");
     crtTk=startTk;
     return 0;
 }
 
-//helper function to check if we have a vector
-int checkif_vector()
+//the type of a declaration from its type token(s), for structures also the token with the name
+int decl_type(Token* type_tk, int *struct_tk)
 {
-    Token *startTk=crtTk;
-    if(crtTk->code == ID)
+    *struct_tk = 0;
+    switch(type_tk->code)
     {
-	if(crtTk->next->code == LBRACKET){
-		    return 1;
-	}
+	case INT: return _INT;
+	case DOUBLE: return _DOUBLE;
+	case CHAR: return _CHAR;
+	case VOID: return _VOID;
+	default: // 'struct name'
+	    *struct_tk = Tk_index(Tk_next(type_tk));
+	    return _STRUCT;
     }
-    crtTk=startTk;
-    return 0;
 }
 
+/* expressions are parsed in a single pass by precedence climbing: the operators wait on a stack
+   until an operator with a lower precedence (or the end of the expression) comes, then they take
+   their operands from the stack of values; the parenthesys, the calls and the indexes are marks
+   on the stack of operators, so there is no recursion and no going back in the tokens */
 
-//helper function to consume a vector element
-int consume_vector_el()
+//the precedence of a binary operator, 0 if the token is not one
+int binary_precedence(int code)
 {
-    Token *startTk=crtTk;
-    if(consume(ID))
+    switch(code)
     {
-	if(consume(LBRACKET)){
-	    if(simple_expr(RBRACKET,None)){
-		if(consume(RBRACKET)){
-		    return 1;
-		}else tkerr(crtTk,"Missing ] after vector index");
-	    }else tkerr(crtTk,"Missing vector index");
-	}
+	case OR: return 1;
+	case AND: return 2;
+	case EQUAL: case NOTEQ: return 3;
+	case LESS: case LESSEQ: case GREATER: case GREATEREQ: return 4;
+	case ADD: case SUB: return 5;
+	case MUL: case DIV: return 6;
+	default: return 0;
     }
-    crtTk=startTk;
-    return 0;
 }
 
-//verify the return type of the function
-int return_type()
+#define PREFIX_PRECEDENCE 7 // unary SUB, NOT and casts
+
+//what waits on the stack of operators
+enum PendingKind { P_BINARY, P_UNARY, P_CAST, P_PAR, P_CALL, P_INDEX };
+
+typedef struct Pending{
+    int kind; // PendingKind
+    Token* tk; // the operator, the type of a cast, the name of a call or the LBRACKET
+    int precedence; // for the operators
+    int type, struct_tk; // for the casts
+    int first; // for the calls: the first node of the arguments
+    int nr_args; // for the calls: the arguments already parsed
+}Pending;
+
+Pending* pending=NULL; // the stack of operators
+int nr_pending=0;
+int cap_pending=0;
+int* values=NULL; // the stack of values (nodes)
+int nr_values=0;
+int cap_values=0;
+
+void push_pending(int kind, Token* tk, int precedence)
 {
-    Token *startTk=crtTk;
-    if(consume(INT) || consume(DOUBLE) || consume(CHAR) || consume(VOID) || struct_type())
+    if(nr_pending == cap_pending)
     {
-	return 1;
-    }else tkerr(crtTk,"Missing or invalid type");
-    crtTk=startTk;
-    return 0;
-}
-
-//simple declaration of a variable EX: 'int x' or 'int *x' or 'int x[]' or 'int x[20]'
-int simple_decl(){
-    Token *startTk=crtTk;
-    if(type()){
-	if(consume(MUL)){ //we have a pointer
-	    if(consume(ID)){
-		return 1;
-	    }else tkerr(crtTk,"Invalid pointer name after *");
-	}
-	if(crtTk->code == ID){ //we have an ID which could be a vector or a simple variable
-	    if(checkif_vector()){
-		if(crtTk->next->code==LBRACKET){
-		    if(crtTk->next->next->code==RBRACKET){ //'v[]'
-			crtTk=crtTk->next->next->next;
-			return 1;
-		    }
-		    else 
-		    {
-		    if(consume_vector_el()) //'v[simple_expr]'
-		    	return 1;
-		    else tkerr(crtTk,"Error in vector declaration");
-		    }
-		}
-	    }
-	    else
-	    {
-		consume(ID); //simple variable
-		return 1;
-	    }
-	}else tkerr(crtTk,"Missing variable");
-    }else tkerr(crtTk,"Missing variable type");
-    crtTk=startTk;
-    return 0;
+	cap_pending = cap_pending ? cap_pending * 2 : 64;
+	pending = (Pending*)realloc(pending, sizeof(Pending) * cap_pending);
+	if(pending == NULL)
+	    err("not enough memory");
+    }
+    Pending *p = &pending[nr_pending++];
+    memset(p, 0, sizeof(Pending));
+    p->kind = kind;
+    p->tk = tk;
+    p->precedence = precedence;
 }
 
-//single argument for a function call
-int arg_fcall()
+void push_value(int n)
 {
-    Token *startTk=crtTk;
-    if(simple_expr(RPAR,COMMA)){
-	return 1;
-    }else tkerr(crtTk,"Error in argument");
-    crtTk=startTk;
-    return 0;
+    if(nr_values == cap_values)
+    {
+	cap_values = cap_values ? cap_values * 2 : 64;
+	values = (int*)realloc(values, sizeof(int) * cap_values);
+	if(values == NULL)
+	    err("not enough memory");
+    }
+    values[nr_values++] = n;
 }
 
-//list of arguments for a function call
-int arg_list_fcall()
+//the operator on top of the stack takes its operands and becomes a node
+void reduce()
 {
-    Token *startTk=crtTk;
-    if(crtTk->code == RPAR){
-	return 1;
+    Pending *p = &pending[--nr_pending];
+    int n;
+    switch(p->kind)
+    {
+	case P_BINARY:
+	    n = addNode(N_BINARY, p->tk);
+	    nodes[n].b = values[--nr_values];
+	    nodes[n].a = values[--nr_values];
+	    break;
+	case P_UNARY:
+	    n = addNode(N_UNARY, p->tk);
+	    nodes[n].a = values[--nr_values];
+	    break;
+	default: // P_CAST
+	    n = addNode(N_CAST, p->tk);
+	    nodes[n].type = p->type;
+	    nodes[n].c = p->struct_tk;
+	    nodes[n].a = values[--nr_values];
+	    break;
     }
-    if(arg_fcall()){
-	while(consume(COMMA)){
-	    if(!arg_fcall())
-		tkerr(crtTk,"Missing argument");
-	}
-	if(crtTk->code==RPAR)
-	    return 1;
-    }else tkerr(crtTk,"Missing argument");
-    crtTk=startTk;
-    return 0;
+    push_value(n);
 }
 
-//used to identify function calls
-int function_call()
+//reduce the operators with a precedence at least the given one, down to the first mark
+void reduce_operators(int precedence)
 {
-    Token *startTk=crtTk;
-    if(consume(ID)){
-	if(consume(LPAR)){
-	    if(arg_list_fcall()){
-		if(consume(RPAR)){
-		    return 1;
-		}else tkerr(crtTk,"Missing ) after arguments list");
-	    }else tkerr(crtTk,"Argument list error");
-	}else tkerr(crtTk,"Missing ( after func");
-    }else tkerr(crtTk,"Missing function name");
-    crtTk=startTk;
-    return 0;
+    while(nr_pending > 0 && pending[nr_pending-1].kind <= P_CAST && pending[nr_pending-1].precedence >= precedence)
+	reduce();
 }
 
-//function to verify that the parenthesys respect the syntax and logic
-int parenthesys_analyzer(int just_return)
+//the innermost open mark (parenthesys, call, index), -1 if there is none
+int open_mark()
 {
-    static int open_PAR=0;
-    if(crtTk->prev->code == ID && crtTk->code == LPAR) // to not count function opening parenthesys
-	return open_PAR;
+    return nr_pending > 0 ? nr_pending-1 : -1;
+}
 
-    //count just the closing parenthesys which do not close also IF or WHILE
-    while(crtTk->code==RPAR && !just_return && !(crtTk->next->code==LACC) && !(crtTk->next->code==ID))
+//the call on top of the stack takes its arguments
+void close_call()
+{
+    Pending *p = &pending[--nr_pending];
+    int n = addNode(N_CALL, p->tk);
+    nodes[n].b = p->first;
+    nodes[n].c = p->nr_args;
+    //the arguments are the last values, linked in order
+    nr_values -= p->nr_args;
+    for(int i = p->nr_args-1; i >= 0; i--)
     {
-	consume(RPAR);
-	open_PAR++;
+	nodes[values[nr_values+i]].next = nodes[n].a;
+	nodes[n].a = values[nr_values+i];
     }
-
-    //count the opening parenthesys
-    while(consume(LPAR) && !just_return)
-	open_PAR--;
-    return open_PAR;
+    push_value(n);
 }
 
-
-//expression for multiple simple mathematical operations EX: 'i+2' or 'x+3+7' or 'z/4+f' or '="this is a string";' or 'function(x,'y',"z",...)'
-int simple_expr(int stop_code1, int stop_code2)
+//a whole expression EX: 'i+2' or '(x+3)*7' or '-v[i].x/f(a,b)' or 'x>=0 && !y', ends at the first token which cannot continue it
+int expression()
 {
     Token *startTk=crtTk;
+    int first=nr_nodes;
+    int expect_operand=1;
+    nr_pending=0;
+    nr_values=0;
 
-    //unary ops
-    consume(NOT);
-    consume(SUB);
-
-    if(typecast())
-    {
-	consume(NOT);
-	consume(SUB);
-    }
-
-    if(crtTk->code==CT_STRING) //string attribution
+    while(1)
     {
-	consume(CT_STRING);
-	return 1;
-    }
-
-    parenthesys_analyzer(0);
-
-    if(consume_vector_el() || consume(ID)||consume(CT_INT)||consume(CT_REAL)||consume(CT_CHAR)){ //non-string attribution
-	if(consume_operator() || crtTk->code == SEMICOLON || crtTk->code == DOT || crtTk->code == LPAR){
-
-	    if(consume(DOT)){ //struct variable
-		if(!consume(ID))
-		    tkerr(crtTk,"Missing field in struct");
-		if(consume_operator())
-		    simple_expr(stop_code1, stop_code2);
+	if(expect_operand)
+	{
+	    if(crtTk->code == SUB || crtTk->code == NOT) //unary ops
+	    {
+		push_pending(P_UNARY, crtTk, PREFIX_PRECEDENCE);
+		consume(crtTk->code);
 	    }
-
-	    if(crtTk->prev->code == ID && crtTk->code == LPAR) //function call
+	    else if(crtTk->code == LPAR && (Tk_next(crtTk)->code == INT || Tk_next(crtTk)->code == DOUBLE || Tk_next(crtTk)->code == CHAR || Tk_next(crtTk)->code == STRUCT)) //typecast
 	    {
-		crtTk=crtTk->prev;
-		if(!function_call())
-		    tkerr(crtTk,"Error in function call");
-		if(consume_operator())
-		{
-		    if(simple_expr(stop_code1, stop_code2))
-			return 1;
-		}
+		consume(LPAR);
+		Token *type_tk=crtTk;
+		type();
+		if(!consume(RPAR))
+		    tkerr(crtTk,"Error in typecast");
+		push_pending(P_CAST, type_tk, PREFIX_PRECEDENCE);
+		pending[nr_pending-1].type = decl_type(type_tk, &pending[nr_pending-1].struct_tk);
 	    }
-
-	    //count parenthesys but taking into account the closing parenthesys if is stopword
-	   if(!(stop_code1 == RPAR && (crtTk->code == stop_code1 || crtTk->code == stop_code2)))
-		parenthesys_analyzer(0);
-
-	    if(stop_code1 == DECLARATION)
+	    else if(consume(LPAR))
+		push_pending(P_PAR, Tk_prev(crtTk), 0);
+	    else if(crtTk->code == ID && Tk_next(crtTk)->code == LPAR) //function call
 	    {
-		if(crtTk->code == COMMA || crtTk->code == SEMICOLON || crtTk->code == ASSIGN)
+		push_pending(P_CALL, crtTk, 0);
+		pending[nr_pending-1].first = nr_nodes;
+		consume(ID);
+		consume(LPAR);
+		if(consume(RPAR)) // 'f()'
 		{
-		    // not to have 'x+>'
-		    crtTk=crtTk->prev;
-		    if(consume_operator())
-			tkerr(crtTk,"Invalid operator here");
-		    crtTk=crtTk->next;
-		    return 1;
+		    close_call();
+		    expect_operand=0;
 		}
 	    }
-
-	    if(stop_code1 == COMPARE)
+	    else if(crtTk->code == ID)
 	    {
-		if(crtTk->code == EQUAL || crtTk->code == NOTEQ || crtTk->code == LESS || crtTk->code == LESSEQ || crtTk->code == GREATER || crtTk->code == GREATEREQ || crtTk->code == AND || crtTk->code == OR || crtTk->code == SEMICOLON || crtTk->code == RPAR)
-		{
-		    // not to have 'x+>'
-		    crtTk=crtTk->prev;
-		    if(consume_operator())
-			tkerr(crtTk,"Invalid operator here");
-		    crtTk=crtTk->next;
-		    return 1;
-		}
+		push_value(addNode(N_NAME, crtTk));
+		consume(ID);
+		expect_operand=0;
 	    }
-
-	    if(crtTk->code == stop_code1 || crtTk->code == stop_code2) //end of simple expression
+	    else if(crtTk->code == CT_INT || crtTk->code == CT_REAL || crtTk->code == CT_CHAR || crtTk->code == CT_STRING)
 	    {
-		// not to have 'x+;'
-		crtTk=crtTk->prev;
-		if(consume_operator())
-		    tkerr(crtTk,"Invalid operator here");
-		crtTk=crtTk->next;
-		return 1;
+		push_value(addNode(N_CONST, crtTk));
+		consume(crtTk->code);
+		expect_operand=0;
 	    }
+	    else tkerr(crtTk,"Missing variable/value");
+	    continue;
+	}
 
-	    if(simple_expr(stop_code1,stop_code2)) //another simple expression
+	int precedence = binary_precedence(crtTk->code);
+	if(precedence) //binary operator
+	{
+	    reduce_operators(precedence);
+	    push_pending(P_BINARY, crtTk, precedence);
+	    consume(crtTk->code);
+	    expect_operand=1;
+	}
+	else if(crtTk->code == LBRACKET) //index of a vector
+	{
+	    push_pending(P_INDEX, crtTk, 0);
+	    consume(LBRACKET);
+	    expect_operand=1;
+	}
+	else if(crtTk->code == DOT) //field of a structure
+	{
+	    consume(DOT);
+	    if(crtTk->code != ID)
+		tkerr(crtTk,"Missing field in struct");
+	    int n = addNode(N_FIELD, crtTk);
+	    nodes[n].a = values[--nr_values];
+	    push_value(n);
+	    consume(ID);
+	}
+	else if(crtTk->code == RPAR || crtTk->code == COMMA || crtTk->code == RBRACKET)
+	{
+	    reduce_operators(0);
+	    int mark = open_mark();
+	    if(mark < 0) // it belongs to the instruction, end of the expression
+		break;
+	    if(crtTk->code == RPAR && pending[mark].kind == P_PAR)
+		nr_pending--;
+	    else if(crtTk->code == RPAR && pending[mark].kind == P_CALL)
 	    {
-		return 1;
-	    }else tkerr(crtTk,"Missing expression");
-
-	}else{
-
-	//same as up here
-
-	   if(!(stop_code1 == RPAR && (crtTk->code == stop_code1 || crtTk->code == stop_code2)))
-		parenthesys_analyzer(0);
-
-	    if(stop_code1 == DECLARATION)
+		pending[mark].nr_args++;
+		close_call();
+	    }
+	    else if(crtTk->code == COMMA && pending[mark].kind == P_CALL)
 	    {
-	    
-		if(crtTk->code == COMMA || crtTk->code == SEMICOLON || crtTk->code == ASSIGN)
-		{
-		    return 1;
-		}
+		pending[mark].nr_args++;
+		expect_operand=1;
 	    }
-
-	    if(stop_code1 == COMPARE)
+	    else if(crtTk->code == RBRACKET && pending[mark].kind == P_INDEX)
 	    {
-		if(crtTk->code == EQUAL || crtTk->code == NOTEQ || crtTk->code == LESS || crtTk->code == LESSEQ || crtTk->code == GREATER || crtTk->code == GREATEREQ || crtTk->code == AND || crtTk->code == OR || crtTk->code == SEMICOLON || crtTk->code == RPAR) //end of simple expression
-		{
-		    return 1;
-		}
+		int n = addNode(N_INDEX, pending[mark].tk);
+		nodes[n].b = values[--nr_values];
+		nodes[n].a = values[--nr_values];
+		push_value(n);
+		nr_pending--;
 	    }
+	    else tkerr(crtTk,"Parenthesys closed or open incorrectly");
+	    consume(crtTk->code);
+	}
+	else
+	    break; //end of the expression
+    }
 
-	    if(crtTk->code == stop_code1 || crtTk->code == stop_code2)
-	    {
-		return 1;
-	    }else tkerr(crtTk,"Invalid operator");
+    reduce_operators(0);
+    if(nr_pending != 0)
+	tkerr(crtTk,pending[nr_pending-1].kind == P_INDEX ? "Missing ] after vector index" : "Missing ) in expression");
+
+    int n = addNode(N_EXPR, startTk);
+    nodes[n].a = values[0];
+    nodes[n].b = first;
+    nodes[n].c = Tk_index(crtTk);
+    return n;
+}
 
+//the variable 'x' or 'x[size]' or 'x[]' or '*x' of a declaration with the given type
+int decl_variable(int its_type, int struct_tk)
+{
+    int n=0;
+    if(consume(MUL)){ //we have a pointer
+	if(crtTk->code == ID){
+	    n = addNode(N_VAR, crtTk);
+	    nodes[n].d = VARIABLE;
+	    consume(ID);
+	}else tkerr(crtTk,"Invalid pointer name after *");
+    }
+    else if(crtTk->code == ID){ //we have an ID which could be a vector or a simple variable
+	n = addNode(N_VAR, crtTk);
+	consume(ID);
+	nodes[n].d = VARIABLE;
+	if(consume(LBRACKET)){
+	    nodes[n].d = VECTOR;
+	    if(!consume(RBRACKET)) //'v[expression]', 'v[]' has no size
+	    {
+		int size = expression();
+		nodes[n].a = size;
+		if(!consume(RBRACKET))
+		    tkerr(crtTk,"Missing ] after vector index");
+	    }
 	}
-    }else tkerr(crtTk,"Missing variable/value");
+    }else tkerr(crtTk,"Missing variable");
+    nodes[n].type = its_type;
+    nodes[n].c = struct_tk;
+    return n;
+}
 
+//simple declaration of a variable EX: 'int x' or 'int *x' or 'int x[]' or 'int x[20]'
+int simple_decl(){
+    Token *startTk=crtTk;
+    if(type()){
+	int struct_tk;
+	int its_type = decl_type(startTk, &struct_tk);
+	int n = decl_variable(its_type, struct_tk);
+	if(n)
+	    return n;
+    }else tkerr(crtTk,"Missing variable type");
     crtTk=startTk;
     return 0;
 }
 
-//function to consume a line of variables declaration
+//function to consume a line of variables declaration, returns the list of variables
 int var_decl_line()
 {
     Token *startTk=crtTk;
-    if(simple_decl()) // 'int x'
+    int first=simple_decl();
+    if(first) // 'int x'
     {
+	int last=first;
 	while(consume(COMMA) || consume(ASSIGN))
 	{
-	    if(crtTk->prev->code == COMMA) // 'int x, '
+	    if(Tk_prev(crtTk)->code == COMMA) // 'int x, ' followed by 'p' or '*p' or 'p[]' or 'p[expression]'
 	    {
-		if(consume(MUL)){ // 'int x,*p'
-		    if(!consume(ID))
-			tkerr(crtTk,"Invalid pointer name after *");
-		}
-
-		else if(crtTk->code == ID) // 'int x, p'
-		{
-		    if(checkif_vector()) // 'int x,p['
-		    {
-			if(crtTk->next->code==LBRACKET)
-			{
-			    if(crtTk->next->next->code==RBRACKET) // 'int x,p[]'
-			    {
-				crtTk=crtTk->next->next->next;
-			    }
-			    else
-			    {
-				if(!consume_vector_el()) //'int x,p[simple_expr]'
-				    tkerr(crtTk,"Error in vector declaration");
-			    }
-			}
-		    }
-		    else
-		    {
-			consume(ID); //'int x,p'
-		    }
-		}else tkerr(crtTk,"Missing variable");
+		int n=decl_variable(nodes[first].type,nodes[first].c);
+		nodes[last].next=n;
+		last=n;
 	    }
-	    else if(crtTk->prev->code == ASSIGN) //'int x ='
+	    else if(Tk_prev(crtTk)->code == ASSIGN) //'int x ='
 	    {
-	    if(!simple_expr(DECLARATION,None))
-		 tkerr(crtTk,"Missing expression");
+		int value=expression();
+		nodes[last].b=value;
 	    }
 	}
 	if(crtTk->code == SEMICOLON)
-	    return 1;
+	    return first;
     } else tkerr(crtTk,"Error in declaration of types");
     crtTk=startTk;
     return 0;
 }
 
-//function to consume a line of variables declaration
-int struct_decl_line()
+//function to consume a line of variables declared after a structure 'x,*p,v[]', returns the list of variables
+int struct_decl_line(int its_type, int struct_tk)
 {
     Token *startTk=crtTk;
-    if(consume(MUL)){ // 'x,*p'
-	if(!consume(ID))
-	    tkerr(crtTk,"Invalid pointer name after *");
-		    }
-	else if(crtTk->code == ID) // 'int x, p'
-	    {
-		if(checkif_vector()) // 'int x,p['
-		{
-		    if(crtTk->next->code==LBRACKET)
-		    {
-			if(crtTk->next->next->code==RBRACKET) // 'x,p[]'
-			{
-			    crtTk=crtTk->next->next->next;
-			}
-			else
-			{
-			    if(!consume_vector_el()) //'x,p[simple_expr]'
-				tkerr(crtTk,"Error in vector declaration");
-			}
-		    }
-		}
-		else
-		{
-		    consume(ID); //'x,p'
-		}
-		}else tkerr(crtTk,"Missing variable");
-	while(consume(COMMA))
-	{
-		if(consume(MUL)){ // 'x,*p'
-		    if(!consume(ID))
-			tkerr(crtTk,"Invalid pointer name after *");
-		}
-
-		else if(crtTk->code == ID) // 'x, p'
-		{
-		    if(checkif_vector()) // 'x,p['
-		    {
-			if(crtTk->next->code==LBRACKET)
-			{
-			    if(crtTk->next->next->code==RBRACKET) // 'x,p[]'
-			    {
-				crtTk=crtTk->next->next->next;
-			    }
-			    else
-			    {
-				if(!consume_vector_el()) //'x,p[simple_expr]'
-				    tkerr(crtTk,"Error in vector declaration");
-			    }
-			}
-		    }
-		    else
-		    {
-			consume(ID); //'x,p'
-		    }
-		}else tkerr(crtTk,"Missing variable");
-	}
-	if(crtTk->code == SEMICOLON)
-	    return 1;
+    int first=decl_variable(its_type,struct_tk);
+    int last=first;
+    while(consume(COMMA))
+    {
+	int n=decl_variable(its_type,struct_tk); // 'x,p' or 'x,*p' or 'x,p[]' or 'x,p[expression]'
+	nodes[last].next=n;
+	last=n;
+    }
+    if(crtTk->code == SEMICOLON)
+	return first;
     crtTk=startTk;
     return 0;
 }
 
 
-//function to consume an assign 'x=3' or 'x=x+1' or 'x=f(4)'
-int simple_assign()
+//the expressions which can be assigned: 'x' or 'v[i]' or 'p.x'
+int is_destination(int expr)
 {
-    Token *startTk=crtTk;
-    int ok = 0;
-    if(consume_vector_el() || consume(ID)){
-	while(consume(ASSIGN)){
-	    simple_expr(SEMICOLON, ASSIGN);
-	    ok = 1;
-	    }
-	if(ok)
-	    return 1;
-	else
-	    tkerr(crtTk,"Missing = or invalid expression after =");
-    } else tkerr(crtTk,"Missing variable");
-    crtTk=startTk;
-    return 0;
+    int kind = nodes[nodes[expr].a].kind;
+    return kind == N_NAME || kind == N_INDEX || kind == N_FIELD;
 }
 
-//function to consume an assign 'x=3)' or 'x=x+1)' or 'x=f(4))'
-int simple_assign_for()
+//the rest of an assign after its destination '=3' or '=x+1' or '=f(4)' or '=y=3', for 'x=y=3' the value of x is the assign 'y=3'
+int assign_rest(int dest)
 {
-    Token *startTk=crtTk;
-    if(consume(ID)){
-	if(consume(ASSIGN)){
-	    if(simple_expr(RPAR, None)){
-		return 1;
-	    } else tkerr(crtTk,"Missing expression after =");
-	} else tkerr(crtTk,"Missing = in assign statement");
-    } else tkerr(crtTk,"Missing variable");
-    crtTk=startTk;
-    return 0;
+    if(!is_destination(dest))
+	tkerr(node_tk(dest),"Missing variable");
+    int n=addNode(N_ASSIGN,crtTk);
+    consume(ASSIGN);
+    nodes[n].a=dest;
+    int value=expression();
+    nodes[n].b=value;
+    int inner=n;
+    while(crtTk->code == ASSIGN)
+    {
+	if(!is_destination(value))
+	    tkerr(crtTk,"Invalid destination of the assign");
+	int next_assign=addNode(N_ASSIGN,crtTk);
+	consume(ASSIGN);
+	nodes[next_assign].a=value;
+	value=expression();
+	nodes[next_assign].b=value;
+	nodes[inner].b=next_assign;
+	inner=next_assign;
+    }
+    return n;
+}
+
+//function to consume an assign 'x=3' or 'v[i]=x+1' or 'p.x=f(4)' or 'x=y=3'
+int simple_assign()
+{
+    int dest=expression();
+    if(crtTk->code != ASSIGN)
+	tkerr(crtTk,"Missing = or invalid expression after =");
+    return assign_rest(dest);
 }
 
-int single_instr();
+//an instruction made of an expression 'f(x)' or 'x<3' or an assign
+int expr_instr()
+{
+    int n=expression();
+    if(crtTk->code == ASSIGN)
+	return assign_rest(n);
+    return n;
+}
 
 // function to consume return statement 'return x' or 'return f(x)' or 'return'
 int return_statement()
 {
     Token *startTk=crtTk;
     if(consume(RETURN)){
+	int n=addNode(N_RETURN,startTk);
 	if(crtTk->code == SEMICOLON) // return;
-	    return 1;
-	if(single_instr()){ // return simple_expr;
-	    return 1;
-	} else tkerr(crtTk,"Invalid expression in return statement");
+	    return n;
+	int value=expression(); // return expression;
+	nodes[n].a=value;
+	return n;
     } else tkerr(crtTk, "Missing RETURN");
     crtTk=startTk;
     return 0;
 }
 
-// verify if we have in the next sequence of tokens a comparison
-int is_comp()
-{
-    Token *tk=crtTk;
-    while(tk != NULL && tk->code != SEMICOLON)
-    {
-	if(tk->code == EQUAL || tk->code == NOTEQ || tk->code == LESS || tk->code == LESSEQ || tk->code == GREATER || tk->code == GREATEREQ)
-	    return 1;
-	tk=tk->next;
-    }
-    return 0;
-}
-
 //function used to see the next tokens and predict the following rule to apply
 int chooser()
 {
@@ -1377,33 +1670,26 @@ int chooser()
 
 	0 - error/invalid
 	1 - declaration of variables -> var_decl_line()
-	2 - function calls -> function_call()
-	3 - simple assign -> simple_assign()
+	3 - assign, function call or any other expression -> expr_instr()
 	4 - return statement -> return_statement()
 	5 - while statement -> while_statement()
 	6 - for statement -> for_statement()
 	7 - break keyword -> skip it + semicolon
 	8 - if statement -> if_statement()
-	9 - comparation statement -> cond()
-	10 - simple expression -> simple_expr()
 	11 - structure declaration -> struct_decl()
 	12 - function definition -> 
     */
 
-    //we remove any possible typecast
-    typecast();
-    parenthesys_analyzer(0);
-
-    if(crtTk->code == INT || crtTk->code == DOUBLE || crtTk->code == CHAR || (crtTk->code == STRUCT && crtTk->next->code == ID)) // 'int' 'double' 'struct struct_name'
+    if(crtTk->code == INT || crtTk->code == DOUBLE || crtTk->code == CHAR || (crtTk->code == STRUCT && Tk_next(crtTk)->code == ID)) // 'int' 'double' 'struct struct_name'
     {
-	if(crtTk->code == STRUCT && crtTk->next->code == ID){ // 'struct struct_name'
-		if(crtTk->next->next->code == LACC)
+	if(crtTk->code == STRUCT && Tk_next(crtTk)->code == ID){ // 'struct struct_name'
+		if(Tk_at(crtTk,2)->code == LACC)
 		{
 			return 11;
 		}
-		else if(crtTk->next->next->code == ID)
+		else if(Tk_at(crtTk,2)->code == ID)
 		{
-			if(crtTk->next->next->next->code == LPAR)
+			if(Tk_at(crtTk,3)->code == LPAR)
 			{
 				return 2;
 			}
@@ -1411,13 +1697,13 @@ int chooser()
 		}	
 			
 	}
-	else if(crtTk->next->code == ID) // 'int x' or 'double f'
+	else if(Tk_next(crtTk)->code == ID) // 'int x' or 'double f'
 	{
-	    if(crtTk->next->next->code == LPAR) // 'int f(' 'double f('
+	    if(Tk_at(crtTk,2)->code == LPAR) // 'int f(' 'double f('
 	    {
 	    	return 12;
 	    }
-	    else if(crtTk->next->next->code == SEMICOLON || crtTk->next->next->code == ASSIGN || crtTk->next->next->code == COMMA || crtTk->next->next->code == LBRACKET) // 'int x=' or 'int x;' or 'int x,' or 'int x['
+	    else if(Tk_at(crtTk,2)->code == SEMICOLON || Tk_at(crtTk,2)->code == ASSIGN || Tk_at(crtTk,2)->code == COMMA || Tk_at(crtTk,2)->code == LBRACKET) // 'int x=' or 'int x;' or 'int x,' or 'int x['
 	    {
 		return 1;
 	    }
@@ -1438,38 +1724,32 @@ int chooser()
     else if(crtTk->code == IF){
 	return 8;
     }
-    else if(crtTk->code == ID) // 'f' or 'x'
+    else if(crtTk->code == ID || crtTk->code == LPAR || crtTk->code == SUB || crtTk->code == NOT || crtTk->code == CT_INT || crtTk->code == CT_REAL || crtTk->code == CT_CHAR || crtTk->code == CT_STRING) // 'f(' or 'x=' or 'v[' or '(x'...
     {
-	if(crtTk->next->code == LPAR) // 'f(' 
-	    return 2;
-	if(crtTk->next->code == ASSIGN) // 'x='
-	    return 3;
-	if(checkif_vector()) // 'v['
-	    return 3;
+	return 3;
     }
 
-    if(is_comp())
-	return 9;
-
-    if(crtTk->code == ID)
-	return 10;
-
     crtTk=startTk;
     return 0;
 }
 
-//simple declaration or declaration with assignment
+//simple declaration or declaration with assignment, returns the list of variables of all the lines
 int decl()
 {
     Token *startTk=crtTk;
-    if(var_decl_line()){
+    int first=var_decl_line();
+    if(first){
+	int last=last_node(first);
 	while(consume(SEMICOLON)){
 	    if(crtTk->code==RACC){
-		crtTk=crtTk->prev; //we go back to the last SEMICOLON to help us in the other functions
-		return 1;
+		crtTk=Tk_prev(crtTk); //we go back to the last SEMICOLON to help us in the other functions
+		return first;
 		}
-	    if(!var_decl_line())
+	    int line=var_decl_line();
+	    if(!line)
 		tkerr(crtTk,"Error in declaration of variables");
+	    nodes[last].next=line;
+	    last=last_node(line);
 	}
     }else tkerr(crtTk,"Missing element in declaration");
     crtTk=startTk;
@@ -1482,42 +1762,43 @@ int if_statement();
 int struct_decl();
 int function_prototype();
 
-//simple instruction, one line
+//simple instruction, one line, returns its node (a list for declarations)
 int single_instr()
 {
+    int n=0;
     switch(chooser())
     {
-	case 1: if(!var_decl_line()) tkerr(crtTk,"Error in declaration"); break;
-	case 2: if(!function_call()) tkerr(crtTk,"Error in function call"); break;
-	case 3: if(!simple_assign()) tkerr(crtTk,"Error in assign statement"); break;
-	case 4: if(!return_statement()) tkerr(crtTk,"Error in return statement"); break;
-	case 5: if(!while_statement()) tkerr(crtTk,"Error in while structure"); break;
-	case 6: if(!for_statement()) tkerr(crtTk,"Error in the for structure"); break;
-	// in case we find BREAK we just verify the SEMICOLON and move on
-	case 7: consume(BREAK); if(!consume(SEMICOLON)) tkerr(crtTk,"Missing semicolon after BREAK"); return single_instr();
-	case 8: if(!if_statement()) tkerr(crtTk,"Error in the if statement"); break;
-	case 9: if(!cond()) tkerr(crtTk,"Error in the conditional statement"); break;
-	case 10: if(!simple_expr(SEMICOLON,None)) tkerr(crtTk,"Error in the expression"); break;
-	case 11: if(!struct_decl()) tkerr(crtTk,"Error in structure declaration"); break;
-	case 12: if(!function_prototype()) tkerr(crtTk,"Error in function prototype"); break;
+	case 1: if(!(n=var_decl_line())) tkerr(crtTk,"Error in declaration"); break;
+	case 3: if(!(n=expr_instr())) tkerr(crtTk,"Error in the expression"); break;
+	case 4: if(!(n=return_statement())) tkerr(crtTk,"Error in return statement"); break;
+	case 5: if(!(n=while_statement())) tkerr(crtTk,"Error in while structure"); break;
+	case 6: if(!(n=for_statement())) tkerr(crtTk,"Error in the for structure"); break;
+	// the SEMICOLON after BREAK is consumed like after any other instruction
+	case 7: n=addNode(N_BREAK,crtTk); consume(BREAK); if(crtTk->code != SEMICOLON) tkerr(crtTk,"Missing semicolon after BREAK"); break;
+	case 8: if(!(n=if_statement())) tkerr(crtTk,"Error in the if statement"); break;
+	case 11: if(!(n=struct_decl())) tkerr(crtTk,"Error in structure declaration"); break;
+	case 12: if(!(n=function_prototype())) tkerr(crtTk,"Error in function prototype"); break;
 	default: tkerr(crtTk,"Invalid instruction"); break;
     }
 
-    if(parenthesys_analyzer(1)!=0) //we see if the parenthesys are used correctly
-	tkerr(crtTk,"Parenthesys closed or open incorrectly");
-
-    return 1;
+    return n;
 }
 
-//multiple simple instructions, multiple lines
-int instr()
+//multiple simple instructions, multiple lines, stored in the block
+int instr(int block)
 {
-    if(single_instr()){
-	while(consume(SEMICOLON) || crtTk->prev->code == RACC){
+    int first=single_instr();
+    if(first){
+	nodes[block].a=first;
+	int last=last_node(first);
+	while(consume(SEMICOLON) || Tk_prev(crtTk)->code == RACC){
 	    if(crtTk->code==RACC)
 		    return 1;
-	    if(!single_instr())
+	    int n=single_instr();
+	    if(!n)
 		tkerr(crtTk,"Missing instruction");
+	    nodes[last].next=n;
+	    last=last_node(n);
 	}
 	if(crtTk->code == RACC)
 	    return 1;
@@ -1530,9 +1811,10 @@ int instr()
 int body(){
     Token *startTk=crtTk;
     if(consume(LACC)){
-	if(instr()){
+	int block=addNode(N_BLOCK,startTk);
+	if(instr(block)){
 	    if(consume(RACC)){
-		return 1;
+		return block;
 	    }else tkerr(crtTk,"missing } after body");
 	}else tkerr(crtTk,"invalid instruction in body");
     }else tkerr(crtTk,"missing { before body");
@@ -1540,21 +1822,28 @@ int body(){
     return 0;
 }
 
+//the body of a while, if, for: a block or a single instruction
+int branch()
+{
+    if(crtTk->code == LACC)
+	return body();
+    return single_instr();
+}
+
 int while_statement()
 {
     Token *startTk=crtTk;
     if(consume(WHILE)){
+	int n=addNode(N_WHILE,startTk);
 	if(consume(LPAR)){
-	    if(cond()){
+	    int condition=expression();
+	    if(condition){
 		if(consume(RPAR)){ // 'while(cond)'
-
-		    if(crtTk->code == LACC){ //while(cond) { }
-			if(body()){
-				return 1;
-			} else tkerr(crtTk,"Error in body");
-		    }
-		    else if(single_instr()){ //while(cond) single_instruction
-			return 1;
+		    int loop_body=branch(); //while(cond) { } or while(cond) single_instruction
+		    if(loop_body){
+			nodes[n].a=condition;
+			nodes[n].b=loop_body;
+			return n;
 		    }
 		    else tkerr(crtTk,"Invalid body/instruction for while");
 
@@ -1570,50 +1859,51 @@ int if_statement()
 {
     Token *startTk=crtTk;
     if(consume(IF)){
+	int n=addNode(N_IF,startTk);
 	if(consume(LPAR)){
-	    if(cond()){
+	    int condition=expression();
+	    if(condition){
 		if(consume(RPAR)){ // if (cond)
+		    nodes[n].a=condition;
 
 		    if(crtTk->code == LACC){
-			if(body()){ //if (cond) { }
+			int if_true=body();
+			if(if_true){ //if (cond) { }
+			    nodes[n].b=if_true;
 			    if(consume(ELSE)){
 
-				//if (cond) { } else
-				if(crtTk->code == LACC){
-				    if(body()){ //if (cond) { } else { }
-					return 1;
-				    } else tkerr(crtTk,"Error in body in else branch of IF");
-
-				}else if(single_instr()){ //if (cond) { } else single_instruction
-				    return 1;
-
+				//if (cond) { } else { } or if (cond) { } else single_instruction
+				int if_false=branch();
+				if(if_false){
+				    nodes[n].c=if_false;
+				    return n;
 				}else tkerr(crtTk,"Error in body in else branch of IF");
 
-			    } else return 1; //if (cond){ }
+			    } else return n; //if (cond){ }
 			}else tkerr(crtTk,"Error in body in if-true branch of IF");
 		    }
 
-		    else if(single_instr())
+		    else
 		    {
-			if(crtTk->next->code == ELSE){
-			    if(!consume(SEMICOLON))
-				tkerr(crtTk,"Missing semicolon");
-			    consume(ELSE);
-
-			//if (cond) single_instruction else
-			if(crtTk->code == LACC){
-			    if(body()){ //if (cond) single_instruction else { }
-				return 1;
-			    } else tkerr(crtTk,"Error in body in else branch of IF");
-
-			}else if(single_instr()){ //if (cond) single_instruction else single_instruction
-			    return 1;
-
-			}else tkerr(crtTk,"Error in body in else branch of IF");
+			int if_true=single_instr();
+			if(if_true){
+			    nodes[n].b=if_true;
+			    if(Tk_next(crtTk)->code == ELSE){
+				if(!consume(SEMICOLON))
+				    tkerr(crtTk,"Missing semicolon");
+				consume(ELSE);
+
+				//if (cond) single_instruction else { } or if (cond) single_instruction else single_instruction
+				int if_false=branch();
+				if(if_false){
+				    nodes[n].c=if_false;
+				    return n;
+				}else tkerr(crtTk,"Error in body in else branch of IF");
 
-			}else return 1; //if (cond) single_instruction
+			    }else return n; //if (cond) single_instruction
+			}
+			else tkerr(crtTk,"Error in if-true branch of IF");
 		    }
-		    else tkerr(crtTk,"Error in if-true branch of IF");
 
 		} else tkerr(crtTk,"Missing ) after condition of IF");
 	    }else tkerr(crtTk,"Error in condition after (");
@@ -1627,60 +1917,42 @@ int for_statement()
 {
     Token *startTk=crtTk;
     if(consume(FOR)){
+	int n=addNode(N_FOR,startTk);
 	if(consume(LPAR)){
-	    if(chooser()==3){ //simple assign
-
-		if(simple_assign()){
-		    if(consume(SEMICOLON)){
-			if(cond()){
-			    if(consume(SEMICOLON)){
-				if(simple_assign_for()){
-				    if(consume(RPAR)){ //for(init,cond,modif)
-					
-					if(crtTk->code == LACC){ //for(init,cond,modif) { }
-					    if(body()){
-						return 1;
-					    } else tkerr(crtTk,"Error in body");
-					}
-					else if(single_instr()){ //for(init,cond,modif) single_instruction
-					    return 1;
-					}
-					else tkerr(crtTk,"Invalid body/instruction in for");
-					
-				    }else tkerr(crtTk,"Missing ) after variable modification in for");
-				}else tkerr(crtTk,"Error in modification of the variable in for");
-			    }else tkerr(crtTk,"Missing SEMICOLON after condition in for");
-			}else tkerr(crtTk,"Error in condition in for");
-		    } else tkerr(crtTk,"Missing SEMICOLON after assignment in for");
-		 }else tkerr(crtTk,"Error in assign statement in for");
-
-	    }else if(chooser() ==1){ //variable declaration
-
-		if(var_decl_line()){
-		    if(consume(SEMICOLON)){
-			if(cond()){
-			    if(consume(SEMICOLON)){
-				if(simple_assign_for()){
-				    if(consume(RPAR)){
-					
-					if(crtTk->code == LACC){ //for(init,cond,modif) { }
-					    if(body()){
-						return 1;
-					    } else tkerr(crtTk,"Error in body");
-					}
-					else if(single_instr()){ //for(init,cond,modif) single_instruction
-					    return 1;
-					}
-					else tkerr(crtTk,"Invalid body/instruction in for");
-					
-				    }else tkerr(crtTk,"Missing ) after variable modification in for");
-				}else tkerr(crtTk,"Error in modification of the variable in for");
-			    }else tkerr(crtTk,"Missing SEMICOLON after condition in for");
-			}else tkerr(crtTk,"Error in condition in for");
-		    } else tkerr(crtTk,"Missing SEMICOLON after assignment in for");
-		 }else tkerr(crtTk,"Error in assign statement in for");
-
-	    }else tkerr(crtTk,"Invalid initialization of variable in for");
+	    int init=0;
+	    int rule=chooser();
+	    if(rule==3) //simple assign
+		init=simple_assign();
+	    else if(rule==1) //variable declaration
+		init=var_decl_line();
+	    else tkerr(crtTk,"Invalid initialization of variable in for");
+
+	    if(init){
+		if(consume(SEMICOLON)){
+		    int condition=expression();
+		    if(condition){
+			if(consume(SEMICOLON)){
+			    int modification=simple_assign();
+			    if(modification){
+				if(consume(RPAR)){ //for(init,cond,modif)
+
+				    //for(init,cond,modif) { } or for(init,cond,modif) single_instruction
+				    int loop_body=branch();
+				    if(loop_body){
+					nodes[n].a=init;
+					nodes[n].b=condition;
+					nodes[n].c=modification;
+					nodes[n].d=loop_body;
+					return n;
+				    }
+				    else tkerr(crtTk,"Invalid body/instruction in for");
+
+				}else tkerr(crtTk,"Missing ) after variable modification in for");
+			    }else tkerr(crtTk,"Error in modification of the variable in for");
+			}else tkerr(crtTk,"Missing SEMICOLON after condition in for");
+		    }else tkerr(crtTk,"Error in condition in for");
+		} else tkerr(crtTk,"Missing SEMICOLON after assignment in for");
+	    }else tkerr(crtTk,"Error in assign statement in for");
 
 	}else tkerr(crtTk,"Missing ( after FOR");
     }else tkerr(crtTk,"Missing FOR statement");
@@ -1693,11 +1965,14 @@ int struct_decl()
 {
     Token *startTk=crtTk;
     if(consume(STRUCT)){
+	int n=addNode(N_STRUCT,crtTk);
 	if(consume(ID)){
 	    if(consume(LACC)){
-		if(decl() && consume(SEMICOLON)){
+		int fields=decl();
+		if(fields && consume(SEMICOLON)){
 		    if(consume(RACC)){
-			    return 1;
+			    nodes[n].a=fields;
+			    return n;
 		     }else tkerr(crtTk,"Missing } after variable declarations");
 		 }else tkerr(crtTk,"Error in variable declaration in structure");
 	    }else tkerr(crtTk,"Missing { after variable name");
@@ -1712,10 +1987,16 @@ int struct_decl()
 int simple_expr_fprototype()
 {
     Token *startTk=crtTk;
+    int n=0;
     if(type()){
 	consume(MUL);
+	n=addNode(N_VAR,crtTk);
 	if(consume(ID))
 	{
+	    int struct_tk;
+	    nodes[n].type=decl_type(startTk,&struct_tk);
+	    nodes[n].c=struct_tk;
+	    nodes[n].d=VARIABLE;
 	    if(consume(LPAR))
 	    {
 		if(!consume(RPAR))
@@ -1723,7 +2004,13 @@ int simple_expr_fprototype()
 	    }
 	    if(consume(LBRACKET))
 	    {
-		consume(CT_INT);
+		nodes[n].d=VECTOR;
+		if(consume(CT_INT))
+		{
+		    int size=addNode(N_EXPR,Tk_prev(crtTk));
+		    nodes[size].a=Tk_index(crtTk);
+		    nodes[n].a=size;
+		}
 		if(!consume(RBRACKET))
 		    tkerr(crtTk,"Missing ] in argument list");
 	    }
@@ -1732,7 +2019,7 @@ int simple_expr_fprototype()
 
     if(crtTk->code == COMMA || crtTk->code == RPAR) //end of argument
     {
-	return 1;
+	return n;
     } else tkerr(crtTk,"Invalid character atfer argument");
     crtTk=startTk;
     return 0;
@@ -1742,24 +2029,30 @@ int simple_expr_fprototype()
 int arg_prototype()
 {
     Token *startTk=crtTk;
-    if(simple_expr_fprototype()){
-	return 1;
+    int n=simple_expr_fprototype();
+    if(n){
+	return n;
     }else tkerr(crtTk,"Error in argument");
     crtTk=startTk;
     return 0;
 }
 
-//list of arguments for a function prototype
-int arg_list_prototype()
+//list of arguments for a function prototype, stored in the function node
+int arg_list_prototype(int func)
 {
     Token *startTk=crtTk;
     if(crtTk->code == RPAR){
 	return 1;
     }
-    if(arg_prototype()){
+    int arg=arg_prototype();
+    if(arg){
+	nodes[func].a=arg;
 	while(consume(COMMA)){
-	    if(!arg_prototype())
+	    int next_arg=arg_prototype();
+	    if(!next_arg)
 		tkerr(crtTk,"Missing argument");
+	    nodes[arg].next=next_arg;
+	    arg=next_arg;
 	}
 	if(crtTk->code==RPAR)
 	    return 1;
@@ -1773,12 +2066,18 @@ int function_prototype()
 {
     Token *startTk=crtTk;
     if(consume(VOID) || type()){
+	int n=addNode(N_FUNC,crtTk);
 	if(consume(ID)){
+	    int struct_tk;
+	    nodes[n].type=decl_type(startTk,&struct_tk);
+	    nodes[n].c=struct_tk;
 	    if(consume(LPAR)){
-		if(arg_list_prototype()){
+		if(arg_list_prototype(n)){
 		    if(consume(RPAR)){
-			if(body()){
-			    return 1;
+			int func_body=body();
+			if(func_body){
+			    nodes[n].b=func_body;
+			    return n;
 			}else tkerr(crtTk,"Error in function body");
 		    }else tkerr(crtTk,"Missing ) after arguments list");
 		}else tkerr(crtTk,"Argument list error");
@@ -1797,16 +2096,16 @@ void ambiguos_and_LeftRecursivity(){
 
     while(crtTk!=NULL)
     {
-	if(type() && crtTk->code == ID && crtTk->next->code == LPAR)
+	if(type() && crtTk->code == ID && Tk_next(crtTk)->code == LPAR)
 	{
 	    crtFunc = crtTk;
 	}
 
 	//we find a recursive call
-	if(crtFunc != NULL && crtTk->code == ID && strcmp(crtTk->text,crtFunc->text)==0 && crtTk!=crtFunc)
+	if(crtFunc != NULL && crtTk->code == ID && crtTk->name_id == crtFunc->name_id && crtTk!=crtFunc)
 	{
 	    while(!consume(RPAR))
-		crtTk=crtTk->next;
+		crtTk=Tk_next(crtTk);
 	    if(consume(AND) || consume(OR))
 	    {
 		tkerr(crtTk,"Left recursivity found");
@@ -1815,13 +2114,25 @@ void ambiguos_and_LeftRecursivity(){
 
 	//ambiguities of kind constant = something are removed in the expression function
 
-	crtTk=crtTk->next;
+	crtTk=Tk_next(crtTk);
     }
 }
 
-//main structure of the syntactical analyzer
+//adding the global declarations to the program
+int last_global=0;
+void add_global(int n)
+{
+    if(last_global == 0)
+	program=n;
+    else
+	nodes[last_global].next=n;
+    last_global=last_node(n);
+}
+
+//main structure of the syntactical analyzer, builds the tree of the program
 int syntactical_analyzer(){
     crtTk=root;
+    int n;
 
     // we identify variable declaration, structure + declaration, function declaration
     while(1)
@@ -1830,33 +2141,37 @@ int syntactical_analyzer(){
 	{
 	    if(crtTk->code == ID)
 	    {
-		if(crtTk->next->code == ASSIGN || crtTk->next->code == SEMICOLON || crtTk->next->code == COMMA || crtTk->next->code == LBRACKET) //struct variable declaration declaration
+		if(Tk_next(crtTk)->code == ASSIGN || Tk_next(crtTk)->code == SEMICOLON || Tk_next(crtTk)->code == COMMA || Tk_next(crtTk)->code == LBRACKET) //struct variable declaration declaration
 		{
-		crtTk=crtTk->prev;
-		crtTk=crtTk->prev;
-		if(!var_decl_line())
+		crtTk=Tk_prev(crtTk);
+		crtTk=Tk_prev(crtTk);
+		if(!(n=var_decl_line()))
 		    return 0;
+		add_global(n);
 		consume(SEMICOLON);
 		}
-		else if(crtTk->next->code == LPAR) //struct function
+		else if(Tk_next(crtTk)->code == LPAR) //struct function
 		{
-		    crtTk=crtTk->prev;
-		    crtTk=crtTk->prev;
-		    if(!function_prototype())
+		    crtTk=Tk_prev(crtTk);
+		    crtTk=Tk_prev(crtTk);
+		    if(!(n=function_prototype()))
 			return 0;
+		    add_global(n);
 		}
 		else return 0;
 	    }
 	    else if(crtTk->code == LACC) //struct declaration
 	    {
-		crtTk=crtTk->prev;
-		crtTk=crtTk->prev;
-		if(!struct_decl())
+		crtTk=Tk_prev(crtTk);
+		crtTk=Tk_prev(crtTk);
+		if(!(n=struct_decl()))
 		    return 0;
+		add_global(n);
 		if(!consume(SEMICOLON))
 		{
-			if(!struct_decl_line()) // simple declaration
+			if(!(n=struct_decl_line(_STRUCT,nodes[n].tk))) // simple declaration
 			return 0;
+			add_global(n);
 		}
 		consume(SEMICOLON);
 	    }
@@ -1867,17 +2182,19 @@ int syntactical_analyzer(){
 	{
 	    if(crtTk->code == ID)
 	    {
-		if(crtTk->next->code == LPAR) //simple function
+		if(Tk_next(crtTk)->code == LPAR) //simple function
 		{
-		    crtTk=crtTk->prev;
-		    if(!function_prototype())
+		    crtTk=Tk_prev(crtTk);
+		    if(!(n=function_prototype()))
 			return 0;
+		    add_global(n);
 		}
 		else
 		{
-		    crtTk=crtTk->prev;
-		    if(!var_decl_line()) // simple declaration
+		    crtTk=Tk_prev(crtTk);
+		    if(!(n=var_decl_line())) // simple declaration
 			return 0;
+		    add_global(n);
 		    consume(SEMICOLON);
 		}
 	    }
@@ -1900,6 +2217,103 @@ int syntactical_analyzer(){
     return 1;
 }
 
+//printing a kind of node
+char *print_kind(int kind)
+{
+    switch(kind)
+    {
+	case N_STRUCT: return "STRUCT";
+	case N_FUNC: return "FUNCTION";
+	case N_VAR: return "VARIABLE";
+	case N_BLOCK: return "BLOCK";
+	case N_ASSIGN: return "ASSIGN";
+	case N_CALL: return "CALL";
+	case N_RETURN: return "RETURN";
+	case N_IF: return "IF";
+	case N_WHILE: return "WHILE";
+	case N_FOR: return "FOR";
+	case N_BREAK: return "BREAK";
+	case N_EXPR: return "EXPRESSION";
+	default: return "NOT FOUND";
+    }
+}
+
+//printing an expression in postfix order, the operands before their operator
+void print_expr(int expr)
+{
+    printf(":");
+    for(int n = nodes[expr].b; n <= nodes[expr].a; n++)
+    {
+	Token *tk = node_tk(n);
+	printf(" ");
+	switch(nodes[n].kind)
+	{
+	    case N_CONST:
+		if(tk->code == CT_INT)
+		    printf("%ld",tk->i);
+		if(tk->code == CT_REAL)
+		    printf("%lf",tk->r);
+		if(tk->code == CT_CHAR)
+		    printf("'%c'",(char)tk->i);
+		if(tk->code == CT_STRING)
+		    printf("\"%s\"",tk->text);
+		break;
+	    case N_NAME: printf("%s",tk->text); break;
+	    case N_CALL: printf("%s()/%d",tk->text,nodes[n].c); break;
+	    case N_INDEX: printf("[]"); break;
+	    case N_FIELD: printf(".%s",tk->text); break;
+	    case N_CAST: printf("(");print_atom((enum Atom)tk->code);printf(")"); break;
+	    case N_UNARY: printf("unary-"); print_atom((enum Atom)tk->code); break;
+	    default: print_atom((enum Atom)tk->code); break;
+	}
+    }
+}
+
+//printing a list of nodes and their children, one node per line
+void print_nodes(int n, int level)
+{
+    for(; n != 0; n = nodes[n].next)
+    {
+	printf("%d ",node_tk(n)->line);
+	for(int i=0; i<level; i++)
+	    printf("    ");
+	printf("%s",print_kind(nodes[n].kind));
+	if(node_tk(n)->code == ID && nodes[n].kind != N_EXPR)
+	    printf(": %s",node_tk(n)->text);
+	if(nodes[n].kind == N_EXPR)
+	    print_expr(n);
+	printf("\n");
+	switch(nodes[n].kind)
+	{
+	    case N_STRUCT: case N_BLOCK: case N_RETURN:
+		print_nodes(nodes[n].a, level+1);
+		break;
+	    case N_FUNC: case N_VAR: case N_ASSIGN: case N_WHILE:
+		print_nodes(nodes[n].a, level+1);
+		print_nodes(nodes[n].b, level+1);
+		break;
+	    case N_IF:
+		print_nodes(nodes[n].a, level+1);
+		print_nodes(nodes[n].b, level+1);
+		print_nodes(nodes[n].c, level+1);
+		break;
+	    case N_FOR:
+		print_nodes(nodes[n].a, level+1);
+		print_nodes(nodes[n].b, level+1);
+		print_nodes(nodes[n].c, level+1);
+		print_nodes(nodes[n].d, level+1);
+		break;
+	}
+    }
+}
+
+//printing the tree of the program
+void print_Tree()
+{
+    printf("\n\tSyntax Tree:\n\n");
+    print_nodes(program, 0);
+}
+
 /*						*
  *	Domain Analysis & Table of Symbols	*
  *						*/
@@ -1907,6 +2321,7 @@ int syntactical_analyzer(){
 typedef struct Symbol{
     Token *tk; // a reference to the token from which we extracted the symbol name
     char *name; // a reference to the name stored in a token
+    int name_id; // the handle of the interned name
     int cls; // class = what exactly is
     int type; // type of the symbol
     char *struct_name; // struct name only for struct variable
@@ -1918,6 +2333,16 @@ typedef struct Symbol{
     struct Symbol* fields[15]; // used only for structs
     };
     int nr_argsORmembers; // nr of arguments or members only for functions and structs
+    int node; // the node of the declaration (0 for the predefined functions)
+    int entry; // the address of the bytecode of a function
+    int slot; // the first slot of a variable in its frame (or in the globals), the offset of a field in its structure
+    int nr_slots; // the slots of the frame of a function
+    int ir_var; // the index of a local variable of a basic type in the SSA form of its function, of a function in ir_functions
+    int ir_flags; // IR_STORED, IR_READ, IR_UNUSED
+    char* c_name; // the name of an argument or a local in the C of -EmitC, while its function is written
+    int scope; // the level of the scope in which the symbol was declared
+    struct Symbol* outer; // the symbol with the same name hidden by this one while its scope is open
+    struct Symbol* same_name; // the previous declared symbol with the same name
     struct Symbol* next; // next symbol in the table
     struct Symbol* prev; // previous symbol in the table
 }Symbol;
@@ -1925,71 +2350,114 @@ typedef struct Symbol{
 Symbol* Symbol_root = NULL;
 Symbol* crtSymbol = NULL;
 
+/* the symbols are also indexed by the handle of their name, so finding a name is a single access:
+   visible_symbols has the innermost symbol of the open scopes, declared_symbols the last one declared */
+Symbol** visible_symbols = NULL;
+Symbol** declared_symbols = NULL;
+int nr_indexed_names = 0;
+
+//stack of the symbols made visible, the open scopes keep the height it had when they were opened
+Symbol** shown_symbols = NULL;
+int nr_shown = 0;
+int cap_shown = 0;
+int* scopes = NULL;
+int nr_scopes = 0;
+int cap_scopes = 0;
+
 //Safely allocate a symbol
 Symbol* SafeAllocSymbol()
 {
     Symbol *block;
-    block = (Symbol*)malloc(sizeof(Symbol));
+    block = (Symbol*)calloc(1, sizeof(Symbol));
     if(block == NULL)
 	err("not enough memory");
     return block;
 }
 
-enum Class { FUNCTION, VARIABLE, VECTOR, FUNCTION_ARGUMENT, STRUCT_FIELD, STRUCT_FIELD_VECTOR, FUNCTION_ARGUMENT_VECTOR };
-enum Type { _INT, _DOUBLE, _CHAR, _STRUCT, _VOID };
 
-//returns the first symbol from the current and relevant depth
-Symbol *start_last_depth(int my_depth)
+//make room in the indexes for all the names interned until now
+void grow_symbol_index()
 {
-    Symbol *sy=Symbol_root;
-
-    //case empty list
-    if(sy==NULL)
-	return NULL;
-
-    //case list with 2 or more elements
-
-    //we find the last element
-    while(sy->next != NULL)
-	sy=sy->next;
+    if(nr_names <= nr_indexed_names)
+	return;
+    int new_size = nr_names * 2;
+    visible_symbols = (Symbol**)realloc(visible_symbols, sizeof(Symbol*) * new_size);
+    declared_symbols = (Symbol**)realloc(declared_symbols, sizeof(Symbol*) * new_size);
+    if(visible_symbols == NULL || declared_symbols == NULL)
+	err("not enough memory");
+    memset(visible_symbols + nr_indexed_names, 0, sizeof(Symbol*) * (new_size - nr_indexed_names));
+    memset(declared_symbols + nr_indexed_names, 0, sizeof(Symbol*) * (new_size - nr_indexed_names));
+    nr_indexed_names = new_size;
+}
 
-    //we find the first element of the current depth
-    while(sy!=NULL && sy->depth == my_depth && sy->line >= 0)
+//open a new scope (LACC, function arguments, structure fields)
+void push_scope()
+{
+    if(nr_scopes == cap_scopes)
     {
-	sy=sy->prev;
+	cap_scopes = cap_scopes ? cap_scopes * 2 : 64;
+	scopes = (int*)realloc(scopes, sizeof(int) * cap_scopes);
+	if(scopes == NULL)
+	    err("not enough memory");
     }
+    scopes[nr_scopes++] = nr_shown;
+}
 
-    //if the last element is predefined function
-    if(sy->line == -1)
-	return NULL;
+//close the innermost scope, its symbols are no longer visible
+void pop_scope()
+{
+    int height = scopes[--nr_scopes];
+    while(nr_shown > height)
+    {
+	Symbol *sy = shown_symbols[--nr_shown];
+	visible_symbols[sy->name_id] = sy->outer;
+    }
+}
 
-    return sy;
+//make a symbol visible in the innermost scope, hiding the outer ones with the same name
+void show_symbol(Symbol *sy)
+{
+    if(nr_shown == cap_shown)
+    {
+	cap_shown = cap_shown ? cap_shown * 2 : 1024;
+	shown_symbols = (Symbol**)realloc(shown_symbols, sizeof(Symbol*) * cap_shown);
+	if(shown_symbols == NULL)
+	    err("not enough memory");
+    }
+    shown_symbols[nr_shown++] = sy;
+    sy->scope = nr_scopes;
+    sy->outer = visible_symbols[sy->name_id];
+    visible_symbols[sy->name_id] = sy;
 }
 
 //adding a symbol to the table
-int addSymbol(Token** its_token, char *its_name, int its_cls, int its_type, int its_depth, int its_line)
+int addSymbol(Token** its_token, int its_name_id, int its_cls, int its_type, int its_depth, int its_line)
 {
+    grow_symbol_index();
+
     //checking for already declared variables
-    Symbol *sy_trav=start_last_depth(its_depth);
-    while(sy_trav != NULL)
+    Symbol *sy_trav=visible_symbols[its_name_id];
+    if(sy_trav != NULL && sy_trav->scope == nr_scopes)
     {
-	if(strcmp(its_name,sy_trav->name)==0)
-	{
-	    printf("Error, %s already present in this scope: line %d\n",its_name,(*(its_token))->line);
-	    return 0;
-	}
-	sy_trav=sy_trav->next;
+	printf("Error, %s already present in this scope: line %d\n",name_text(its_name_id),(*(its_token))->line);
+	return 0;
     }
 
     //allocating and storing
     Symbol *sy = SafeAllocSymbol();
-    sy->tk = crtTk;
-    sy->name = its_name;
+    sy->tk = its_token != NULL ? *its_token : NULL;
+    sy->name = name_text(its_name_id);
+    sy->name_id = its_name_id;
     sy->cls = its_cls;
     sy->type = its_type;
     sy->depth = its_depth;
     sy->line = its_line;
 
+    //indexing by name
+    show_symbol(sy);
+    sy->same_name = declared_symbols[its_name_id];
+    declared_symbols[its_name_id] = sy;
+
     //adding to the table
     if(crtSymbol==NULL)
     {
@@ -2042,7 +2510,7 @@ void actual_size(Symbol* sy)
     int curr_size = 0;
     char string[20] = "";
     Token* curr_tk = sy->tk;
-    curr_tk=curr_tk->next->next;
+    curr_tk=Tk_at(curr_tk,2);
     while(curr_size != sy->size)
     {
 	if(curr_tk->code == ID)
@@ -2065,7 +2533,7 @@ void actual_size(Symbol* sy)
 	    strcat(string,")");
 	if(curr_tk->code == DOT)
 	    strcat(string,".");
-	curr_tk=curr_tk->next;
+	curr_tk=Tk_next(curr_tk);
 	curr_size++;
     }
     printf("%s",string);
@@ -2105,287 +2573,173 @@ void print_Symbols()
     }
 }
 
-#define NEXT_TK crtTk=crtTk->next;
-#define IF_NOT_CORRECT_EXIT if(correctness == 0) return 0;
-
-//verify if the crtTk is a certain code
-int crtTk_is(int this_code)
-{
-    if(crtTk->code == this_code)
-	return 1;
-    else
-	return 0;
-}
-
-//verify if the given token is a certain code
-int Tk_is(Token* tk, int this_code)
-{
-    if(tk->code == this_code)
-	return 1;
-    else
-	return 0;
-}
-
-//apparition of a type EX: 'int' or 'double' or 'char' or 'struct s' or 'void' but without consume
-int if_is_type(Token *tk)
-{
-    if(Tk_is(tk, INT) || Tk_is(tk, DOUBLE) || Tk_is(tk, CHAR) || Tk_is(tk, VOID) || ( tk->prev != NULL && Tk_is(tk->prev, STRUCT)))
-    {
-	return 1;
-    }
-    return 0;
-}
-
-//returns the class of a simple token
-int symbol_class(Token *tk)
-{
-    if(tk->next->code == LPAR)
-	return FUNCTION;
-    if(tk->next->code == LBRACKET)
-	return VECTOR;
-    return VARIABLE;
-}
-
-//returns the type of a simple token
-int symbol_type(Token *tk)
-{
-    if(tk->prev->code == ID)
-    {
-	return _STRUCT;
-    }
-    else
-	if(tk->prev->code == INT)
-	    return _INT;
-	else
-	if(tk->prev->code == CHAR)
-	    return _CHAR;
-	else
-	if(tk->prev->code == DOUBLE)
-	    return _DOUBLE;
-	else
-	if(tk->prev->code == VOID)
-	    return _VOID;
-    return _VOID;
-}
-
-//helper function to store size and process vectors of any type
-void vector_TS()
-{
-    if(crtSymbol->cls == STRUCT_FIELD && crtTk->code == LBRACKET)
-	crtSymbol->cls = STRUCT_FIELD_VECTOR;
-    if(crtSymbol->cls == FUNCTION_ARGUMENT && crtTk->code == LBRACKET)
-	crtSymbol->cls = FUNCTION_ARGUMENT_VECTOR;
-    if(crtSymbol->cls == VECTOR || crtSymbol->cls == STRUCT_FIELD_VECTOR || crtSymbol->cls == FUNCTION_ARGUMENT_VECTOR)
-    {
-	consume(LBRACKET);
-	int curr_size = 0;
-	/* in case the size is a more complex value even if the TS will record an incorrect one 
-		the program will continue to operate normally		ex: v[3*5+a] */
-	while(!crtTk_is(RBRACKET))
-	{
-	    curr_size++;
-	    NEXT_TK;
-	}
-	crtSymbol->size = curr_size;
-	consume(RBRACKET);
-    }
-}
-
-// function to verify if a certain variable is in the symbol table
-int if_symbol_in_table(char *variable_name)
-{
-    Symbol *sy = Symbol_root;
-    while(sy != NULL)
-    {
-	if(strcmp(sy->name,variable_name)==0)
-	    return 1;
-	sy=sy->next;
-    }
-    return 0;
-}
-
 // adding predifined functions - Types analysis function
 void add_predifined_func()
 {
-    addSymbol(NULL,"put_s",FUNCTION,_VOID,0,-1);
-    addSymbol(NULL,"c",FUNCTION_ARGUMENT_VECTOR,CHAR,0,-1);
+    addSymbol(NULL,NAME_PUT_S,FUNCTION,_VOID,0,-1);
+    push_scope(); // each function has its own arguments
+    addSymbol(NULL,intern_string("c"),FUNCTION_ARGUMENT_VECTOR,CHAR,0,-1);
+    pop_scope();
 
     (crtSymbol->prev)->nr_argsORmembers=1;
     (crtSymbol->prev)->args[0]=crtSymbol;
 
 
-    addSymbol(NULL,"get_s",FUNCTION,_VOID,0,-1);
-    addSymbol(NULL,"c",FUNCTION_ARGUMENT_VECTOR,CHAR,0,-1);
+    addSymbol(NULL,NAME_GET_S,FUNCTION,_VOID,0,-1);
+    push_scope(); // each function has its own arguments
+    addSymbol(NULL,intern_string("c"),FUNCTION_ARGUMENT_VECTOR,CHAR,0,-1);
+    pop_scope();
 
     (crtSymbol->prev)->nr_argsORmembers=1;
     (crtSymbol->prev)->args[0]=crtSymbol;
 
 
-    addSymbol(NULL,"put_i",FUNCTION,_VOID,0,-1);
-    addSymbol(NULL,"i",FUNCTION_ARGUMENT,_INT,0,-1);
+    addSymbol(NULL,NAME_PUT_I,FUNCTION,_VOID,0,-1);
+    push_scope(); // each function has its own arguments
+    addSymbol(NULL,intern_string("i"),FUNCTION_ARGUMENT,_INT,0,-1);
+    pop_scope();
 
     (crtSymbol->prev)->nr_argsORmembers=1;
     (crtSymbol->prev)->args[0]=crtSymbol;
 
 
-    addSymbol(NULL,"get_i",FUNCTION,_INT,0,-1);
+    addSymbol(NULL,NAME_GET_I,FUNCTION,_INT,0,-1);
 
 
-    addSymbol(NULL,"put_d",FUNCTION,_VOID,0,-1);
-    addSymbol(NULL,"d",FUNCTION_ARGUMENT,_DOUBLE,0,-1);
+    addSymbol(NULL,NAME_PUT_D,FUNCTION,_VOID,0,-1);
+    push_scope(); // each function has its own arguments
+    addSymbol(NULL,intern_string("d"),FUNCTION_ARGUMENT,_DOUBLE,0,-1);
+    pop_scope();
 
     (crtSymbol->prev)->nr_argsORmembers=1;
     (crtSymbol->prev)->args[0]=crtSymbol;
 
 
-    addSymbol(NULL,"get_d",FUNCTION,_DOUBLE,0,-1);
+    addSymbol(NULL,NAME_GET_D,FUNCTION,_DOUBLE,0,-1);
 
-    addSymbol(NULL,"put_c",FUNCTION,_VOID,0,-1);
-    addSymbol(NULL,"c",FUNCTION_ARGUMENT,_CHAR,0,-1);
+    addSymbol(NULL,NAME_PUT_C,FUNCTION,_VOID,0,-1);
+    push_scope(); // each function has its own arguments
+    addSymbol(NULL,intern_string("c"),FUNCTION_ARGUMENT,_CHAR,0,-1);
+    pop_scope();
 
     (crtSymbol->prev)->nr_argsORmembers=1;
     (crtSymbol->prev)->args[0]=crtSymbol;
 
 
-    addSymbol(NULL,"get_c",FUNCTION,_CHAR,0,-1);
+    addSymbol(NULL,NAME_GET_C,FUNCTION,_CHAR,0,-1);
 
-    addSymbol(NULL,"seconds",FUNCTION,_DOUBLE,0,-1);
+    addSymbol(NULL,NAME_SECONDS,FUNCTION,_DOUBLE,0,-1);
 }
 
-//main structure of the domain analysis and table of symbols analyzer
-int domain_and_symbols()
+//the vector class of a class
+int vector_class(int cls)
 {
-    add_predifined_func();
+    switch(cls)
+    {
+	case VARIABLE: return VECTOR;
+	case STRUCT_FIELD: return STRUCT_FIELD_VECTOR;
+	case FUNCTION_ARGUMENT: return FUNCTION_ARGUMENT_VECTOR;
+	default: return cls;
+    }
+}
 
-    crtTk=root;
-    int correctness = 1;
-    int depth = 0;
+//adding the symbol of a declaration node (N_VAR or N_FUNC), NULL if already declared in this scope
+Symbol* declare(int n, int cls, int depth, char *owner)
+{
+    Token *tk = node_tk(n);
+    if(nodes[n].kind == N_VAR && nodes[n].d == VECTOR)
+	cls = vector_class(cls);
+    if(!addSymbol(&tk,tk->name_id,cls,nodes[n].type,depth,tk->line))
+	return NULL;
+    crtSymbol->node = n;
+    if(owner != NULL) // field of a structure
+	crtSymbol->struct_name = owner;
+    else if(nodes[n].type == _STRUCT)
+	crtSymbol->struct_name = tokens[nodes[n].c].text;
+    //the size of a vector is the number of tokens between the brackets
+    if(nodes[n].a != 0 && nodes[n].kind == N_VAR)
+	crtSymbol->size = nodes[nodes[n].a].c - nodes[nodes[n].a].tk;
+    return crtSymbol;
+}
 
-    while(crtTk != NULL)
+//adding the symbols declared in a list of nodes and in their children
+int domain_nodes(int n, int depth)
+{
+    for(; n != 0; n = nodes[n].next)
     {
-	if(crtTk_is(LACC))
-	    depth++;
-	if(crtTk_is(RACC))
-	    depth--;
-
-	// symbol found
-	if(type() || consume(VOID))
+	switch(nodes[n].kind)
 	{
-	    // structure
-	    if(consume(LACC))
-	    {
-		char *structure_name = crtTk->prev->prev->text;
-
-		//structure declaration
-		while(!crtTk_is(RACC))
-		{
-		    //now we store only structure fields
-		    type();
-		    int curr_type = symbol_type(crtTk);
-		    correctness = addSymbol(&crtTk,crtTk->text,STRUCT_FIELD,curr_type,depth,crtTk->line);
-		    NEXT_TK
-		    IF_NOT_CORRECT_EXIT
-		    crtSymbol->struct_name = structure_name;
-		    vector_TS();
-
-		    while(crtTk_is(COMMA))
-		    {
-			NEXT_TK
-			correctness = addSymbol(&crtTk,crtTk->text,STRUCT_FIELD,curr_type,depth,crtTk->line);
-			NEXT_TK
-			IF_NOT_CORRECT_EXIT
-			crtSymbol->struct_name = structure_name;
+	    case N_VAR:
+		if(declare(n,VARIABLE,depth,NULL) == NULL)
+		    return 0;
+		break;
 
-			vector_TS();
-		    }
-		    consume(SEMICOLON);
-		}
-		consume(RACC);
-		//we may have variable instatiation right after declaration
-		if(!crtTk_is(SEMICOLON))
-		{
-		    correctness = addSymbol(&crtTk,crtTk->text,VARIABLE,_STRUCT,depth,crtTk->line);
-		    crtSymbol->struct_name = structure_name;
-		    NEXT_TK
-		    IF_NOT_CORRECT_EXIT
-		    while(crtTk_is(COMMA))
-		    {
-			NEXT_TK
-			correctness = addSymbol(&crtTk,crtTk->text,VARIABLE,_STRUCT,depth,crtTk->line);
-			crtSymbol->struct_name = structure_name;
-			NEXT_TK
-			IF_NOT_CORRECT_EXIT
-			vector_TS();
-		    }
-		    vector_TS();
-		}
-		consume(SEMICOLON);
-	    }
-	    else
-	    // function or simple variable
+	    case N_STRUCT:
 	    {
-		int curr_type = symbol_type(crtTk);
-		int curr_class = symbol_class(crtTk);
-		char *structure_Name;
-		correctness = addSymbol(&crtTk,crtTk->text,curr_class,curr_type,depth,crtTk->line);
-		if(crtSymbol->type == _STRUCT)
+		char *structure_name = node_tk(n)->text;
+		push_scope(); // the fields have their own scope
+		for(int field = nodes[n].a; field != 0; field = nodes[field].next)
 		{
-		    structure_Name = crtTk->prev->text;
-		    crtSymbol->struct_name = structure_Name;
+		    if(declare(field,STRUCT_FIELD,depth,structure_name) == NULL)
+			return 0;
 		}
-		IF_NOT_CORRECT_EXIT
-		NEXT_TK
+		pop_scope();
+		break;
+	    }
 
-		// function
-		if(curr_class == FUNCTION)
+	    case N_FUNC:
+	    {
+		Symbol *function = declare(n,FUNCTION,depth,NULL);
+		if(function == NULL)
+		    return 0;
+		push_scope(); // the arguments are visible only in the function
+		for(int arg = nodes[n].a; arg != 0; arg = nodes[arg].next)
 		{
-		    consume(LPAR);
-		    Symbol *function=crtSymbol;
-		    int nr_arg=0;
-
-		    // function arguments
-		    while(type() || consume(VOID))
-		    {
-			correctness = addSymbol(&crtTk,crtTk->text,FUNCTION_ARGUMENT,symbol_type(crtTk),depth,crtTk->line);
-			NEXT_TK
-			IF_NOT_CORRECT_EXIT
-			vector_TS();
-			consume(COMMA);
-			nr_arg++;
-		    }
-
-		    // modify function to include the argument list
-		    function->nr_argsORmembers=nr_arg;
-		    Symbol *arg=function->next;
-		    for(int i=0;i<nr_arg;i++)
-		    {
-			function->args[i]=arg;
-			arg=arg->next;
-		    }
+		    Symbol *sy = declare(arg,FUNCTION_ARGUMENT,depth,NULL);
+		    if(sy == NULL)
+			return 0;
+		    if(function->nr_argsORmembers == 15)
+			tkerr(node_tk(arg),"Too many arguments");
+		    function->args[function->nr_argsORmembers++] = sy;
 		}
-		else
-		    vector_TS();
+		if(!domain_nodes(nodes[n].b,depth))
+		    return 0;
+		pop_scope();
+		break;
+	    }
 
-		// simple variable
-		while(crtTk_is(COMMA) && curr_class!=FUNCTION && curr_type!=STRUCT)
-		{
-		    NEXT_TK
-		    correctness = addSymbol(&crtTk,crtTk->text,symbol_class(crtTk),curr_type,depth,crtTk->line);
-		    if(crtSymbol->type == _STRUCT)
-			crtSymbol->struct_name = structure_Name;
-		    NEXT_TK
+	    case N_BLOCK:
+		push_scope();
+		if(!domain_nodes(nodes[n].a,depth+1))
+		    return 0;
+		pop_scope();
+		break;
 
-		    // vector
-		    vector_TS();
+	    case N_IF:
+		if(!domain_nodes(nodes[n].b,depth) || !domain_nodes(nodes[n].c,depth))
+		    return 0;
+		break;
 
-		    IF_NOT_CORRECT_EXIT
-		}
-	    }
+	    case N_WHILE:
+		if(!domain_nodes(nodes[n].b,depth))
+		    return 0;
+		break;
 
+	    case N_FOR:
+		if(!domain_nodes(nodes[n].a,depth) || !domain_nodes(nodes[n].d,depth))
+		    return 0;
+		break;
 	}
-	else
-	    NEXT_TK
     }
+    return 1;
+}
+
+//main structure of the domain analysis and table of symbols analyzer
+int domain_and_symbols()
+{
+    add_predifined_func();
+
+    int correctness = domain_nodes(program,0);
 
     if(Symbol_root!=NULL)
     {
@@ -2401,18 +2755,164 @@ int domain_and_symbols()
 	    return 0;
 	}
 
-    //search for unused
-    crtTk=root;
-    while(crtTk != NULL)
+    return correctness;
+}
+
+/*						*
+ *		 Name Resolution		*
+ *						*/
+
+//the symbol of each ID token, indexed by the position of the token (NULL for struct names)
+Symbol** bindings = NULL;
+
+//the field with the given name of the structure of the base symbol
+Symbol* find_field(Symbol *base, int field_name_id)
+{
+    if(base == NULL || base->type != _STRUCT || base->cls == STRUCT_FIELD || base->cls == STRUCT_FIELD_VECTOR)
+	return NULL;
+    for(Symbol *sy = declared_symbols[field_name_id]; sy != NULL; sy = sy->same_name)
+    {
+	// interned names are unique, so the same struct has the same name pointer
+	if((sy->cls == STRUCT_FIELD || sy->cls == STRUCT_FIELD_VECTOR) && sy->struct_name == base->struct_name)
+	    return sy;
+    }
+    return NULL;
+}
+
+//binding an ID used in an expression to the symbol visible at that point
+int resolve_token(Token *tk)
+{
+    Symbol *sy = visible_symbols[tk->name_id];
+    if(sy == NULL)
     {
-	if(crtTk_is(ID) && crtTk->prev->code != STRUCT && !if_symbol_in_table(crtTk->text))
+	printf("\nline %d: %s is not declared in the current scope\n",tk->line,tk->text);
+	return 0;
+    }
+    bindings[Tk_index(tk)] = sy;
+    return 1;
+}
+
+//the symbol of the structure of a field 'p' in 'p.x' or in 'v[i].x'
+Symbol* field_base(int n)
+{
+    n = nodes[n].a;
+    while(nodes[n].kind == N_INDEX)
+	n = nodes[n].a;
+    if(nodes[n].kind != N_NAME)
+	return NULL;
+    return bindings[nodes[n].tk];
+}
+
+//binding the names of an expression, the operands come before their operator so the structure of a field is already bound
+int resolve_expr(int expr)
+{
+    if(expr == 0)
+	return 1;
+    for(int n = nodes[expr].b; n <= nodes[expr].a; n++)
+    {
+	if(nodes[n].kind == N_NAME || nodes[n].kind == N_CALL)
 	{
-	    printf("\n%s is not declared in the current scope\n",crtTk->text);
-	    return 0;
+	    if(!resolve_token(node_tk(n)))
+		return 0;
+	}
+	else if(nodes[n].kind == N_FIELD)
+	{
+	    Symbol *sy = find_field(field_base(n), node_tk(n)->name_id);
+	    if(sy == NULL)
+	    {
+		printf("\nline %d: %s is not a field of the structure\n",node_tk(n)->line,node_tk(n)->text);
+		return 0;
+	    }
+	    bindings[nodes[n].tk] = sy;
+	}
+    }
+    return 1;
+}
+
+//the declarations become visible in the order and the scopes used by domain_and_symbols
+int resolve_nodes(int n)
+{
+    for(; n != 0; n = nodes[n].next)
+    {
+	switch(nodes[n].kind)
+	{
+	    case N_VAR:
+		show_symbol(bindings[nodes[n].tk]);
+		if(!resolve_expr(nodes[n].a) || !resolve_nodes(nodes[n].b))
+		    return 0;
+		break;
+
+	    case N_STRUCT:
+		push_scope();
+		for(int field = nodes[n].a; field != 0; field = nodes[field].next)
+		{
+		    show_symbol(bindings[nodes[field].tk]);
+		    if(!resolve_expr(nodes[field].a))
+			return 0;
+		}
+		pop_scope();
+		break;
+
+	    case N_FUNC:
+		show_symbol(bindings[nodes[n].tk]);
+		push_scope();
+		for(int arg = nodes[n].a; arg != 0; arg = nodes[arg].next)
+		    show_symbol(bindings[nodes[arg].tk]);
+		if(!resolve_nodes(nodes[n].b))
+		    return 0;
+		pop_scope();
+		break;
+
+	    case N_BLOCK:
+		push_scope();
+		if(!resolve_nodes(nodes[n].a))
+		    return 0;
+		pop_scope();
+		break;
+
+	    case N_EXPR:
+		if(!resolve_expr(n))
+		    return 0;
+		break;
+
+	    default: // the children are expressions or instructions
+		if(!resolve_nodes(nodes[n].a) || !resolve_nodes(nodes[n].b) || !resolve_nodes(nodes[n].c) || !resolve_nodes(nodes[n].d))
+		    return 0;
+		break;
 	}
-	NEXT_TK;
+    }
+    return 1;
+}
+
+/* we walk the tree opening and closing the scopes like domain_and_symbols did, so every ID
+   is bound once to the symbol visible at that point; later phases just read the binding */
+int resolve_names()
+{
+    bindings = (Symbol**)calloc(nr_tokens, sizeof(Symbol*));
+    if(bindings == NULL)
+	err("not enough memory");
+
+    //the declarations are bound to their symbol
+    for(Symbol *sy = Symbol_root; sy != NULL; sy = sy->next)
+    {
+	if(sy->line >= 0)
+	    bindings[Tk_index(sy->tk)] = sy;
+    }
+
+    //we start again with only the predefined functions visible
+    memset(visible_symbols, 0, sizeof(Symbol*) * nr_indexed_names);
+    nr_shown = 0;
+    nr_scopes = 0;
+    for(Symbol *sy = Symbol_root; sy != NULL && sy->line < 0; sy = sy->next)
+    {
+	if(sy->cls == FUNCTION)
+	    show_symbol(sy);
     }
 
+    int correctness = resolve_nodes(program);
+
+    nr_shown = 0;
+    nr_scopes = 0;
     return correctness;
 }
 
@@ -2475,43 +2975,6 @@ char *print_code(int code)
 }
 
 
-//we find the symbol based on a certain token
-Symbol* find_symbol(Token* tk)
-{
-    Symbol* sy=Symbol_root;
-    Symbol* possible_match=NULL;
-
-    //if we have a vector & we search left_operand
-    if(tk->code == RBRACKET)
-    {
-	while(tk->code != LBRACKET)
-	    tk=tk->prev;
-	tk=tk->prev;
-    }
-
-    //we find the correct symbol
-    while(sy!=NULL)
-    {
-	int line_prev_found=-1;
-
-	//we search for the same name on the closest line to our token but not after it
-	if(strcmp(sy->name, tk->text)==0 && line_prev_found<=sy->line && sy->line<=tk->line)
-	{
-	    possible_match=sy;
-	    line_prev_found = sy->line;
-	}
-	sy=sy->next;
-    }
-
-    if(possible_match==NULL)
-    {
-	tkerr(tk,"Invalid token found");
-	return Symbol_root;
-    }
-    else
-	return possible_match;
-}
-
 //we verify if 2 types are compatible
 int compatible_types(int type_l, int type_r, int line)
 {
@@ -2560,6 +3023,15 @@ int compatible_types(int type_l, int type_r, int line)
 	return 0;
     }
 
+    //the structures are copied, check_assign verifies they are of the same kind
+    if(type_l == _STRUCT)
+    {
+	if(type_r == _STRUCT)
+	    return 1;
+	printf("\n\nImpossible to implicitly convert types at line %d\n",line);
+	return 0;
+    }
+
     printf("\n\nUnexpected type error at line %d\n",line);
     return 0;
 }
@@ -2586,197 +3058,115 @@ int compatible_classes(int class_l, int class_r, int line)
     return 0;
 }
 
-// verify if a vector is a vector element or a vector base pointer
-int vector_element(Token* tk, int cls)
+//the symbol of a term of an expression: 'x' or 'v[i]' (the vector) or 'p.x' (the field) or 'f(a)'
+Symbol* node_symbol(int n)
 {
-    if(cls == VECTOR || cls == FUNCTION_ARGUMENT_VECTOR || cls == STRUCT_FIELD_VECTOR)
-    {
-	tk=tk->next;
-	if(Tk_is(tk,LBRACKET))
-	{
-	    while(!Tk_is(tk,RBRACKET))
-		tk=tk->next;
-	    tk=tk->next;
-	    return VARIABLE;
-	}
-    }
-    return cls;
+    while(nodes[n].kind == N_INDEX)
+	n = nodes[n].a;
+    if(nodes[n].kind == N_NAME || nodes[n].kind == N_FIELD || nodes[n].kind == N_CALL)
+	return bindings[nodes[n].tk];
+    return NULL;
 }
 
-//finds out the class of a token and returns it
-int find_class(Token *tk)
+//finds out the class of a term and returns it
+int term_class(int n)
 {
-    if(Tk_is(tk,ID))
+    switch(nodes[n].kind)
     {
-	// to find out if element or vector pointer from its tokens near him and his class
-	return vector_element(tk,(find_symbol(tk))->cls);
+	case N_CONST: return node_tk(n)->code == CT_STRING ? VECTOR : VARIABLE;
+	case N_INDEX: return VARIABLE; // an element of the vector
+	case N_CAST: return VARIABLE;
+	case N_NAME: case N_FIELD: case N_CALL: return node_symbol(n)->cls;
+	default: return 100;
     }
-    if(Tk_is(tk,CT_INT))
-	return VARIABLE;
-    if(Tk_is(tk,CT_REAL))
-	return VARIABLE;
-    if(Tk_is(tk,CT_CHAR))
-	return VARIABLE;
-    if(Tk_is(tk,CT_STRING))
-	return VECTOR;
-
-    return 100;
 }
 
-//finds out the type of a token and returns it
-int find_type(Token *tk)
+//finds out the type of a term and returns it
+int term_type(int n)
 {
-    if(Tk_is(tk,ID))
-	return (find_symbol(tk))->type;
-    if(Tk_is(tk,CT_INT))
-	return _INT;
-    if(Tk_is(tk,CT_REAL))
-	return _DOUBLE;
-    if(Tk_is(tk,CT_CHAR))
-	return _CHAR;
-    if(Tk_is(tk,CT_STRING))
-	return _CHAR;
-
-    return 100;
+    switch(nodes[n].kind)
+    {
+	case N_CONST:
+	    switch(node_tk(n)->code)
+	    {
+		case CT_INT: return _INT;
+		case CT_REAL: return _DOUBLE;
+		default: return _CHAR; // CT_CHAR, CT_STRING
+	    }
+	case N_CAST: return nodes[n].type;
+	case N_NAME: case N_FIELD: case N_CALL: case N_INDEX: return node_symbol(n)->type;
+	default: return 100;
+    }
 }
 
-// this helps us determine the class of a certain expression and its compatibility
-int expr_cls(Token *tk, int stop_code1, int stop_code2, int class_l)
-{
-    int arg;
+//the terms of an expression are the operands of its operators, left to right
+int* terms=NULL;
+int nr_terms=0;
+int* term_stack=NULL; // the operators still to be walked
+int cap_terms=0;
 
-    //first term
-    if(tk->code != stop_code1 && tk->code != stop_code2)
+//collect the terms of the expression with the given root, the operators are walked with a stack of their own
+void collect_terms(int root)
+{
+    int nr_stack = 0;
+    nr_terms = 0;
+    if(cap_terms < nr_nodes) // an expression has less terms and operators than nodes
     {
-	arg = find_class(tk);
-	tk=tk->next;
-
-	//verify comaptibility
-	if(!compatible_classes(class_l, arg, tk->prev->line))
-	    return -1;
-
-	// found a function as a term
-	if(tk->code == LPAR && (find_symbol(tk->prev))->cls == FUNCTION)
-	{
-	    while(tk->code!=RPAR)
-		tk=tk->next;
-	    tk=tk->next;
-	}
-
-	//found a vector as a term
-	if(tk->code == LBRACKET)
+	cap_terms = nr_nodes * 2;
+	terms = (int*)realloc(terms, sizeof(int) * cap_terms);
+	term_stack = (int*)realloc(term_stack, sizeof(int) * cap_terms);
+	if(terms == NULL || term_stack == NULL)
+	    err("not enough memory");
+    }
+    term_stack[nr_stack++] = root;
+    while(nr_stack > 0)
+    {
+	int n = term_stack[--nr_stack];
+	if(nodes[n].kind == N_BINARY) // the left operand is walked first
 	{
-	    while(tk->code != RBRACKET)
-		tk=tk->next;
-	    tk=tk->next;
+	    term_stack[nr_stack++] = nodes[n].b;
+	    term_stack[nr_stack++] = nodes[n].a;
 	}
+	else if(nodes[n].kind == N_UNARY)
+	    term_stack[nr_stack++] = nodes[n].a;
+	else
+	    terms[nr_terms++] = n;
     }
+}
 
-    //rest of the terms and operands
-    while(!(tk->code == stop_code1 || tk->code == stop_code2))
+// this helps us determine the class of a certain expression and its compatibility
+int expr_cls(int root, int class_l)
+{
+    collect_terms(root);
+    for(int i = 0; i < nr_terms; i++)
     {
-	if(tk->code == MUL || tk->code == ADD || tk->code == SUB || tk->code == DIV)
-	    tk=tk->next;
-	arg = find_class(tk);
+	int arg = term_class(terms[i]);
 
-	if(!compatible_classes(class_l, arg, tk->line))
+	//verify comaptibility
+	if(!compatible_classes(class_l, arg, node_tk(terms[i])->line))
 	    return -1;
-
-	tk=tk->next;
-
-	// found a function as an argument
-	if(tk->code == LPAR && (find_symbol(tk->prev))->cls == FUNCTION)
-	{
-	    while(tk->code!=RPAR)
-		tk=tk->next;
-	    tk=tk->next;
-	}
-
-	//found a vector as an argument
-	if(tk->code == LBRACKET)
-	{
-	    while(tk->code != RBRACKET)
-		tk=tk->next;
-	    tk=tk->next;
-	}
-
     }
 
     return class_l;
 }
 
 //expression type helps us analyze the type of an expression based on another type and see if conversions or errors needs to occur
-int expr_type(Token *tk, int stop_code1, int stop_code2, int type_l, Token **func_end, Token **vector_end)
+int expr_type(int root, int type_l)
 {
     int arg,conversion_needed=0;
 
-    // argument
-    if(tk->code != stop_code1 && tk->code != stop_code2)
-    {
-	arg = find_type(tk);
-	tk=tk->next;
-
-	//verify types
-	if(!compatible_types(type_l, arg, tk->prev->line))
-	    return -1;
-
-	//verify if conversion is needed
-	if(arg != type_l)
-	    conversion_needed = 1;
-
-	// found a function as an argument
-	if(tk->code == LPAR && (find_symbol(tk->prev))->cls == FUNCTION)
-	{
-	    while(tk->code!=RPAR)
-		tk=tk->next;
-	    tk=tk->next;
-	    *func_end=tk;
-	}
-
-	//found a vector as an argument
-	if(tk->code == LBRACKET)
-	{
-	    while(tk->code != RBRACKET)
-		tk=tk->next;
-	    tk=tk->next;
-	    *vector_end=tk;
-	}
-    }
-
-    //rest of operands and tokens
-    while(!(tk->code == stop_code1 || tk->code == stop_code2))
+    collect_terms(root);
+    for(int i = 0; i < nr_terms; i++)
     {
-	if(tk->code == MUL || tk->code == ADD || tk->code == SUB || tk->code == DIV)
-	    tk=tk->next;
-	arg = find_type(tk);
+	arg = term_type(terms[i]);
 
 	//verify types
-	if(!compatible_types(type_l, arg, tk->line))
+	if(!compatible_types(type_l, arg, node_tk(terms[i])->line))
 	    return -1;
 
 	//verify if conversion is needed
 	if(arg != type_l)
 	    conversion_needed = 1;
-
-	tk=tk->next;
-
-	// found a function as an argument
-	if(tk->code == LPAR && (find_symbol(tk->prev))->cls == FUNCTION)
-	{
-	    while(tk->code!=RPAR)
-		tk=tk->next;
-	    tk=tk->next;
-	    *func_end=tk;
-	}
-	
-	//found a vector as an argument
-	if(tk->code == LBRACKET)
-	{
-	    while(tk->code != RBRACKET)
-		tk=tk->next;
-	    tk=tk->next;
-	    *vector_end=tk;
-	}
     }
 
     //if conversion is needed convert everything to int
@@ -2786,263 +3176,220 @@ int expr_type(Token *tk, int stop_code1, int stop_code2, int type_l, Token **fun
 	return _INT;
 }
 
-//main body of type analysis algorithm
-int type_analysis()
+//the type of the value of each node of an expression, the operands are before their operator
+void type_expr(int expr)
 {
-    crtTk = root;
-    Symbol *left_operand=NULL;
-    int correctness = 1;
-
-    //we verify the type of the functions in the source code
-    while(crtTk!=NULL)
+    for(int n = nodes[expr].b; n <= nodes[expr].a; n++)
     {
-	//we found a function
-	// token is an ID && is not a struct name ID && we have no types before the ID (so, is no function decl) && is a function => function call
-	if(crtTk_is(ID) && (crtTk->prev!=NULL && crtTk->prev->code != STRUCT) && !(if_is_type(crtTk->prev)) && (find_symbol(crtTk)->cls) == FUNCTION)
+	switch(nodes[n].kind)
 	{
-	    Symbol* function = find_symbol(crtTk);
-
-	    //useful info about the function
-	    if(DEVELOPER_OPTIONS)
-	    {
-	    	printf("Function: %s \n\tdeclared arguments:\n",function->name);
-	    	for(int i=0; i<function->nr_argsORmembers; i++)
-	    	{
-			printf("\t\targ[%d] = %s ~ %s of type %s\n",i,function->args[i]->name, print_class(function->args[i]->cls), print_type(function->args[i]->type));
-	    	}
-	    	printf("\n");
-	    	if(function->nr_argsORmembers!=0)
-			printf("\targument called with: \n");
-	    }
-
-	    NEXT_TK //skip the name
-	    NEXT_TK //skip the LPAR
-
-	    int index;
-	    int LPARopen;
-	    Token* func_end;
-	    Token* vector_end;
-
-	    vector_end=NULL;
-	    func_end = NULL;
-	    index = 0;
-	    LPARopen = 0;
-	    while(!crtTk_is(RPAR))
-	    {
-		//we have an argument
-		/*
-		    We find its type & class, store them vectors to be compared later
-		*/
-		if((Tk_is(crtTk->prev,COMMA) || (Tk_is(crtTk->prev,LPAR) && !LPARopen)) && !crtTk_is(RPAR))
-		{
-		    LPARopen = 1;
-
-		    int arg_class = expr_cls(crtTk,COMMA,RPAR,function->args[index]->cls);
-		    int arg_type = expr_type(crtTk,COMMA,RPAR,function->args[index]->type,&func_end,&vector_end);
-
-		    //verify types and classes
-		    if(arg_type == -1 || arg_class == -1)
-			return 0;
-		    if(DEVELOPER_OPTIONS)
-		    	printf("\t\t%s - %s of type %s\n",print_code(crtTk->code), print_class(arg_class), print_type(arg_type));
-		    index++;
-
-		    //if we found a function move to the next argument
-		    if(func_end != NULL)
-		    {
-			crtTk = func_end;
-			func_end = NULL;
-		    }
-
-		    //if we found a vector move to the next argument
-		    if(vector_end != NULL)
-		    {
-			crtTk = vector_end;
-			vector_end = NULL;
-		    }
-		}
-		if(!crtTk_is(RPAR))
-		    NEXT_TK
-	    }
+	    case N_UNARY:
+		nodes[n].type = node_tk(n)->code == NOT ? _INT : nodes[nodes[n].a].type;
+		break;
+	    case N_BINARY:
+		if(binary_precedence(node_tk(n)->code) < binary_precedence(ADD)) // comparisons, AND, OR
+		    nodes[n].type = _INT;
+		else if(nodes[nodes[n].a].type == _DOUBLE || nodes[nodes[n].b].type == _DOUBLE)
+		    nodes[n].type = _DOUBLE;
+		else
+		    nodes[n].type = _INT;
+		break;
+	    default:
+		nodes[n].type = term_type(n);
+		break;
 	}
-
-	NEXT_TK
     }
+}
 
-    crtTk = root;
+//verify the arguments of a function call against the declared arguments
+int check_call(int call)
+{
+    Symbol* function = node_symbol(call);
+    if(function->cls != FUNCTION)
+    {
+	printf("\nError at line %d: %s is not a function\n",node_tk(call)->line,function->name);
+	return 0;
+    }
 
-    //we verify the type of the assign in the source code
-    while(crtTk!=NULL)
+    //useful info about the function
+    if(DEVELOPER_OPTIONS)
     {
-	//we found an ASSIGN token
-	if(crtTk_is(ASSIGN))
+	printf("Function: %s \n\tdeclared arguments:\n",function->name);
+	for(int i=0; i<function->nr_argsORmembers; i++)
 	{
-	    //we store and search the left operand
-	    left_operand = find_symbol(crtTk->prev);
-	    if(DEVELOPER_OPTIONS)
-	    {
-		if(left_operand->type != _STRUCT)
-		    printf("line: %d ~ left operand: %s -> %s --- ",crtTk->line,left_operand->name,print_type(left_operand->type));
-		else
-		    printf("line: %d ~ left operand: %s -> %s-%s --- ",crtTk->line,left_operand->name,print_type(left_operand->type),left_operand->struct_name);
-	    }
-
-	    NEXT_TK
+		printf("\t\targ[%d] = %s ~ %s of type %s\n",i,function->args[i]->name, print_class(function->args[i]->cls), print_type(function->args[i]->type));
+	}
+	printf("\n");
+	if(function->nr_argsORmembers!=0)
+		printf("\targument called with: \n");
+    }
 
-	    if(DEVELOPER_OPTIONS)
-		printf("right operand types: ");
+    if(nodes[call].c > function->nr_argsORmembers)
+    {
+	printf("\nError at line %d: too many arguments for %s\n",node_tk(call)->line,function->name);
+	return 0;
+    }
+    if(nodes[call].c < function->nr_argsORmembers)
+    {
+	printf("\nError at line %d: too few arguments for %s\n",node_tk(call)->line,function->name);
+	return 0;
+    }
 
-	    //we store and search the right operands
+    int index = 0;
+    int first = nodes[call].b; // the first node of the argument
+    for(int arg = nodes[call].a; arg != 0; arg = nodes[arg].next)
+    {
+	/*
+	    We find its type & class and compare them with the declared ones
+	*/
+	int arg_class = expr_cls(arg,function->args[index]->cls);
+	int arg_type = expr_type(arg,function->args[index]->type);
+
+	//verify types and classes
+	if(arg_type == -1 || arg_class == -1)
+	    return 0;
+	if(DEVELOPER_OPTIONS)
+	    printf("\t\t%s - %s of type %s\n",print_code(node_tk(first)->code), print_class(arg_class), print_type(arg_type));
+	index++;
+	first = arg + 1;
+    }
+    return 1;
+}
 
-		Token* func_end=NULL;
-		Token* vector_end=NULL;
-		int right_operand_type = expr_type(crtTk,SEMICOLON,RPAR,left_operand->type,&func_end,&vector_end);
-		int right_operand_class = expr_cls(crtTk,SEMICOLON,RPAR,find_class(left_operand->tk));
+//give types to the nodes of an expression and verify the calls of functions inside it
+int check_expr(int expr)
+{
+    if(expr == 0)
+	return 1;
+    type_expr(expr);
+    for(int n = nodes[expr].b; n <= nodes[expr].a; n++)
+    {
+	if(nodes[n].kind == N_CALL && !check_call(n))
+	    return 0;
+    }
+    return 1;
+}
 
-		if(DEVELOPER_OPTIONS)
-			printf("%s of type %s     ", print_class(right_operand_class), print_type(right_operand_type));
+//verify the value assigned to the left operand, the token shows the line
+int check_assign(Symbol *left_operand, int class_l, Token *tk, int value)
+{
+    if(DEVELOPER_OPTIONS)
+    {
+	if(left_operand->type != _STRUCT)
+	    printf("line: %d ~ left operand: %s -> %s --- ",tk->line,left_operand->name,print_type(left_operand->type));
+	else
+	    printf("line: %d ~ left operand: %s -> %s-%s --- ",tk->line,left_operand->name,print_type(left_operand->type),left_operand->struct_name);
+    }
 
-		//verify types and classes
-		if(right_operand_type == -1 || right_operand_class == -1)
-		    return 0;
+    if(DEVELOPER_OPTIONS)
+	printf("right operand types: ");
 
-		//some operands may be structures of different kind
-		if(left_operand->type == right_operand_type && left_operand->type == _STRUCT)
-		{
-		    if(strcmp(left_operand->struct_name, (find_symbol(crtTk))->struct_name)!=0)
-		    {
-			printf("\nError at line %d: type of left operand 'STRUCT %s' is different from type of right operand 'STRUCT %s'\n",crtTk->line,left_operand->struct_name, ((find_symbol(crtTk))->struct_name));
-			correctness = 0;
-		    }
-		}
-		IF_NOT_CORRECT_EXIT
-		NEXT_TK
+    //we store and search the right operands
+    int root = nodes[value].a;
+    int right_operand_type = expr_type(root,left_operand->type);
+    int right_operand_class = expr_cls(root,class_l);
 
-		//if we found a function move to the next argument
-		if(func_end != NULL)
-		{
-		    crtTk = func_end;
-		    func_end = NULL;
-		}
+    if(DEVELOPER_OPTIONS)
+	printf("%s of type %s     ", print_class(right_operand_class), print_type(right_operand_type));
 
-		//if we found a vector move to the next argument
-		if(vector_end != NULL)
-		{
-		    crtTk = vector_end;
-		    vector_end = NULL;
-		}
+    //verify types and classes
+    if(right_operand_type == -1 || right_operand_class == -1)
+	return 0;
 
-	    if(DEVELOPER_OPTIONS)
-		printf("\n");
+    //some operands may be structures of different kind
+    if(left_operand->type == right_operand_type && left_operand->type == _STRUCT)
+    {
+	Symbol *right_operand = node_symbol(root);
+	if(right_operand == NULL || left_operand->struct_name != right_operand->struct_name) // interned names are unique
+	{
+	    printf("\nError at line %d: type of left operand 'STRUCT %s' is different from type of right operand 'STRUCT %s'\n",node_tk(root)->line,left_operand->struct_name, right_operand != NULL ? right_operand->struct_name : "?");
+	    return 0;
 	}
-	NEXT_TK
     }
 
+    if(DEVELOPER_OPTIONS)
+	printf("\n");
     return 1;
 }
 
-
-/*						*
- *		 Code Generation		*
- *						*/
-
-typedef struct Stack{
-    char* name;
-    int memory_loc;
-    int type;
-    union
-    {
-	int value_i;
-	double value_f;
-    };
-    struct Stack *next;
-}Stack;
-
-Stack* st_root=NULL;
-Stack* crt_st=NULL;
-
-//function to print the whole stack
-void print_stack()
+//the number of elements of a vector, its size must be a positive integer constant
+int vector_length(Symbol* sy)
 {
-    Stack* st=st_root;
-    while(st!=NULL)
-    {
-	printf("Name: %s = ", st->name);
-	if(st->type == _INT)
-	    printf("%d", st->value_i);
-	if(st->type == _DOUBLE)
-	    printf("%lf", st->value_f);
-	if(st->type == _CHAR)
-	    printf("'%c'",(char)(st->value_i));
-	printf(" at %d\n", st->memory_loc);
-	st=st->next;
-    }
+    int size = nodes[sy->node].a;
+    int root = size != 0 ? nodes[size].a : 0;
+    if(root != size - 1 || nodes[root].kind != N_CONST || node_tk(root)->code != CT_INT || node_tk(root)->i <= 0)
+	tkerr(sy->tk, "the size of the vector %s must be a positive integer constant", sy->name);
+    return (int)node_tk(root)->i;
 }
 
-//memory counter
-int mem=0;
-
-//type of registers (data_type + empty/non-empty)
-enum type_reg { I_NO_VAL, I_VAL, D_NO_VAL, D_VAL, C_NO_VAL, C_VAL};
-
-//push an element on the stack
-void push_stack(Symbol *sy, int enable, int value_int, double value_float)
+//verify the types in a list of nodes and in their children
+int check_nodes(int n)
 {
-    Stack *st;
-    //SAFE ALLOC
-    st = (Stack*)malloc(sizeof(Stack));
-    if(st == NULL)
-	err("not enough memory");
-
-    st->name = sy->name;
-    st->memory_loc = mem;
-    if(sy->cls == VECTOR || sy->cls == FUNCTION_ARGUMENT_VECTOR || sy->cls == STRUCT_FIELD_VECTOR)
+    for(; n != 0; n = nodes[n].next)
     {
-	if(sy->line>=0)
-	    mem=mem+(sy->tk->next->next->i);
-	else
-	    mem+=50;
-    }
-    else
-	mem++;
+	switch(nodes[n].kind)
+	{
+	    case N_VAR:
+	    {
+		Symbol *sy = bindings[nodes[n].tk];
+		if(!check_expr(nodes[n].a) || !check_expr(nodes[n].b))
+		    return 0;
+		if(sy->cls == VECTOR) // checked here, -O may remove the vector before its slots are counted
+		    vector_length(sy);
+		if(nodes[n].b != 0 && !check_assign(sy,sy->cls,node_tk(n),nodes[n].b))
+		    return 0;
+		break;
+	    }
 
-    //integer
-    if(enable == I_NO_VAL)
-	st->value_i = 0;
-    if(enable == I_VAL)
-	st->value_i = value_int;
-    //double
-    if(enable == D_NO_VAL)
-	st->value_f = 0;
-    if(enable == D_VAL)
-	st->value_f = value_float;
-    //char
-    if(enable == C_NO_VAL)
-	st->value_i = 0;
-    if(enable == C_VAL)
-	st->value_i = value_int;
+	    case N_ASSIGN:
+	    {
+		int dest = nodes[nodes[n].a].a;
+		int value = nodes[n].b;
+		if(!check_expr(nodes[n].a) || !check_nodes(value))
+		    return 0;
+		if(nodes[value].kind == N_ASSIGN) // 'x=y=3', x receives the value of y
+		    value = nodes[value].a;
+		if(!check_assign(node_symbol(dest),term_class(dest),node_tk(n),value))
+		    return 0;
+		break;
+	    }
 
-    st->next=NULL;
+	    case N_EXPR:
+		if(!check_expr(n))
+		    return 0;
+		break;
 
-    //determining the basic type
-    if(enable == I_NO_VAL || enable == I_VAL)
-	st->type = _INT;
-    if(enable == D_NO_VAL || enable == D_VAL)
-	st->type = _DOUBLE;
-    if(enable == C_NO_VAL || enable == C_VAL)
-	st->type = _CHAR;
+	    case N_STRUCT:
+		for(int field = nodes[n].a; field != 0; field = nodes[field].next)
+		    if(bindings[nodes[field].tk]->cls == STRUCT_FIELD_VECTOR)
+			vector_length(bindings[nodes[field].tk]);
+		break;
 
-    if(crt_st==NULL)
-    {
-	st_root = st;
-    }
-    else
-    {
-	crt_st->next = st;
+	    case N_FUNC:
+		if(!check_nodes(nodes[n].b))
+		    return 0;
+		break;
+
+	    default: // the children are expressions or instructions
+		if(!check_nodes(nodes[n].a) || !check_nodes(nodes[n].b) || !check_nodes(nodes[n].c) || !check_nodes(nodes[n].d))
+		    return 0;
+		break;
+	}
     }
-    crt_st = st;
+    return 1;
+}
+
+//main body of type analysis algorithm
+int type_analysis()
+{
+    return check_nodes(program);
 }
 
+
+/*						*
+ *		 Code Generation		*
+ *						*/
+
 enum OpCode {
     O_STORE_I, // store integer
     O_STORE_C, // store char
@@ -3065,638 +3412,9505 @@ enum OpCode {
     O_MODIFY_I, // modify an already stored integer
     O_MODIFY_C, // modify an already stored char
     O_MODIFY_D, // modify an already stored double
-
-    O_LOAD_F, // load a function (arguments)
-
+    O_STORE_GLOBAL_I, // store a global integer
+    O_STORE_GLOBAL_C, // store a global char
+    O_STORE_GLOBAL_D, // store a global double
+    O_LOAD_GLOBAL_I, // load a global integer
+    O_LOAD_GLOBAL_C, // load a global char
+    O_LOAD_GLOBAL_D, // load a global double
+    O_MODIFY_GLOBAL_I, // modify a global integer
+    O_MODIFY_GLOBAL_C, // modify a global char
+    O_MODIFY_GLOBAL_D, // modify a global double
+    O_ADDR, // push the address of a slot of the frame
+    O_ADDR_GLOBAL, // push the address of a global slot
+    O_INDEX, // the address of an element of a vector: address + index * size of the element
+    O_FIELD, // the address of a field of a structure: address + offset of the field
+    O_LOAD_AT_I, // load the integer at an address
+    O_LOAD_AT_C, // load the char at an address
+    O_LOAD_AT_D, // load the double at an address
+    O_MODIFY_AT_I, // modify the integer at an address
+    O_MODIFY_AT_C, // modify the char at an address
+    O_MODIFY_AT_D, // modify the double at an address
+    O_COPY, // copy a structure from an address to another
+    O_VECTOR, // d[k] = a[k] op b[k] for k from a start to an end by the SIMD instructions, see vector_run
+
+    O_CONST_I, // push an integer (or char) constant
+    O_CONST_D, // push a double constant
+    O_NEG_I, // negate integer
+    O_NEG_D, // negate double
+    O_NOT_I, // logical not of an integer
+    O_SHL_I, // shift an integer left by i
+    O_SHR_I, // shift an integer right by i, keeping its sign
+    O_USHR_I, // shift an integer right by i, as unsigned
+    O_MULHI_I, // the upper 32 bits of the 64 bits product of an integer by i
+    O_CONV_I_D, // convert integer to double
+    O_CONV_D_I, // convert double to integer
+    O_CONV_I_C, // convert integer to char
+
+    O_EQUAL_I, // compare integers ==
+    O_EQUAL_D, // compare doubles ==
+    O_NOTEQ_I, // compare integers !=
+    O_NOTEQ_D, // compare doubles !=
+    O_LESS_I, // compare integers <
+    O_LESS_D, // compare doubles <
+    O_LESSEQ_I, // compare integers <=
+    O_LESSEQ_D, // compare doubles <=
+    O_GREATER_I, // compare integers >
+    O_GREATER_D, // compare doubles >
+    O_GREATEREQ_I, // compare integers >=
+    O_GREATEREQ_D, // compare doubles >=
+
+    O_JMP, // jump
+    O_JF, // jump if the integer on the stack is false (0)
+    O_JT, // jump if the integer on the stack is true
+    O_CALL, // call a function, its arguments are on the stack
+    O_ENTER, // the frame starts with the arguments, make room for the other slots of the function
+    O_LOAD_STRUCT, // push the slots of a structure from its address (a structure passed by value)
+    O_RET, // return from a function, its value is left on the stack
+    O_POP, // drop values from the stack
+
+    O_PUT_I, // predefined put_i
+    O_PUT_D, // predefined put_d
+    O_PUT_C, // predefined put_c
+    O_GET_I, // predefined get_i
+    O_GET_D, // predefined get_d
+    O_GET_C, // predefined get_c
+    O_SECONDS, // predefined seconds
 
     O_HALT, // halt operation
 };
 
-int neutral_el = 0;
+//the operands of O_VECTOR which are values instead of the addresses of vectors, added to the op code in i
+#define VECTOR_SCALAR_A 0x100
+#define VECTOR_SCALAR_B 0x200
 
-//choose the next operator & neutral_element
-int next_op(Token* tk, int type)
+//printing op code function
+char *print_op(int op)
 {
-    if(tk->code == ADD)
-    {
-	neutral_el = 0;
-	if(type == _INT)
-	    return O_ADD_I;
-	if(type == _CHAR)
-	    return O_ADD_C;
-	if(type == _DOUBLE)
-	    return O_ADD_D;
-    }
-    if(tk->code == SUB)
+    switch(op)
     {
-	neutral_el = 0;
-	if(type == _INT)
-	    return O_SUB_I;
-	if(type == _CHAR)
-	    return O_SUB_C;
-	if(type == _DOUBLE)
-	    return O_SUB_D;
-    }
-    if(tk->code == MUL)
-    {
-	neutral_el = 1;
-	if(type == _INT)
-	    return O_MUL_I;
-	if(type == _CHAR)
-	    return O_MUL_C;
-	if(type == _DOUBLE)
-	    return O_MUL_D;
+	case O_STORE_I: return "O_STORE_I";
+	case O_STORE_C: return "O_STORE_C";
+	case O_STORE_D: return "O_STORE_D";
+	case O_ADD_I: return "O_ADD_I";
+	case O_ADD_C: return "O_ADD_C";
+	case O_ADD_D: return "O_ADD_D";
+	case O_SUB_I: return "O_SUB_I";
+	case O_SUB_C: return "O_SUB_C";
+	case O_SUB_D: return "O_SUB_D";
+	case O_LOAD_I: return "O_LOAD_I";
+	case O_LOAD_C: return "O_LOAD_C";
+	case O_LOAD_D: return "O_LOAD_D";
+	case O_MUL_I: return "O_MUL_I";
+	case O_MUL_C: return "O_MUL_C";
+	case O_MUL_D: return "O_MUL_D";
+	case O_DIV_I: return "O_DIV_I";
+	case O_DIV_C: return "O_DIV_C";
+	case O_DIV_D: return "O_DIV_D";
+	case O_MODIFY_I: return "O_MODIFY_I";
+	case O_MODIFY_C: return "O_MODIFY_C";
+	case O_MODIFY_D: return "O_MODIFY_D";
+	case O_STORE_GLOBAL_I: return "O_STORE_GLOBAL_I";
+	case O_STORE_GLOBAL_C: return "O_STORE_GLOBAL_C";
+	case O_STORE_GLOBAL_D: return "O_STORE_GLOBAL_D";
+	case O_LOAD_GLOBAL_I: return "O_LOAD_GLOBAL_I";
+	case O_LOAD_GLOBAL_C: return "O_LOAD_GLOBAL_C";
+	case O_LOAD_GLOBAL_D: return "O_LOAD_GLOBAL_D";
+	case O_MODIFY_GLOBAL_I: return "O_MODIFY_GLOBAL_I";
+	case O_MODIFY_GLOBAL_C: return "O_MODIFY_GLOBAL_C";
+	case O_MODIFY_GLOBAL_D: return "O_MODIFY_GLOBAL_D";
+	case O_ADDR: return "O_ADDR";
+	case O_ADDR_GLOBAL: return "O_ADDR_GLOBAL";
+	case O_INDEX: return "O_INDEX";
+	case O_FIELD: return "O_FIELD";
+	case O_LOAD_AT_I: return "O_LOAD_AT_I";
+	case O_LOAD_AT_C: return "O_LOAD_AT_C";
+	case O_LOAD_AT_D: return "O_LOAD_AT_D";
+	case O_MODIFY_AT_I: return "O_MODIFY_AT_I";
+	case O_MODIFY_AT_C: return "O_MODIFY_AT_C";
+	case O_MODIFY_AT_D: return "O_MODIFY_AT_D";
+	case O_COPY: return "O_COPY";
+	case O_VECTOR: return "O_VECTOR";
+	case O_CONST_I: return "O_CONST_I";
+	case O_CONST_D: return "O_CONST_D";
+	case O_NEG_I: return "O_NEG_I";
+	case O_NEG_D: return "O_NEG_D";
+	case O_NOT_I: return "O_NOT_I";
+	case O_SHL_I: return "O_SHL_I";
+	case O_SHR_I: return "O_SHR_I";
+	case O_USHR_I: return "O_USHR_I";
+	case O_MULHI_I: return "O_MULHI_I";
+	case O_CONV_I_D: return "O_CONV_I_D";
+	case O_CONV_D_I: return "O_CONV_D_I";
+	case O_CONV_I_C: return "O_CONV_I_C";
+	case O_EQUAL_I: return "O_EQUAL_I";
+	case O_EQUAL_D: return "O_EQUAL_D";
+	case O_NOTEQ_I: return "O_NOTEQ_I";
+	case O_NOTEQ_D: return "O_NOTEQ_D";
+	case O_LESS_I: return "O_LESS_I";
+	case O_LESS_D: return "O_LESS_D";
+	case O_LESSEQ_I: return "O_LESSEQ_I";
+	case O_LESSEQ_D: return "O_LESSEQ_D";
+	case O_GREATER_I: return "O_GREATER_I";
+	case O_GREATER_D: return "O_GREATER_D";
+	case O_GREATEREQ_I: return "O_GREATEREQ_I";
+	case O_GREATEREQ_D: return "O_GREATEREQ_D";
+	case O_JMP: return "O_JMP";
+	case O_JF: return "O_JF";
+	case O_JT: return "O_JT";
+	case O_CALL: return "O_CALL";
+	case O_ENTER: return "O_ENTER";
+	case O_LOAD_STRUCT: return "O_LOAD_STRUCT";
+	case O_RET: return "O_RET";
+	case O_POP: return "O_POP";
+	case O_PUT_I: return "O_PUT_I";
+	case O_PUT_D: return "O_PUT_D";
+	case O_PUT_C: return "O_PUT_C";
+	case O_GET_I: return "O_GET_I";
+	case O_GET_D: return "O_GET_D";
+	case O_GET_C: return "O_GET_C";
+	case O_SECONDS: return "O_SECONDS";
+	case O_HALT: return "O_HALT";
+	default: return "NOT FOUND";
     }
-    if(tk->code == DIV)
+}
+
+//the op code for a certain type, the typed op codes are in the order integer, char, double
+int typed_op(int op, int type)
+{
+    if(type == _CHAR)
+	return op + 1;
+    if(type == _DOUBLE)
+	return op + 2;
+    return op;
+}
+
+//the op code of an arithmetic operator for a certain type
+int arith_op(int code, int type)
+{
+    switch(code)
     {
-	neutral_el = 1;
-	if(type == _INT)
-	    return O_DIV_I;
-	if(type == _CHAR)
-	    return O_DIV_C;
-	if(type == _DOUBLE)
-	    return O_DIV_D;
+	case ADD: return typed_op(O_ADD_I, type);
+	case SUB: return typed_op(O_SUB_I, type);
+	case MUL: return typed_op(O_MUL_I, type);
+	case DIV: return typed_op(O_DIV_I, type);
+	default: return O_HALT;
     }
-    return O_HALT;
 }
 
-//load a register
-double load_reg(char* name_to_find)
+//the op code of a comparison, the chars are compared as integers
+int compare_op(int code, int type)
 {
-    Stack* st=st_root;
-    while(st!=NULL)
+    int op;
+    switch(code)
     {
-	if(strcmp(st->name,name_to_find)==0)
-	{
-	    if(st->type == _INT || st->type == _CHAR)
-		return st->value_i;
-	    if(st->type == _DOUBLE)
-		return st->value_f;
-	}
-	st=st->next;
+	case EQUAL: op = O_EQUAL_I; break;
+	case NOTEQ: op = O_NOTEQ_I; break;
+	case LESS: op = O_LESS_I; break;
+	case LESSEQ: op = O_LESSEQ_I; break;
+	case GREATER: op = O_GREATER_I; break;
+	case GREATEREQ: op = O_GREATEREQ_I; break;
+	default: return O_HALT;
     }
-    return 0;
+    return type == _DOUBLE ? op + 1 : op;
 }
 
-double get_value_token(Token* tk, int type, int show_msg);
+/* the program is compiled once into a linear bytecode which is then executed by a dispatch loop,
+   the instructions refer to their token (names, lines) and have one or two operands */
+typedef struct Instr{
+    int op; // OpCode
+    int tk; // the token of the instruction (the name of the variable or function, the line for errors)
+    union{
+	struct{
+	    int i; // integer constant, address of a jump or call, number of values
+	    int j; // the second operand (the slots of the arguments for O_ENTER)
+	};
+	double d; // double constant
+    };
+}Instr;
 
-int op_code_find(Token* tk);
+Instr* bytecode=NULL;
+int nr_instr=0;
+int cap_instr=0;
 
-double op_code_execute(int op_code, Token *tk, int aux, int value_i, float value_f);
+int max_stack=0; // no expression needs more values on the stack than this
 
-//find a value in the stack
-Stack* find_reg(char* its_name)
+//adding an instruction, returns its address
+int emit(int op, int tk, int i)
 {
-    Stack* st=st_root;
-    while(st!=NULL)
+    if(nr_instr == cap_instr)
     {
-	if(strcmp(st->name,its_name)==0)
-	    return st;
-	st=st->next;
+	cap_instr = cap_instr ? cap_instr * 2 : 1024;
+	bytecode = (Instr*)realloc(bytecode, sizeof(Instr) * cap_instr);
+	if(bytecode == NULL)
+	    err("not enough memory");
     }
-    return st_root;
+    Instr *ins = &bytecode[nr_instr];
+    ins->op = op;
+    ins->tk = tk;
+    ins->i = i;
+    ins->j = 0;
+    return nr_instr++;
+}
+
+//adding a double constant
+int emit_d(int tk, double d)
+{
+    int pc = emit(O_CONST_D, tk, 0);
+    bytecode[pc].d = d;
+    return pc;
+}
+
+//the jump at the given address goes to the next instruction added
+void patch(int jump)
+{
+    bytecode[jump].i = nr_instr;
+}
+
+//only the basic types have values on the stack, the structures and void have none
+int has_value(int type)
+{
+    return type == _INT || type == _CHAR || type == _DOUBLE;
+}
+
+//push the zero value of a type
+void gen_zero(int type, int tk)
+{
+    if(type == _DOUBLE)
+	emit_d(tk, 0);
+    else if(has_value(type))
+	emit(O_CONST_I, tk, 0);
 }
 
-//return a value from a function
-void return_func(Token* func)
+#define KEEP_TYPE -1 // the value stays as it is
+#define TRUTH -2 // the value is used as a condition: an integer, doubles are compared with 0
+#define LEFT_OF_AND -3 // a condition followed by the jump of AND
+#define LEFT_OF_OR -4 // a condition followed by the jump of OR
+#define ADDRESS -5 // the address of a variable, an element or a field instead of its value
+
+//convert the value on top of the stack from a type to another
+void gen_convert(int from, int to, int tk)
 {
-    Token* tk = func;
-    Symbol* f = find_symbol(func);
-    int value_int = 0;
-    double value_float = 0;
-    if(f->type != _VOID)
+    if(from == to || !has_value(from) || (to < 0 && to != TRUTH) || (to >= 0 && !has_value(to)))
+	return;
+    if(to == TRUTH)
     {
-	while(tk!=NULL)
+	if(from == _DOUBLE)
 	{
-	    if(tk->code == RETURN)
-	    {
-		tk=tk->next;
-		if(f->type == _INT)
-		{
-		    if(tk->next->code != SEMICOLON)
-			value_int = (int) op_code_execute(next_op(tk->next, _INT),tk, 0, 0, 0);
-		    else
-			value_int = (int) get_value_token(tk, _INT, 0);
-		    op_code_execute(O_MODIFY_I, func, 0, value_int, 0);
-		    break;
-		}
-		else if(f->type == _CHAR)
-		{
-		    if(tk->next->code != SEMICOLON)
-			value_int = (char) op_code_execute(next_op(tk->next, _CHAR),tk, 0, 0, 0);
-		    else
-			value_int = (char) get_value_token(tk, _CHAR, 0);
-		    op_code_execute(O_MODIFY_C, func, 0, value_int, 0);
-		    break;
-		}
-		else if(f->type == _DOUBLE)
-		{
-		    if(tk->next->code != SEMICOLON)
-			value_float = (double) op_code_execute(next_op(tk->next, _DOUBLE),tk, 0, 0, 0);
-		    else
-			value_float = (double) get_value_token(tk, _DOUBLE, 0);
-		    op_code_execute(O_MODIFY_D, func, 0, 0, value_float);
-		    break;
-		}
-	    }
-	    tk = tk->next;
+	    emit_d(tk, 0);
+	    emit(O_NOTEQ_D, tk, 0);
 	}
+	return;
+    }
+    if(from == _DOUBLE)
+    {
+	emit(O_CONV_D_I, tk, 0);
+	if(to == _CHAR)
+	    emit(O_CONV_I_C, tk, 0);
     }
+    else if(to == _DOUBLE)
+	emit(O_CONV_I_D, tk, 0);
+    else if(to == _CHAR)
+	emit(O_CONV_I_C, tk, 0);
 }
 
-//push argument of a function in the stack
-void push_args(Token* func, Token* f_call)
+/* every variable has slots: one for a basic type, one for each field of a structure and the
+   elements of a vector one after another; the globals have fixed slots and the variables of a
+   function have slots in its frame, so a variable is found by an index instead of its name */
+int nr_globals=0; // the slots of the global variables
+int nr_frame_slots=0; // the slots used in the frame of the function being generated
+Symbol* gen_function=NULL; // the function whose body is generated
+
+int symbol_slots(Symbol* sy);
+
+//the number of slots of a structure, its fields get their offsets
+int struct_slots(char* struct_name)
 {
-    Token* tk = func;
-    while(tk!=NULL)
+    for(int n = program; n != 0; n = nodes[n].next)
     {
-	if(tk->code == ID && (tk->next->code == COMMA || tk->next->code == RPAR) && (tk->prev->code == INT || tk->prev->code== CHAR || tk->prev->code == DOUBLE))
+	if(nodes[n].kind != N_STRUCT || node_tk(n)->text != struct_name) // interned names are unique
+	    continue;
+	int size = 0;
+	for(int field = nodes[n].a; field != 0; field = nodes[field].next)
 	{
-	    if(tk->prev->code == INT)
-	    {
-		op_code_execute(O_STORE_I, tk, I_NO_VAL, 0, 0);
-	    }
+	    Symbol* sy = bindings[nodes[field].tk];
+	    sy->slot = size;
+	    size += symbol_slots(sy);
 	}
-	tk=tk->next;
+	return size;
     }
-    tk=f_call;
-    /*while(tk!=NULL)
-    {
-	if((tk->prev->code == LPAR || tk->prev->code == COMMA) && (tk->next->code == COMMA || tk->next->code == RPAR))
-	{
-	    op_code_execute(O_MODIFY_I, func, mem_loc, value_int, 0);
-	}
-    }*/
+    return 0;
 }
 
-// finite state machine for OP codes
-double op_code_execute(int op_code, Token* tk, int aux, int value_i, float value_f)
+//the name of the structure which is the type of a symbol, the fields keep their owner in struct_name
+char* type_struct_name(Symbol* sy)
 {
-    Stack* reg=NULL;
-    switch(op_code){
-
-    case O_STORE_I:	if(aux==0) //no value to store given
-			{
-			    printf("O_STORE_I: %s with %d\n",tk->text, 0);
-			    push_stack(find_symbol(tk), I_NO_VAL, 0, 0 );
-			}
-			else
-			{
-			    printf("O_STORE_I: %s with %d\n",tk->text, value_i);
-			    push_stack(find_symbol(tk), I_VAL, value_i, 0 );
-			}
-			return 1;
-
-    case O_STORE_C: if(aux==0) //no value to store given
-			{
-			    printf("O_STORE_C: %s with ''\n",tk->text);
-			    push_stack(find_symbol(tk), C_NO_VAL, 0, 0 );
-			}
-			else
-			{
-			    printf("O_STORE_C: %s with '%c'\n",tk->text, (char)(value_i));
-			    push_stack(find_symbol(tk), C_VAL, value_i, 0 );
-			}
-			return 1;
-
-    case O_STORE_D: if(aux==0) //no value to store given
-			{
-			    printf("O_STORE_D: %s with %lf\n",tk->text, 0.0);
-			    push_stack(find_symbol(tk), D_NO_VAL, 0, 0 );
-			}
-			else
-			{
-			    printf("O_STORE_D: %s with %lf\n",tk->text, value_f);
-			    push_stack(find_symbol(tk), D_VAL, 0, value_f );
-			}
-			return 1;
-
-    case O_ADD_I:	printf("O_ADD_I: %d\n", (int)(get_value_token(tk,_INT,0)));
-			if(tk->code!=SEMICOLON && tk->code!=COMMA)
-			{
-			    return (int)(get_value_token(tk,_INT,1))+op_code_execute(next_op(tk->next, _INT), tk->next->next, 0, 0, 0);
-			}
-			return 0;
-
-    case O_ADD_C:	printf("O_ADD_C: '%c'\n",(char)(get_value_token(tk,_CHAR,0)));
-			if(tk->code!=SEMICOLON && tk->code!=COMMA)
-			{
-			    return (char)(get_value_token(tk,_CHAR,1))+op_code_execute(next_op(tk->next, _CHAR), tk->next->next, 0, 0, 0);
-			}
-			return 0;
-			
-    case O_ADD_D: 	printf("O_ADD_D: %lf\n", (double)(get_value_token(tk,_DOUBLE,0)));
-    			if(tk->code!=SEMICOLON && tk->code!=COMMA)
-			{
-			    return (double)(get_value_token(tk,_DOUBLE,1))+op_code_execute(next_op(tk->next, _DOUBLE), tk->next->next, 0, 0, 0);
-			}
-			return 0;
-			
-    case O_SUB_I:	printf("O_SUB_I: %d\n", (int)(get_value_token(tk,_INT,0)));
-			if(tk->code!=SEMICOLON && tk->code!=COMMA)
-			{
-			    return (int)(get_value_token(tk,_INT,1))-op_code_execute(next_op(tk->next, _INT), tk->next->next, 0, 0, 0);
-			}
-			return 0;
-
-    case O_SUB_C:	printf("O_SUB_C: '%c'\n",(char)(get_value_token(tk,_CHAR,0)));
-			if(tk->code!=SEMICOLON && tk->code!=COMMA)
-			{
-			    return (char)(get_value_token(tk,_CHAR,1))-op_code_execute(next_op(tk->next, _CHAR), tk->next->next, 0, 0, 0);
-			}
-			return 0;
-			
-    case O_SUB_D:	printf("O_SUB_D: %lf\n", (double)(get_value_token(tk,_INT,0)));
-			if(tk->code!=SEMICOLON && tk->code!=COMMA)
-			{
-			    return (int)(get_value_token(tk,_INT,1))-op_code_execute(next_op(tk->next, _DOUBLE), tk->next->next, 0, 0, 0);
-			}
-			return 0;
+    if(sy->cls == STRUCT_FIELD || sy->cls == STRUCT_FIELD_VECTOR)
+	return tokens[nodes[sy->node].c].text;
+    return sy->struct_name;
+}
 
-    case O_MUL_I:	printf("O_MUL_I: %d\n",(int)(get_value_token(tk,_CHAR,0)));
-			if(tk->code!=SEMICOLON && tk->code!=COMMA)
-			{
-			    return (int)(get_value_token(tk,_INT,1))*op_code_execute(next_op(tk->next, _INT), tk->next->next, 0, 0, 0);
-			}
-			return 0;
-			
-    case O_MUL_C: 	printf("O_MUL_C: '%c'\n", (char)(get_value_token(tk,_CHAR,0)));
-    			if(tk->code!=SEMICOLON && tk->code!=COMMA)
-			{
-			    return (char)(get_value_token(tk,_DOUBLE,1))*op_code_execute(next_op(tk->next, _CHAR), tk->next->next, 0, 0, 0);
-			}
-			return 0;
-			
-    case O_MUL_D: 	printf("O_MUL_D: %lf\n", (double)(get_value_token(tk,_DOUBLE,0)));
-    			if(tk->code!=SEMICOLON && tk->code!=COMMA)
-			{
-			    return (double)(get_value_token(tk,_DOUBLE,1))*op_code_execute(next_op(tk->next, _DOUBLE), tk->next->next, 0, 0, 0);
-			}
-			return 0;
-			
-    case O_DIV_I: 	printf("O_DIV_I: %d\n", (int)(get_value_token(tk,_INT,0)));
-    			if(tk->code!=SEMICOLON && tk->code!=COMMA)
-			{
-			    return (int)(get_value_token(tk,_INT,1))/op_code_execute(next_op(tk->next, _INT), tk->next->next, 0, 0, 0);
-			}
-			return 0;
-			
-    case O_DIV_C: 	printf("O_DIV_C: '%c'\n",(char)(get_value_token(tk,_CHAR,0)));
-			if(tk->code!=SEMICOLON && tk->code!=COMMA)
-			{
-			    return (char)(get_value_token(tk,_CHAR,1))/op_code_execute(next_op(tk->next, _CHAR), tk->next->next, 0, 0, 0);
-			}
-			return 0;
-			
-    case O_DIV_D: 	printf("O_DIV_D: %lf\n", (double)(get_value_token(tk,_DOUBLE,0)));
-    			if(tk->code!=SEMICOLON && tk->code!=COMMA)
-			{
-			    return (double)(get_value_token(tk,_DOUBLE,1))/op_code_execute(next_op(tk->next, _DOUBLE), tk->next->next, 0, 0, 0);
-			}
-			return 0;
+//the slots of one element of a vector, or of a variable which is not a vector
+int element_slots(Symbol* sy)
+{
+    return sy->type == _STRUCT ? struct_slots(type_struct_name(sy)) : 1;
+}
 
-    case O_LOAD_I:	if(aux) // show load instruction message
-			    printf("O_LOAD_I: %s\n",tk->text);
-			return (int)(load_reg(tk->text));
-
-    case O_LOAD_C:	if(aux) // show load instruction message
-			    printf("O_LOAD_C: %s\n",tk->text);
-			return (char)(load_reg(tk->text));
-
-    case O_LOAD_D:	if(aux) // show load instruction message
-			    printf("O_LOAD_D: %s\n",tk->text);
-			return (double)(load_reg(tk->text));
-
-    case O_MODIFY_I:	printf("O_MODIFY_I: %s = %d\n",tk->text,value_i);
-			reg = find_reg(tk->text);
-			reg->value_i = value_i;
-			return 1;
-
-    case O_MODIFY_C:	printf("O_MODIFY_C: %s = '%c'\n",tk->text,(char)(value_i));
-			reg = find_reg(tk->text);
-			reg->value_i = (char)(value_i);
-			return 1;
-
-    case O_MODIFY_D:	printf("O_MODIFY_D: %s = %lf\n",tk->text, (double)(value_f));
-			reg = find_reg(tk->text);
-			reg->value_f = (double)(value_f);
-			return 1;
-
-    case O_LOAD_F:	printf("\n----START FUNC-----\n");
-			printf("O_LOAD_F: %s\n",tk->text);
-			tk=tk->next;
-			Symbol* f = find_symbol(tk->prev);
-			Token* func = f->tk;
-			//create a stack variable with the return value in which to store it
-			if(f->type == _INT)
-			    op_code_execute(O_STORE_I, func, I_NO_VAL, 0, 0);
-			else
-			    if(f->type == _DOUBLE)
-				op_code_execute(O_STORE_D, func, D_NO_VAL, 0, 0);
-			    else
-				if(f->type == _CHAR)
-				    op_code_execute(O_STORE_C, func, C_NO_VAL, 0, 0);
-			//push_args(func,tk); // push arguments of the function
-			crtTk=func->next;
-			//skip the already done part
-			while(!Tk_is(crtTk,RACC))
-			{
-			    op_code_find(crtTk);
-			    NEXT_TK
-			}
-			NEXT_TK
-			crtTk=tk;
-			return_func(func); //get the return value
-			printf("----END FUNC-----\n");
-			return 1;
+//the slots of a variable, a vector argument has only the address of the vector
+int symbol_slots(Symbol* sy)
+{
+    if(sy->cls == FUNCTION_ARGUMENT_VECTOR)
+	return 1;
+    if(sy->cls != VECTOR && sy->cls != STRUCT_FIELD_VECTOR)
+	return element_slots(sy);
+    return element_slots(sy) * vector_length(sy);
+}
 
-    case O_HALT: printf("O_HALT\n"); return neutral_el;
-    default: printf("OP CODE NOT FOUND!\n"); return -1;
-    }
+//the globals are the variables declared outside of the functions, the arguments are in the frame
+int is_global(Symbol* sy)
+{
+    return sy->depth == 0 && (sy->cls == VARIABLE || sy->cls == VECTOR);
 }
 
-//get the value from a certain variable
-double get_value_token(Token* tk, int type, int show_msg)
+//the variable gets its slots in the globals or in the frame of the function
+void place_variable(Symbol* sy)
 {
-    if(tk->code == CT_INT || tk->code == CT_CHAR)
-	return tk->i;
-    if(tk->code == CT_REAL)
-	return tk->r;
-    if(tk->code == ID)
+    if(gen_function == NULL)
     {
-	if(type == _INT)
-	    return op_code_execute(O_LOAD_I, tk, show_msg, 0, 0);
-	if(type == _CHAR)
-	    return op_code_execute(O_LOAD_C, tk, show_msg, 0, 0);
-	if(type == _DOUBLE)
-	    return op_code_execute(O_LOAD_D, tk, show_msg, 0, 0);
+	sy->slot = nr_globals;
+	nr_globals += symbol_slots(sy);
+	return;
     }
-    return -1;
+    sy->slot = nr_frame_slots;
+    nr_frame_slots += symbol_slots(sy);
+    if(nr_frame_slots > gen_function->nr_slots)
+	gen_function->nr_slots = nr_frame_slots;
 }
 
-//choose the op code based on certain criteria
-int op_code_find(Token* tk)
+//the type each node of an expression is converted to, set by the operator which uses it
+int* wanted=NULL;
+//the slots of the structures passed by value, their values are pushed instead of their address
+int* by_value=NULL;
+//the jumps after the left operands of AND/OR waiting for their operator
+int* pending_jumps=NULL;
+int cap_wanted=0;
+
+//the nodes which leave a value on the stack: the basic types and the addresses of the structures and vectors
+int pushes_value(int n)
 {
-    int correct=1;
+    if(nodes[n].kind == N_CALL) // a structure is not returned
+	return has_value(nodes[n].type);
+    return has_value(nodes[n].type) || nodes[n].type == _STRUCT;
+}
 
-    //predifined functions
+//the type the operands of a binary operator are converted to
+int operand_type(int n)
+{
+    int code = node_tk(n)->code;
+    if(code == AND || code == OR)
+	return TRUTH;
+    if(binary_precedence(code) < binary_precedence(ADD)) // comparisons
+	return nodes[nodes[n].a].type == _DOUBLE || nodes[nodes[n].b].type == _DOUBLE ? _DOUBLE : _INT;
+    return nodes[n].type;
+}
 
-    if(tk->code == ID && strcmp(tk->text,"put_i")==0)
+//the instruction of a predefined function, O_POP for put_s and get_s which only drop their arguments
+int predefined_op(Symbol* f)
+{
+    switch(f->name_id)
     {
-	int value_int = (int) get_value_token(tk->next->next, _INT, 1);
-	printf("%d\n",value_int);
-	NEXT_TK
-	return 1;
+	case NAME_PUT_I: return O_PUT_I;
+	case NAME_PUT_D: return O_PUT_D;
+	case NAME_PUT_C: return O_PUT_C;
+	case NAME_GET_I: return O_GET_I;
+	case NAME_GET_D: return O_GET_D;
+	case NAME_GET_C: return O_GET_C;
+	case NAME_SECONDS: return O_SECONDS;
+	default: return O_POP;
     }
+}
 
-    if(tk->code == ID && strcmp(tk->text,"put_d")==0)
+//the arguments are already on the stack where the frame of the function starts, the predefined functions are instructions
+void gen_call(int n)
+{
+    Symbol* f = node_symbol(n);
+    if(f->line >= 0)
     {
-	double value_float = (double) get_value_token(tk->next->next, _DOUBLE, 1);
-	printf("%lf\n",value_float);
-	NEXT_TK
-	return 1;
+	emit(O_CALL, nodes[n].tk, 0); // the addresses of the functions are set after all are generated
+	return;
     }
-
-    if(tk->code == ID && strcmp(tk->text,"put_c")==0)
+    int op = predefined_op(f);
+    if(op == O_POP) // put_s and get_s, the strings are not stored
     {
-	int value_int = (char) get_value_token(tk->next->next, _CHAR, 1);
-	printf("%c\n",(char) value_int);
-	NEXT_TK
-	return 1;
+	if(nodes[n].c > 0)
+	    emit(O_POP, nodes[n].tk, nodes[n].c);
+	return;
     }
+    emit(op, nodes[n].tk, 0);
+}
 
-    //skip function declarations except main
-    if(tk->code == ID && strcmp(tk->text,"main")!=0  && find_symbol(tk)->cls == FUNCTION && (tk->prev->code == INT || tk->prev->code== VOID || tk->prev->code== CHAR || tk->prev->code == DOUBLE))
-    {
-	while(!consume(RACC))
-	    NEXT_TK
-	return 1;
-    }
+//push a variable: the value of a basic type, the address of a vector or a structure
+void gen_name(int n, int want)
+{
+    Symbol* sy = bindings[nodes[n].tk];
+    if(sy->cls == FUNCTION_ARGUMENT_VECTOR) // its slot has the address of the vector
+	emit(O_LOAD_I, nodes[n].tk, sy->slot);
+    else if(want != ADDRESS && has_value(sy->type) && (sy->cls == VARIABLE || sy->cls == FUNCTION_ARGUMENT))
+	emit(typed_op(is_global(sy) ? O_LOAD_GLOBAL_I : O_LOAD_I, sy->type), nodes[n].tk, sy->slot);
+    else
+	emit(is_global(sy) ? O_ADDR_GLOBAL : O_ADDR, nodes[n].tk, sy->slot);
+}
 
-    // Load a function
-    if(tk->code == ID && find_symbol(tk)->cls == FUNCTION && (tk->prev->code!=INT && tk->prev->code!= VOID && tk->prev->code!= CHAR && tk->prev->code!= DOUBLE))
+//generate the code of an operator or term, its operands are already on the stack
+void gen_term(int n, int want, int *nr_jumps)
+{
+    Token* tk = node_tk(n);
+    switch(nodes[n].kind)
     {
-	while(!consume(RACC))
-	    NEXT_TK
-	return op_code_execute(O_LOAD_F,tk,0, 0, 0);
-    }
-
-    //store variables - add them to the stack
-    if(tk->code == ID && find_symbol(tk)->cls == VARIABLE && (tk->prev->code==INT || tk->prev->code==CHAR || tk->prev->code==DOUBLE))
+	case N_CONST:
+	    if(tk->code == CT_REAL)
+		emit_d(nodes[n].tk, tk->r);
+	    else
+		emit(O_CONST_I, nodes[n].tk, tk->code == CT_STRING ? 0 : (int)tk->i);
+	    break;
+	case N_NAME: gen_name(n, want); break;
+	case N_INDEX: // the address of the vector and the index are on the stack
+	{
+	    Symbol* sy = node_symbol(n);
+	    emit(O_INDEX, nodes[n].tk, element_slots(sy));
+	    if(want != ADDRESS && has_value(nodes[n].type))
+		emit(typed_op(O_LOAD_AT_I, nodes[n].type), nodes[n].tk, 0);
+	    break;
+	}
+	case N_FIELD: // the address of the structure is on the stack
+	{
+	    Symbol* sy = bindings[nodes[n].tk];
+	    emit(O_FIELD, nodes[n].tk, sy->slot);
+	    if(want != ADDRESS && has_value(nodes[n].type) && sy->cls == STRUCT_FIELD)
+		emit(typed_op(O_LOAD_AT_I, nodes[n].type), nodes[n].tk, 0);
+	    break;
+	}
+	case N_CALL: gen_call(n); break;
+	case N_CAST: break; // the operand was converted to the type of the cast
+	case N_UNARY:
+	    if(tk->code == NOT)
+		emit(O_NOT_I, nodes[n].tk, 0);
+	    else if(nodes[n].type == _DOUBLE)
+		emit(O_NEG_D, nodes[n].tk, 0);
+	    else
+	    {
+		emit(O_NEG_I, nodes[n].tk, 0);
+		gen_convert(_INT, nodes[n].type, nodes[n].tk); // -c is a char again
+	    }
+	    break;
+	case N_BINARY:
+	    if(tk->code == AND || tk->code == OR)
+	    {
+		//a && b: a; JF false; b; JF false; 1; JMP end; false: 0; end:  (|| with JT and the values swapped)
+		int left = pending_jumps[--(*nr_jumps)];
+		int right = emit(tk->code == AND ? O_JF : O_JT, nodes[n].tk, 0);
+		emit(O_CONST_I, nodes[n].tk, tk->code == AND);
+		int end = emit(O_JMP, nodes[n].tk, 0);
+		patch(left);
+		patch(right);
+		emit(O_CONST_I, nodes[n].tk, tk->code != AND);
+		patch(end);
+	    }
+	    else if(binary_precedence(tk->code) < binary_precedence(ADD))
+		emit(compare_op(tk->code, operand_type(n)), nodes[n].tk, 0);
+	    else
+		emit(arith_op(tk->code, nodes[n].type), nodes[n].tk, 0);
+	    break;
+    }
+}
+
+//the operators tell their operands the type they need, returns the slots of the structures passed by value
+int expr_wanted(int expr, int type)
+{
+    int first = nodes[expr].b;
+    int root = nodes[expr].a;
+    int size = root - first + 1;
+    if(cap_wanted < size)
+    {
+	cap_wanted = size * 2;
+	wanted = (int*)realloc(wanted, sizeof(int) * cap_wanted);
+	pending_jumps = (int*)realloc(pending_jumps, sizeof(int) * cap_wanted);
+	by_value = (int*)realloc(by_value, sizeof(int) * cap_wanted);
+	if(wanted == NULL || pending_jumps == NULL || by_value == NULL)
+	    err("not enough memory");
+    }
+    //the operators tell their operands the type they need
+    int struct_values = 0;
+    for(int n = first; n <= root; n++)
+    {
+	wanted[n - first] = KEEP_TYPE;
+	by_value[n - first] = 0;
+    }
+    wanted[root - first] = type;
+    for(int n = first; n <= root; n++)
+    {
+	switch(nodes[n].kind)
+	{
+	    case N_BINARY:
+		wanted[nodes[n].a - first] = wanted[nodes[n].b - first] = operand_type(n);
+		if(node_tk(n)->code == AND)
+		    wanted[nodes[n].a - first] = LEFT_OF_AND;
+		else if(node_tk(n)->code == OR)
+		    wanted[nodes[n].a - first] = LEFT_OF_OR;
+		break;
+	    case N_UNARY:
+		wanted[nodes[n].a - first] = node_tk(n)->code == NOT ? TRUTH : nodes[n].type;
+		break;
+	    case N_CAST:
+		wanted[nodes[n].a - first] = nodes[n].type;
+		break;
+	    case N_INDEX:
+		wanted[nodes[n].a - first] = ADDRESS;
+		wanted[nodes[n].b - first] = _INT;
+		break;
+	    case N_FIELD:
+		wanted[nodes[n].a - first] = ADDRESS;
+		break;
+	    case N_CALL:
+	    {
+		Symbol* f = node_symbol(n);
+		int index = 0;
+		for(int arg = nodes[n].a; arg != 0; arg = nodes[arg].next, index++)
+		{
+		    if(f->args[index]->cls != FUNCTION_ARGUMENT)
+			continue;
+		    wanted[arg - first] = f->args[index]->type;
+		    if(f->args[index]->type == _STRUCT)
+		    {
+			by_value[arg - first] = element_slots(f->args[index]);
+			struct_values += by_value[arg - first];
+		    }
+		}
+		break;
+	    }
+	}
+    }
+    return struct_values;
+}
+
+//generate the code of an expression with its value converted to the given type (or its ADDRESS), the nodes are in postfix order
+void gen_expr(int expr, int type)
+{
+    int first = nodes[expr].b;
+    int root = nodes[expr].a;
+    int size = root - first + 1;
+    int struct_values = expr_wanted(expr, type);
+    //every value (and the constants of the conditions) may be on the stack at the same time
+    if(2 * size + 2 + struct_values > max_stack)
+	max_stack = 2 * size + 2 + struct_values;
+
+    int nr_jumps = 0;
+    for(int n = first; n <= root; n++)
+    {
+	int want = wanted[n - first];
+	gen_term(n, want, &nr_jumps);
+	if(want == LEFT_OF_AND || want == LEFT_OF_OR) // the left operand decides if the right one is evaluated
+	{
+	    gen_convert(nodes[n].type, TRUTH, nodes[n].tk);
+	    pending_jumps[nr_jumps++] = emit(want == LEFT_OF_AND ? O_JF : O_JT, nodes[n].tk, 0);
+	}
+	else
+	    gen_convert(nodes[n].type, want, nodes[n].tk);
+	if(by_value[n - first] > 0)
+	    emit(O_LOAD_STRUCT, nodes[n].tk, by_value[n - first]);
+    }
+}
+
+void gen_nodes(int n);
+
+//a declared variable gets its slots, a basic type is initialized
+void gen_var(int n)
+{
+    Symbol* sy = bindings[nodes[n].tk];
+    place_variable(sy);
+    if(sy->cls != VARIABLE || !has_value(sy->type)) // the vectors and the structures start with zeros
+	return;
+    if(nodes[n].b != 0) // int/char/double x = value
+	gen_expr(nodes[n].b, sy->type);
+    else
+	gen_zero(sy->type, nodes[n].tk);
+    emit(typed_op(is_global(sy) ? O_STORE_GLOBAL_I : O_STORE_I, sy->type), nodes[n].tk, sy->slot);
+}
+
+//modify variables - a basic type directly in its slot, the elements and the fields at their address
+void gen_assign(int n)
+{
+    int dest = nodes[nodes[n].a].a;
+    Symbol* sy = node_symbol(dest);
+    int value = nodes[n].b;
+    if(nodes[value].kind == N_ASSIGN) // x = y = value, x receives the value of y
+    {
+	gen_assign(value);
+	value = nodes[value].a;
+    }
+    if(nodes[dest].kind == N_NAME && has_value(sy->type) && (sy->cls == VARIABLE || sy->cls == FUNCTION_ARGUMENT))
+    {
+	gen_expr(value, sy->type);
+	emit(typed_op(is_global(sy) ? O_MODIFY_GLOBAL_I : O_MODIFY_I, sy->type), nodes[dest].tk, sy->slot);
+	return;
+    }
+    gen_expr(nodes[n].a, ADDRESS);
+    gen_expr(value, nodes[dest].type);
+    if(has_value(nodes[dest].type))
+	emit(typed_op(O_MODIFY_AT_I, nodes[dest].type), nodes[n].tk, 0);
+    else if(pushes_value(nodes[value].a)) // a structure is copied
+	emit(O_COPY, nodes[n].tk, element_slots(sy));
+    else
+	emit(O_POP, nodes[n].tk, 1);
+}
+
+//the value of the return is left on the stack for the caller
+void gen_return(int n)
+{
+    int type = gen_function->type;
+    if(nodes[n].a == 0)
+	gen_zero(type, nodes[n].tk);
+    else
+    {
+	gen_expr(nodes[n].a, has_value(type) ? type : KEEP_TYPE);
+	if(!has_value(type) && pushes_value(nodes[nodes[n].a].a))
+	    emit(O_POP, nodes[n].tk, 1);
+    }
+    emit(O_RET, nodes[n].tk, has_value(type));
+}
+
+//the jumps of the break instructions waiting for the end of their loop
+int* break_jumps=NULL;
+int nr_breaks=0;
+int cap_breaks=0;
+int loop_depth=0;
+
+//a break jumps after the innermost loop
+void gen_break(int n)
+{
+    if(loop_depth == 0)
+	tkerr(node_tk(n), "break outside of a loop");
+    if(nr_breaks == cap_breaks)
+    {
+	cap_breaks = cap_breaks ? cap_breaks * 2 : 64;
+	break_jumps = (int*)realloc(break_jumps, sizeof(int) * cap_breaks);
+	if(break_jumps == NULL)
+	    err("not enough memory");
+    }
+    break_jumps[nr_breaks++] = emit(O_JMP, nodes[n].tk, 0);
+}
+
+//if(cond) a else b:  cond; JF else; a; JMP end; else: b; end:
+void gen_if(int n)
+{
+    gen_expr(nodes[n].a, TRUTH);
+    int if_false = emit(O_JF, nodes[n].tk, 0);
+    gen_nodes(nodes[n].b);
+    if(nodes[n].c == 0)
+    {
+	patch(if_false);
+	return;
+    }
+    int end = emit(O_JMP, nodes[n].tk, 0);
+    patch(if_false);
+    gen_nodes(nodes[n].c);
+    patch(end);
+}
+
+/* the condition of a loop is after its body, so an iteration has a single jump:
+   init; JMP cond; body: instructions; modification; cond: cond; JT body; end:
+   the breaks of the loop are patched to its end */
+void gen_loop(int n, int cond, int body, int modification)
+{
+    int breaks = nr_breaks;
+    int to_cond = emit(O_JMP, nodes[n].tk, 0);
+    int start = nr_instr;
+    loop_depth++;
+    gen_nodes(body);
+    loop_depth--;
+    gen_nodes(modification);
+    patch(to_cond);
+    gen_expr(cond, TRUTH);
+    emit(O_JT, nodes[n].tk, start);
+    for(; nr_breaks > breaks; nr_breaks--)
+	patch(break_jumps[nr_breaks - 1]);
+}
+
+//generate the code of a node
+void gen_node(int n)
+{
+    switch(nodes[n].kind)
+    {
+	case N_VAR: gen_var(n); break;
+	case N_ASSIGN: gen_assign(n); break;
+	case N_RETURN: gen_return(n); break;
+	case N_EXPR:
+	    gen_expr(n, KEEP_TYPE);
+	    if(pushes_value(nodes[n].a))
+		emit(O_POP, nodes[n].tk, 1);
+	    break;
+	case N_BLOCK:
+	{
+	    int slots = nr_frame_slots; // the slots of the variables of the block are used again after it
+	    gen_nodes(nodes[n].a);
+	    nr_frame_slots = slots;
+	    break;
+	}
+	case N_IF: gen_if(n); break;
+	case N_WHILE: gen_loop(n, nodes[n].a, nodes[n].b, 0); break;
+	case N_FOR:
+	    gen_nodes(nodes[n].a);
+	    gen_loop(n, nodes[n].b, nodes[n].d, nodes[n].c);
+	    break;
+	case N_BREAK: gen_break(n); break;
+    }
+}
+
+//generate the code of a list of nodes
+void gen_nodes(int n)
+{
+    for(; n != 0; n = nodes[n].next)
+	gen_node(n);
+}
+
+//generate the body of a function, its arguments have the first slots of the frame (the caller pushed them there)
+void gen_func(int n)
+{
+    gen_function = bindings[nodes[n].tk];
+    gen_function->entry = nr_instr;
+    gen_function->nr_slots = 0;
+    nr_frame_slots = 0;
+    for(int arg = nodes[n].a; arg != 0; arg = nodes[arg].next)
+	place_variable(bindings[nodes[arg].tk]);
+    int enter = emit(O_ENTER, nodes[n].tk, 0);
+    bytecode[enter].j = nr_frame_slots; // the arguments
+    gen_nodes(nodes[n].b);
+    //a function without return gives the zero of its type
+    gen_zero(gen_function->type, nodes[n].tk);
+    emit(O_RET, nodes[n].tk, has_value(gen_function->type));
+    bytecode[enter].i = gen_function->nr_slots;
+    gen_function = NULL;
+}
+
+//print the bytecode with the addresses of the instructions
+void print_bytecode()
+{
+    printf("\nBytecode:\n");
+    for(int pc = 0; pc < nr_instr; pc++)
+    {
+	Instr* ins = &bytecode[pc];
+	printf("%6d  %-18s", pc, print_op(ins->op));
+	switch(ins->op)
+	{
+	    case O_CONST_D: printf("%lf", ins->d); break;
+	    case O_JMP: case O_JF: case O_JT: printf("-> %d", ins->i); break;
+	    case O_CALL: printf("%s -> %d", tokens[ins->tk].text, ins->i); break;
+	    case O_STORE_I: case O_STORE_C: case O_STORE_D:
+	    case O_LOAD_I: case O_LOAD_C: case O_LOAD_D:
+	    case O_MODIFY_I: case O_MODIFY_C: case O_MODIFY_D:
+	    case O_STORE_GLOBAL_I: case O_STORE_GLOBAL_C: case O_STORE_GLOBAL_D:
+	    case O_LOAD_GLOBAL_I: case O_LOAD_GLOBAL_C: case O_LOAD_GLOBAL_D:
+	    case O_MODIFY_GLOBAL_I: case O_MODIFY_GLOBAL_C: case O_MODIFY_GLOBAL_D:
+	    case O_ADDR: case O_ADDR_GLOBAL: // the values of the SSA form have no name
+		printf("%s [%d]", tokens[ins->tk].text ? tokens[ins->tk].text : "", ins->i);
+		break;
+	    case O_ENTER: printf("%d slots, %d for arguments", ins->i, ins->j); break;
+	    case O_CONST_I: case O_POP: case O_INDEX: case O_FIELD: case O_COPY: case O_LOAD_STRUCT: case O_RET:
+	    case O_SHL_I: case O_SHR_I: case O_USHR_I: case O_MULHI_I: printf("%d", ins->i); break;
+	    case O_VECTOR:
+		printf("%s%s%s", print_op(ins->i & 0xFF), ins->i & VECTOR_SCALAR_A ? " scalar a" : "", ins->i & VECTOR_SCALAR_B ? " scalar b" : "");
+		break;
+	}
+	printf("\n");
+    }
+    printf("\n");
+}
+
+/*						*
+ *		   SSA Form			*
+ *						*/
+
+/* with -O the functions are compiled through a typed SSA form: every value is defined by a single
+   instruction, the instructions are in basic blocks which end with a jump, a branch or a return, and
+   a variable assigned in several blocks gets a phi in the block where they meet. Only the locals of
+   the basic types become values; the vectors, the structures and the globals are read and written
+   by explicit loads and stores at their addresses. The passes change the blocks of the functions,
+   then every function is generated to bytecode again, so the machine code backends get the result */
+
+double seconds();
+
+#define IR_ADDRESS 5 // the type of the addresses of the vectors, the structures and their elements
+
+enum IrOp {
+    I_CONST, // a constant of the type of the instruction
+    I_PARAM, // an argument of the function of a basic type or the address of a vector, i = its slot
+    I_PHI, // the value from the predecessor of the block with the same index as the operand
+    I_ADD, I_SUB, I_MUL, I_DIV, // the arithmetic in the type of the instruction
+    I_NEG, I_NOT,
+    I_SHL, I_SHR, I_USHR, I_MULHI, // the int shifted by i (as unsigned for ushr), the upper half of its product by i
+    I_EQUAL, I_NOTEQ, I_LESS, I_LESSEQ, I_GREATER, I_GREATEREQ, // an integer 0 or 1
+    I_CONV, // the operand converted to the type of the instruction
+    I_ADDR, // the address of the vector or the structure sy
+    I_FRAME, // the address of the slots of the frame from i which are not a variable (a copy of a structure)
+    I_INDEX, // the address of an element: the address + the index * i
+    I_FIELD, // the address of a field: the address + i
+    I_LOAD, // the value at the address
+    I_STORE, // the second operand is stored at the address given by the first
+    I_LOAD_GLOBAL, // the value of the global sy
+    I_STORE_GLOBAL, // the operand is stored in the global sy
+    I_COPY, // i slots of a structure are copied from the second address to the first
+    I_VECTOR, // O_VECTOR with i as its op code: the vectors or values d, a, b, the start and the end
+    I_CALL, // calls sy with the operands as arguments
+    I_JMP, // jumps to target[0]
+    I_BR, // jumps to target[0] if the operand is not 0, else to target[1]
+    I_RET, // returns the operand, if there is one
+};
+
+char* ir_op_name(int op)
+{
+    switch(op)
+    {
+	case I_CONST: return "const";
+	case I_PARAM: return "param";
+	case I_PHI: return "phi";
+	case I_ADD: return "add";
+	case I_SUB: return "sub";
+	case I_MUL: return "mul";
+	case I_DIV: return "div";
+	case I_NEG: return "neg";
+	case I_NOT: return "not";
+	case I_SHL: return "shl";
+	case I_SHR: return "shr";
+	case I_USHR: return "ushr";
+	case I_MULHI: return "mulhi";
+	case I_EQUAL: return "equal";
+	case I_NOTEQ: return "noteq";
+	case I_LESS: return "less";
+	case I_LESSEQ: return "lesseq";
+	case I_GREATER: return "greater";
+	case I_GREATEREQ: return "greatereq";
+	case I_CONV: return "conv";
+	case I_ADDR: return "addr";
+	case I_FRAME: return "frame";
+	case I_INDEX: return "index";
+	case I_FIELD: return "field";
+	case I_LOAD: return "load";
+	case I_STORE: return "store";
+	case I_LOAD_GLOBAL: return "load_global";
+	case I_STORE_GLOBAL: return "store_global";
+	case I_COPY: return "copy";
+	case I_VECTOR: return "vector";
+	case I_CALL: return "call";
+	case I_JMP: return "jmp";
+	case I_BR: return "br";
+	case I_RET: return "ret";
+	default: return "?";
+    }
+}
+
+char* ir_type_name(int type)
+{
+    switch(type)
+    {
+	case _INT: return "int";
+	case _CHAR: return "char";
+	case _DOUBLE: return "double";
+	case IR_ADDRESS: return "addr";
+	default: return "void";
+    }
+}
+
+/* the instructions of all the functions are in one arena and are referred by their index (0 is no
+   instruction), a block has a list of them; the value of an instruction is referred by its index */
+typedef struct IrInstr{
+    int op; // IrOp
+    int type; // of the value: _INT, _CHAR, _DOUBLE, IR_ADDRESS or _VOID when there is none
+    int tk; // the token in the source, for the names and the lines of the errors
+    int block;
+    int prev, next; // in the block
+    int* args; // the operands
+    int nr_args;
+    int cap_args;
+    int target[2]; // the blocks of I_JMP and I_BR
+    int forward; // a removed instruction whose value is the one of another
+    Symbol* sy;
+    union{
+	int i;
+	double d;
+    };
+}IrInstr;
+
+typedef struct IrBlock{
+    int first, last; // the instructions, the phis are the first ones and the jump or return is the last
+    int* preds; // the blocks which jump here, a block which branches twice here is twice
+    int nr_preds;
+    int cap_preds;
+    int dead; // removed from its function
+    int sealed; // all the predecessors are known, while the function is built
+    int* defs; // the value of each variable at the end of the block, while the function is built
+    int* incomplete; // the phis made before the block was sealed, with their variables
+    int nr_incomplete;
+    int cap_incomplete;
+    int idom; // the immediate dominator, the entry has itself
+    int dom_first, dom_last; // the number of the block in a depth first walk of the dominator tree, and of its last descendant
+    int rpo; // the position in the reverse postorder, -1 when the block can not be reached
+    int link; // used by the passes
+}IrBlock;
+
+typedef struct IrFunction{
+    Symbol* sy;
+    int node;
+    int* blocks; // in the order of the code, the first is the entry
+    int nr_blocks;
+    int cap_blocks;
+    int arg_slots; // the first slots of the frame, filled by the caller
+}IrFunction;
+
+IrInstr* ir=NULL;
+int nr_ir=1;
+int cap_ir=0;
+IrBlock* ir_blocks=NULL;
+int nr_ir_blocks=1;
+int cap_ir_blocks=0;
+IrFunction* ir_functions=NULL;
+int nr_ir_functions=0;
+
+IrFunction* ir_fn=NULL; // the function being built or changed
+int ir_current=0; // the block where the instructions are added
+
+//the local variables of the basic types of the function being built, by their ir_var
+Symbol** ir_vars=NULL;
+int nr_ir_vars=0;
+int cap_ir_vars=0;
+
+int ir_new(int op, int type, int tk)
+{
+    if(nr_ir >= cap_ir)
+    {
+	cap_ir = cap_ir ? cap_ir * 2 : 4096;
+	ir = (IrInstr*)realloc(ir, sizeof(IrInstr) * cap_ir);
+	if(ir == NULL)
+	    err("not enough memory");
+	if(nr_ir == 1) // 0 is no instruction
+	    memset(&ir[0], 0, sizeof(IrInstr));
+    }
+    IrInstr* x = &ir[nr_ir];
+    memset(x, 0, sizeof(IrInstr));
+    x->op = op;
+    x->type = type;
+    x->tk = tk;
+    return nr_ir++;
+}
+
+void ir_arg(int x, int v)
+{
+    IrInstr* in = &ir[x];
+    if(in->nr_args == in->cap_args)
+    {
+	in->cap_args = in->cap_args ? in->cap_args * 2 : 2;
+	in->args = (int*)realloc(in->args, sizeof(int) * in->cap_args);
+	if(in->args == NULL)
+	    err("not enough memory");
+    }
+    in->args[in->nr_args++] = v;
+}
+
+//the value of an instruction, following the removed ones
+int ir_resolve(int v)
+{
+    while(v != 0 && ir[v].forward != 0)
+	v = ir[v].forward;
+    return v;
+}
+
+void ir_append(int b, int x)
+{
+    ir[x].block = b;
+    ir[x].prev = ir_blocks[b].last;
+    ir[x].next = 0;
+    if(ir_blocks[b].last)
+	ir[ir_blocks[b].last].next = x;
+    else
+	ir_blocks[b].first = x;
+    ir_blocks[b].last = x;
+}
+
+void ir_insert_before(int at, int x)
+{
+    int b = ir[at].block;
+    ir[x].block = b;
+    ir[x].next = at;
+    ir[x].prev = ir[at].prev;
+    if(ir[at].prev)
+	ir[ir[at].prev].next = x;
+    else
+	ir_blocks[b].first = x;
+    ir[at].prev = x;
+}
+
+//the instruction leaves its block
+void ir_unlink(int x)
+{
+    int b = ir[x].block;
+    if(ir[x].prev)
+	ir[ir[x].prev].next = ir[x].next;
+    else
+	ir_blocks[b].first = ir[x].next;
+    if(ir[x].next)
+	ir[ir[x].next].prev = ir[x].prev;
+    else
+	ir_blocks[b].last = ir[x].prev;
+    ir[x].prev = ir[x].next = 0;
+}
+
+//an instruction is replaced by a value and removed
+void ir_replace(int x, int v)
+{
+    if(ir[x].block != 0)
+	ir_unlink(x);
+    ir[x].forward = v;
+}
+
+//the first instruction of a block which is not a phi
+int ir_after_phis(int b)
+{
+    int x = ir_blocks[b].first;
+    while(x != 0 && ir[x].op == I_PHI)
+	x = ir[x].next;
+    return x;
+}
+
+int ir_is_terminator(int op)
+{
+    return op == I_JMP || op == I_BR || op == I_RET;
+}
+
+//the jumps of the block, 0, 1 or 2
+int ir_succs(int b, int* succ)
+{
+    int x = ir_blocks[b].last;
+    if(x == 0)
+	return 0;
+    if(ir[x].op == I_JMP)
+    {
+	succ[0] = ir[x].target[0];
+	return 1;
+    }
+    if(ir[x].op == I_BR)
+    {
+	succ[0] = ir[x].target[0];
+	succ[1] = ir[x].target[1];
+	return 2;
+    }
+    return 0;
+}
+
+int ir_new_block()
+{
+    if(nr_ir_blocks >= cap_ir_blocks)
+    {
+	cap_ir_blocks = cap_ir_blocks ? cap_ir_blocks * 2 : 1024;
+	ir_blocks = (IrBlock*)realloc(ir_blocks, sizeof(IrBlock) * cap_ir_blocks);
+	if(ir_blocks == NULL)
+	    err("not enough memory");
+	if(nr_ir_blocks == 1) // 0 is no block
+	    memset(&ir_blocks[0], 0, sizeof(IrBlock));
+    }
+    memset(&ir_blocks[nr_ir_blocks], 0, sizeof(IrBlock));
+    return nr_ir_blocks++;
+}
+
+//the block is added at the end of the code of the function
+void ir_place(IrFunction* f, int b)
+{
+    if(f->nr_blocks == f->cap_blocks)
+    {
+	f->cap_blocks = f->cap_blocks ? f->cap_blocks * 2 : 16;
+	f->blocks = (int*)realloc(f->blocks, sizeof(int) * f->cap_blocks);
+	if(f->blocks == NULL)
+	    err("not enough memory");
+    }
+    f->blocks[f->nr_blocks++] = b;
+}
+
+void ir_add_pred(int b, int pred)
+{
+    IrBlock* bl = &ir_blocks[b];
+    if(bl->nr_preds == bl->cap_preds)
+    {
+	bl->cap_preds = bl->cap_preds ? bl->cap_preds * 2 : 2;
+	bl->preds = (int*)realloc(bl->preds, sizeof(int) * bl->cap_preds);
+	if(bl->preds == NULL)
+	    err("not enough memory");
+    }
+    bl->preds[bl->nr_preds++] = pred;
+}
+
+//the predecessor with the given index is removed, with the operands of the phis which come from it
+void ir_remove_pred(int b, int index)
+{
+    IrBlock* bl = &ir_blocks[b];
+    for(int k = index; k + 1 < bl->nr_preds; k++)
+	bl->preds[k] = bl->preds[k + 1];
+    bl->nr_preds--;
+    for(int x = bl->first; x != 0 && ir[x].op == I_PHI; x = ir[x].next)
+    {
+	for(int k = index; k + 1 < ir[x].nr_args; k++)
+	    ir[x].args[k] = ir[x].args[k + 1];
+	ir[x].nr_args--;
+    }
+}
+
+int ir_pred_index(int b, int pred)
+{
+    for(int k = 0; k < ir_blocks[b].nr_preds; k++)
+	if(ir_blocks[b].preds[k] == pred)
+	    return k;
+    return -1;
+}
+
+/*  the analyses of the control flow: the reverse postorder of the blocks which can be reached from
+    the entry and their immediate dominators (Cooper, Harvey and Kennedy) */
+int* ir_order=NULL; // the blocks in reverse postorder
+int nr_ir_order=0;
+int cap_ir_order=0;
+
+void ir_compute_order(IrFunction* f)
+{
+    if(cap_ir_order < f->nr_blocks)
+    {
+	cap_ir_order = f->nr_blocks * 2;
+	ir_order = (int*)realloc(ir_order, sizeof(int) * cap_ir_order);
+	if(ir_order == NULL)
+	    err("not enough memory");
+    }
+    for(int k = 0; k < f->nr_blocks; k++)
+    {
+	ir_blocks[f->blocks[k]].rpo = -1;
+	ir_blocks[f->blocks[k]].link = 0; // the next successor to visit
+    }
+    //a depth first search without recursion, the stack is in the end of ir_order
+    int* stack = (int*)malloc(sizeof(int) * (f->nr_blocks + 1));
+    if(stack == NULL)
+	err("not enough memory");
+    int height = 0, done = f->nr_blocks;
+    stack[height++] = f->blocks[0];
+    ir_blocks[f->blocks[0]].rpo = 0;
+    while(height > 0)
+    {
+	int b = stack[height - 1];
+	int succ[2];
+	int nr = ir_succs(b, succ);
+	if(ir_blocks[b].link < nr)
+	{
+	    int s = succ[ir_blocks[b].link++];
+	    if(ir_blocks[s].rpo < 0)
+	    {
+		ir_blocks[s].rpo = 0;
+		stack[height++] = s;
+	    }
+	    continue;
+	}
+	height--;
+	ir_order[--done] = b; // the postorder from the end
+    }
+    free(stack);
+    nr_ir_order = f->nr_blocks - done;
+    memmove(ir_order, ir_order + done, sizeof(int) * nr_ir_order);
+    for(int k = 0; k < nr_ir_order; k++)
+	ir_blocks[ir_order[k]].rpo = k;
+}
+
+int ir_intersect(int a, int b)
+{
+    while(a != b)
+    {
+	while(ir_blocks[a].rpo > ir_blocks[b].rpo)
+	    a = ir_blocks[a].idom;
+	while(ir_blocks[b].rpo > ir_blocks[a].rpo)
+	    b = ir_blocks[b].idom;
+    }
+    return a;
+}
+
+void ir_compute_dominators(IrFunction* f)
+{
+    ir_compute_order(f);
+    for(int k = 0; k < nr_ir_order; k++)
+	ir_blocks[ir_order[k]].idom = 0;
+    int entry = ir_order[0];
+    ir_blocks[entry].idom = entry;
+    int changed = 1;
+    while(changed)
+    {
+	changed = 0;
+	for(int k = 1; k < nr_ir_order; k++)
+	{
+	    int b = ir_order[k];
+	    int idom = 0;
+	    for(int p = 0; p < ir_blocks[b].nr_preds; p++)
+	    {
+		int pred = ir_blocks[b].preds[p];
+		if(ir_blocks[pred].rpo < 0 || ir_blocks[pred].idom == 0)
+		    continue;
+		idom = idom == 0 ? pred : ir_intersect(pred, idom);
+	    }
+	    if(idom != ir_blocks[b].idom)
+	    {
+		ir_blocks[b].idom = idom;
+		changed = 1;
+	    }
+	}
+    }
+    //the dominator tree is numbered without recursion, its children are lists in the order of the blocks
+    int* child = (int*)malloc(sizeof(int) * (3 * nr_ir_order + 1));
+    if(child == NULL)
+	err("not enough memory");
+    int* sibling = child + nr_ir_order;
+    int* stack = sibling + nr_ir_order;
+    for(int k = 0; k < nr_ir_order; k++)
+	child[k] = -1;
+    for(int k = nr_ir_order - 1; k > 0; k--)
+    {
+	int parent = ir_blocks[ir_blocks[ir_order[k]].idom].rpo;
+	sibling[k] = child[parent];
+	child[parent] = k;
+    }
+    int height = 0, number = 0;
+    stack[height++] = 0;
+    ir_blocks[entry].dom_first = number++;
+    while(height > 0)
+    {
+	int k = stack[height - 1];
+	if(child[k] < 0)
+	{
+	    ir_blocks[ir_order[k]].dom_last = number - 1;
+	    height--;
+	    continue;
+	}
+	int c = child[k];
+	child[k] = sibling[c];
+	ir_blocks[ir_order[c]].dom_first = number++;
+	stack[height++] = c;
+    }
+    free(child);
+}
+
+//the blocks which can not be reached only dominate themselves
+int ir_dominates(int a, int b)
+{
+    if(ir_blocks[a].rpo < 0 || ir_blocks[b].rpo < 0)
+	return a == b;
+    return ir_blocks[a].dom_first <= ir_blocks[b].dom_first && ir_blocks[b].dom_first <= ir_blocks[a].dom_last;
+}
+
+/*  the SSA form is built while the tree is lowered (Braun, Buchwald, Hack, Leissa, Mallon and Zwinkau):
+    an assignment sets the value of the variable in the current block, a read looks for it in the
+    block and then in its predecessors, with a phi where they meet; a block whose predecessors are not
+    all known yet (the start of a loop) gets phis which are completed when it is sealed */
+int ir_emit(int op, int type, int tk)
+{
+    int x = ir_new(op, type, tk);
+    ir_append(ir_current, x);
+    return x;
+}
+
+int ir_emit1(int op, int type, int tk, int a)
+{
+    int x = ir_emit(op, type, tk);
+    ir_arg(x, a);
+    return x;
+}
+
+int ir_emit2(int op, int type, int tk, int a, int b)
+{
+    int x = ir_emit1(op, type, tk, a);
+    ir_arg(x, b);
+    return x;
+}
+
+int ir_const(int type, int value, int tk)
+{
+    int x = ir_emit(I_CONST, type, tk);
+    ir[x].i = value;
+    return x;
+}
+
+int ir_const_d(double value, int tk)
+{
+    int x = ir_emit(I_CONST, _DOUBLE, tk);
+    ir[x].d = value;
+    return x;
+}
+
+int ir_zero(int type, int tk)
+{
+    return type == _DOUBLE ? ir_const_d(0, tk) : ir_const(type, 0, tk);
+}
+
+//a block is started: the next instructions are added to it
+void ir_start(int b)
+{
+    ir_place(ir_fn, b);
+    ir_current = b;
+}
+
+void ir_jump(int to)
+{
+    int x = ir_emit(I_JMP, _VOID, 0);
+    ir[x].target[0] = to;
+    ir_add_pred(to, ir_current);
+}
+
+void ir_branch(int cond, int if_true, int if_false, int tk)
+{
+    int x = ir_emit1(I_BR, _VOID, tk, cond);
+    ir[x].target[0] = if_true;
+    ir[x].target[1] = if_false;
+    ir_add_pred(if_true, ir_current);
+    ir_add_pred(if_false, ir_current);
+}
+
+//the code after a return or a break can not be reached, it is in a block without predecessors
+void ir_start_unreachable()
+{
+    int b = ir_new_block();
+    ir_blocks[b].sealed = 1;
+    ir_start(b);
+}
+
+int* ir_defs(int b)
+{
+    if(ir_blocks[b].defs == NULL)
+    {
+	ir_blocks[b].defs = (int*)calloc(nr_ir_vars > 0 ? nr_ir_vars : 1, sizeof(int));
+	if(ir_blocks[b].defs == NULL)
+	    err("not enough memory");
+    }
+    return ir_blocks[b].defs;
+}
+
+void ir_write(int var, int b, int value)
+{
+    ir_defs(b)[var] = value;
+}
+
+int ir_read(int var, int b);
+
+int ir_new_phi(int b, int type, int tk)
+{
+    int x = ir_new(I_PHI, type, tk);
+    int at = ir_after_phis(b);
+    if(at != 0)
+	ir_insert_before(at, x);
+    else
+	ir_append(b, x);
+    return x;
+}
+
+//a phi whose operands are all the same value (or itself) is that value
+int ir_remove_trivial_phi(int phi)
+{
+    int same = 0;
+    for(int k = 0; k < ir[phi].nr_args; k++)
+    {
+	int v = ir_resolve(ir[phi].args[k]);
+	if(v == same || v == phi)
+	    continue;
+	if(same != 0)
+	    return phi;
+	same = v;
+    }
+    if(same == 0) // only in blocks which can not be reached
+    {
+	int b = ir[phi].block;
+	same = ir_new(I_CONST, ir[phi].type, ir[phi].tk);
+	int at = ir_after_phis(b);
+	if(at != 0)
+	    ir_insert_before(at, same);
+	else
+	    ir_append(b, same);
+    }
+    ir_replace(phi, same);
+    return same;
+}
+
+int ir_add_phi_operands(int var, int phi)
+{
+    int b = ir[phi].block;
+    for(int k = 0; k < ir_blocks[b].nr_preds; k++)
+    {
+	int v = ir_read(var, ir_blocks[b].preds[k]);
+	ir_arg(phi, v);
+    }
+    return ir_remove_trivial_phi(phi);
+}
+
+int ir_read_recursive(int var, int b)
+{
+    Symbol* sy = ir_vars[var];
+    int tk = nodes[sy->node].tk;
+    int v;
+    if(!ir_blocks[b].sealed)
+    {
+	v = ir_new_phi(b, sy->type, tk);
+	IrBlock* bl = &ir_blocks[b];
+	if(bl->nr_incomplete + 2 > bl->cap_incomplete)
+	{
+	    bl->cap_incomplete = bl->cap_incomplete ? bl->cap_incomplete * 2 : 8;
+	    bl->incomplete = (int*)realloc(bl->incomplete, sizeof(int) * bl->cap_incomplete);
+	    if(bl->incomplete == NULL)
+		err("not enough memory");
+	}
+	bl->incomplete[bl->nr_incomplete++] = var;
+	bl->incomplete[bl->nr_incomplete++] = v;
+    }
+    else if(ir_blocks[b].nr_preds == 0) // not reached
+    {
+	v = ir_new(I_CONST, sy->type, tk);
+	int at = ir_after_phis(b);
+	if(at != 0)
+	    ir_insert_before(at, v);
+	else
+	    ir_append(b, v);
+    }
+    else if(ir_blocks[b].nr_preds == 1)
+	v = ir_read(var, ir_blocks[b].preds[0]);
+    else
+    {
+	v = ir_new_phi(b, sy->type, tk);
+	ir_write(var, b, v); // a loop reading the variable finds the phi
+	v = ir_add_phi_operands(var, v);
+    }
+    ir_write(var, b, v);
+    return v;
+}
+
+int ir_read(int var, int b)
+{
+    int v = ir_defs(b)[var];
+    if(v != 0)
+	return ir_resolve(v);
+    return ir_read_recursive(var, b);
+}
+
+//all the predecessors of the block are known, its phis get their operands
+void ir_seal(int b)
+{
+    for(int k = 0; k < ir_blocks[b].nr_incomplete; k += 2)
+	ir_add_phi_operands(ir_blocks[b].incomplete[k], ir_blocks[b].incomplete[k + 1]);
+    free(ir_blocks[b].incomplete);
+    ir_blocks[b].incomplete = NULL;
+    ir_blocks[b].nr_incomplete = 0;
+    ir_blocks[b].sealed = 1;
+}
+
+//the operands of all the instructions are the values which were not removed
+void ir_apply_forwards(IrFunction* f)
+{
+    for(int k = 0; k < f->nr_blocks; k++)
+	for(int x = ir_blocks[f->blocks[k]].first; x != 0; x = ir[x].next)
+	    for(int a = 0; a < ir[x].nr_args; a++)
+		ir[x].args[a] = ir_resolve(ir[x].args[a]);
+}
+
+//the phis which became trivial after their operands were removed
+int ir_remove_trivial_phis(IrFunction* f)
+{
+    int removed = 0, changed = 1;
+    while(changed)
+    {
+	changed = 0;
+	for(int k = 0; k < f->nr_blocks; k++)
+	{
+	    int x = ir_blocks[f->blocks[k]].first;
+	    while(x != 0 && ir[x].op == I_PHI)
+	    {
+		int next = ir[x].next;
+		if(ir_remove_trivial_phi(x) != x)
+		{
+		    removed++;
+		    changed = 1;
+		}
+		x = next;
+	    }
+	}
+    }
+    ir_apply_forwards(f);
+    return removed;
+}
+
+/*  the lowering of the expressions follows gen_expr: the operators tell their operands the type they
+    need, the values are kept on a stack in postfix order. AND and OR are lowered to branches; when
+    their value is needed it is a phi of 1 and 0 */
+int* ir_values=NULL;
+int nr_ir_values=0;
+int cap_ir_values=0;
+int* ir_parent=NULL; // the operator which uses each node of the expression
+int cap_ir_parent=0;
+int ir_first=0; // the first node of the expression
+
+void ir_push_value(int v)
+{
+    if(nr_ir_values == cap_ir_values)
+    {
+	cap_ir_values = cap_ir_values ? cap_ir_values * 2 : 64;
+	ir_values = (int*)realloc(ir_values, sizeof(int) * cap_ir_values);
+	if(ir_values == NULL)
+	    err("not enough memory");
+    }
+    ir_values[nr_ir_values++] = v;
+}
+
+int ir_pop_value()
+{
+    return ir_values[--nr_ir_values];
+}
+
+//convert a value as gen_convert does
+int ir_convert(int v, int from, int to, int tk)
+{
+    if(from == to || !has_value(from) || (to < 0 && to != TRUTH) || (to >= 0 && !has_value(to)))
+	return v;
+    if(to == TRUTH)
+	return from == _DOUBLE ? ir_emit2(I_NOTEQ, _INT, tk, v, ir_const_d(0, tk)) : v;
+    if(from == _CHAR && to == _INT) // the chars are kept as integers
+	return v;
+    return ir_emit1(I_CONV, to, tk, v);
+}
+
+//the first operand of an operator, the first node of its subtree comes from it
+int first_operand(int n)
+{
+    switch(nodes[n].kind)
+    {
+	case N_BINARY: case N_UNARY: case N_CAST: case N_INDEX: case N_FIELD: return nodes[n].a;
+	case N_CALL: return nodes[n].c > 0 ? nodes[n].a : 0;
+	default: return 0;
+    }
+}
+
+void ir_call(int n)
+{
+    Symbol* f = node_symbol(n);
+    int args = nr_ir_values - nodes[n].c;
+    if(f->line < 0 && predefined_op(f) == O_POP) // put_s and get_s only compute their arguments
+    {
+	nr_ir_values = args;
+	return;
+    }
+    int x = ir_emit(I_CALL, has_value(f->type) ? f->type : _VOID, nodes[n].tk);
+    ir[x].sy = f;
+    for(int k = args; k < nr_ir_values; k++)
+	ir_arg(x, ir_values[k]);
+    nr_ir_values = args;
+    if(has_value(f->type))
+	ir_push_value(x);
+}
+
+//the value of an operator or term, its operands are on the stack
+void ir_term(int n, int want)
+{
+    Token* tk = node_tk(n);
+    int t = nodes[n].tk;
+    switch(nodes[n].kind)
+    {
+	case N_CONST:
+	    if(tk->code == CT_REAL)
+		ir_push_value(ir_const_d(tk->r, t));
+	    else
+		ir_push_value(ir_const(nodes[n].type, tk->code == CT_STRING ? 0 : (int)tk->i, t));
+	    break;
+	case N_NAME:
+	{
+	    Symbol* sy = bindings[t];
+	    if(sy->cls == FUNCTION_ARGUMENT_VECTOR) // its slot has the address of the vector
+	    {
+		int x = ir_emit(I_PARAM, IR_ADDRESS, t);
+		ir[x].i = sy->slot;
+		ir_push_value(x);
+	    }
+	    else if(want != ADDRESS && has_value(sy->type) && (sy->cls == VARIABLE || sy->cls == FUNCTION_ARGUMENT))
+	    {
+		if(is_global(sy))
+		{
+		    int x = ir_emit(I_LOAD_GLOBAL, sy->type, t);
+		    ir[x].sy = sy;
+		    ir_push_value(x);
+		}
+		else
+		    ir_push_value(ir_read(sy->ir_var, ir_current));
+	    }
+	    else
+	    {
+		int x = ir_emit(I_ADDR, IR_ADDRESS, t);
+		ir[x].sy = sy;
+		ir_push_value(x);
+	    }
+	    break;
+	}
+	case N_INDEX:
+	{
+	    int index = ir_pop_value();
+	    int vector = ir_pop_value();
+	    int x = ir_emit2(I_INDEX, IR_ADDRESS, t, vector, index);
+	    ir[x].i = element_slots(node_symbol(n));
+	    if(want != ADDRESS && has_value(nodes[n].type))
+		x = ir_emit1(I_LOAD, nodes[n].type, t, x);
+	    ir_push_value(x);
+	    break;
+	}
+	case N_FIELD:
+	{
+	    Symbol* sy = bindings[t];
+	    int x = ir_emit1(I_FIELD, IR_ADDRESS, t, ir_pop_value());
+	    ir[x].i = sy->slot;
+	    if(want != ADDRESS && has_value(nodes[n].type) && sy->cls == STRUCT_FIELD)
+		x = ir_emit1(I_LOAD, nodes[n].type, t, x);
+	    ir_push_value(x);
+	    break;
+	}
+	case N_CALL: ir_call(n); break;
+	case N_CAST: break; // the operand was converted to the type of the cast
+	case N_UNARY:
+	{
+	    int v = ir_pop_value();
+	    if(tk->code == NOT)
+		ir_push_value(ir_emit1(I_NOT, _INT, t, v));
+	    else if(nodes[n].type == _DOUBLE)
+		ir_push_value(ir_emit1(I_NEG, _DOUBLE, t, v));
+	    else // -c is a char again
+		ir_push_value(ir_convert(ir_emit1(I_NEG, _INT, t, v), _INT, nodes[n].type, t));
+	    break;
+	}
+	case N_BINARY:
+	{
+	    int b = ir_pop_value();
+	    int a = ir_pop_value();
+	    int op;
+	    switch(tk->code)
+	    {
+		case EQUAL: op = I_EQUAL; break;
+		case NOTEQ: op = I_NOTEQ; break;
+		case LESS: op = I_LESS; break;
+		case LESSEQ: op = I_LESSEQ; break;
+		case GREATER: op = I_GREATER; break;
+		case GREATEREQ: op = I_GREATEREQ; break;
+		case ADD: op = I_ADD; break;
+		case SUB: op = I_SUB; break;
+		case MUL: op = I_MUL; break;
+		default: op = I_DIV; break;
+	    }
+	    ir_push_value(ir_emit2(op, op >= I_EQUAL ? _INT : nodes[n].type, t, a, b));
+	    break;
+	}
+    }
+}
+
+int ir_range(int first, int root, int root_want);
+int ir_frame_slots(int slots);
+
+//the branches of a condition: AND, OR and NOT become jumps, the other values are compared with 0
+void ir_cond(int first, int root, int if_true, int if_false)
+{
+    int code = nodes[root].kind == N_BINARY || nodes[root].kind == N_UNARY ? node_tk(root)->code : 0;
+    if(code == AND || code == OR)
+    {
+	int right = ir_new_block();
+	if(code == AND)
+	    ir_cond(first, nodes[root].a, right, if_false);
+	else
+	    ir_cond(first, nodes[root].a, if_true, right);
+	ir_start(right);
+	ir_seal(right);
+	ir_cond(nodes[root].a + 1, nodes[root].b, if_true, if_false);
+    }
+    else if(code == NOT)
+	ir_cond(first, nodes[root].a, if_false, if_true);
+    else
+	ir_branch(ir_range(first, root, TRUTH), if_true, if_false, nodes[root].tk);
+}
+
+//the value of AND or OR: 1 or 0 from the branches
+int ir_logic_value(int first, int root)
+{
+    int if_true = ir_new_block(), if_false = ir_new_block(), end = ir_new_block();
+    ir_cond(first, root, if_true, if_false);
+    ir_start(if_true);
+    ir_seal(if_true);
+    int one = ir_const(_INT, 1, nodes[root].tk);
+    ir_jump(end);
+    ir_start(if_false);
+    ir_seal(if_false);
+    int zero = ir_const(_INT, 0, nodes[root].tk);
+    ir_jump(end);
+    ir_start(end);
+    ir_seal(end);
+    int phi = ir_new_phi(end, _INT, nodes[root].tk);
+    ir_arg(phi, one);
+    ir_arg(phi, zero);
+    return phi;
+}
+
+/* the value of the nodes from first to root, the operands of the operators are computed in postfix
+   order; at the first node of an AND/OR which is not part of a condition the whole operator is
+   lowered to branches, the outermost one which starts there */
+int ir_range(int first, int root, int root_want)
+{
+    int values = nr_ir_values;
+    for(int n = first; n <= root; n++)
+    {
+	if(first_operand(n) == 0) // a leaf, the first node of the operators above it
+	{
+	    int logic = 0;
+	    for(int m = n; ir_parent[m - ir_first] != 0 && ir_parent[m - ir_first] <= root && first_operand(ir_parent[m - ir_first]) == m; )
+	    {
+		m = ir_parent[m - ir_first];
+		if(nodes[m].kind == N_BINARY && (node_tk(m)->code == AND || node_tk(m)->code == OR))
+		    logic = m;
+	    }
+	    if(logic != 0)
+	    {
+		int want = logic == root ? root_want : wanted[logic - ir_first];
+		ir_push_value(ir_convert(ir_logic_value(n, logic), _INT, want, nodes[logic].tk));
+		n = logic;
+		continue;
+	    }
+	}
+	int want = n == root ? root_want : wanted[n - ir_first];
+	ir_term(n, want);
+	if(pushes_value(n))
+	{
+	    int v = ir_pop_value();
+	    v = ir_convert(v, nodes[n].type, want, nodes[n].tk);
+	    if(by_value[n - ir_first] > 0)
+	    {
+		//a structure passed by value is copied now when a call before its own could change it
+		for(int m = n + 1; m <= root; m++)
+		{
+		    if(nodes[m].kind != N_CALL)
+			continue;
+		    int arg = nodes[m].a;
+		    while(arg != 0 && arg != n)
+			arg = nodes[arg].next;
+		    if(arg == n)
+			break;
+		    int copy = ir_emit(I_FRAME, IR_ADDRESS, nodes[n].tk);
+		    ir[copy].i = ir_frame_slots(by_value[n - ir_first]);
+		    int x = ir_emit2(I_COPY, _VOID, nodes[n].tk, copy, v); // ir may move while x is emitted
+		    ir[x].i = by_value[n - ir_first];
+		    v = copy;
+		    break;
+		}
+	    }
+	    ir_push_value(v);
+	}
+    }
+    int v = nr_ir_values > values ? ir_pop_value() : 0;
+    nr_ir_values = values;
+    return v;
+}
+
+//the operators of the expression are known before it is lowered
+void ir_prepare(int expr, int type)
+{
+    expr_wanted(expr, type);
+    int first = nodes[expr].b;
+    int root = nodes[expr].a;
+    int size = root - first + 1;
+    if(cap_ir_parent < size)
+    {
+	cap_ir_parent = size * 2;
+	ir_parent = (int*)realloc(ir_parent, sizeof(int) * cap_ir_parent);
+	if(ir_parent == NULL)
+	    err("not enough memory");
+    }
+    memset(ir_parent, 0, sizeof(int) * size);
+    for(int n = first; n <= root; n++)
+    {
+	switch(nodes[n].kind)
+	{
+	    case N_BINARY: case N_INDEX:
+		ir_parent[nodes[n].a - first] = ir_parent[nodes[n].b - first] = n;
+		break;
+	    case N_UNARY: case N_CAST: case N_FIELD:
+		ir_parent[nodes[n].a - first] = n;
+		break;
+	    case N_CALL:
+		for(int arg = nodes[n].a; arg != 0; arg = nodes[arg].next)
+		    ir_parent[arg - first] = n;
+		break;
+	}
+    }
+    ir_first = first;
+}
+
+int ir_expr(int expr, int type)
+{
+    ir_prepare(expr, type);
+    return ir_range(nodes[expr].b, nodes[expr].a, type);
+}
+
+void ir_cond_expr(int expr, int if_true, int if_false)
+{
+    ir_prepare(expr, TRUTH);
+    ir_cond(nodes[expr].b, nodes[expr].a, if_true, if_false);
+}
+
+//slots of the frame which are not a variable, for the copies of the structures
+int ir_frame_slots(int slots)
+{
+    int slot = nr_frame_slots;
+    nr_frame_slots += slots;
+    if(nr_frame_slots > gen_function->nr_slots)
+	gen_function->nr_slots = nr_frame_slots;
+    return slot;
+}
+
+//the locals of the basic types are values in the SSA form
+int ir_is_value(Symbol* sy)
+{
+    return !is_global(sy) && has_value(sy->type) && (sy->cls == VARIABLE || sy->cls == FUNCTION_ARGUMENT);
+}
+
+void ir_add_var(Symbol* sy)
+{
+    if(nr_ir_vars == cap_ir_vars)
+    {
+	cap_ir_vars = cap_ir_vars ? cap_ir_vars * 2 : 64;
+	ir_vars = (Symbol**)realloc(ir_vars, sizeof(Symbol*) * cap_ir_vars);
+	if(ir_vars == NULL)
+	    err("not enough memory");
+    }
+    sy->ir_var = nr_ir_vars;
+    ir_vars[nr_ir_vars++] = sy;
+}
+
+//the declarations of the instructions of a function
+void ir_find_vars(int n)
+{
+    for(; n != 0; n = nodes[n].next)
+    {
+	switch(nodes[n].kind)
+	{
+	    case N_VAR:
+		if(ir_is_value(bindings[nodes[n].tk]))
+		    ir_add_var(bindings[nodes[n].tk]);
+		break;
+	    case N_BLOCK: case N_IF: case N_WHILE: case N_FOR:
+		ir_find_vars(nodes[n].a);
+		ir_find_vars(nodes[n].b);
+		ir_find_vars(nodes[n].c);
+		ir_find_vars(nodes[n].d);
+		break;
+	}
+    }
+}
+
+void ir_nodes(int n);
+
+void ir_var(int n)
+{
+    Symbol* sy = bindings[nodes[n].tk];
+    if(!ir_is_value(sy))
+    {
+	place_variable(sy); // the vectors and the structures start with zeros
+	return;
+    }
+    int v = nodes[n].b != 0 ? ir_expr(nodes[n].b, sy->type) : ir_zero(sy->type, nodes[n].tk);
+    ir_write(sy->ir_var, ir_current, v);
+}
+
+//the assignments as gen_assign: a value is the new definition of its variable, the others are stored
+void ir_assign(int n)
+{
+    int dest = nodes[nodes[n].a].a;
+    Symbol* sy = node_symbol(dest);
+    int value = nodes[n].b;
+    if(nodes[value].kind == N_ASSIGN) // x = y = value, x receives the value of y
+    {
+	ir_assign(value);
+	value = nodes[value].a;
+    }
+    if(nodes[dest].kind == N_NAME && has_value(sy->type) && (sy->cls == VARIABLE || sy->cls == FUNCTION_ARGUMENT))
+    {
+	int v = ir_expr(value, sy->type);
+	if(is_global(sy))
+	{
+	    int x = ir_emit1(I_STORE_GLOBAL, _VOID, nodes[dest].tk, v); // ir may move while x is emitted
+	    ir[x].sy = sy;
+	}
+	else
+	    ir_write(sy->ir_var, ir_current, v);
+	return;
+    }
+    int address = ir_expr(nodes[n].a, ADDRESS);
+    int v = ir_expr(value, nodes[dest].type);
+    int x;
+    if(has_value(nodes[dest].type))
+    {
+	x = ir_emit2(I_STORE, _VOID, nodes[n].tk, address, v); // ir may move while x is emitted
+	ir[x].i = nodes[dest].type;
+    }
+    else if(pushes_value(nodes[value].a)) // a structure is copied
+    {
+	x = ir_emit2(I_COPY, _VOID, nodes[n].tk, address, v);
+	ir[x].i = element_slots(sy);
+    }
+}
+
+void ir_return(int n)
+{
+    int type = gen_function->type;
+    int v = 0;
+    if(nodes[n].a == 0)
+	v = has_value(type) ? ir_zero(type, nodes[n].tk) : 0;
+    else
+    {
+	v = ir_expr(nodes[n].a, has_value(type) ? type : KEEP_TYPE);
+	if(!has_value(type))
+	    v = 0;
+    }
+    int x = ir_emit(I_RET, _VOID, nodes[n].tk);
+    if(v != 0)
+	ir_arg(x, v);
+    ir_start_unreachable();
+}
+
+//the blocks after the loops, the innermost is the last
+int* ir_loop_exits=NULL;
+int nr_ir_loop_exits=0;
+int cap_ir_loop_exits=0;
+
+void ir_break(int n)
+{
+    if(nr_ir_loop_exits == 0)
+	tkerr(node_tk(n), "break outside of a loop");
+    ir_jump(ir_loop_exits[nr_ir_loop_exits - 1]);
+    ir_start_unreachable();
+}
+
+void ir_if(int n)
+{
+    int if_true = ir_new_block(), end = ir_new_block();
+    int if_false = nodes[n].c != 0 ? ir_new_block() : end;
+    ir_cond_expr(nodes[n].a, if_true, if_false);
+    ir_start(if_true);
+    ir_seal(if_true);
+    ir_nodes(nodes[n].b);
+    ir_jump(end);
+    if(nodes[n].c != 0)
+    {
+	ir_start(if_false);
+	ir_seal(if_false);
+	ir_nodes(nodes[n].c);
+	ir_jump(end);
+    }
+    ir_start(end);
+    ir_seal(end);
+}
+
+/* the loops have their condition after the body, as gen_loop: the blocks of the condition are
+   built first, since the body jumps back to them, and are moved after the body */
+void ir_loop(int cond, int body, int modification)
+{
+    int head = ir_new_block(), start = ir_new_block(), end = ir_new_block();
+    ir_jump(head);
+    int head_at = ir_fn->nr_blocks;
+    ir_start(head); // sealed when the body jumped back to it
+    if(cond != 0)
+	ir_cond_expr(cond, start, end);
+    else
+	ir_jump(start);
+    int start_at = ir_fn->nr_blocks;
+    ir_start(start);
+    ir_seal(start);
+    if(nr_ir_loop_exits == cap_ir_loop_exits)
+    {
+	cap_ir_loop_exits = cap_ir_loop_exits ? cap_ir_loop_exits * 2 : 16;
+	ir_loop_exits = (int*)realloc(ir_loop_exits, sizeof(int) * cap_ir_loop_exits);
+	if(ir_loop_exits == NULL)
+	    err("not enough memory");
+    }
+    ir_loop_exits[nr_ir_loop_exits++] = end;
+    ir_nodes(body);
+    nr_ir_loop_exits--;
+    ir_nodes(modification);
+    ir_jump(head);
+    ir_seal(head);
+    //the blocks of the body go before the ones of the condition
+    int nr_cond = start_at - head_at, nr_body = ir_fn->nr_blocks - start_at;
+    int* moved = (int*)malloc(sizeof(int) * (nr_cond + 1));
+    if(moved == NULL)
+	err("not enough memory");
+    memcpy(moved, ir_fn->blocks + head_at, sizeof(int) * nr_cond);
+    memmove(ir_fn->blocks + head_at, ir_fn->blocks + start_at, sizeof(int) * nr_body);
+    memcpy(ir_fn->blocks + head_at + nr_body, moved, sizeof(int) * nr_cond);
+    free(moved);
+    ir_start(end);
+    ir_seal(end);
+}
+
+void ir_node(int n)
+{
+    switch(nodes[n].kind)
+    {
+	case N_VAR: ir_var(n); break;
+	case N_ASSIGN: ir_assign(n); break;
+	case N_RETURN: ir_return(n); break;
+	case N_EXPR: ir_expr(n, KEEP_TYPE); break;
+	case N_BLOCK:
+	{
+	    int slots = nr_frame_slots; // the slots of the variables of the block are used again after it
+	    ir_nodes(nodes[n].a);
+	    nr_frame_slots = slots;
+	    break;
+	}
+	case N_IF: ir_if(n); break;
+	case N_WHILE: ir_loop(nodes[n].a, nodes[n].b, 0); break;
+	case N_FOR:
+	    ir_nodes(nodes[n].a);
+	    ir_loop(nodes[n].b, nodes[n].d, nodes[n].c);
+	    break;
+	case N_BREAK: ir_break(n); break;
+    }
+}
+
+void ir_nodes(int n)
+{
+    for(; n != 0; n = nodes[n].next)
+	ir_node(n);
+}
+
+//the SSA form of a function, its arguments have the first slots of the frame as in gen_func
+IrFunction* ir_lower_func(int n)
+{
+    if(nr_ir_functions % 16 == 0)
+    {
+	ir_functions = (IrFunction*)realloc(ir_functions, sizeof(IrFunction) * (nr_ir_functions + 16));
+	if(ir_functions == NULL)
+	    err("not enough memory");
+    }
+    IrFunction* f = &ir_functions[nr_ir_functions++];
+    memset(f, 0, sizeof(IrFunction));
+    f->sy = gen_function = bindings[nodes[n].tk];
+    f->sy->ir_var = nr_ir_functions - 1;
+    f->node = n;
+    gen_function->nr_slots = 0;
+    nr_frame_slots = 0;
+    nr_ir_vars = 0;
+    ir_fn = f;
+    for(int arg = nodes[n].a; arg != 0; arg = nodes[arg].next)
+    {
+	Symbol* sy = bindings[nodes[arg].tk];
+	place_variable(sy);
+	if(ir_is_value(sy))
+	    ir_add_var(sy);
+    }
+    f->arg_slots = nr_frame_slots;
+    ir_find_vars(nodes[n].b);
+
+    int entry = ir_new_block();
+    ir_blocks[entry].sealed = 1;
+    ir_start(entry);
+    for(int arg = nodes[n].a; arg != 0; arg = nodes[arg].next)
+    {
+	Symbol* sy = bindings[nodes[arg].tk];
+	if(!ir_is_value(sy))
+	    continue;
+	int x = ir_emit(I_PARAM, sy->type, nodes[arg].tk);
+	ir[x].i = sy->slot;
+	ir_write(sy->ir_var, entry, x);
+    }
+    ir_nodes(nodes[n].b);
+    //a function without return gives the zero of its type
+    int zero = has_value(gen_function->type) ? ir_zero(gen_function->type, nodes[n].tk) : 0;
+    int x = ir_emit(I_RET, _VOID, nodes[n].tk);
+    if(zero != 0)
+	ir_arg(x, zero);
+    ir_remove_trivial_phis(f);
+    for(int k = 0; k < f->nr_blocks; k++)
+    {
+	free(ir_blocks[f->blocks[k]].defs);
+	ir_blocks[f->blocks[k]].defs = NULL;
+    }
+    gen_function = NULL;
+    ir_fn = NULL;
+    return f;
+}
+
+void ir_print_instr(int x)
+{
+    IrInstr* in = &ir[x];
+    if(in->type != _VOID)
+	printf("    v%-5d = %-6s ", x, ir_type_name(in->type));
+    else
+	printf("    %15s", "");
+    printf("%s", ir_op_name(in->op));
+    switch(in->op)
+    {
+	case I_CONST:
+	    if(in->type == _DOUBLE)
+		printf(" %g", in->d);
+	    else
+		printf(" %d", in->i);
+	    break;
+	case I_PARAM: case I_FRAME: case I_INDEX: case I_FIELD: case I_COPY: printf(" [%d]", in->i); break;
+	case I_SHL: case I_SHR: case I_USHR: case I_MULHI: printf(" %d", in->i); break;
+	case I_ADDR: case I_LOAD_GLOBAL: case I_STORE_GLOBAL: case I_CALL: printf(" %s", in->sy->name); break;
+	case I_VECTOR: printf(" [%s]", print_op(in->i & 0xFF)); break;
+    }
+    for(int k = 0; k < in->nr_args; k++)
+	printf("%s v%d", k ? "," : "", in->args[k]);
+    if(in->op == I_JMP)
+	printf(" b%d", in->target[0]);
+    else if(in->op == I_BR)
+	printf(", b%d, b%d", in->target[0], in->target[1]);
+    printf("\n");
+}
+
+void ir_print_function(IrFunction* f)
+{
+    printf("function %s\n", f->sy->name);
+    for(int k = 0; k < f->nr_blocks; k++)
+    {
+	int b = f->blocks[k];
+	printf("  b%d:", b);
+	if(ir_blocks[b].nr_preds > 0)
+	{
+	    printf("  ; from");
+	    for(int p = 0; p < ir_blocks[b].nr_preds; p++)
+		printf(" b%d", ir_blocks[b].preds[p]);
+	}
+	printf("\n");
+	for(int x = ir_blocks[b].first; x != 0; x = ir[x].next)
+	    ir_print_instr(x);
+    }
+}
+
+void ir_print(const char* after)
+{
+    printf("\nSSA form after %s:\n", after);
+    for(int k = 0; k < nr_ir_functions; k++)
+	ir_print_function(&ir_functions[k]);
+}
+
+/*  the passes change the SSA form of one function and return the number of their changes; the
+    pipeline given by -Passes runs them in order over all the functions */
+typedef struct IrPass{
+    const char* name;
+    int (*run)(IrFunction* f);
+    int (*run_program)(); // a pass on all the functions at once, instead of run
+    const char* description;
+    double seconds; // the time of all its runs
+    int changes;
+}IrPass;
+
+const char* ir_pass_name=NULL; // the pass which runs, for the errors of verify
+
+//the blocks of the function being verified have link -1
+int ir_block_of_function(int b)
+{
+    return ir_blocks[b].link == -1;
+}
+
+int* ir_position=NULL; // the position of the instructions of the function being verified, 0 for the others
+int cap_ir_position=0;
+
+//the number of jumps from a block to another
+int ir_edges(int from, int to)
+{
+    int succ[2], count = 0;
+    int nr = ir_succs(from, succ);
+    for(int k = 0; k < nr; k++)
+	count += succ[k] == to;
+    return count;
+}
+
+void ir_invalid(IrFunction* f, int x, const char* what)
+{
+    err("the SSA form of %s is not valid after %s: %s at v%d", f->sy->name, ir_pass_name ? ir_pass_name : "lower", what, x);
+}
+
+//the blocks end with their jump, the phis agree with the predecessors and the values dominate their uses
+int ir_verify(IrFunction* f)
+{
+    if(f->nr_blocks == 0 || ir_blocks[f->blocks[0]].nr_preds != 0)
+	ir_invalid(f, 0, "the entry has predecessors");
+    int position = 0;
+    for(int k = 0; k < f->nr_blocks; k++)
+	ir_blocks[f->blocks[k]].link = -1;
+    for(int k = 0; k < f->nr_blocks; k++)
+    {
+	int b = f->blocks[k];
+	IrBlock* bl = &ir_blocks[b];
+	if(bl->dead || bl->last == 0 || !ir_is_terminator(ir[bl->last].op))
+	    ir_invalid(f, bl->last, "a block does not end with a jump or a return");
+	int phis = 1;
+	for(int x = bl->first; x != 0; x = ir[x].next)
+	{
+	    if(ir[x].block != b || ir[x].forward != 0)
+		ir_invalid(f, x, "an instruction is not in its block");
+	    if(ir_is_terminator(ir[x].op) && x != bl->last)
+		ir_invalid(f, x, "a jump in the middle of a block");
+	    if(ir[x].op == I_PHI && (!phis || ir[x].nr_args != bl->nr_preds))
+		ir_invalid(f, x, "a phi which does not match the predecessors");
+	    phis = phis && ir[x].op == I_PHI;
+	}
+	for(int p = 0; p < bl->nr_preds; p++)
+	{
+	    int pred = bl->preds[p], count = 0;
+	    for(int q = 0; q < bl->nr_preds; q++)
+		count += bl->preds[q] == pred;
+	    if(ir_blocks[pred].dead || ir_edges(pred, b) != count || !ir_block_of_function(pred))
+		ir_invalid(f, bl->first, "the predecessors do not match the jumps");
+	}
+	int succ[2];
+	int nr = ir_succs(b, succ);
+	for(int s = 0; s < nr; s++)
+	    if(ir_blocks[succ[s]].dead || !ir_block_of_function(succ[s]) || ir_pred_index(succ[s], b) < 0)
+		ir_invalid(f, bl->last, "a jump to a block which does not have it as predecessor");
+    }
+    //the values are defined before their uses, in the same block or in a dominator
+    ir_compute_dominators(f);
+    if(cap_ir_position < nr_ir)
+    {
+	ir_position = (int*)realloc(ir_position, sizeof(int) * nr_ir * 2);
+	if(ir_position == NULL)
+	    err("not enough memory");
+	memset(ir_position + cap_ir_position, 0, sizeof(int) * (nr_ir * 2 - cap_ir_position));
+	cap_ir_position = nr_ir * 2;
+    }
+    int* order = ir_position;
+    for(int k = 0; k < f->nr_blocks; k++)
+	for(int x = ir_blocks[f->blocks[k]].first; x != 0; x = ir[x].next)
+	    order[x] = ++position;
+    for(int k = 0; k < f->nr_blocks; k++)
+    {
+	int b = f->blocks[k];
+	if(ir_blocks[b].rpo < 0)
+	    continue;
+	for(int x = ir_blocks[b].first; x != 0; x = ir[x].next)
+	{
+	    for(int a = 0; a < ir[x].nr_args; a++)
+	    {
+		int v = ir[x].args[a];
+		if(v <= 0 || v >= nr_ir || order[v] == 0 || ir[v].type == _VOID)
+		    ir_invalid(f, x, "an operand which is not a value of the function");
+		int at = ir[x].op == I_PHI ? ir_blocks[b].preds[a] : b;
+		if(ir_blocks[at].rpo < 0)
+		    continue;
+		if(ir[v].block == at ? ir[x].op != I_PHI && order[v] >= order[x] : !ir_dominates(ir[v].block, at))
+		    ir_invalid(f, x, "an operand which is not defined before its use");
+	    }
+	}
+    }
+    for(int k = 0; k < f->nr_blocks; k++)
+	for(int x = ir_blocks[f->blocks[k]].first; x != 0; x = ir[x].next)
+	    order[x] = 0;
+    return 0;
+}
+
+//the block does not belong to its function anymore, the blocks it jumps to lose it as predecessor
+void ir_remove_block(int b)
+{
+    int succ[2];
+    int nr = ir_succs(b, succ);
+    for(int s = 0; s < nr; s++)
+    {
+	int index = ir_pred_index(succ[s], b);
+	if(index >= 0)
+	    ir_remove_pred(succ[s], index);
+    }
+    ir_blocks[b].dead = 1;
+}
+
+//the jump of a block goes to another block
+void ir_retarget(int b, int from, int to)
+{
+    int x = ir_blocks[b].last;
+    for(int k = 0; k < 2; k++)
+    {
+	if(ir[x].target[k] != from || (ir[x].op == I_JMP && k == 1))
+	    continue;
+	ir[x].target[k] = to;
+	ir_remove_pred(from, ir_pred_index(from, b));
+	ir_add_pred(to, b);
+    }
+}
+
+void ir_compact_blocks(IrFunction* f)
+{
+    int nr = 0;
+    for(int k = 0; k < f->nr_blocks; k++)
+	if(!ir_blocks[f->blocks[k]].dead)
+	    f->blocks[nr++] = f->blocks[k];
+    f->nr_blocks = nr;
+}
+
+//a branch to the same block becomes a jump
+int ir_single_jump(int b)
+{
+    int x = ir_blocks[b].last;
+    if(ir[x].op != I_BR || ir[x].target[0] != ir[x].target[1])
+	return 0;
+    ir_remove_pred(ir[x].target[0], ir_pred_index(ir[x].target[0], b));
+    ir[x].op = I_JMP;
+    ir[x].nr_args = 0;
+    return 1;
+}
+
+/* the end of the chain of blocks which only jump, from b: as in a union-find, the blocks of the path
+   then have link -end and are not followed again; a chain which comes back on itself ends in the
+   first block seen twice, which keeps its jump */
+int ir_chain_end(int b, int* path)
+{
+    int n = 0, end = b;
+    while(ir_blocks[end].link > 0 && ir_blocks[end].rpo != -2)
+    {
+	ir_blocks[end].rpo = -2; // on the path
+	path[n++] = end;
+	end = ir_blocks[end].link;
+    }
+    if(ir_blocks[end].link < 0)
+	end = -ir_blocks[end].link;
+    for(int k = 0; k < n; k++)
+	ir_blocks[path[k]].link = path[k] == end ? 0 : -end;
+    return end;
+}
+
+//the block continues with the instructions of the one it jumps to, which has no other predecessor
+void ir_merge_block(int b, int to)
+{
+    for(int y = ir_blocks[to].first; y != 0 && ir[y].op == I_PHI; y = ir_blocks[to].first)
+	ir_replace(y, ir[y].args[0]);
+    ir_unlink(ir_blocks[b].last);
+    while(ir_blocks[to].first != 0)
+    {
+	int y = ir_blocks[to].first;
+	ir_unlink(y);
+	ir_append(b, y);
+    }
+    int succ[2];
+    int nr = ir_succs(b, succ);
+    for(int s = 0; s < nr; s++)
+	for(int p = 0; p < ir_blocks[succ[s]].nr_preds; p++)
+	    if(ir_blocks[succ[s]].preds[p] == to)
+		ir_blocks[succ[s]].preds[p] = b;
+    ir_blocks[to].nr_preds = 0;
+    ir_blocks[to].dead = 1;
+}
+
+/* the control flow is simplified: the blocks which can not be reached are removed, a branch to the
+   same block becomes a jump, the jumps to blocks which only jump are sent to the end of their chain
+   and a block is merged with the single block jumping to it. Each step visits the blocks once: the
+   merges follow the reverse postorder, so a block takes at once the chain of blocks after it */
+int ir_simplify_cfg(IrFunction* f)
+{
+    int changes = 0;
+    ir_compute_order(f);
+    for(int k = 1; k < f->nr_blocks; k++)
+    {
+	int b = f->blocks[k];
+	if(ir_blocks[b].rpo < 0 && !ir_blocks[b].dead)
+	{
+	    ir_remove_block(b);
+	    changes++;
+	}
+    }
+    ir_compact_blocks(f);
+    for(int k = 0; k < f->nr_blocks; k++)
+	changes += ir_single_jump(f->blocks[k]);
+    //the blocks which only jump to a block without phis are skipped
+    for(int k = 0; k < f->nr_blocks; k++)
+    {
+	int b = f->blocks[k];
+	int x = ir_blocks[b].first;
+	int to = ir[x].target[0];
+	ir_blocks[b].link = 0;
+	if(k > 0 && ir[x].op == I_JMP && to != b && (ir_blocks[to].first == 0 || ir[ir_blocks[to].first].op != I_PHI))
+	    ir_blocks[b].link = to;
+    }
+    int* path = (int*)malloc(sizeof(int) * (f->nr_blocks + 1));
+    if(path == NULL)
+	err("not enough memory");
+    for(int k = 1; k < f->nr_blocks; k++)
+    {
+	int b = f->blocks[k];
+	if(ir_blocks[b].link == 0)
+	    continue;
+	int end = ir_chain_end(b, path);
+	if(end == b)
+	    continue;
+	while(ir_blocks[b].nr_preds > 0)
+	{
+	    int pred = ir_blocks[b].preds[0];
+	    ir_retarget(pred, b, end);
+	    changes += ir_single_jump(pred);
+	}
+	ir_remove_block(b);
+	changes++;
+    }
+    free(path);
+    ir_compact_blocks(f);
+    ir_compute_order(f);
+    for(int k = 0; k < nr_ir_order; k++)
+    {
+	int b = ir_order[k];
+	if(ir_blocks[b].dead)
+	    continue;
+	for(int x = ir_blocks[b].last; ir[x].op == I_JMP; x = ir_blocks[b].last)
+	{
+	    int to = ir[x].target[0];
+	    if(to == b || to == f->blocks[0] || ir_blocks[to].nr_preds != 1)
+		break;
+	    ir_merge_block(b, to);
+	    changes++;
+	}
+    }
+    ir_compact_blocks(f);
+    ir_apply_forwards(f);
+    return changes + ir_remove_trivial_phis(f);
+}
+
+/*  sparse conditional constant propagation (Wegman and Zadeck): the values start unknown and only
+    the blocks reached from the entry by the jumps which can be taken are evaluated, so a value
+    which is a constant on the only branch taken stays a constant; the operators are folded with the
+    arithmetic of the virtual machine and a division by zero is left for the run time */
+enum { LAT_TOP, LAT_CONST, LAT_BOTTOM };
+
+typedef struct IrLattice{
+    int state; // LAT_TOP (not known yet), LAT_CONST or LAT_BOTTOM (not a constant)
+    union{
+	int i;
+	double d;
+    };
+}IrLattice;
+
+IrLattice* ir_lattice=NULL;
+int cap_ir_lattice=0;
+int* ir_users=NULL; // the instructions which use each value, from ir_user_start[v] to ir_user_end[v]
+int* ir_user_start=NULL;
+int* ir_user_end=NULL;
+int cap_ir_users=0;
+int* ir_edges_taken=NULL; // bit s of a block is set when its jump to target[s] can be taken
+int* ir_work=NULL; // the instructions to evaluate again and the blocks to evaluate, as -block
+int nr_ir_work=0;
+int cap_ir_work=0;
+
+#define IR_STORED 1 // a global assigned in a function, its loads are not replaced by its initial constant
+#define IR_READ 2 // a variable whose memory is read, the stores to the others are removed
+#define IR_UNUSED 4 // a global removed from the program, it has no slot
+
+//the globals assigned by a function, the others keep the constant they were initialized with
+void ir_find_stored_globals()
+{
+    for(int k = 0; k < nr_ir_functions; k++)
+    {
+	IrFunction* f = &ir_functions[k];
+	for(int b = 0; b < f->nr_blocks; b++)
+	    for(int x = ir_blocks[f->blocks[b]].first; x != 0; x = ir[x].next)
+		if(ir[x].op == I_STORE_GLOBAL)
+		    ir[x].sy->ir_flags |= IR_STORED;
+    }
+}
+
+//the value of a global which is only initialized with a constant, or with its negation
+int ir_global_constant(Symbol* sy, IrLattice* value)
+{
+    if((sy->ir_flags & IR_STORED) || sy->node == 0 || nodes[sy->node].b == 0)
+	return 0;
+    int expr = nodes[sy->node].b;
+    int root = nodes[expr].a, sign = 1;
+    if(nodes[root].kind == N_UNARY && node_tk(root)->code == SUB && nodes[root].a == nodes[expr].b)
+    {
+	sign = -1;
+	root = nodes[root].a;
+    }
+    if(root != nodes[expr].b || nodes[root].kind != N_CONST || node_tk(root)->code == CT_STRING)
+	return 0;
+    Token* tk = node_tk(root);
+    double d = tk->code == CT_REAL ? sign * tk->r : sign * (double)tk->i;
+    value->state = LAT_CONST;
+    if(sy->type == _DOUBLE)
+	value->d = d;
+    else if(d < INT_MIN || d > INT_MAX)
+	return 0;
+    else
+	value->i = sy->type == _CHAR ? (char)(int)d : (int)d;
+    return 1;
+}
+
+int ir_same_lattice(IrLattice* a, IrLattice* b, int type)
+{
+    if(a->state != b->state)
+	return 0;
+    if(a->state != LAT_CONST)
+	return 1;
+    return type == _DOUBLE ? memcmp(&a->d, &b->d, sizeof(double)) == 0 : a->i == b->i;
+}
+
+//the constant value of an operator whose operands are constants, 0 when it is not folded
+int ir_fold(int x, IrLattice* r)
+{
+    IrInstr* in = &ir[x];
+    IrLattice* a = in->nr_args > 0 ? &ir_lattice[in->args[0]] : NULL;
+    IrLattice* b = in->nr_args > 1 ? &ir_lattice[in->args[1]] : NULL;
+    int from = in->nr_args > 0 ? ir[in->args[0]].type : _VOID;
+    r->state = LAT_CONST;
+    switch(in->op)
+    {
+	case I_ADD: case I_SUB: case I_MUL: case I_DIV:
+	    if(in->type == _DOUBLE)
+	    {
+		switch(in->op)
+		{
+		    case I_ADD: r->d = a->d + b->d; break;
+		    case I_SUB: r->d = a->d - b->d; break;
+		    case I_MUL: r->d = a->d * b->d; break;
+		    default: r->d = a->d / b->d; break;
+		}
+		return 1;
+	    }
+	    if(in->op == I_DIV)
+	    {
+		if(in->type == _CHAR)
+		{
+		    if((char)b->i == 0)
+			return 0;
+		    r->i = (char)((char)a->i / (char)b->i);
+		    return 1;
+		}
+		if(b->i == 0)
+		    return 0;
+		r->i = b->i == -1 ? (int)(0u - (unsigned)a->i) : a->i / b->i;
+		return 1;
+	    }
+	    //the integers wrap around as in the virtual machine
+	    switch(in->op)
+	    {
+		case I_ADD: r->i = (int)((unsigned)a->i + (unsigned)b->i); break;
+		case I_SUB: r->i = (int)((unsigned)a->i - (unsigned)b->i); break;
+		default: r->i = (int)((unsigned)a->i * (unsigned)b->i); break;
+	    }
+	    if(in->type == _CHAR)
+		r->i = (char)r->i;
+	    return 1;
+	case I_NEG:
+	    if(in->type == _DOUBLE)
+		r->d = -a->d;
+	    else
+		r->i = (int)(0u - (unsigned)a->i);
+	    return 1;
+	case I_NOT: r->i = !a->i; return 1;
+	case I_SHL: r->i = (int)((unsigned)a->i << in->i); return 1;
+	case I_SHR: r->i = a->i >> in->i; return 1;
+	case I_USHR: r->i = (int)((unsigned)a->i >> in->i); return 1;
+	case I_MULHI: r->i = (int)((long long)a->i * in->i >> 32); return 1;
+	case I_EQUAL: case I_NOTEQ: case I_LESS: case I_LESSEQ: case I_GREATER: case I_GREATEREQ:
+	{
+	    int c;
+	    if(from == _DOUBLE)
+		c = a->d < b->d ? -1 : a->d > b->d ? 1 : a->d == b->d ? 0 : 2; // 2 when one is NaN
+	    else
+		c = a->i < b->i ? -1 : a->i > b->i;
+	    switch(in->op)
+	    {
+		case I_EQUAL: r->i = c == 0; break;
+		case I_NOTEQ: r->i = c != 0; break;
+		case I_LESS: r->i = c == -1; break;
+		case I_LESSEQ: r->i = c == -1 || c == 0; break;
+		case I_GREATER: r->i = c == 1; break;
+		default: r->i = c == 1 || c == 0; break;
+	    }
+	    return 1;
+	}
+	case I_CONV:
+	    if(in->type == _DOUBLE)
+	    {
+		r->d = from == _DOUBLE ? a->d : a->i;
+		return 1;
+	    }
+	    if(from == _DOUBLE)
+	    {
+		if(!(a->d > INT_MIN - 1.0 && a->d < INT_MAX + 1.0)) // not an int, as NaN
+		    return 0;
+		r->i = (int)a->d;
+	    }
+	    else
+		r->i = a->i;
+	    if(in->type == _CHAR)
+		r->i = (char)r->i;
+	    return 1;
+	default: return 0;
+    }
+}
+
+void ir_push_work(int w)
+{
+    if(nr_ir_work == cap_ir_work)
+    {
+	cap_ir_work = cap_ir_work ? cap_ir_work * 2 : 256;
+	ir_work = (int*)realloc(ir_work, sizeof(int) * cap_ir_work);
+	if(ir_work == NULL)
+	    err("not enough memory");
+    }
+    ir_work[nr_ir_work++] = w;
+}
+
+//the jump from a block to its target s can be taken, the target is evaluated
+void ir_take_edge(int b, int s)
+{
+    if(ir_edges_taken[b] & (1 << s))
+	return;
+    ir_edges_taken[b] |= 1 << s;
+    int to = ir[ir_blocks[b].last].target[s];
+    if(!ir_blocks[to].link)
+    {
+	ir_blocks[to].link = 1;
+	ir_push_work(-to);
+	return;
+    }
+    for(int phi = ir_blocks[to].first; phi != 0 && ir[phi].op == I_PHI; phi = ir[phi].next)
+	ir_push_work(phi);
+}
+
+void ir_sccp_eval(int x)
+{
+    IrInstr* in = &ir[x];
+    IrLattice r = { LAT_BOTTOM, { 0 } };
+    switch(in->op)
+    {
+	case I_JMP: ir_take_edge(in->block, 0); return;
+	case I_BR:
+	{
+	    IrLattice* c = &ir_lattice[in->args[0]];
+	    if(c->state == LAT_BOTTOM)
+	    {
+		ir_take_edge(in->block, 0);
+		ir_take_edge(in->block, 1);
+	    }
+	    else if(c->state == LAT_CONST)
+		ir_take_edge(in->block, c->i != 0 ? 0 : 1);
+	    return;
+	}
+	case I_CONST:
+	    r.state = LAT_CONST;
+	    if(in->type == _DOUBLE)
+		r.d = in->d;
+	    else
+		r.i = in->i;
+	    break;
+	case I_PHI:
+	{
+	    r.state = LAT_TOP;
+	    IrBlock* bl = &ir_blocks[in->block];
+	    for(int k = 0; k < in->nr_args && r.state != LAT_BOTTOM; k++)
+	    {
+		int pred = bl->preds[k];
+		int jump = ir_blocks[pred].last;
+		int taken = ((ir_edges_taken[pred] & 1) && ir[jump].target[0] == in->block) ||
+		    ((ir_edges_taken[pred] & 2) && ir[jump].target[1] == in->block);
+		IrLattice* v = &ir_lattice[in->args[k]];
+		if(!taken || v->state == LAT_TOP)
+		    continue;
+		if(r.state == LAT_TOP)
+		    r = *v;
+		else if(!ir_same_lattice(&r, v, in->type))
+		    r.state = LAT_BOTTOM;
+	    }
+	    break;
+	}
+	case I_LOAD_GLOBAL:
+	    if(!ir_global_constant(in->sy, &r))
+		r.state = LAT_BOTTOM;
+	    break;
+	case I_ADD: case I_SUB: case I_MUL: case I_DIV: case I_NEG: case I_NOT: case I_CONV:
+	case I_SHL: case I_SHR: case I_USHR: case I_MULHI:
+	case I_EQUAL: case I_NOTEQ: case I_LESS: case I_LESSEQ: case I_GREATER: case I_GREATEREQ:
+	{
+	    int top = 0, bottom = 0;
+	    for(int k = 0; k < in->nr_args; k++)
+	    {
+		top |= ir_lattice[in->args[k]].state == LAT_TOP;
+		bottom |= ir_lattice[in->args[k]].state == LAT_BOTTOM;
+	    }
+	    if(bottom || (!top && !ir_fold(x, &r)))
+		r.state = LAT_BOTTOM;
+	    else if(top)
+		r.state = LAT_TOP;
+	    break;
+	}
+	default:
+	    if(in->type == _VOID)
+		return;
+    }
+    if(ir_same_lattice(&r, &ir_lattice[x], in->type))
+	return;
+    ir_lattice[x] = r;
+    for(int k = ir_user_start[x]; k < ir_user_end[x]; k++)
+	if(ir_blocks[ir[ir_users[k]].block].link)
+	    ir_push_work(ir_users[k]);
+}
+
+//the users of the values of the function
+void ir_find_users(IrFunction* f)
+{
+    if(cap_ir_users < nr_ir)
+    {
+	cap_ir_users = nr_ir * 2;
+	ir_user_start = (int*)realloc(ir_user_start, sizeof(int) * cap_ir_users);
+	ir_user_end = (int*)realloc(ir_user_end, sizeof(int) * cap_ir_users);
+	if(ir_user_start == NULL || ir_user_end == NULL)
+	    err("not enough memory");
+    }
+    int total = 0;
+    for(int k = 0; k < f->nr_blocks; k++)
+	for(int x = ir_blocks[f->blocks[k]].first; x != 0; x = ir[x].next)
+	{
+	    ir_user_start[x] = 0;
+	    total += ir[x].nr_args;
+	}
+    for(int k = 0; k < f->nr_blocks; k++)
+	for(int x = ir_blocks[f->blocks[k]].first; x != 0; x = ir[x].next)
+	    for(int a = 0; a < ir[x].nr_args; a++)
+		ir_user_start[ir[x].args[a]]++;
+    //the counts become the end of the users of each value, the start goes down as they are added
+    int end = 0;
+    for(int k = 0; k < f->nr_blocks; k++)
+	for(int x = ir_blocks[f->blocks[k]].first; x != 0; x = ir[x].next)
+	{
+	    end += ir_user_start[x];
+	    ir_user_start[x] = ir_user_end[x] = end;
+	}
+    ir_users = (int*)realloc(ir_users, sizeof(int) * (total + 1));
+    if(ir_users == NULL)
+	err("not enough memory");
+    for(int k = 0; k < f->nr_blocks; k++)
+	for(int x = ir_blocks[f->blocks[k]].first; x != 0; x = ir[x].next)
+	    for(int a = 0; a < ir[x].nr_args; a++)
+		ir_users[--ir_user_start[ir[x].args[a]]] = x;
+}
+
+int ir_sccp(IrFunction* f)
+{
+    if(cap_ir_lattice < nr_ir + 1)
+    {
+	cap_ir_lattice = (nr_ir + 1) * 2;
+	ir_lattice = (IrLattice*)realloc(ir_lattice, sizeof(IrLattice) * cap_ir_lattice);
+	if(ir_lattice == NULL)
+	    err("not enough memory");
+    }
+    ir_edges_taken = (int*)realloc(ir_edges_taken, sizeof(int) * nr_ir_blocks);
+    if(ir_edges_taken == NULL)
+	err("not enough memory");
+    ir_find_users(f);
+    for(int k = 0; k < f->nr_blocks; k++)
+    {
+	int b = f->blocks[k];
+	ir_blocks[b].link = 0; // evaluated
+	ir_edges_taken[b] = 0;
+	for(int x = ir_blocks[b].first; x != 0; x = ir[x].next)
+	    ir_lattice[x].state = LAT_TOP;
+    }
+    nr_ir_work = 0;
+    ir_blocks[f->blocks[0]].link = 1;
+    ir_push_work(-f->blocks[0]);
+    while(nr_ir_work > 0)
+    {
+	int w = ir_work[--nr_ir_work];
+	if(w > 0)
+	    ir_sccp_eval(w);
+	else
+	    for(int x = ir_blocks[-w].first; x != 0; x = ir[x].next)
+		ir_sccp_eval(x);
+    }
+
+    //the constants replace their instructions, the branches which are always taken become jumps
+    int changes = 0;
+    for(int k = 0; k < f->nr_blocks; k++)
+    {
+	int b = f->blocks[k];
+	if(!ir_blocks[b].link)
+	    continue;
+	for(int x = ir_blocks[b].first, next; x != 0; x = next)
+	{
+	    next = ir[x].next;
+	    IrLattice* v = &ir_lattice[x];
+	    if(ir[x].op == I_BR && ir_lattice[ir[x].args[0]].state == LAT_CONST)
+	    {
+		int taken = ir_lattice[ir[x].args[0]].i != 0 ? 0 : 1;
+		int other = ir[x].target[1 - taken];
+		ir_remove_pred(other, ir_pred_index(other, b));
+		ir[x].target[0] = ir[x].target[taken];
+		ir[x].op = I_JMP;
+		ir[x].nr_args = 0;
+		changes++;
+	    }
+	    if(v->state != LAT_CONST || ir[x].op == I_CONST || ir[x].type == _VOID)
+		continue;
+	    int c = ir_new(I_CONST, ir[x].type, ir[x].tk);
+	    if(ir[x].type == _DOUBLE)
+		ir[c].d = v->d;
+	    else
+		ir[c].i = v->i;
+	    ir_insert_before(ir[x].op == I_PHI ? ir_after_phis(b) : x, c);
+	    ir_replace(x, c);
+	    changes++;
+	}
+    }
+    ir_apply_forwards(f);
+    return changes + ir_remove_trivial_phis(f);
+}
+
+/*  the dead code: the values which are not used by an instruction with an effect are removed, with
+    the stores to the vectors and the structures which are never read. A division which may stop the
+    program and a load which may be outside of the stack are kept, as the calls */
+//the variable whose address is the base of an address, NULL for the addresses of the arguments
+Symbol* ir_address_root(int v)
+{
+    while(ir[v].op == I_FIELD || ir[v].op == I_INDEX)
+	v = ir[v].args[0];
+    return ir[v].op == I_ADDR ? ir[v].sy : NULL;
+}
+
+//the variables in memory read by the function: loaded, copied or given to a call
+void ir_mark_reads(IrFunction* f)
+{
+    for(int k = 0; k < f->nr_blocks; k++)
+	for(int x = ir_blocks[f->blocks[k]].first; x != 0; x = ir[x].next)
+	{
+	    if(ir[x].op == I_LOAD_GLOBAL)
+		ir[x].sy->ir_flags |= IR_READ;
+	    for(int a = 0; a < ir[x].nr_args; a++)
+	    {
+		int v = ir[x].args[a];
+		if(ir[v].type != IR_ADDRESS || ir[x].op == I_FIELD || ir[x].op == I_INDEX)
+		    continue;
+		if((ir[x].op == I_STORE || ir[x].op == I_COPY || ir[x].op == I_VECTOR) && a == 0) // written
+		    continue;
+		Symbol* sy = ir_address_root(v);
+		if(sy != NULL)
+		    sy->ir_flags |= IR_READ;
+	    }
+	}
+}
+
+//a store to a local variable which is never read
+int ir_dead_store(int x)
+{
+    Symbol* sy = ir_address_root(ir[x].args[0]);
+    return sy != NULL && !is_global(sy) && !(sy->ir_flags & IR_READ);
+}
+
+//an instruction whose only effect is its value
+int ir_removable(int x)
+{
+    switch(ir[x].op)
+    {
+	case I_DIV:
+	{
+	    int d = ir[x].args[1];
+	    if(ir[x].type == _DOUBLE)
+		return 1;
+	    if(ir[d].op != I_CONST)
+		return 0;
+	    return ir[x].type == _CHAR ? (char)ir[d].i != 0 : ir[d].i != 0;
+	}
+	case I_LOAD: // the fields of a variable are always in the stack, the elements may not be
+	{
+	    int v = ir[x].args[0];
+	    while(ir[v].op == I_FIELD)
+		v = ir[v].args[0];
+	    return ir[v].op == I_ADDR || ir[v].op == I_FRAME;
+	}
+	case I_STORE: case I_COPY: return ir_dead_store(x);
+	case I_STORE_GLOBAL: case I_CALL: case I_VECTOR: case I_JMP: case I_BR: case I_RET: return 0;
+	default: return 1;
+    }
+}
+
+char* ir_live=NULL;
+int cap_ir_live=0;
+
+int ir_dce(IrFunction* f)
+{
+    if(cap_ir_live < nr_ir)
+    {
+	cap_ir_live = nr_ir * 2;
+	ir_live = (char*)realloc(ir_live, cap_ir_live);
+	if(ir_live == NULL)
+	    err("not enough memory");
+    }
+    for(int k = 0; k < f->nr_blocks; k++)
+	for(int x = ir_blocks[f->blocks[k]].first; x != 0; x = ir[x].next)
+	    if(ir[x].op == I_ADDR && !is_global(ir[x].sy))
+		ir[x].sy->ir_flags &= ~IR_READ;
+    ir_mark_reads(f);
+    //the instructions with effects are live, and the values they use
+    nr_ir_work = 0;
+    for(int k = 0; k < f->nr_blocks; k++)
+	for(int x = ir_blocks[f->blocks[k]].first; x != 0; x = ir[x].next)
+	{
+	    ir_live[x] = !ir_removable(x);
+	    if(ir_live[x])
+		ir_push_work(x);
+	}
+    while(nr_ir_work > 0)
+    {
+	int x = ir_work[--nr_ir_work];
+	for(int a = 0; a < ir[x].nr_args; a++)
+	    if(!ir_live[ir[x].args[a]])
+	    {
+		ir_live[ir[x].args[a]] = 1;
+		ir_push_work(ir[x].args[a]);
+	    }
+    }
+    int changes = 0;
+    for(int k = 0; k < f->nr_blocks; k++)
+	for(int x = ir_blocks[f->blocks[k]].first, next; x != 0; x = next)
+	{
+	    next = ir[x].next;
+	    if(ir_live[x])
+		continue;
+	    ir_unlink(x);
+	    ir[x].block = 0;
+	    changes++;
+	}
+    return changes;
+}
+
+/*  the program: the functions which can not be called from main or from the initialization of a
+    global are removed, the globals which are not read get no slots and their stores are removed */
+
+//a function is reached, its calls are followed later
+void ir_reach_function(Symbol* sy, char* reached, int* work, int* nr_work)
+{
+    if(sy->line < 0 || reached[sy->ir_var])
+	return;
+    reached[sy->ir_var] = 1;
+    work[(*nr_work)++] = sy->ir_var;
+}
+
+//an expression with a call is computed even if its value is not used
+int ir_has_call(int expr)
+{
+    for(int n = nodes[expr].b; n <= nodes[expr].a; n++)
+	if(nodes[n].kind == N_CALL)
+	    return 1;
+    return 0;
+}
+
+int ir_global_dce()
+{
+    char* reached = (char*)calloc(nr_ir_functions + 1, 1);
+    int* work = (int*)malloc(sizeof(int) * (nr_ir_functions + 1));
+    if(reached == NULL || work == NULL)
+	err("not enough memory");
+    int nr_work = 0, changes = 0;
+    for(int k = 0; k < nr_ir_functions; k++)
+	if(ir_functions[k].sy->name_id == NAME_MAIN)
+	    ir_reach_function(ir_functions[k].sy, reached, work, &nr_work);
+    for(int n = program; n != 0; n = nodes[n].next)
+	if(nodes[n].kind == N_VAR && nodes[n].b != 0)
+	    for(int e = nodes[nodes[n].b].b; e <= nodes[nodes[n].b].a; e++)
+		if(nodes[e].kind == N_CALL)
+		    ir_reach_function(node_symbol(e), reached, work, &nr_work);
+    while(nr_work > 0)
+    {
+	IrFunction* f = &ir_functions[work[--nr_work]];
+	for(int k = 0; k < f->nr_blocks; k++)
+	    for(int x = ir_blocks[f->blocks[k]].first; x != 0; x = ir[x].next)
+		if(ir[x].op == I_CALL)
+		    ir_reach_function(ir[x].sy, reached, work, &nr_work);
+    }
+    int nr = 0;
+    for(int k = 0; k < nr_ir_functions; k++)
+    {
+	if(reached[k])
+	{
+	    ir_functions[k].sy->ir_var = nr;
+	    ir_functions[nr++] = ir_functions[k];
+	}
+	else
+	{
+	    free(ir_functions[k].blocks);
+	    changes++;
+	}
+    }
+    nr_ir_functions = nr;
+    free(reached);
+    free(work);
+
+    //the globals read by the functions left and by the initializations of the globals kept,
+    //an initialization reads only the globals declared before it
+    for(int n = program; n != 0; n = nodes[n].next)
+	if(nodes[n].kind == N_VAR)
+	    bindings[nodes[n].tk]->ir_flags &= ~(IR_READ | IR_UNUSED);
+    for(int k = 0; k < nr_ir_functions; k++)
+	ir_mark_reads(&ir_functions[k]);
+    int* globals = (int*)malloc(sizeof(int) * nr_nodes);
+    if(globals == NULL)
+	err("not enough memory");
+    int nr_declared = 0;
+    for(int n = program; n != 0; n = nodes[n].next)
+	if(nodes[n].kind == N_VAR)
+	    globals[nr_declared++] = n;
+    for(int k = nr_declared - 1; k >= 0; k--)
+    {
+	int n = globals[k], expr = nodes[n].b;
+	Symbol* sy = bindings[nodes[n].tk];
+	if(!(sy->ir_flags & IR_READ) && (expr == 0 || !ir_has_call(expr)))
+	{
+	    sy->ir_flags |= IR_UNUSED;
+	    changes++;
+	    continue;
+	}
+	if(expr != 0)
+	    for(int e = nodes[expr].b; e <= nodes[expr].a; e++)
+		if(nodes[e].kind == N_NAME)
+		    bindings[nodes[e].tk]->ir_flags |= IR_READ;
+    }
+    free(globals);
+    for(int k = 0; k < nr_ir_functions; k++)
+    {
+	IrFunction* f = &ir_functions[k];
+	for(int b = 0; b < f->nr_blocks; b++)
+	    for(int x = ir_blocks[f->blocks[b]].first, next; x != 0; x = next)
+	    {
+		next = ir[x].next;
+		Symbol* sy = ir[x].op == I_STORE_GLOBAL ? ir[x].sy : NULL;
+		if(ir[x].op == I_STORE || ir[x].op == I_COPY)
+		    sy = ir_address_root(ir[x].args[0]);
+		if(sy == NULL || !is_global(sy) || (sy->ir_flags & IR_READ))
+		    continue;
+		ir_unlink(x);
+		ir[x].block = 0;
+		changes++;
+	    }
+    }
+    return changes;
+}
+
+/*  the inlining: a call of a small function which can not call itself again, even through other
+    functions, and whose variables are all values, is replaced by a copy of its blocks. The arguments
+    are the values given by the call and the returns jump to the rest of the block of the call, where a
+    phi gets the returned value. It runs before sccp, so the constant arguments are folded in the copy */
+int inline_size=20; // the most instructions of an inlined function (-InlineSize=N)
+
+int* ir_clone=NULL; // the copy of each instruction and of each block of the inlined function
+int* ir_clone_block=NULL;
+int cap_ir_clone=0;
+int cap_ir_clone_block=0;
+int* ir_block_after=NULL; // the order of the blocks of the function while its calls are inlined
+int cap_ir_block_after=0;
+
+//the instructions of a function which compute or return, -1 when it has variables in memory
+int ir_inline_cost(IrFunction* g)
+{
+    int cost = 0;
+    for(int k = 0; k < g->nr_blocks; k++)
+	for(int x = ir_blocks[g->blocks[k]].first; x != 0; x = ir[x].next)
+	{
+	    if(ir[x].op == I_FRAME || (ir[x].op == I_ADDR && !is_global(ir[x].sy)))
+		return -1;
+	    if(ir[x].op != I_CONST && ir[x].op != I_PARAM && ir[x].op != I_PHI && ir[x].op != I_JMP)
+		cost++;
+	}
+    return cost;
+}
+
+//the functions which can call themselves are found as the strongly connected components of the
+//calls (Tarjan), with more than one function or with a function which calls itself
+int* ir_scc_index=NULL; // the order in which the functions are visited from 1, 0 before
+int* ir_scc_low=NULL;
+int* ir_scc_stack=NULL;
+int nr_ir_scc_stack=0;
+int ir_scc_visited=0;
+char* ir_recursive=NULL;
+
+void ir_find_recursion(int k)
+{
+    ir_scc_index[k] = ir_scc_low[k] = ++ir_scc_visited;
+    ir_scc_stack[nr_ir_scc_stack++] = k;
+    IrFunction* f = &ir_functions[k];
+    for(int b = 0; b < f->nr_blocks; b++)
+	for(int x = ir_blocks[f->blocks[b]].first; x != 0; x = ir[x].next)
+	{
+	    if(ir[x].op != I_CALL || ir[x].sy->line < 0)
+		continue;
+	    int callee = ir[x].sy->ir_var;
+	    if(callee == k)
+		ir_recursive[k] = 1;
+	    if(ir_scc_index[callee] == 0)
+	    {
+		ir_find_recursion(callee);
+		if(ir_scc_low[callee] < ir_scc_low[k])
+		    ir_scc_low[k] = ir_scc_low[callee];
+	    }
+	    else if(ir_scc_index[callee] > 0 && ir_scc_index[callee] < ir_scc_low[k]) // still on the stack
+		ir_scc_low[k] = ir_scc_index[callee];
+	}
+    if(ir_scc_low[k] != ir_scc_index[k])
+	return;
+    int first = nr_ir_scc_stack;
+    do
+	first--;
+    while(ir_scc_stack[first] != k);
+    for(int s = first; s < nr_ir_scc_stack; s++)
+    {
+	if(nr_ir_scc_stack - first > 1)
+	    ir_recursive[ir_scc_stack[s]] = 1;
+	ir_scc_index[ir_scc_stack[s]] = -1; // done
+    }
+    nr_ir_scc_stack = first;
+}
+
+//the call x in block b of f is replaced by a copy of the blocks of g
+void ir_inline_call(IrFunction* f, int b, int x, IrFunction* g)
+{
+    if(cap_ir_clone < nr_ir || cap_ir_clone_block < nr_ir_blocks)
+    {
+	cap_ir_clone = nr_ir * 2;
+	cap_ir_clone_block = nr_ir_blocks * 2;
+	ir_clone = (int*)realloc(ir_clone, sizeof(int) * cap_ir_clone);
+	ir_clone_block = (int*)realloc(ir_clone_block, sizeof(int) * cap_ir_clone_block);
+	if(ir_clone == NULL || ir_clone_block == NULL)
+	    err("not enough memory");
+    }
+    if(cap_ir_block_after < nr_ir_blocks + g->nr_blocks + 1)
+    {
+	cap_ir_block_after = (nr_ir_blocks + g->nr_blocks + 1) * 2;
+	ir_block_after = (int*)realloc(ir_block_after, sizeof(int) * cap_ir_block_after);
+	if(ir_block_after == NULL)
+	    err("not enough memory");
+    }
+    //the instructions after the call go to a new block, which takes the place of b in its successors
+    int rest = ir_new_block();
+    ir_blocks[rest].sealed = 1;
+    for(int y = ir[x].next, next; y != 0; y = next)
+    {
+	next = ir[y].next;
+	ir_unlink(y);
+	ir_append(rest, y);
+    }
+    int last = ir_blocks[rest].last;
+    for(int s = 0; s < 2 && last != 0; s++)
+    {
+	int succ = ir[last].target[s];
+	if(succ == 0 || (s == 1 && succ == ir[last].target[0]))
+	    continue;
+	for(int p = 0; p < ir_blocks[succ].nr_preds; p++)
+	    if(ir_blocks[succ].preds[p] == b)
+		ir_blocks[succ].preds[p] = rest;
+    }
+
+    //the blocks of g are copied after b, the returns jump to rest
+    int first = f->nr_blocks;
+    for(int k = 0; k < g->nr_blocks; k++)
+    {
+	int copy = ir_new_block();
+	ir_blocks[copy].sealed = 1;
+	ir_clone_block[g->blocks[k]] = copy;
+	ir_place(f, copy);
+    }
+    ir_place(f, rest);
+    for(int k = 0; k < g->nr_blocks; k++)
+    {
+	int from = g->blocks[k], copy = ir_clone_block[from];
+	for(int p = 0; p < ir_blocks[from].nr_preds; p++)
+	    ir_add_pred(copy, ir_clone_block[ir_blocks[from].preds[p]]);
+	for(int y = ir_blocks[from].first; y != 0; y = ir[y].next)
+	{
+	    if(ir[y].op == I_PARAM) // the argument of the call with the same slot
+	    {
+		int j = 0;
+		for(int arg = nodes[g->node].a; arg != 0; arg = nodes[arg].next, j++)
+		    if(bindings[nodes[arg].tk]->slot == ir[y].i)
+			ir_clone[y] = ir[x].args[j];
+		continue;
+	    }
+	    int z = ir_new(ir[y].op == I_RET ? I_JMP : ir[y].op, ir[y].type, ir[y].tk);
+	    ir[z].sy = ir[y].sy;
+	    ir[z].d = ir[y].d;
+	    for(int s = 0; s < 2; s++)
+		ir[z].target[s] = ir[y].target[s] ? ir_clone_block[ir[y].target[s]] : 0;
+	    if(ir[y].op == I_RET)
+	    {
+		ir[z].type = _VOID;
+		ir[z].target[0] = rest;
+		ir_add_pred(rest, copy);
+	    }
+	    ir_append(copy, z);
+	    ir_clone[y] = z;
+	}
+    }
+    int value = 0;
+    if(ir[x].type != _VOID)
+    {
+	value = ir_new(I_PHI, ir[x].type, ir[x].tk);
+	ir_insert_before(ir_blocks[rest].first, value);
+    }
+    for(int k = 0; k < g->nr_blocks; k++)
+	for(int y = ir_blocks[g->blocks[k]].first; y != 0; y = ir[y].next)
+	{
+	    if(ir[y].op == I_PARAM)
+		continue;
+	    if(ir[y].op == I_RET)
+	    {
+		if(value != 0)
+		    ir_arg(value, ir_clone[ir[y].args[0]]);
+		continue;
+	    }
+	    for(int a = 0; a < ir[y].nr_args; a++)
+		ir_arg(ir_clone[y], ir_clone[ir[y].args[a]]);
+	}
+
+    //b jumps to the copy of the entry, the blocks are placed after b
+    ir_replace(x, value);
+    int jmp = ir_new(I_JMP, _VOID, ir[x].tk);
+    ir[jmp].target[0] = ir_clone_block[g->blocks[0]];
+    ir_append(b, jmp);
+    ir_add_pred(ir[jmp].target[0], b);
+    ir_block_after[rest] = ir_block_after[b];
+    for(int k = f->nr_blocks - 1; k >= first; k--)
+	ir_block_after[k == first ? b : f->blocks[k - 1]] = f->blocks[k];
+}
+
+int ir_inline()
+{
+    int changes = 0;
+    ir_scc_index = (int*)calloc(nr_ir_functions + 1, sizeof(int));
+    ir_scc_low = (int*)malloc(sizeof(int) * (nr_ir_functions + 1));
+    ir_scc_stack = (int*)malloc(sizeof(int) * (nr_ir_functions + 1));
+    ir_recursive = (char*)calloc(nr_ir_functions + 1, 1);
+    int* cost = (int*)malloc(sizeof(int) * (nr_ir_functions + 1));
+    if(ir_scc_index == NULL || ir_scc_low == NULL || ir_scc_stack == NULL || ir_recursive == NULL || cost == NULL)
+	err("not enough memory");
+    ir_scc_visited = nr_ir_scc_stack = 0;
+    for(int k = 0; k < nr_ir_functions; k++)
+    {
+	if(ir_scc_index[k] == 0)
+	    ir_find_recursion(k);
+	cost[k] = ir_inline_cost(&ir_functions[k]);
+    }
+    for(int k = 0; k < nr_ir_functions; k++)
+    {
+	IrFunction* f = &ir_functions[k];
+	if(cap_ir_block_after < nr_ir_blocks)
+	{
+	    cap_ir_block_after = nr_ir_blocks * 2;
+	    ir_block_after = (int*)realloc(ir_block_after, sizeof(int) * cap_ir_block_after);
+	    if(ir_block_after == NULL)
+		err("not enough memory");
+	}
+	for(int i = 0; i < f->nr_blocks; i++)
+	    ir_block_after[f->blocks[i]] = i + 1 < f->nr_blocks ? f->blocks[i + 1] : 0;
+	/* the copies come right after the block of the call, so their calls are inlined too; the calls
+	   of a block are inlined from the last one, so the instructions after a call are moved once */
+	for(int b = f->blocks[0]; b != 0; b = ir_block_after[b])
+	    for(int x = ir_blocks[b].last, prev; x != 0; x = prev)
+	    {
+		prev = ir[x].prev;
+		if(ir[x].op != I_CALL || ir[x].sy->line < 0)
+		    continue;
+		int g = ir[x].sy->ir_var;
+		if(ir_recursive[g] || cost[g] < 0 || cost[g] > inline_size)
+		    continue;
+		ir_inline_call(f, b, x, &ir_functions[g]);
+		changes++;
+	    }
+	int nr = 0;
+	for(int b = f->blocks[0]; b != 0; b = ir_block_after[b])
+	    f->blocks[nr++] = b;
+	ir_apply_forwards(f);
+	ir_remove_trivial_phis(f);
+	cost[k] = ir_inline_cost(f);
+    }
+    free(ir_scc_index); free(ir_scc_low); free(ir_scc_stack); free(ir_recursive);
+    free(cost);
+    return changes;
+}
+
+/*  the loops: a back edge jumps to a block which dominates the block it leaves, the header. The
+    natural loop of the header is the header and the blocks which reach the back edges without
+    passing through it. A loop is changed only after it has a preheader, the single block outside
+    which jumps to the header; the inner loops come after their outer loops in the reverse postorder,
+    so they are changed first */
+char* ir_in_loop=NULL; // the blocks of the loop being changed
+int cap_ir_in_loop=0;
+
+//the headers of the loops which can be reached, the innermost last
+int ir_find_headers(IrFunction* f, int* headers)
+{
+    ir_compute_dominators(f);
+    int nr = 0;
+    for(int k = 0; k < nr_ir_order; k++)
+    {
+	int h = ir_order[k];
+	for(int p = 0; p < ir_blocks[h].nr_preds; p++)
+	{
+	    int pred = ir_blocks[h].preds[p];
+	    if(ir_blocks[pred].rpo >= ir_blocks[h].rpo && ir_dominates(h, pred)) // a jump back
+	    {
+		headers[nr++] = h;
+		break;
+	    }
+	}
+    }
+    return nr;
+}
+
+//marks the blocks of the loop of the header h in ir_in_loop
+void ir_find_loop(int h)
+{
+    if(cap_ir_in_loop < nr_ir_blocks + 1) // and the preheader which may be added
+    {
+	cap_ir_in_loop = nr_ir_blocks * 2;
+	ir_in_loop = (char*)realloc(ir_in_loop, cap_ir_in_loop);
+	if(ir_in_loop == NULL)
+	    err("not enough memory");
+    }
+    memset(ir_in_loop, 0, cap_ir_in_loop);
+    ir_in_loop[h] = 1;
+    nr_ir_work = 0;
+    for(int p = 0; p < ir_blocks[h].nr_preds; p++)
+    {
+	int pred = ir_blocks[h].preds[p];
+	if(ir_blocks[pred].rpo >= 0 && !ir_in_loop[pred] && ir_dominates(h, pred))
+	{
+	    ir_in_loop[pred] = 1;
+	    ir_push_work(pred);
+	}
+    }
+    while(nr_ir_work > 0)
+    {
+	int b = ir_work[--nr_ir_work];
+	for(int p = 0; p < ir_blocks[b].nr_preds; p++)
+	{
+	    int pred = ir_blocks[b].preds[p];
+	    if(ir_blocks[pred].rpo >= 0 && !ir_in_loop[pred])
+	    {
+		ir_in_loop[pred] = 1;
+		ir_push_work(pred);
+	    }
+	}
+    }
+}
+
+//the preheader of the loop of h, a new block when the jumps from outside do not come from one block
+//which only jumps to h
+int ir_preheader(IrFunction* f, int h)
+{
+    int outside = 0, pred = 0;
+    for(int p = 0; p < ir_blocks[h].nr_preds; p++)
+	if(!ir_in_loop[ir_blocks[h].preds[p]])
+	{
+	    outside++;
+	    pred = ir_blocks[h].preds[p];
+	}
+    if(outside == 0) // the entry
+	return 0;
+    if(outside == 1 && ir[ir_blocks[pred].last].op == I_JMP)
+	return pred;
+    int ph = ir_new_block();
+    ir_blocks[ph].sealed = 1;
+    ir_blocks[ph].rpo = -1;
+    //the jumps from outside go to the preheader, its phis get their operands
+    int* preds = ir_blocks[h].preds;
+    int nr_preds = ir_blocks[h].nr_preds;
+    for(int p = 0; p < nr_preds; p++)
+    {
+	if(ir_in_loop[preds[p]])
+	    continue;
+	ir_add_pred(ph, preds[p]);
+	int last = ir_blocks[preds[p]].last;
+	for(int s = 0; s < 2; s++)
+	    if(ir[last].target[s] == h)
+		ir[last].target[s] = ph;
+    }
+    int* args = (int*)malloc(sizeof(int) * (nr_preds + 1));
+    if(args == NULL)
+	err("not enough memory");
+    for(int x = ir_blocks[h].first; x != 0 && ir[x].op == I_PHI; x = ir[x].next)
+    {
+	int phi = ir_new(I_PHI, ir[x].type, ir[x].tk);
+	ir_append(ph, phi);
+	int nr = 0;
+	args[nr++] = phi;
+	for(int p = 0; p < nr_preds; p++)
+	    if(ir_in_loop[preds[p]])
+		args[nr++] = ir[x].args[p];
+	    else
+		ir_arg(phi, ir[x].args[p]);
+	memcpy(ir[x].args, args, sizeof(int) * nr);
+	ir[x].nr_args = nr;
+    }
+    int nr = 0;
+    args[nr++] = ph;
+    for(int p = 0; p < nr_preds; p++)
+	if(ir_in_loop[preds[p]])
+	    args[nr++] = preds[p];
+    memcpy(preds, args, sizeof(int) * nr);
+    ir_blocks[h].nr_preds = nr;
+    free(args);
+    int jmp = ir_new(I_JMP, _VOID, ir[ir_blocks[h].last].tk);
+    ir[jmp].target[0] = h;
+    ir_append(ph, jmp);
+    for(int x = ir_blocks[ph].first; x != jmp; )
+    {
+	int next = ir[x].next;
+	ir_remove_trivial_phi(x);
+	x = next;
+    }
+    //the preheader is placed right before the header
+    int at = 0;
+    while(f->blocks[at] != h)
+	at++;
+    ir_place(f, ph);
+    memmove(f->blocks + at + 1, f->blocks + at, sizeof(int) * (f->nr_blocks - 1 - at));
+    f->blocks[at] = ph;
+    return ph;
+}
+
+/*  the loop invariant code motion: the values computed in a loop from values computed before it are
+    computed once in the preheader. Only the instructions which can not stop the program are moved,
+    as the loop may not run at all, and the loads only from the loops without stores and calls */
+int ir_hoistable(int x, int writes)
+{
+    switch(ir[x].op)
+    {
+	case I_ADD: case I_SUB: case I_MUL: case I_NEG: case I_NOT:
+	case I_SHL: case I_SHR: case I_USHR: case I_MULHI:
+	case I_EQUAL: case I_NOTEQ: case I_LESS: case I_LESSEQ: case I_GREATER: case I_GREATEREQ:
+	case I_CONV: case I_INDEX: case I_FIELD:
+	    return 1;
+	case I_DIV: return ir_removable(x);
+	case I_LOAD: return !writes && ir_removable(x);
+	case I_LOAD_GLOBAL: return !writes;
+	default: return 0;
+    }
+}
+
+//a value which does not change in the loop, the ones computed again at every use may be in it
+int ir_loop_invariant(int v)
+{
+    switch(ir[v].op)
+    {
+	case I_CONST: case I_PARAM: case I_ADDR: case I_FRAME: return 1;
+	default: return !ir_in_loop[ir[v].block];
+    }
+}
+
+//the value is moved to the preheader, if it is in the loop
+void ir_before_loop(int v, int ph)
+{
+    if(!ir_in_loop[ir[v].block])
+	return;
+    ir_unlink(v);
+    ir_insert_before(ir_blocks[ph].last, v);
+}
+
+int ir_hoist(IrFunction* f, int h, int ph)
+{
+    (void)f, (void)h; // the loop is in ir_order and ir_in_loop
+    int writes = 0, changes = 0;
+    for(int k = 0; k < nr_ir_order; k++)
+	if(ir_in_loop[ir_order[k]])
+	    for(int x = ir_blocks[ir_order[k]].first; x != 0; x = ir[x].next)
+		writes |= ir[x].op == I_STORE || ir[x].op == I_STORE_GLOBAL || ir[x].op == I_COPY || ir[x].op == I_VECTOR || ir[x].op == I_CALL;
+    //in reverse postorder the operands in the loop are seen before their uses
+    for(int k = 0; k < nr_ir_order; k++)
+    {
+	if(!ir_in_loop[ir_order[k]])
+	    continue;
+	for(int x = ir_blocks[ir_order[k]].first, next; x != 0; x = next)
+	{
+	    next = ir[x].next;
+	    if(!ir_hoistable(x, writes))
+		continue;
+	    int a = 0;
+	    while(a < ir[x].nr_args && ir_loop_invariant(ir[x].args[a]))
+		a++;
+	    if(a < ir[x].nr_args)
+		continue;
+	    for(a = 0; a < ir[x].nr_args; a++)
+		ir_before_loop(ir[x].args[a], ph);
+	    ir_unlink(x);
+	    ir_insert_before(ir_blocks[ph].last, x);
+	    changes++;
+	}
+    }
+    return changes;
+}
+
+/*  the induction variables: a phi of the header which grows by a constant in each iteration, as i
+    in while(i < n) { ...; i = i + 1; }. When the loop exits only from its header, by a comparison of
+    the variable with a constant, and the variable starts with a constant, its uses after the loop get
+    the constant value it has then (iv). Its products by a value computed before the loop can become
+    phis too, which grow by the product of the step (sr). In the virtual machine the addition and the
+    copy of the new phi cost more than the multiplication, so sr is not in the default pipeline */
+
+//the step of the induction variable phi of h, its increment in *inc, 0 when phi is not one
+int ir_iv_step(int phi, int h, int ph, int* inc)
+{
+    if(ir[phi].op != I_PHI || ir[phi].type != _INT)
+	return 0;
+    int at = ir_pred_index(h, ph), step = 0;
+    *inc = 0;
+    for(int p = 0; p < ir[phi].nr_args; p++)
+    {
+	int v = ir[phi].args[p];
+	if(p == at)
+	    continue;
+	if(*inc != 0 && v != *inc)
+	    return 0;
+	*inc = v;
+    }
+    int v = *inc;
+    if(v == 0 || (ir[v].op != I_ADD && ir[v].op != I_SUB) || ir[v].type != _INT)
+	return 0;
+    int a = ir[v].args[0], b = ir[v].args[1];
+    if(ir[v].op == I_ADD && a != phi)
+    {
+	a = b;
+	b = ir[v].args[0];
+    }
+    if(a != phi || ir[b].op != I_CONST)
+	return 0;
+    step = ir[v].op == I_ADD ? ir[b].i : (int)(0u - (unsigned)ir[b].i);
+    return step;
+}
+
+//the product of two values before the jump of the preheader, folded when they are constants
+int ir_mul_before(int ph, int a, int b, int tk)
+{
+    int x;
+    if(ir[a].op == I_CONST && ir[b].op == I_CONST)
+    {
+	x = ir_new(I_CONST, _INT, tk);
+	ir[x].i = (int)((unsigned)ir[a].i * (unsigned)ir[b].i);
+    }
+    else
+    {
+	x = ir_new(I_MUL, _INT, tk);
+	ir_arg(x, a);
+	ir_arg(x, b);
+    }
+    ir_insert_before(ir_blocks[ph].last, x);
+    return x;
+}
+
+int ir_reduce_strength(IrFunction* f, int h, int ph)
+{
+    (void)f;
+    int changes = 0;
+    for(int k = 0; k < nr_ir_order; k++)
+    {
+	if(!ir_in_loop[ir_order[k]])
+	    continue;
+	for(int x = ir_blocks[ir_order[k]].first, next; x != 0; x = next)
+	{
+	    next = ir[x].next;
+	    if(ir[x].op != I_MUL || ir[x].type != _INT)
+		continue;
+	    //i * k or (i + step) * k, with k computed before the loop
+	    int iv = ir[x].args[0], factor = ir[x].args[1];
+	    if(!ir_loop_invariant(factor))
+	    {
+		iv = factor;
+		factor = ir[x].args[0];
+	    }
+	    if(!ir_loop_invariant(factor) || ir[factor].type != _INT)
+		continue;
+	    int phi = iv, inc = 0, step = 0;
+	    if(ir[iv].block != h || (step = ir_iv_step(phi, h, ph, &inc)) == 0)
+	    {
+		phi = ir[iv].op == I_ADD || ir[iv].op == I_SUB ? ir[iv].args[0] : 0;
+		if(phi == 0 || ir[phi].block != h || (step = ir_iv_step(phi, h, ph, &inc)) == 0 || inc != iv)
+		    continue;
+	    }
+	    //the new phi starts with the product of the start and grows by the product of the step
+	    ir_before_loop(factor, ph);
+	    int at = ir_pred_index(h, ph);
+	    int start = ir_mul_before(ph, ir[phi].args[at], factor, ir[x].tk);
+	    int c = ir_new(I_CONST, _INT, ir[x].tk);
+	    ir[c].i = step;
+	    ir_insert_before(ir_blocks[ph].last, c);
+	    int stride = ir_mul_before(ph, c, factor, ir[x].tk);
+	    int product = ir_new(I_PHI, _INT, ir[x].tk);
+	    ir_insert_before(ir_blocks[h].first, product);
+	    int grown = ir_new(I_ADD, _INT, ir[x].tk);
+	    ir_arg(grown, product);
+	    ir_arg(grown, stride);
+	    ir_insert_before(ir[inc].next, grown);
+	    for(int p = 0; p < ir_blocks[h].nr_preds; p++)
+		ir_arg(product, p == at ? start : grown);
+	    ir_replace(x, iv == phi ? product : grown);
+	    changes++;
+	}
+    }
+    return changes;
+}
+
+//the uses after the loop of the induction variables compared with a constant to exit
+int ir_exit_values(IrFunction* f, int h, int ph)
+{
+    int br = ir_blocks[h].last;
+    if(ir[br].op != I_BR || !ir_in_loop[ir[br].target[0]] || ir_in_loop[ir[br].target[1]])
+	return 0;
+    for(int k = 0; k < nr_ir_order; k++)
+    {
+	int b = ir_order[k], succ[2];
+	if(!ir_in_loop[b] || b == h)
+	    continue;
+	for(int s = ir_succs(b, succ) - 1; s >= 0; s--)
+	    if(!ir_in_loop[succ[s]])
+		return 0;
+    }
+    int cmp = ir[br].args[0], inc;
+    if(ir[cmp].op < I_LESS || ir[cmp].op > I_GREATEREQ || ir[cmp].nr_args != 2)
+	return 0;
+    int phi = ir[cmp].args[0], limit = ir[cmp].args[1], op = ir[cmp].op;
+    if(ir[phi].op == I_CONST) // n > i is i < n
+    {
+	phi = ir[cmp].args[1];
+	limit = ir[cmp].args[0];
+	op = op == I_LESS ? I_GREATER : op == I_LESSEQ ? I_GREATEREQ : op == I_GREATER ? I_LESS : I_LESSEQ;
+    }
+    if(ir[phi].op != I_PHI || ir[phi].block != h || ir[limit].op != I_CONST)
+	return 0;
+    int step = ir_iv_step(phi, h, ph, &inc);
+    int start = ir[phi].args[ir_pred_index(h, ph)];
+    if(step == 0 || ir[start].op != I_CONST)
+	return 0;
+    //the loop runs while i < n (or i > n when it goes down), the last value is the first which is not
+    long long i = ir[start].i, n = ir[limit].i, last;
+    switch(op)
+    {
+	case I_LESSEQ: n++; // fall through
+	case I_LESS:
+	    if(step < 0)
+		return 0;
+	    last = i >= n ? i : i + (n - i + step - 1) / step * step;
+	    break;
+	case I_GREATEREQ: n--; // fall through
+	case I_GREATER:
+	    if(step > 0)
+		return 0;
+	    last = i <= n ? i : i - (i - n - step - 1) / -step * -step;
+	    break;
+	default: return 0;
+    }
+    if(last < INT_MIN || last > INT_MAX)
+	return 0;
+    int value = 0, changes = 0;
+    for(int k = 0; k < f->nr_blocks; k++)
+    {
+	if(ir_in_loop[f->blocks[k]])
+	    continue;
+	for(int x = ir_blocks[f->blocks[k]].first; x != 0; x = ir[x].next)
+	    for(int a = 0; a < ir[x].nr_args; a++)
+	    {
+		if(ir[x].args[a] != phi)
+		    continue;
+		if(value == 0) // in the entry, it dominates all the uses
+		{
+		    value = ir_new(I_CONST, _INT, ir[phi].tk);
+		    ir[value].i = (int)last;
+		    ir_insert_before(ir_blocks[f->blocks[0]].first, value);
+		}
+		ir[x].args[a] = value;
+		changes++;
+	    }
+    }
+    return changes;
+}
+
+//the loops of f, from the innermost, get a preheader and are changed by loop_pass
+int ir_for_loops(IrFunction* f, int (*loop_pass)(IrFunction* f, int h, int ph))
+{
+    int* headers = (int*)malloc(sizeof(int) * (f->nr_blocks + 1));
+    if(headers == NULL)
+	err("not enough memory");
+    int changes = 0;
+    for(int k = ir_find_headers(f, headers) - 1; k >= 0; k--)
+    {
+	ir_compute_dominators(f);
+	ir_find_loop(headers[k]);
+	int ph = ir_preheader(f, headers[k]);
+	if(ph == 0)
+	    continue;
+	ir_compute_dominators(f);
+	changes += loop_pass(f, headers[k], ph);
+    }
+    free(headers);
+    ir_apply_forwards(f);
+    return changes;
+}
+
+int ir_licm(IrFunction* f)
+{
+    return ir_for_loops(f, ir_hoist);
+}
+
+int ir_induction(IrFunction* f)
+{
+    return ir_for_loops(f, ir_exit_values);
+}
+
+//a new int instruction before at, of the operand a (and b when it is not 0) and of the constant i
+int ir_int_before(int at, int op, int a, int b, int i)
+{
+    int x = ir_new(op, _INT, ir[at].tk);
+    ir_arg(x, a);
+    if(b != 0)
+	ir_arg(x, b);
+    ir[x].i = i;
+    ir_insert_before(at, x);
+    return x;
+}
+
+//n when k is 2^n, else -1
+int ir_log2(unsigned k)
+{
+    int n = 0;
+    if(k == 0 || (k & (k - 1)) != 0)
+	return -1;
+    while(k >>= 1)
+	n++;
+    return n;
+}
+
+/* the magic number m and the shift s of the quotient by d, whose absolute value is at least 3: the
+   upper half of the product by m, corrected by x when m has not the sign of d, shifted right by s
+   and plus 1 when it is negative (the signed division by constants of Hacker's Delight, 10-4) */
+void ir_magic(int d, int* m, int* s)
+{
+    const unsigned two31 = 0x80000000u;
+    unsigned ad = d < 0 ? 0u - (unsigned)d : (unsigned)d;
+    unsigned t = two31 + ((unsigned)d >> 31);
+    unsigned anc = t - 1 - t % ad; // the largest multiple of d minus 1 below 2^31
+    unsigned q1 = two31 / anc, r1 = two31 - q1 * anc;
+    unsigned q2 = two31 / ad, r2 = two31 - q2 * ad;
+    unsigned delta;
+    int p = 31;
+    do
+    {
+	p++;
+	q1 *= 2;
+	r1 *= 2;
+	if(r1 >= anc)
+	{
+	    q1++;
+	    r1 -= anc;
+	}
+	q2 *= 2;
+	r2 *= 2;
+	if(r2 >= ad)
+	{
+	    q2++;
+	    r2 -= ad;
+	}
+	delta = ad - r2;
+    } while(q1 < delta || (q1 == delta && r1 == 0));
+    *m = (int)(q2 + 1);
+    if(d < 0)
+	*m = (int)(0u - (unsigned)*m);
+    *s = p - 32;
+}
+
+//the product x of a by the constant k as a shift, 0 when k is not a power of two or its opposite
+int ir_mul_constant(int x, int a, int k)
+{
+    int n = ir_log2((unsigned)k), neg = 0;
+    if(n < 0)
+    {
+	n = ir_log2(0u - (unsigned)k);
+	neg = 1;
+    }
+    if(n <= 0) // 0, 1 and -1 are left to sccp
+	return 0;
+    int v = ir_int_before(x, I_SHL, a, 0, n);
+    return neg ? ir_int_before(x, I_NEG, v, 0, 0) : v;
+}
+
+//the quotient x of a by the constant d by shifts and a multiplication, 0 when it stays a division
+int ir_div_constant(int x, int a, int d)
+{
+    if(d == 0 || d == 1 || d == -1 || d == INT_MIN) // the error, a itself and INT_MIN / -1 which wraps around
+	return 0;
+    int n = ir_log2(d < 0 ? 0u - (unsigned)d : (unsigned)d), q;
+    if(n > 0)
+    {
+	//rounded toward 0: 2^n - 1 is added first to the negative ones
+	int bias = ir_int_before(x, I_USHR, n == 1 ? a : ir_int_before(x, I_SHR, a, 0, 31), 0, 32 - n);
+	q = ir_int_before(x, I_SHR, ir_int_before(x, I_ADD, a, bias, 0), 0, n);
+	return d < 0 ? ir_int_before(x, I_NEG, q, 0, 0) : q;
+    }
+    int m, s;
+    ir_magic(d, &m, &s);
+    q = ir_int_before(x, I_MULHI, a, 0, m);
+    if(d > 0 && m < 0)
+	q = ir_int_before(x, I_ADD, q, a, 0);
+    else if(d < 0 && m > 0)
+	q = ir_int_before(x, I_SUB, q, a, 0);
+    if(s > 0)
+	q = ir_int_before(x, I_SHR, q, 0, s);
+    return ir_int_before(x, I_ADD, q, ir_int_before(x, I_USHR, q, 0, 31), 0);
+}
+
+//the products and the quotients of the ints by constants, anywhere in f
+int ir_reduce_constants(IrFunction* f)
+{
+    int changes = 0;
+    for(int k = 0; k < f->nr_blocks; k++)
+	for(int x = ir_blocks[f->blocks[k]].first, next; x != 0; x = next)
+	{
+	    next = ir[x].next;
+	    if((ir[x].op != I_MUL && ir[x].op != I_DIV) || ir[x].type != _INT)
+		continue;
+	    int a = ir[x].args[0], c = ir[x].args[1], v;
+	    if(ir[x].op == I_MUL && ir[a].op == I_CONST)
+	    {
+		a = c;
+		c = ir[x].args[0];
+	    }
+	    if(ir[c].op != I_CONST)
+		continue;
+	    v = ir[x].op == I_MUL ? ir_mul_constant(x, a, ir[c].i) : ir_div_constant(x, a, ir[c].i);
+	    if(v != 0)
+	    {
+		ir_replace(x, v);
+		changes++;
+	    }
+	}
+    ir_apply_forwards(f);
+    return changes;
+}
+
+//the products in the loops by the induction variables first, then the ones by constants which are left
+int ir_strength(IrFunction* f)
+{
+    int changes = ir_for_loops(f, ir_reduce_strength);
+    return changes + ir_reduce_constants(f);
+}
+
+/*  the vectorization: a loop which only computes d[i] = a[i] op b[i] for i from its start while
+    i < n, growing by 1, where a and b are elements of vectors of ints or doubles or values computed
+    before the loop, is first run by an I_VECTOR in the preheader. The virtual machine computes it with
+    the SIMD instructions of the processor, several elements at once (O_VECTOR), and its value is the
+    index where it stopped, from which the loop computes the last elements. When the vectors overlap or
+    are not in the stack it does nothing and the loop computes all of them, with the same errors */
+
+//the address of the element phi of a vector whose address is computed before the loop
+int ir_vector_index(int v, int phi)
+{
+    return ir[v].op == I_INDEX && ir[v].i == 1 && ir[v].args[1] == phi && ir_loop_invariant(ir[v].args[0]);
+}
+
+//the vector of the element loaded by v at the index phi, or the value v computed before the loop
+int ir_vector_operand(int v, int phi, int type, int* operand)
+{
+    if(ir[v].type != type)
+	return -1;
+    if(ir_loop_invariant(v))
+    {
+	*operand = v;
+	return 1;
+    }
+    if(ir[v].op != I_LOAD || !ir_vector_index(ir[v].args[0], phi))
+	return -1;
+    *operand = ir[ir[v].args[0]].args[0];
+    return 0;
+}
+
+int ir_vectorize_loop(IrFunction* f, int h, int ph)
+{
+    (void)f;
+    int br = ir_blocks[h].last, body = ir[br].target[0];
+    if(ir[br].op != I_BR || body == h || !ir_in_loop[body] || ir_in_loop[ir[br].target[1]] || ir_blocks[h].nr_preds != 2 ||
+       ir_blocks[body].nr_preds != 1 || ir[ir_blocks[body].last].op != I_JMP || ir[ir_blocks[body].last].target[0] != h)
+	return 0;
+    //the header has only the phi of the index and its comparison with n
+    int phi = ir_blocks[h].first, cmp = ir[br].args[0], inc;
+    if(ir[phi].op != I_PHI || ir_iv_step(phi, h, ph, &inc) != 1 || ir[inc].block != body)
+	return 0;
+    for(int x = ir[phi].next; x != br; x = ir[x].next)
+	if(ir[x].op != I_CONST && x != cmp)
+	    return 0;
+    if(ir[cmp].op != I_LESS || ir[cmp].block != h || ir[cmp].args[0] != phi || !ir_loop_invariant(ir[cmp].args[1]))
+	return 0;
+    //the body has one operation, whose value is stored
+    int store = 0, x = 0;
+    for(int y = ir_blocks[body].first; y != 0; y = ir[y].next)
+	switch(ir[y].op)
+	{
+	    case I_CONST: case I_PARAM: case I_ADDR: case I_FRAME: case I_INDEX: case I_LOAD: case I_JMP: break;
+	    case I_STORE:
+		if(store != 0)
+		    return 0;
+		store = y;
+		break;
+	    case I_ADD: case I_SUB: case I_MUL: case I_DIV:
+		if(y == inc)
+		    break;
+		if(x != 0)
+		    return 0;
+		x = y;
+		break;
+	    default: return 0;
+	}
+    if(x == 0 || store == 0 || ir[store].args[1] != x || ir[store].i != ir[x].type || !ir_vector_index(ir[store].args[0], phi))
+	return 0;
+    int type = ir[x].type;
+    if((type != _INT || ir[x].op == I_DIV) && type != _DOUBLE)
+	return 0;
+    int operands[2], flags = 0;
+    for(int a = 0; a < 2; a++)
+    {
+	int scalar = ir_vector_operand(ir[x].args[a], phi, type, &operands[a]);
+	if(scalar < 0)
+	    return 0;
+	flags |= scalar ? VECTOR_SCALAR_A << a : 0;
+    }
+    if(flags == (VECTOR_SCALAR_A | VECTOR_SCALAR_B))
+	return 0;
+    //the other loads and addresses would be left for the loop
+    for(int y = ir_blocks[body].first; y != 0; y = ir[y].next)
+	if((ir[y].op == I_LOAD && y != ir[x].args[0] && y != ir[x].args[1]) ||
+	   (ir[y].op == I_INDEX && y != ir[store].args[0] && (ir[ir[x].args[0]].op != I_LOAD || y != ir[ir[x].args[0]].args[0]) &&
+	    (ir[ir[x].args[1]].op != I_LOAD || y != ir[ir[x].args[1]].args[0])))
+	    return 0;
+    int dest = ir[ir[store].args[0]].args[0], end = ir[cmp].args[1];
+    ir_before_loop(dest, ph);
+    ir_before_loop(operands[0], ph);
+    ir_before_loop(operands[1], ph);
+    ir_before_loop(end, ph);
+    int at = ir_pred_index(h, ph);
+    int vector = ir_new(I_VECTOR, _INT, ir[store].tk);
+    ir_arg(vector, dest);
+    ir_arg(vector, operands[0]);
+    ir_arg(vector, operands[1]);
+    ir_arg(vector, ir[phi].args[at]);
+    ir_arg(vector, end);
+    static const int ops[] = { [I_ADD] = O_ADD_I, [I_SUB] = O_SUB_I, [I_MUL] = O_MUL_I, [I_DIV] = O_DIV_I };
+    ir[vector].i = typed_op(ops[ir[x].op], type) | flags;
+    ir_insert_before(ir_blocks[ph].last, vector);
+    ir[phi].args[at] = vector;
+    return 1;
+}
+
+int ir_vectorize(IrFunction* f)
+{
+    return ir_for_loops(f, ir_vectorize_loop);
+}
+
+IrPass ir_passes[] = {
+    {"verify", ir_verify, NULL, "checks the jumps, the phis and that the values dominate their uses", 0, 0},
+    {"inline", NULL, ir_inline, "copies the small functions which can not call themselves in place of their calls", 0, 0},
+    {"sccp", ir_sccp, NULL, "replaces the values which are always the same constant, folds the branches always taken", 0, 0},
+    {"licm", ir_licm, NULL, "computes the values which do not change in a loop once before it", 0, 0},
+    {"iv", ir_induction, NULL, "gives the induction variables their constant values after the loops", 0, 0},
+    {"sr", ir_strength, NULL, "turns the products of the induction variables into induction variables, the ones and the quotients by constants into shifts", 0, 0},
+    {"vectorize", ir_vectorize, NULL, "computes the loops over the elements of vectors with the SIMD instructions", 0, 0},
+    {"globaldce", NULL, ir_global_dce, "removes the functions not called from main and the globals never read", 0, 0},
+    {"dce", ir_dce, NULL, "removes the values not used and the stores to the local variables never read", 0, 0},
+    {"cfg", ir_simplify_cfg, NULL, "removes the unreachable blocks, merges the blocks and skips the empty ones", 0, 0},
+};
+#define NR_IR_PASSES (int)(sizeof(ir_passes) / sizeof(ir_passes[0]))
+
+char* ir_pipeline="inline,sccp,licm,iv,globaldce,dce,vectorize,cfg"; // the names of the passes separated by commas
+char* ir_dump=NULL; // the pass after which the SSA form is printed, "" after all of them
+
+IrPass* ir_find_pass(const char* name, int len)
+{
+    for(int k = 0; k < NR_IR_PASSES; k++)
+	if((int)strlen(ir_passes[k].name) == len && strncmp(ir_passes[k].name, name, len) == 0)
+	    return &ir_passes[k];
+    return NULL;
+}
+
+//the pipeline has only known passes
+int ir_check_pipeline(const char* pipeline)
+{
+    while(*pipeline)
+    {
+	int len = strcspn(pipeline, ",");
+	if(ir_find_pass(pipeline, len) == NULL)
+	{
+	    printf("Unknown pass '%.*s'\n", len, pipeline);
+	    return 0;
+	}
+	pipeline += len + (pipeline[len] == ',');
+    }
+    return 1;
+}
+
+void ir_dump_after(const char* name)
+{
+    if(ir_dump != NULL && (*ir_dump == '\0' || strcmp(ir_dump, name) == 0))
+	ir_print(name);
+}
+
+void ir_run_pipeline()
+{
+    ir_dump_after("lower");
+    for(const char* name = ir_pipeline; *name; )
+    {
+	int len = strcspn(name, ",");
+	IrPass* pass = ir_find_pass(name, len);
+	ir_pass_name = pass->name;
+	double start = seconds();
+	if(pass->run_program != NULL)
+	    pass->changes += pass->run_program();
+	else
+	    for(int k = 0; k < nr_ir_functions; k++)
+		pass->changes += pass->run(&ir_functions[k]);
+	pass->seconds += seconds() - start;
+	ir_dump_after(pass->name);
+	name += len + (name[len] == ',');
+    }
+    ir_pass_name = NULL;
+}
+
+void print_passes()
+{
+    printf("\nPasses of the SSA form (%d functions):\n", nr_ir_functions);
+    for(int k = 0; k < NR_IR_PASSES; k++)
+	printf("  %-10s %lf seconds, %d changes\n", ir_passes[k].name, ir_passes[k].seconds, ir_passes[k].changes);
+}
+
+/*  the SSA form is generated to bytecode again: the values used once, right after they are computed
+    in the same block, stay on the stack of the virtual machine as in gen_expr; the other values and
+    the phis get slots of the frame after the variables and the constants, the arguments and the
+    addresses are computed again at every use */
+int* ir_uses=NULL; // the number of uses of each value
+int* ir_use_block=NULL; // the block of the last use, -1 for a phi
+int* ir_slot=NULL; // the slot of a value, -1 when it has none
+char* ir_deferred=NULL; // the value stays on the stack until its use
+int cap_ir_gen=0;
+int* ir_block_pc=NULL; // the address of the code of each block
+int* ir_sim=NULL; // the values left on the stack while a block is simulated
+int nr_ir_sim=0;
+int* ir_jumps=NULL; // the jumps to blocks: the address of the jump followed by its block
+int nr_ir_jumps=0;
+int cap_ir_jumps=0;
+
+int ir_rematerialized(int x)
+{
+    return ir[x].op == I_CONST || ir[x].op == I_PARAM || ir[x].op == I_ADDR || ir[x].op == I_FRAME;
+}
+
+//the type of the instructions of the virtual machine, an address is an integer
+int ir_basic(int type)
+{
+    return type == IR_ADDRESS ? _INT : type;
+}
+
+//the slots of a structure passed by value as an operand of a call, 0 for the other operands
+int ir_by_value(int x, int a)
+{
+    if(ir[x].op != I_CALL || ir[x].sy->line < 0)
+	return 0;
+    Symbol* arg = ir[x].sy->args[a];
+    return arg->cls == FUNCTION_ARGUMENT && arg->type == _STRUCT ? element_slots(arg) : 0;
+}
+
+//the phis of a block get their values on the jumps to it, so a branch to it gets a block with this jump
+void ir_split_edges(IrFunction* f)
+{
+    int* blocks = (int*)malloc(sizeof(int) * (f->nr_blocks * 3 + 1));
+    if(blocks == NULL)
+	err("not enough memory");
+    int nr = 0;
+    for(int k = 0; k < f->nr_blocks; k++)
+    {
+	int b = f->blocks[k];
+	if(ir_blocks[b].first != 0 && ir[ir_blocks[b].first].op == I_PHI && ir_blocks[b].nr_preds > 1)
+	{
+	    for(int p = 0; p < ir_blocks[b].nr_preds; p++)
+	    {
+		int pred = ir_blocks[b].preds[p];
+		int jump = ir_blocks[pred].last;
+		if(ir[jump].op != I_BR)
+		    continue;
+		int stub = ir_new_block();
+		int x = ir_new(I_JMP, _VOID, ir[jump].tk);
+		ir[x].target[0] = b;
+		ir_append(stub, x);
+		ir_add_pred(stub, pred);
+		ir[jump].target[ir[jump].target[0] == b ? 0 : 1] = stub;
+		ir_blocks[b].preds[p] = stub;
+		blocks[nr++] = stub;
+	    }
+	}
+	blocks[nr++] = b;
+    }
+    free(f->blocks);
+    f->blocks = blocks;
+    f->nr_blocks = f->cap_blocks = nr;
+}
+
+void ir_undefer(int v)
+{
+    ir_deferred[v] = 0;
+    for(int k = nr_ir_sim - 1; k >= 0; k--)
+    {
+	if(ir_sim[k] != v)
+	    continue;
+	memmove(ir_sim + k, ir_sim + k + 1, sizeof(int) * (nr_ir_sim - k - 1));
+	nr_ir_sim--;
+	return;
+    }
+}
+
+//the operands left on the stack must be the first ones of the instruction, in order, on the top of the stack
+void ir_simulate_block(int b)
+{
+    nr_ir_sim = 0;
+    for(int x = ir_blocks[b].first; x != 0; x = ir[x].next)
+    {
+	if(ir[x].op == I_PHI || ir_rematerialized(x))
+	    continue;
+	int run = 0;
+	while(run < ir[x].nr_args && ir_deferred[ir[x].args[run]] && !ir_by_value(x, run))
+	    run++;
+	for(int a = run; a < ir[x].nr_args; a++)
+	    if(ir_deferred[ir[x].args[a]])
+		ir_undefer(ir[x].args[a]);
+	int on_top = nr_ir_sim >= run;
+	for(int a = 0; a < run && on_top; a++)
+	    on_top = ir_sim[nr_ir_sim - run + a] == ir[x].args[a];
+	if(on_top)
+	    nr_ir_sim -= run;
+	else
+	    for(int a = 0; a < run; a++)
+		ir_undefer(ir[x].args[a]);
+	if(ir_deferred[x])
+	    ir_sim[nr_ir_sim++] = x;
+    }
+    while(nr_ir_sim > 0)
+	ir_undefer(ir_sim[nr_ir_sim - 1]);
+}
+
+//the operands of a commutative operator are swapped when the second one can stay on the stack and the first can not
+void ir_swap_operands(int x)
+{
+    static const int mirror[] = { [I_ADD] = I_ADD, [I_MUL] = I_MUL, [I_EQUAL] = I_EQUAL, [I_NOTEQ] = I_NOTEQ,
+	[I_LESS] = I_GREATER, [I_LESSEQ] = I_GREATEREQ, [I_GREATER] = I_LESS, [I_GREATEREQ] = I_LESSEQ };
+    IrInstr* in = &ir[x];
+    if(in->op > I_GREATEREQ || mirror[in->op] == 0 || ir_deferred[in->args[0]] || !ir_deferred[in->args[1]])
+	return;
+    int first = in->args[0];
+    in->args[0] = in->args[1];
+    in->args[1] = first;
+    in->op = mirror[in->op];
+}
+
+/* a value used only by a phi of the block its block jumps to is computed directly in the slot of
+   the phi, when the phi is not used after it in the block and is not copied to another phi */
+int ir_phi_slot(int v)
+{
+    int b = ir[v].block;
+    int jump = ir_blocks[b].last;
+    if(ir_uses[v] != 1 || ir_use_block[v] != -1 || ir[jump].op != I_JMP)
+	return -1;
+    int to = ir[jump].target[0];
+    int index = ir_pred_index(to, b);
+    int phi = ir_blocks[to].first;
+    while(phi != 0 && ir[phi].op == I_PHI && ir[phi].args[index] != v)
+	phi = ir[phi].next;
+    if(phi == 0 || ir[phi].op != I_PHI)
+	return -1;
+    for(int x = ir[v].next; x != 0; x = ir[x].next)
+	for(int a = 0; a < ir[x].nr_args; a++)
+	    if(ir[x].args[a] == phi)
+		return -1;
+    for(int other = ir_blocks[to].first; other != 0 && ir[other].op == I_PHI; other = ir[other].next)
+	if(ir[other].args[index] == phi)
+	    return -1;
+    return ir_slot[phi];
+}
+
+void ir_jump_to(int op, int b, int tk)
+{
+    if(nr_ir_jumps + 2 > cap_ir_jumps)
+    {
+	cap_ir_jumps = cap_ir_jumps ? cap_ir_jumps * 2 : 256;
+	ir_jumps = (int*)realloc(ir_jumps, sizeof(int) * cap_ir_jumps);
+	if(ir_jumps == NULL)
+	    err("not enough memory");
+    }
+    ir_jumps[nr_ir_jumps++] = emit(op, tk, 0);
+    ir_jumps[nr_ir_jumps++] = b;
+}
+
+//push a value which is not on the stack
+void ir_gen_value(int v)
+{
+    int tk = ir[v].tk;
+    if(ir_slot[v] >= 0)
+    {
+	emit(typed_op(O_LOAD_I, ir_basic(ir[v].type)), tk, ir_slot[v]);
+	return;
+    }
+    switch(ir[v].op)
+    {
+	case I_CONST:
+	    if(ir[v].type == _DOUBLE)
+		emit_d(tk, ir[v].d);
+	    else
+		emit(O_CONST_I, tk, ir[v].i);
+	    break;
+	case I_PARAM: emit(typed_op(O_LOAD_I, ir_basic(ir[v].type)), tk, ir[v].i); break;
+	case I_ADDR: emit(is_global(ir[v].sy) ? O_ADDR_GLOBAL : O_ADDR, tk, ir[v].sy->slot); break;
+	case I_FRAME: emit(O_ADDR, tk, ir[v].i); break;
+    }
+}
+
+//the operation of an instruction whose operands are on the stack
+void ir_gen_op(int x)
+{
+    IrInstr* in = &ir[x];
+    int type = ir_basic(in->type);
+    switch(in->op)
+    {
+	case I_ADD: emit(typed_op(O_ADD_I, type), in->tk, 0); break;
+	case I_SUB: emit(typed_op(O_SUB_I, type), in->tk, 0); break;
+	case I_MUL: emit(typed_op(O_MUL_I, type), in->tk, 0); break;
+	case I_DIV: emit(typed_op(O_DIV_I, type), in->tk, 0); break;
+	case I_NEG: emit(type == _DOUBLE ? O_NEG_D : O_NEG_I, in->tk, 0); break;
+	case I_NOT: emit(O_NOT_I, in->tk, 0); break;
+	case I_SHL: case I_SHR: case I_USHR: case I_MULHI: emit(O_SHL_I + in->op - I_SHL, in->tk, in->i); break;
+	case I_EQUAL: case I_NOTEQ: case I_LESS: case I_LESSEQ: case I_GREATER: case I_GREATEREQ:
+	    emit(O_EQUAL_I + 2 * (in->op - I_EQUAL) + (ir[in->args[0]].type == _DOUBLE), in->tk, 0);
+	    break;
+	case I_CONV: gen_convert(ir_basic(ir[in->args[0]].type), type, in->tk); break;
+	case I_INDEX: emit(O_INDEX, in->tk, in->i); break;
+	case I_FIELD: emit(O_FIELD, in->tk, in->i); break;
+	case I_LOAD: emit(typed_op(O_LOAD_AT_I, type), in->tk, 0); break;
+	case I_STORE: emit(typed_op(O_MODIFY_AT_I, in->i), in->tk, 0); break;
+	case I_LOAD_GLOBAL: emit(typed_op(O_LOAD_GLOBAL_I, type), in->tk, in->sy->slot); break;
+	case I_STORE_GLOBAL: emit(typed_op(O_MODIFY_GLOBAL_I, in->sy->type), in->tk, in->sy->slot); break;
+	case I_COPY: emit(O_COPY, in->tk, in->i); break;
+	case I_VECTOR: emit(O_VECTOR, in->tk, in->i); break;
+	case I_CALL:
+	    if(in->sy->line >= 0)
+		emit(O_CALL, in->tk, 0); // the addresses of the functions are set after all are generated
+	    else
+		emit(predefined_op(in->sy), in->tk, 0);
+	    break;
+	case I_RET: emit(O_RET, in->tk, in->nr_args > 0); break;
+    }
+}
+
+//the phis of the block jumped to get their values from this block
+void ir_gen_phi_copies(int b, int to)
+{
+    int index = ir_pred_index(to, b), nr = 0, last = 0;
+    for(int phi = ir_blocks[to].first; phi != 0 && ir[phi].op == I_PHI; phi = ir[phi].next)
+    {
+	if(ir_slot[ir[phi].args[index]] == ir_slot[phi]) // computed in its slot
+	    continue;
+	ir_gen_value(ir[phi].args[index]);
+	nr++;
+	last = phi;
+    }
+    if(nr + 1 > max_stack)
+	max_stack = nr + 1;
+    for(int phi = last; nr > 0; phi = ir[phi].prev)
+    {
+	if(ir_slot[ir[phi].args[index]] == ir_slot[phi])
+	    continue;
+	emit(typed_op(O_STORE_I, ir_basic(ir[phi].type)), ir[phi].tk, ir_slot[phi]);
+	nr--;
+    }
+}
+
+void ir_generate(IrFunction* f)
+{
+    ir_split_edges(f);
+    ir_compute_order(f);
+    if(cap_ir_gen < nr_ir)
+    {
+	cap_ir_gen = nr_ir * 2;
+	ir_uses = (int*)realloc(ir_uses, sizeof(int) * cap_ir_gen);
+	ir_use_block = (int*)realloc(ir_use_block, sizeof(int) * cap_ir_gen);
+	ir_slot = (int*)realloc(ir_slot, sizeof(int) * cap_ir_gen);
+	ir_deferred = (char*)realloc(ir_deferred, cap_ir_gen);
+	ir_sim = (int*)realloc(ir_sim, sizeof(int) * cap_ir_gen);
+	if(ir_uses == NULL || ir_use_block == NULL || ir_slot == NULL || ir_deferred == NULL || ir_sim == NULL)
+	    err("not enough memory");
+    }
+    ir_block_pc = (int*)realloc(ir_block_pc, sizeof(int) * nr_ir_blocks);
+    if(ir_block_pc == NULL)
+	err("not enough memory");
+    for(int k = 0; k < f->nr_blocks; k++)
+	for(int x = ir_blocks[f->blocks[k]].first; x != 0; x = ir[x].next)
+	{
+	    ir_uses[x] = 0;
+	    ir_slot[x] = -1;
+	}
+    for(int k = 0; k < f->nr_blocks; k++)
+    {
+	int b = f->blocks[k];
+	if(ir_blocks[b].rpo < 0)
+	    continue;
+	for(int x = ir_blocks[b].first; x != 0; x = ir[x].next)
+	    for(int a = 0; a < ir[x].nr_args; a++)
+	    {
+		ir_uses[ir[x].args[a]]++;
+		ir_use_block[ir[x].args[a]] = ir[x].op == I_PHI ? -1 : b;
+	    }
+    }
+    //the values used once in their block try to stay on the stack
+    for(int k = 0; k < f->nr_blocks; k++)
+    {
+	int b = f->blocks[k];
+	for(int x = ir_blocks[b].first; x != 0; x = ir[x].next)
+	    ir_deferred[x] = ir[x].type != _VOID && ir[x].op != I_PHI && !ir_rematerialized(x) && ir_uses[x] == 1 && ir_use_block[x] == b;
+    }
+    int slots = f->sy->nr_slots;
+    for(int k = 0; k < f->nr_blocks; k++)
+    {
+	int b = f->blocks[k];
+	if(ir_blocks[b].rpo < 0)
+	    continue;
+	for(int x = ir_blocks[b].first; x != 0; x = ir[x].next)
+	    ir_swap_operands(x);
+	ir_simulate_block(b);
+	for(int x = ir_blocks[b].first; x != 0 && ir[x].op == I_PHI; x = ir[x].next)
+	    ir_slot[x] = slots++;
+    }
+    for(int k = 0; k < f->nr_blocks; k++)
+    {
+	int b = f->blocks[k];
+	if(ir_blocks[b].rpo < 0)
+	    continue;
+	for(int x = ir_blocks[b].first; x != 0; x = ir[x].next)
+	    if(ir[x].op != I_PHI && ir[x].type != _VOID && !ir_deferred[x] && !ir_rematerialized(x) && ir_uses[x] > 0)
+		ir_slot[x] = ir_phi_slot(x) >= 0 ? ir_phi_slot(x) : slots++;
+    }
+
+    int enter = emit(O_ENTER, nodes[f->node].tk, slots);
+    bytecode[enter].j = f->arg_slots;
+    f->sy->entry = enter;
+    f->sy->nr_slots = slots;
+    nr_ir_jumps = 0;
+    int depth = 0, peak = 0;
+    for(int k = 0; k < f->nr_blocks; k++)
+    {
+	int b = f->blocks[k];
+	if(ir_blocks[b].rpo < 0)
+	    continue;
+	int next = k + 1;
+	while(next < f->nr_blocks && ir_blocks[f->blocks[next]].rpo < 0)
+	    next++;
+	next = next < f->nr_blocks ? f->blocks[next] : 0;
+	ir_block_pc[b] = nr_instr;
+	for(int x = ir_blocks[b].first; x != 0; x = ir[x].next)
+	{
+	    IrInstr* in = &ir[x];
+	    if(in->op == I_PHI || ir_rematerialized(x))
+		continue;
+	    if(in->op == I_JMP && ir_blocks[in->target[0]].first != 0 && ir[ir_blocks[in->target[0]].first].op == I_PHI)
+		ir_gen_phi_copies(b, in->target[0]);
+	    int pushed = 0;
+	    for(int a = 0; a < in->nr_args; a++)
+	    {
+		int v = in->args[a];
+		if(ir_deferred[v]) // already on the stack
+		{
+		    depth--;
+		    pushed++;
+		    continue;
+		}
+		ir_gen_value(v);
+		pushed++;
+		int by_value_slots = ir_by_value(x, a);
+		if(by_value_slots > 0)
+		{
+		    emit(O_LOAD_STRUCT, in->tk, by_value_slots);
+		    pushed += by_value_slots - 1;
+		}
+		if(depth + pushed > peak)
+		    peak = depth + pushed;
+	    }
+	    switch(in->op)
+	    {
+		case I_JMP:
+		    if(in->target[0] != next)
+			ir_jump_to(O_JMP, in->target[0], in->tk);
+		    break;
+		case I_BR:
+		    if(in->target[1] == next)
+			ir_jump_to(O_JT, in->target[0], in->tk);
+		    else
+		    {
+			ir_jump_to(O_JF, in->target[1], in->tk);
+			if(in->target[0] != next)
+			    ir_jump_to(O_JMP, in->target[0], in->tk);
+		    }
+		    break;
+		default: ir_gen_op(x); break;
+	    }
+	    if(in->type == _VOID)
+		continue;
+	    if(ir_deferred[x])
+		depth++;
+	    else if(ir_slot[x] >= 0)
+		emit(typed_op(O_STORE_I, ir_basic(in->type)), in->tk, ir_slot[x]);
+	    else
+		emit(O_POP, in->tk, 1);
+	    if(depth + 1 > peak)
+		peak = depth + 1;
+	}
+    }
+    for(int k = 0; k < nr_ir_jumps; k += 2)
+	bytecode[ir_jumps[k]].i = ir_block_pc[ir_jumps[k + 1]];
+    //the values of a call and the constant of a comparison with 0.0 are pushed over the peak
+    if(peak + 2 > max_stack)
+	max_stack = peak + 2;
+}
+
+//the SSA form is not needed after the code is generated
+void ir_free()
+{
+    for(int x = 1; x < nr_ir; x++)
+	free(ir[x].args);
+    for(int b = 1; b < nr_ir_blocks; b++)
+    {
+	free(ir_blocks[b].preds);
+	free(ir_blocks[b].incomplete);
+	free(ir_blocks[b].defs);
+    }
+    for(int k = 0; k < nr_ir_functions; k++)
+	free(ir_functions[k].blocks);
+    free(ir_live); free(ir_clone); free(ir_clone_block); free(ir_in_loop);
+    free(ir); free(ir_blocks); free(ir_functions); free(ir_vars); free(ir_order);
+    free(ir_values); free(ir_parent); free(ir_loop_exits);
+    free(ir_uses); free(ir_use_block); free(ir_slot); free(ir_deferred); free(ir_block_pc); free(ir_sim); free(ir_jumps); free(ir_position);
+    free(ir_lattice); free(ir_users); free(ir_user_start); free(ir_user_end); free(ir_edges_taken); free(ir_work);
+    ir = NULL; ir_blocks = NULL; ir_functions = NULL; ir_vars = NULL; ir_order = NULL;
+    ir_values = ir_parent = ir_loop_exits = NULL;
+    ir_uses = ir_use_block = ir_slot = ir_block_pc = ir_sim = ir_jumps = NULL;
+    ir_deferred = ir_live = NULL;
+    ir_clone = ir_clone_block = NULL;
+    ir_in_loop = NULL;
+    ir_position = NULL;
+    cap_ir_position = 0;
+    ir_lattice = NULL;
+    ir_users = ir_user_start = ir_user_end = ir_edges_taken = ir_work = NULL;
+    cap_ir_lattice = cap_ir_users = cap_ir_work = cap_ir_live = cap_ir_clone = cap_ir_clone_block = cap_ir_in_loop = 0;
+    nr_ir = nr_ir_blocks = 1;
+    cap_ir = cap_ir_blocks = nr_ir_functions = cap_ir_vars = cap_ir_order = 0;
+    cap_ir_values = cap_ir_parent = cap_ir_loop_exits = cap_ir_gen = cap_ir_jumps = 0;
+}
+
+//a value on the stack of the virtual machine, the chars are kept as integers
+typedef union Value{
+    int i;
+    double d;
+}Value;
+
+/* the globals are at the bottom of the stack and the frames of the calls are above them: the
+   slots of the called function followed by the values of its expressions */
+Value* vm_stack=NULL;
+int cap_vm_stack=0;
+
+//what is needed to return from a call
+typedef struct Frame{
+    int return_address; // the instruction after the call
+    int fp; // the first slot of the frame of the caller
+}Frame;
+
+Frame* frames=NULL;
+int cap_frames=0;
+
+#define MAX_CALLS 1000000 // the depth of the calls after which the program is stopped
+
+//statistics of the execution
+long long executed_instr=0;
+long long executed_calls=0;
+int max_depth_calls=0;
+
+//the stack of the virtual machine has room for the given height and the deepest expression above it
+void grow_vm_stack(int height)
+{
+    if(height + max_stack <= cap_vm_stack)
+	return;
+    int old_cap = cap_vm_stack;
+    cap_vm_stack = (height + max_stack) * 2;
+    vm_stack = (Value*)realloc(vm_stack, sizeof(Value) * cap_vm_stack);
+    if(vm_stack == NULL)
+	err("not enough memory");
+    memset(vm_stack + old_cap, 0, sizeof(Value) * (cap_vm_stack - old_cap));
+}
+
+//the time in seconds for the predefined seconds()
+double seconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/* O_VECTOR: the loop d[k] = a[k] op b[k] runs on 2 elements at once with SSE2 and on 4 with AVX2,
+   when the processor has it. The elements are the slots of the stack, an int is in the low half of its
+   slot and the high half is never read, so the ints are computed as the doubles, 8 bytes apart */
+int simd_width=0; // the elements computed at once, 0 before the processor is asked
+
+#if defined(__x86_64__)
+//the operation of op on the 2 slots of a and b
+static inline __m128d vector_sse2(int op, __m128d a, __m128d b)
+{
+    __m128i x = _mm_castpd_si128(a), y = _mm_castpd_si128(b);
+    switch(op)
+    {
+	case O_ADD_I: return _mm_castsi128_pd(_mm_add_epi32(x, y));
+	case O_SUB_I: return _mm_castsi128_pd(_mm_sub_epi32(x, y));
+	case O_MUL_I: return _mm_castsi128_pd(_mm_mul_epu32(x, y)); // the low half of the product
+	case O_ADD_D: return _mm_add_pd(a, b);
+	case O_SUB_D: return _mm_sub_pd(a, b);
+	case O_MUL_D: return _mm_mul_pd(a, b);
+	default: return _mm_div_pd(a, b);
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256d vector_avx2(int op, __m256d a, __m256d b)
+{
+    __m256i x = _mm256_castpd_si256(a), y = _mm256_castpd_si256(b);
+    switch(op)
+    {
+	case O_ADD_I: return _mm256_castsi256_pd(_mm256_add_epi32(x, y));
+	case O_SUB_I: return _mm256_castsi256_pd(_mm256_sub_epi32(x, y));
+	case O_MUL_I: return _mm256_castsi256_pd(_mm256_mul_epu32(x, y));
+	case O_ADD_D: return _mm256_add_pd(a, b);
+	case O_SUB_D: return _mm256_sub_pd(a, b);
+	case O_MUL_D: return _mm256_mul_pd(a, b);
+	default: return _mm256_div_pd(a, b);
+    }
+}
+
+//a loop for each op, a and b grow by 0 when they are a value repeated
+#define VECTOR_CASE(code, width, load, store, compute) \
+    case code: \
+	for(int k = 0; k < n; k += width, a += width * step_a, b += width * step_b) \
+	    store(&d[k].d, compute(code, load(&a->d), load(&b->d))); \
+	break;
+#define VECTOR_LOOP(width, load, store, compute) \
+    switch(op) \
+    { \
+	VECTOR_CASE(O_ADD_I, width, load, store, compute) \
+	VECTOR_CASE(O_SUB_I, width, load, store, compute) \
+	VECTOR_CASE(O_MUL_I, width, load, store, compute) \
+	VECTOR_CASE(O_ADD_D, width, load, store, compute) \
+	VECTOR_CASE(O_SUB_D, width, load, store, compute) \
+	VECTOR_CASE(O_MUL_D, width, load, store, compute) \
+	VECTOR_CASE(O_DIV_D, width, load, store, compute) \
+    }
+
+static void vector_loop_sse2(int op, Value* d, Value* a, int step_a, Value* b, int step_b, int n)
+{
+    VECTOR_LOOP(2, _mm_loadu_pd, _mm_storeu_pd, vector_sse2)
+}
+
+__attribute__((target("avx2")))
+static void vector_loop_avx2(int op, Value* d, Value* a, int step_a, Value* b, int step_b, int n)
+{
+    VECTOR_LOOP(4, _mm256_loadu_pd, _mm256_storeu_pd, vector_avx2)
+}
+#endif
+
+//the operands d, a, b, start and end are on the stack from top, the index reached is returned
+int vector_run(Value* top, int op)
+{
+#if defined(__x86_64__)
+    if(simd_width == 0)
+	simd_width = __builtin_cpu_supports("avx2") ? 4 : 2;
+    long long start = top[3].i, n = ((long long)top[4].i - start) / simd_width * simd_width;
+    long long limit = top - vm_stack;
+    if(n <= 0)
+	return (int)start;
+    //the vectors are in the stack below the operands, a source is the destination or does not overlap it
+    Value* at[3];
+    Value repeated[2][4];
+    for(int k = 0; k < 3; k++)
+    {
+	if(k > 0 && (op & (VECTOR_SCALAR_A << (k - 1))))
+	{
+	    for(int r = 0; r < 4; r++)
+		repeated[k - 1][r] = top[k];
+	    at[k] = repeated[k - 1];
+	    continue;
+	}
+	long long first = top[k].i + start;
+	if(first < 0 || first + n > limit)
+	    return (int)start;
+	at[k] = vm_stack + first;
+	if(k > 0 && at[k] != at[0] && (at[k] < at[0] ? at[0] - at[k] : at[k] - at[0]) < n)
+	    return (int)start;
+    }
+    int step_a = !(op & VECTOR_SCALAR_A), step_b = !(op & VECTOR_SCALAR_B);
+    if(simd_width == 4)
+	vector_loop_avx2(op & 0xFF, at[0], at[1], step_a, at[2], step_b, n);
+    else
+	vector_loop_sse2(op & 0xFF, at[0], at[1], step_a, at[2], step_b, n);
+    return (int)(start + n);
+#else
+    return top[3].i; // the loop computes all the elements
+#endif
+}
+
+/*						*
+ *	       Execution Trace			*
+ *						*/
+
+/* the trace is off unless asked for: every executed instruction then writes a record of a fixed
+   size in a ring buffer, which is flushed to the trace file when it is full and at the end of
+   the execution; the records are decoded later with -DumpTrace */
+typedef struct TraceRecord{
+    int op;
+    int line; // the source line of the instruction
+    int operand; // the slot, the address or the target of the instruction
+    int depth; // the number of active calls
+    Value value; // the value stored, loaded or computed by the instruction
+}TraceRecord;
+
+#define TRACE_MAGIC "MCTRACE1"
+#define TRACE_RING_SIZE 65536 // a power of 2, the indexes are masked
+
+/* a single producer single consumer ring: the virtual machine only moves trace_head and the
+   flush only moves trace_tail, so the flush could run on another thread without a lock */
+TraceRecord* trace_ring=NULL;
+atomic_ulong trace_head;
+atomic_ulong trace_tail;
+FILE* trace_file=NULL;
+char* trace_name=NULL; // the source file name followed by .trace
+
+//writes the records between the tail and the head to the trace file
+void trace_flush()
+{
+    unsigned long tail = atomic_load_explicit(&trace_tail, memory_order_relaxed);
+    unsigned long head = atomic_load_explicit(&trace_head, memory_order_acquire);
+    while(tail != head)
+    {
+	unsigned long first = tail & (TRACE_RING_SIZE - 1);
+	unsigned long count = head - tail;
+	if(first + count > TRACE_RING_SIZE) // the records wrap around the end of the ring
+	    count = TRACE_RING_SIZE - first;
+	if(fwrite(trace_ring + first, sizeof(TraceRecord), count, trace_file) != count)
+	    err("cannot write the trace");
+	tail += count;
+    }
+    atomic_store_explicit(&trace_tail, tail, memory_order_release);
+}
+
+//flushes the last records and closes the trace file, also when the execution stops with an error
+void trace_close()
+{
+    if(trace_file == NULL)
+	return;
+    trace_flush();
+    fclose(trace_file);
+    trace_file = NULL;
+    free(trace_ring);
+    trace_ring = NULL;
+}
+
+//opens the trace file and writes its header
+void trace_open(const char* name)
+{
+    trace_file = fopen(name, "wb");
+    if(trace_file == NULL)
+	err("cannot open the trace file %s", name);
+    int record_size = sizeof(TraceRecord);
+    fwrite(TRACE_MAGIC, 1, 8, trace_file);
+    fwrite(&record_size, sizeof(int), 1, trace_file);
+    trace_ring = (TraceRecord*)malloc(sizeof(TraceRecord) * TRACE_RING_SIZE);
+    if(trace_ring == NULL)
+	err("not enough memory");
+    atomic_init(&trace_head, 0);
+    atomic_init(&trace_tail, 0);
+    atexit(trace_close);
+}
+
+//adds a record to the ring, the full ring is flushed first
+static inline void trace_record(int op, int line, int operand, int depth, Value value)
+{
+    unsigned long head = atomic_load_explicit(&trace_head, memory_order_relaxed);
+    if(head - atomic_load_explicit(&trace_tail, memory_order_acquire) == TRACE_RING_SIZE)
+	trace_flush();
+    TraceRecord* r = &trace_ring[head & (TRACE_RING_SIZE - 1)];
+    r->op = op;
+    r->line = line;
+    r->operand = operand;
+    r->depth = depth;
+    r->value = value;
+    atomic_store_explicit(&trace_head, head + 1, memory_order_release);
+}
+
+//the type of the value recorded for an op code: 'i', 'c', 'd' or 0 if there is no value
+char trace_value_kind(int op)
+{
+    switch(op)
+    {
+	case O_STORE_D: case O_LOAD_D: case O_MODIFY_D: case O_STORE_GLOBAL_D: case O_LOAD_GLOBAL_D:
+	case O_MODIFY_GLOBAL_D: case O_LOAD_AT_D: case O_MODIFY_AT_D: case O_ADD_D: case O_SUB_D:
+	case O_MUL_D: case O_DIV_D: case O_CONST_D: case O_NEG_D: case O_CONV_I_D: case O_PUT_D:
+	case O_GET_D: case O_SECONDS:
+	    return 'd';
+	case O_STORE_C: case O_LOAD_C: case O_MODIFY_C: case O_STORE_GLOBAL_C: case O_LOAD_GLOBAL_C:
+	case O_MODIFY_GLOBAL_C: case O_LOAD_AT_C: case O_MODIFY_AT_C: case O_ADD_C: case O_SUB_C:
+	case O_MUL_C: case O_DIV_C: case O_CONV_I_C: case O_PUT_C: case O_GET_C:
+	    return 'c';
+	case O_JMP: case O_ENTER: case O_LOAD_STRUCT: case O_RET: case O_POP: case O_HALT:
+	    return 0;
+	default:
+	    return 'i';
+    }
+}
+
+//prints the records of a trace file written with -Trace
+int dump_trace(const char* name)
+{
+    FILE* f = fopen(name, "rb");
+    if(f == NULL)
+    {
+	perror("ERROR opening the trace file\n");
+	return -1;
+    }
+    char magic[8];
+    int record_size;
+    if(fread(magic, 1, 8, f) != 8 || memcmp(magic, TRACE_MAGIC, 8) != 0 ||
+       fread(&record_size, sizeof(int), 1, f) != 1 || record_size != sizeof(TraceRecord))
+    {
+	printf("%s is not a trace of this compiler\n", name);
+	fclose(f);
+	return -1;
+    }
+    TraceRecord r;
+    long long nr = 0;
+    while(fread(&r, sizeof(TraceRecord), 1, f) == 1)
+    {
+	if(r.op < 0 || r.op > O_HALT)
+	{
+	    printf("invalid record %lld\n", nr);
+	    fclose(f);
+	    return -1;
+	}
+	printf("%10lld  line %-4d depth %-4d %-18s %-8d", nr, r.line, r.depth, print_op(r.op), r.operand);
+	switch(trace_value_kind(r.op))
+	{
+	    case 'i': printf(" %d", r.value.i); break;
+	    case 'c': // the characters which cannot be printed as they are, as '\0', are printed by their code
+		if(isprint((unsigned char)r.value.i))
+		    printf(" '%c'", (char)r.value.i);
+		else
+		    printf(" '\\%d'", (char)r.value.i);
+		break;
+	    case 'd': printf(" %lf", r.value.d); break;
+	}
+	printf("\n");
+	nr++;
+    }
+    fclose(f);
+    printf("\n%lld instructions traced\n", nr);
+    return 0;
+}
+
+/*						*
+ *	      Register Allocation		*
+ *						*/
+
+/* the native code keeps in registers the slots of the frame which are only loaded and stored by
+   their number, never through an address. The liveness of these slots over the bytecode of a
+   function gives each one a live interval, from the first instruction where it is used or live to
+   the last one, and a linear scan of the intervals by their start gives each one a free register of
+   its class: an xmm register for the slots of doubles, a general purpose one for the others. When
+   the registers of the class are taken the interval with the lowest spill cost stays in memory:
+   the cost is the loads and stores of the slot weighted by the depth of their loops, less the
+   writes and reads of the register around the calls it crosses, since the functions of the program
+   use the same registers and the runtime keeps only the ones the C convention keeps */
+#define RA_GP 5 // the general purpose registers: r15, r8, r9, r10, r11
+#define RA_KEPT 1 // the first ones are kept by the calls of the runtime
+#define RA_XMM 14 // xmm2 to xmm15
+#define RA_CANDIDATES 256 // the slots of a function which may get a register, the most used ones
+#define RA_WORDS (RA_CANDIDATES / 64)
+
+int ra_entry=-1; // the function allocated, -1 for none
+int ra_end=0;
+int* ra_reg=NULL; // the register of each slot: -1 in memory, below RA_GP a general purpose one, else RA_GP + an xmm one
+int* ra_index=NULL; // the candidate of each slot, -1 for none
+long long* ra_cost=NULL; // the weighted loads and stores of each slot, -1 for the slots with an address
+int cap_ra_slots=0;
+int ra_slot[RA_CANDIDATES]; // the slot of each candidate
+int nr_ra=0;
+unsigned long long* ra_live=NULL; // for each instruction of the function, the candidates live before it
+long cap_ra_live=0;
+int ra_registers=0; // the slots kept in registers, for the statistics
+
+//the functions start with O_ENTER and end before the next one
+int function_entry(int pc)
+{
+    while(bytecode[pc].op != O_ENTER)
+	pc--;
+    return pc;
+}
+
+int function_end(int entry)
+{
+    int pc = entry + 1;
+    while(pc < nr_instr && bytecode[pc].op != O_ENTER)
+	pc++;
+    return pc;
+}
+
+int ra_access(int op)
+{
+    return (op >= O_LOAD_I && op <= O_LOAD_D) || (op >= O_MODIFY_I && op <= O_MODIFY_D) || (op >= O_STORE_I && op <= O_STORE_D);
+}
+
+int ra_store(int op)
+{
+    return (op >= O_MODIFY_I && op <= O_MODIFY_D) || (op >= O_STORE_I && op <= O_STORE_D);
+}
+
+//the calls of the runtime, which keep the first RA_KEPT registers
+int ra_runtime_call(int op)
+{
+    switch(op)
+    {
+	case O_COPY: case O_VECTOR: case O_LOAD_STRUCT: case O_PUT_I: case O_PUT_D: case O_PUT_C:
+	case O_GET_I: case O_GET_D: case O_GET_C: case O_SECONDS:
+	    return 1;
+    }
+    return 0;
+}
+
+//an instruction in a nest of loops counts as if it ran 8 times for each of them
+long long ra_weight(int depth)
+{
+    return 1LL << (3 * (depth < 8 ? depth : 8));
+}
+
+int ra_is_live(int pc, int c)
+{
+    return ra_live[(long)(pc - ra_entry) * RA_WORDS + c / 64] >> (c % 64) & 1;
+}
+
+//the register of a slot of the function allocated, -1 if it stays in memory
+int ra_register(int slot)
+{
+    return ra_entry >= 0 && slot < bytecode[ra_entry].i ? ra_reg[slot] : -1;
+}
+
+//what a register saves on a candidate: its spill cost less the writes and reads around the calls
+#define RA_GAIN(c, r) (ra_cost[ra_slot[c]] - calls[c] - ((r) >= RA_KEPT ? runtime[c] : 0))
+
+//the allocation of the function which starts at entry, used until the next one
+void reg_alloc(int entry)
+{
+    int end = function_end(entry);
+    int nr_slots = bytecode[entry].i;
+    ra_entry = -1;
+    ra_end = end;
+    nr_ra = 0;
+    if(!REGISTERS)
+	return;
+    if(nr_slots > cap_ra_slots)
+    {
+	cap_ra_slots = nr_slots;
+	ra_reg = (int*)realloc(ra_reg, sizeof(int) * cap_ra_slots);
+	ra_index = (int*)realloc(ra_index, sizeof(int) * cap_ra_slots);
+	ra_cost = (long long*)realloc(ra_cost, sizeof(long long) * cap_ra_slots);
+    }
+    if((long)(end - entry) * RA_WORDS > cap_ra_live)
+    {
+	cap_ra_live = (long)(end - entry) * RA_WORDS;
+	ra_live = (unsigned long long*)realloc(ra_live, sizeof(unsigned long long) * cap_ra_live);
+    }
+    int* depth = (int*)calloc(end - entry, sizeof(int));
+    if((nr_slots && (ra_reg == NULL || ra_index == NULL || ra_cost == NULL)) || ra_live == NULL || depth == NULL)
+	err("not enough memory");
+    ra_entry = entry;
+
+    //the loops are the instructions from the target of a back jump to the jump
+    for(int pc = entry; pc < end; pc++)
+    {
+	Instr* ins = &bytecode[pc];
+	if((ins->op == O_JMP || ins->op == O_JF || ins->op == O_JT) && ins->i >= entry && ins->i <= pc)
+	    for(int k = ins->i; k <= pc; k++)
+		depth[k - entry]++;
+    }
+    //the spill costs, the slots whose address is taken (with the whole variable) stay in memory
+    for(int k = 0; k < nr_slots; k++)
+    {
+	ra_reg[k] = ra_index[k] = -1;
+	ra_cost[k] = 0;
+    }
+    for(int pc = entry + 1; pc < end; pc++)
+    {
+	Instr* ins = &bytecode[pc];
+	if(ins->op == O_ADDR)
+	{
+	    Symbol* sy = bindings[ins->tk];
+	    int size = sy != NULL && !is_global(sy) && sy->slot == ins->i ? symbol_slots(sy) : nr_slots - ins->i;
+	    for(int k = ins->i; k < ins->i + size && k < nr_slots; k++)
+		ra_cost[k] = -1;
+	}
+	else if(ra_access(ins->op) && ins->i < nr_slots && ra_cost[ins->i] >= 0)
+	    ra_cost[ins->i] += ra_weight(depth[pc - entry]);
+    }
+    //the candidates, by their costs
+    for(int k = 0; k < nr_slots; k++)
+    {
+	if(ra_cost[k] <= 0 || (nr_ra == RA_CANDIDATES && ra_cost[k] <= ra_cost[ra_slot[nr_ra - 1]]))
+	    continue;
+	int at = nr_ra < RA_CANDIDATES ? nr_ra++ : RA_CANDIDATES - 1;
+	for(; at > 0 && ra_cost[ra_slot[at - 1]] < ra_cost[k]; at--)
+	    ra_slot[at] = ra_slot[at - 1];
+	ra_slot[at] = k;
+    }
+    for(int c = 0; c < nr_ra; c++)
+	ra_index[ra_slot[c]] = c;
+
+    //the liveness, backwards until nothing changes
+    memset(ra_live, 0, sizeof(unsigned long long) * (end - entry) * RA_WORDS);
+    int changed;
+    do
+    {
+	changed = 0;
+	for(int pc = end - 1; pc >= entry; pc--)
+	{
+	    Instr* ins = &bytecode[pc];
+	    unsigned long long live[RA_WORDS];
+	    int next = ins->op != O_JMP && ins->op != O_RET && ins->op != O_HALT && pc + 1 < end;
+	    int jump = (ins->op == O_JMP || ins->op == O_JF || ins->op == O_JT) && ins->i >= entry && ins->i < end;
+	    for(int w = 0; w < RA_WORDS; w++)
+		live[w] = (next ? ra_live[(long)(pc + 1 - entry) * RA_WORDS + w] : 0) | (jump ? ra_live[(long)(ins->i - entry) * RA_WORDS + w] : 0);
+	    if(ra_access(ins->op) && ins->i < nr_slots && ra_index[ins->i] >= 0)
+	    {
+		int c = ra_index[ins->i];
+		if(ra_store(ins->op))
+		    live[c / 64] &= ~(1ULL << (c % 64));
+		else
+		    live[c / 64] |= 1ULL << (c % 64);
+	    }
+	    for(int w = 0; w < RA_WORDS; w++)
+		if(live[w] != ra_live[(long)(pc - entry) * RA_WORDS + w])
+		{
+		    ra_live[(long)(pc - entry) * RA_WORDS + w] = live[w];
+		    changed = 1;
+		}
+	}
+    }while(changed);
+
+    //the intervals, the classes and the calls crossed
+    int start[RA_CANDIDATES], stop[RA_CANDIDATES], is_int[RA_CANDIDATES];
+    long long calls[RA_CANDIDATES], runtime[RA_CANDIDATES];
+    for(int c = 0; c < nr_ra; c++)
+    {
+	start[c] = stop[c] = -1;
+	is_int[c] = 0;
+	calls[c] = runtime[c] = 0;
+    }
+    for(int pc = entry; pc < end; pc++)
+    {
+	Instr* ins = &bytecode[pc];
+	int access = ra_access(ins->op) && ins->i < nr_slots ? ra_index[ins->i] : -1;
+	if(access >= 0 && ins->op != O_LOAD_D && ins->op != O_STORE_D && ins->op != O_MODIFY_D)
+	    is_int[access] = 1;
+	for(int c = 0; c < nr_ra; c++)
+	{
+	    if(c != access && !ra_is_live(pc, c))
+		continue;
+	    if(start[c] < 0)
+		start[c] = pc;
+	    stop[c] = pc;
+	    if(pc + 1 < end && ra_is_live(pc + 1, c))
+	    {
+		if(ins->op == O_CALL)
+		    calls[c] += 2 * ra_weight(depth[pc - entry]);
+		else if(ra_runtime_call(ins->op))
+		    runtime[c] += 2 * ra_weight(depth[pc - entry]);
+	    }
+	}
+    }
+
+    //the linear scan: the intervals by their start take a free register or the one of a cheaper interval
+    int order[RA_CANDIDATES], owner[RA_GP + RA_XMM];
+    for(int c = 0; c < nr_ra; c++)
+    {
+	int at = c;
+	for(; at > 0 && start[order[at - 1]] > start[c]; at--)
+	    order[at] = order[at - 1];
+	order[at] = c;
+    }
+    for(int r = 0; r < RA_GP + RA_XMM; r++)
+	owner[r] = -1;
+    for(int k = 0; k < nr_ra; k++)
+    {
+	int c = order[k];
+	for(int r = 0; r < RA_GP + RA_XMM; r++)
+	    if(owner[r] >= 0 && stop[owner[r]] < start[c])
+		owner[r] = -1;
+	//the registers not kept by the runtime come first, the kept ones are for the intervals which save more with them
+	int first = is_int[c] ? 0 : RA_GP, last = is_int[c] ? RA_GP : RA_GP + RA_XMM;
+	int best = -1;
+	long long gain = 0;
+	for(int r = last - 1; r >= first; r--)
+	{
+	    long long g = RA_GAIN(c, r) - (owner[r] >= 0 ? RA_GAIN(owner[r], r) : 0);
+	    if(g > gain)
+	    {
+		gain = g;
+		best = r;
+	    }
+	}
+	if(best < 0)
+	    continue;
+	if(owner[best] >= 0) // spilled, it stays in memory
+	    ra_reg[ra_slot[owner[best]]] = -1;
+	owner[best] = c;
+	ra_reg[ra_slot[c]] = best;
+    }
+    for(int c = 0; c < nr_ra; c++)
+	if(ra_reg[ra_slot[c]] >= 0)
+	    ra_registers++;
+    free(depth);
+}
+
+/*						*
+ *	      x86-64 Machine Code		*
+ *						*/
+
+/* with -Jit the functions are translated to x86-64 code before the execution: every op code becomes
+   a fixed sequence of machine instructions working on the same stack of values as the virtual
+   machine, so the compiled functions share the frames of the interpreted code. While the machine
+   code runs the registers keep the state of the virtual machine:
+	rbx = (sp - vm_stack) in bytes, r12 = (fp - vm_stack) in bytes, r13 = vm_stack, r14 = the calls
+   and the offsets stay right when the stack is moved by grow_vm_stack */
+#if defined(__x86_64__)
+#define JIT_SUPPORTED
+#endif
+
+enum{RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15};
+enum{CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_BE = 0x6, CC_A = 0x7, CC_S = 0x8, CC_NS = 0x9,
+     CC_P = 0xA, CC_NP = 0xB, CC_L = 0xC, CC_GE = 0xD, CC_LE = 0xE, CC_G = 0xF, CC_JMP = -1, CC_CALL = -2};
+
+unsigned char* jit_buffer=NULL;
+int jit_size=0; // the bytes of machine code
+int jit_cap=0;
+int* jit_offset=NULL; // the offset of the machine code of each instruction, -1 if it is interpreted
+int* jit_osr=NULL; // the offset of the entry of -Tiered at the start of each loop, which reads the registers
+#define JIT_INSTR_BYTES 256 // the most bytes of machine code for an instruction, on average
+
+#define JIT_STACK_SIZE (64 << 20) // the compiled calls use their own machine stack, deeper than the C one
+unsigned char* jit_stack=NULL;
+
+//the entry of the machine code: runs the code at the given address with the fp and sp offsets and
+//returns the sp offset after the return of the function; osr enters in the middle of a function
+long (*jit_run)(void* code, long fp, long sp, long osr, long calls)=NULL;
+
+typedef struct JitPatch{
+    int at; // the offset of a rel32 in the machine code
+    int target; // the instruction to which it jumps
+}JitPatch;
+
+JitPatch* jit_patches=NULL;
+int nr_jit_patches=0;
+int cap_jit_patches=0;
+
+/* with -Elf the same machine code is written to an executable: the functions of the compiler and
+   their variables called and used by the code are replaced by the ones of the executable */
+int elf_output=0;
+
+typedef struct ElfSymbol{
+    void* host; // the function or variable of the compiler, or the interned name of a function
+    long long address; // its replacement in the executable
+}ElfSymbol;
+
+ElfSymbol* elf_symbols=NULL;
+int nr_elf_symbols=0;
+
+//the address used by the machine code for a function or a variable of the compiler
+long long jit_address(void* host)
+{
+    if(!elf_output)
+	return (long long)(size_t)host;
+    for(int k = 0; k < nr_elf_symbols; k++)
+	if(elf_symbols[k].host == host)
+	    return elf_symbols[k].address;
+    err("the executable has no replacement for a function of the compiler");
+    return 0;
+}
+
+/* with -S the same templates write assembly for the GNU assembler: every instruction below is
+   written as its Intel syntax to asm_file instead of its bytes, the addresses of the compiler are
+   the symbols of the runtime of the assembly and the local jumps get labels */
+FILE* asm_file=NULL;
+int nr_asm_skips=0; // the labels of the local jumps
+const char* asm_symbol(void* host);
+
+//the errors of the compiler get the token, the ones of the programs of -Elf and -S get its line
+int jit_token(int tk)
+{
+    return elf_output || asm_file != NULL ? tokens[tk].line : tk;
+}
+
+//the names of the registers in the assembly
+const char* asm_q[16] = {"rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"};
+const char* asm_d[16] = {"eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi", "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"};
+const char* asm_b[16] = {"al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil", "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"};
+const char* asm_cc[16] = {"o", "no", "b", "ae", "e", "ne", "be", "a", "s", "ns", "p", "np", "l", "ge", "le", "g"};
+
+//the kinds of the operands: the general purpose registers have 32 bits or 64 with w, the address is the one of lea,
+//the dword is the source of movsxd
+enum{X_NONE, X_GP, X_BYTE, X_XMM, X_ADDRESS, X_DWORD};
+
+/* the instructions of the templates by their prefix, their op code and the extension in the reg
+   field, -1 when it is a register; store is set when the r/m operand is the destination */
+typedef struct X86Op{
+    int prefix;
+    int op;
+    int ext;
+    const char* name;
+    int reg;
+    int rm;
+    int store;
+}X86Op;
+
+const X86Op x86_ops[] = {
+    {0, 0x8B, -1, "mov", X_GP, X_GP, 0}, {0, 0x89, -1, "mov", X_GP, X_GP, 1}, {0, 0xC7, 0, "mov", X_NONE, X_GP, 1},
+    {0, 0x03, -1, "add", X_GP, X_GP, 0}, {0, 0x01, -1, "add", X_GP, X_GP, 1}, {0, 0x2B, -1, "sub", X_GP, X_GP, 0},
+    {0, 0x0FAF, -1, "imul", X_GP, X_GP, 0}, {0, 0x69, -1, "imul", X_GP, X_GP, 0}, {0, 0x3B, -1, "cmp", X_GP, X_GP, 0},
+    {0, 0x39, -1, "cmp", X_GP, X_GP, 1}, {0, 0x85, -1, "test", X_GP, X_GP, 1}, {0, 0x8D, -1, "lea", X_GP, X_ADDRESS, 0},
+    {0, 0x20, -1, "and", X_BYTE, X_BYTE, 1}, {0, 0x08, -1, "or", X_BYTE, X_BYTE, 1},
+    {0, 0x81, 0, "add", X_NONE, X_GP, 1}, {0, 0x81, 5, "sub", X_NONE, X_GP, 1}, {0, 0x81, 7, "cmp", X_NONE, X_GP, 1},
+    {0, 0x83, 0, "add", X_NONE, X_GP, 1}, {0, 0x83, 7, "cmp", X_NONE, X_GP, 1}, {0, 0xC1, 5, "shr", X_NONE, X_GP, 1},
+    {0, 0xC1, 4, "shl", X_NONE, X_GP, 1}, {0, 0xC1, 7, "sar", X_NONE, X_GP, 1}, {0, 0x63, -1, "movsxd", X_GP, X_DWORD, 0},
+    {0, 0x0FBA, 7, "btc", X_NONE, X_GP, 1}, {0, 0xF7, 3, "neg", X_NONE, X_GP, 1}, {0, 0xF7, 7, "idiv", X_NONE, X_GP, 1},
+    {0, 0xFF, 0, "inc", X_NONE, X_GP, 1}, {0, 0xFF, 1, "dec", X_NONE, X_GP, 1},
+    {0, 0x0FBE, -1, "movsx", X_GP, X_BYTE, 0}, {0, 0x0FB6, -1, "movzx", X_GP, X_BYTE, 0},
+    {0, 0x0F28, -1, "movaps", X_XMM, X_XMM, 0}, {0xF2, 0x0F10, -1, "movsd", X_XMM, X_XMM, 0},
+    {0xF2, 0x0F11, -1, "movsd", X_XMM, X_XMM, 1}, {0xF2, 0x0F58, -1, "addsd", X_XMM, X_XMM, 0},
+    {0xF2, 0x0F5C, -1, "subsd", X_XMM, X_XMM, 0}, {0xF2, 0x0F59, -1, "mulsd", X_XMM, X_XMM, 0},
+    {0xF2, 0x0F5E, -1, "divsd", X_XMM, X_XMM, 0}, {0x66, 0x0F2E, -1, "ucomisd", X_XMM, X_XMM, 0},
+    {0xF2, 0x0F2A, -1, "cvtsi2sd", X_XMM, X_GP, 0}, {0xF2, 0x0F2C, -1, "cvttsd2si", X_GP, X_XMM, 0},
+    {0x66, 0x0F6E, -1, "movq", X_XMM, X_GP, 0}, {0x66, 0x0F7E, -1, "movq", X_XMM, X_GP, 1},
+};
+
+//the name of a register of the given kind
+void x86_register(char* text, int kind, int w, int reg)
+{
+    if(kind == X_XMM)
+	sprintf(text, "xmm%d", reg);
+    else
+	strcpy(text, kind == X_BYTE ? asm_b[reg] : w && kind != X_DWORD ? asm_q[reg] : asm_d[reg]);
+}
+
+/* writes an instruction of the templates: the r/m operand is the register rm or, when it is not
+   NULL, the memory operand mem; the immediate follows the operands */
+void x86_text(int prefix, int w, int op, int reg, int rm, const char* mem, int has_imm, long long imm)
+{
+    X86Op setcc = {0, op, 0, NULL, X_NONE, X_BYTE, 1};
+    const X86Op* x = NULL;
+    char name[16], operand[64], reg_name[8];
+    if(prefix == 0 && op >> 4 == 0x0F9)
+	x = &setcc;
+    for(int k = 0; x == NULL && k < (int)(sizeof(x86_ops) / sizeof(x86_ops[0])); k++)
+	if(x86_ops[k].prefix == prefix && x86_ops[k].op == op && (x86_ops[k].ext < 0 || x86_ops[k].ext == reg))
+	    x = &x86_ops[k];
+    if(x == NULL)
+	err("no assembly for the op code %X", op);
+    if(x == &setcc)
+	sprintf(name, "set%s", asm_cc[op & 15]);
+    else
+	strcpy(name, x->name);
+    if(mem == NULL)
+	x86_register(operand, x->rm, w, rm);
+    else
+	sprintf(operand, "%s%s", x->rm == X_ADDRESS ? "" : x->rm == X_BYTE ? "BYTE PTR " : x->rm == X_DWORD || (x->rm == X_GP && !w) ? "DWORD PTR " : "QWORD PTR ", mem);
+    x86_register(reg_name, x->reg, w, reg);
+    if(x->reg == X_NONE)
+	fprintf(asm_file, "\t%s %s", name, operand);
+    else if(x->store)
+	fprintf(asm_file, "\t%s %s, %s", name, operand, reg_name);
+    else
+	fprintf(asm_file, "\t%s %s, %s", name, reg_name, operand);
+    if(has_imm)
+	fprintf(asm_file, ", %lld", imm);
+    fputc('\n', asm_file);
+}
+
+void jb(int byte)
+{
+    if(asm_file != NULL)
+	err("the bytes of the machine code have no assembly");
+    if(jit_size == jit_cap)
+	err("the machine code is too big");
+    jit_buffer[jit_size++] = (unsigned char)byte;
+}
+
+void jb4(int v)
+{
+    for(int k = 0; k < 4; k++)
+	jb((v >> (8 * k)) & 0xFF);
+}
+
+void jb8(long long v)
+{
+    for(int k = 0; k < 8; k++)
+	jb((v >> (8 * k)) & 0xFF);
+}
+
+void jit_bytes(int n, ...)
+{
+    va_list va;
+    va_start(va, n);
+    for(int k = 0; k < n; k++)
+	jb(va_arg(va, int));
+    va_end(va);
+}
+
+//the immediate after the operands, of 8 bits for the op codes of the shifts, bt and the small constants
+void jit_imm(int op, int v)
+{
+    if(op == 0x83 || op == 0xC1 || op == 0x0FBA)
+	jb(v);
+    else
+	jb4(v);
+}
+
+#define JIT_ELEMENT -2 // the index of jit_mem for [r13 + rax * 8]
+
+/* an instruction with the memory operand [r13 + index + disp]: the index is RBX for the values of
+   the stack, R12 for the slots of the frame, -1 for the globals and JIT_ELEMENT with no disp for
+   [r13 + rax * 8]; prefix is 0 or the prefix of an SSE instruction and the op code has 1 or 2 bytes */
+void jit_mem_op(int prefix, int w, int op, int reg, int index, int disp, int has_imm, int imm)
+{
+    if(asm_file != NULL)
+    {
+	char mem[48];
+	if(index == JIT_ELEMENT)
+	    strcpy(mem, "[r13+rax*8]");
+	else if(index < 0)
+	    sprintf(mem, "[r13%+d]", disp);
+	else
+	    sprintf(mem, "[r13+%s%+d]", asm_q[index], disp);
+	x86_text(prefix, w, op, reg, 0, mem, has_imm, imm);
+	return;
+    }
+    if(prefix)
+	jb(prefix);
+    jb(0x40 | (w ? 8 : 0) | ((reg & 8) ? 4 : 0) | (index == R12 ? 2 : 0) | 1);
+    if(op > 0xFF)
+	jb(op >> 8);
+    jb(op & 0xFF);
+    if(index == JIT_ELEMENT)
+	jit_bytes(3, 0x44 | (reg & 7) << 3, 0xC5, 0x00);
+    else if(index < 0)
+    {
+	jb(0x80 | (reg & 7) << 3 | 5);
+	jb4(disp);
+    }
+    else
+    {
+	jb(0x80 | (reg & 7) << 3 | 4);
+	jb((index & 7) << 3 | 5);
+	jb4(disp);
+    }
+    if(has_imm)
+	jit_imm(op, imm);
+}
+
+void jit_mem(int prefix, int w, int op, int reg, int index, int disp)
+{
+    jit_mem_op(prefix, w, op, reg, index, disp, 0, 0);
+}
+
+//with an immediate, the extension of the op code is in reg
+void jit_mem_imm(int prefix, int w, int op, int ext, int index, int disp, int imm)
+{
+    jit_mem_op(prefix, w, op, ext, index, disp, 1, imm);
+}
+
+//the values on the stack, k is relative to sp
+#define ST(k) RBX, 8 * (k)
+
+//op reg, [base + disp32], the base is not rsp nor r12
+void jit_at(int prefix, int w, int op, int reg, int base, int disp)
+{
+    if(asm_file != NULL)
+    {
+	char mem[48];
+	sprintf(mem, "[%s%+d]", asm_q[base], disp);
+	x86_text(prefix, w, op, reg, 0, mem, 0, 0);
+	return;
+    }
+    if(prefix)
+	jb(prefix);
+    int rex = 0x40 | (w ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((base & 8) ? 1 : 0);
+    if(rex != 0x40)
+	jb(rex);
+    if(op > 0xFF)
+	jb(op >> 8);
+    jb(op & 0xFF);
+    jb(0x80 | (reg & 7) << 3 | (base & 7));
+    jb4(disp);
+}
+
+//moves sp by the given number of values, the flags are kept for the jumps of the comparisons
+void jit_sp(int values)
+{
+    if(values == 0)
+	return;
+    jit_at(0, 1, 0x8D, RBX, RBX, 8 * values); // lea rbx, [rbx + disp32]
+}
+
+//op reg, rm on two registers, with the REX prefix when it is needed
+void jit_rr_op(int prefix, int w, int op, int reg, int rm, int has_imm, int imm)
+{
+    if(asm_file != NULL)
+    {
+	x86_text(prefix, w, op, reg, rm, NULL, has_imm, imm);
+	return;
+    }
+    if(prefix)
+	jb(prefix);
+    int rex = 0x40 | (w ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((rm & 8) ? 1 : 0);
+    if(rex != 0x40)
+	jb(rex);
+    if(op > 0xFF)
+	jb(op >> 8);
+    jb(op & 0xFF);
+    jb(0xC0 | (reg & 7) << 3 | (rm & 7));
+    if(has_imm)
+	jit_imm(op, imm);
+}
+
+void jit_rr(int prefix, int w, int op, int reg, int rm)
+{
+    jit_rr_op(prefix, w, op, reg, rm, 0, 0);
+}
+
+//with an immediate, the extension of the op code (or for imul the destination) is in reg
+void jit_rr_imm(int prefix, int w, int op, int ext, int rm, int imm)
+{
+    jit_rr_op(prefix, w, op, ext, rm, 1, imm);
+}
+
+//an instruction without operands: 0x99 cdq, 0xC3 ret
+void jit_op(int op)
+{
+    if(asm_file != NULL)
+	fprintf(asm_file, "\t%s\n", op == 0x99 ? "cdq" : "ret");
+    else
+	jb(op);
+}
+
+void jit_push(int reg, int pop)
+{
+    if(asm_file != NULL)
+	fprintf(asm_file, "\t%s %s\n", pop ? "pop" : "push", asm_q[reg]);
+    else
+    {
+	if(reg & 8)
+	    jb(0x41);
+	jb((pop ? 0x58 : 0x50) + (reg & 7));
+    }
+}
+
+//calls a function of the compiler, the arguments are already in the registers
+void jit_call(void* f)
+{
+    if(asm_file != NULL)
+    {
+	fprintf(asm_file, "\tcall %s\n", asm_symbol(f));
+	return;
+    }
+    jit_bytes(2, 0x48, 0xB8); // mov rax, imm64
+    jb8(jit_address(f));
+    jit_bytes(2, 0xFF, 0xD0); // call rax
+}
+
+//the address of a variable of the compiler, or of the name of a function for the errors of the calls
+void jit_load_address(int reg, void* host)
+{
+    if(asm_file != NULL)
+    {
+	fprintf(asm_file, "\tlea %s, %s[rip]\n", asm_q[reg], asm_symbol(host));
+	return;
+    }
+    jit_bytes(2, 0x48 | ((reg & 8) ? 1 : 0), 0xB8 + (reg & 7)); // mov reg, imm64
+    jb8(jit_address(host));
+}
+
+void jit_mov_imm(int reg, int v)
+{
+    if(asm_file != NULL)
+    {
+	fprintf(asm_file, "\tmov %s, %d\n", asm_d[reg], v);
+	return;
+    }
+    if(reg & 8)
+	jb(0x41);
+    jb(0xB8 + (reg & 7)); // mov reg32, imm32
+    jb4(v);
+}
+
+void jit_mov_imm64(int reg, long long v)
+{
+    if(asm_file != NULL)
+    {
+	fprintf(asm_file, "\tmovabs %s, %lld\n", asm_q[reg], v);
+	return;
+    }
+    jit_bytes(2, 0x48 | ((reg & 8) ? 1 : 0), 0xB8 + (reg & 7));
+    jb8(v);
+}
+
+/* a jump forward, of rel8 or with far of rel32, to the place given by jit_skip_to: the result is
+   the offset to patch, or the label for -S */
+int jit_skip(int cc, int far)
+{
+    if(asm_file != NULL)
+    {
+	fprintf(asm_file, "\tj%s .Ls%d\n", cc == CC_JMP ? "mp" : asm_cc[cc], nr_asm_skips);
+	return nr_asm_skips++;
+    }
+    if(!far)
+	jit_bytes(2, cc == CC_JMP ? 0xEB : 0x70 | cc, 0);
+    else if(cc == CC_JMP)
+	jb(0xE9);
+    else
+	jit_bytes(2, 0x0F, 0x80 | cc);
+    if(far)
+	jb4(0);
+    return jit_size - (far ? 4 : 1);
+}
+
+void jit_skip_to(int skip, int far)
+{
+    int rel = jit_size - (skip + (far ? 4 : 1));
+    if(asm_file != NULL)
+	fprintf(asm_file, ".Ls%d:\n", skip);
+    else if(far)
+	memcpy(jit_buffer + skip, &rel, 4);
+    else
+	jit_buffer[skip] = rel;
+}
+
+//jumps over the call of the error function when the condition holds, the error gets the token and rax
+void jit_error_unless(int cc, void* error, int tk)
+{
+    int skip = jit_skip(cc, 0);
+    jit_mov_imm(RDI, jit_token(tk));
+    jit_rr(0, 1, 0x89, RAX, RSI); // mov rsi, rax
+    jit_call(error);
+    jit_skip_to(skip, 0);
+}
+
+//a jump or a call to an instruction, the rel32 is patched when all the code is emitted
+void jit_branch(int cc, int target)
+{
+    if(asm_file != NULL)
+    {
+	if(cc == CC_CALL)
+	    fprintf(asm_file, "\tcall f_%s\n", tokens[bytecode[target].tk].text);
+	else
+	    fprintf(asm_file, "\tj%s .L%d\n", cc == CC_JMP ? "mp" : asm_cc[cc], target);
+	return;
+    }
+    if(cc == CC_JMP)
+	jb(0xE9);
+    else if(cc == CC_CALL)
+	jb(0xE8);
+    else
+	jit_bytes(2, 0x0F, 0x80 | cc);
+    if(nr_jit_patches == cap_jit_patches)
+    {
+	cap_jit_patches = cap_jit_patches ? cap_jit_patches * 2 : 256;
+	jit_patches = (JitPatch*)realloc(jit_patches, sizeof(JitPatch) * cap_jit_patches);
+	if(jit_patches == NULL)
+	    err("not enough memory");
+    }
+    jit_patches[nr_jit_patches].at = jit_size;
+    jit_patches[nr_jit_patches].target = target;
+    nr_jit_patches++;
+    jb4(0);
+}
+
+//the functions called by the machine code
+long jit_enter_frame(long sp, int nr_slots, int nr_args, int tk)
+{
+    (void)tk; // the stack grows here, the one of -Elf has a fixed size and stops at tk
+    int height = sp / sizeof(Value) - nr_args;
+    grow_vm_stack(height + nr_slots);
+    memset(vm_stack + height + nr_args, 0, sizeof(Value) * (nr_slots - nr_args));
+    return height * (long)sizeof(Value);
+}
+
+void jit_copy(long sp, int nr_values, int tk)
+{
+    Value* top = vm_stack + sp / sizeof(Value);
+    int address = top->i;
+    if(address < 0 || top[1].i < 0 || address + nr_values > top - vm_stack || top[1].i + nr_values > top - vm_stack)
+	tkerr(&tokens[tk], "invalid memory access at %d", address);
+    memmove(vm_stack + address, vm_stack + top[1].i, sizeof(Value) * nr_values);
+}
+
+void jit_vector(long sp, int op)
+{
+    Value* top = vm_stack + sp / sizeof(Value) - 1;
+    top->i = vector_run(top, op);
+}
+
+void jit_load_struct(long sp, int nr_values, int tk)
+{
+    Value* top = vm_stack + sp / sizeof(Value);
+    int address = top[-1].i;
+    if(address < 0 || address + nr_values > top - vm_stack)
+	tkerr(&tokens[tk], "invalid memory access at %d", address);
+    memmove(top - 1, vm_stack + address, sizeof(Value) * nr_values);
+}
+
+void jit_memory_error(int tk, int address)
+{
+    tkerr(&tokens[tk], "invalid memory access at %d", address);
+}
+
+void jit_division_error(int tk, int unused)
+{
+    (void)unused;
+    tkerr(&tokens[tk], "division by zero");
+}
+
+void jit_calls_error(int tk, int unused)
+{
+    (void)unused;
+    tkerr(&tokens[tk], "too many nested calls of %s", tokens[tk].text);
+}
+
+void jit_put_i(int v){ printf("%d\n", v); }
+void jit_put_d(double v){ printf("%lf\n", v); }
+void jit_put_c(int v){ printf("%c\n", (char)v); }
+
+int jit_get_i()
+{
+    int v;
+    if(scanf("%d", &v) != 1)
+	v = 0;
+    return v;
+}
+
+double jit_get_d()
+{
+    double v;
+    if(scanf("%lf", &v) != 1)
+	v = 0;
+    return v;
+}
+
+int jit_get_c()
+{
+    int v = getchar();
+    return v == EOF ? 0 : v;
+}
+
+//sp[-2] = sp[-2] op sp[-1] for int and char, the op code works on eax and the memory
+void jit_arith_i(int op, int is_char)
+{
+    jit_mem(0, 0, 0x8B, RAX, ST(-2)); // mov eax, sp[-2]
+    jit_mem(0, 0, op, RAX, ST(-1));
+    if(is_char)
+	jit_rr(0, 0, 0x0FBE, RAX, RAX); // movsx eax, al
+    jit_mem(0, 0, 0x89, RAX, ST(-2));
+    jit_sp(-1);
+}
+
+void jit_arith_d(int op)
+{
+    jit_mem(0xF2, 0, 0x0F10, 0, ST(-2)); // movsd xmm0, sp[-2]
+    jit_mem(0xF2, 0, 0x0F00 | op, 0, ST(-1));
+    jit_mem(0xF2, 0, 0x0F11, 0, ST(-2));
+    jit_sp(-1);
+}
+
+//the condition in al becomes the int in sp[k]
+void jit_set_bool(int k)
+{
+    jit_rr(0, 0, 0x0FB6, RAX, RAX); // movzx eax, al
+    jit_mem(0, 0, 0x89, RAX, ST(k));
+}
+
+void jit_compare_i(int cc)
+{
+    jit_mem(0, 0, 0x8B, RAX, ST(-2));
+    jit_mem(0, 0, 0x3B, RAX, ST(-1)); // cmp eax, sp[-1]
+    jit_rr(0, 0, 0x0F90 | cc, 0, RAX); // setcc al
+    jit_set_bool(-2);
+    jit_sp(-1);
+}
+
+//the doubles are compared as in C: every comparison with a NaN is false, except !=
+void jit_compare_d(int op)
+{
+    int swap = op == O_LESS_D || op == O_LESSEQ_D; // a < b is b > a, the unordered result clears both
+    jit_mem(0xF2, 0, 0x0F10, 0, ST(swap ? -1 : -2));
+    jit_mem(0x66, 0, 0x0F2E, 0, ST(swap ? -2 : -1)); // ucomisd xmm0, the other operand
+    switch(op)
+    {
+	case O_EQUAL_D: case O_NOTEQ_D: // sete al; setnp cl; and al, cl or setne al; setp cl; or al, cl
+	    jit_rr(0, 0, 0x0F90 | (op == O_EQUAL_D ? CC_E : CC_NE), 0, RAX);
+	    jit_rr(0, 0, 0x0F90 | (op == O_EQUAL_D ? CC_NP : CC_P), 0, RCX);
+	    jit_rr(0, 0, op == O_EQUAL_D ? 0x20 : 0x08, RCX, RAX);
+	    break;
+	case O_LESS_D: case O_GREATER_D: jit_rr(0, 0, 0x0F90 | CC_A, 0, RAX); break;
+	case O_LESSEQ_D: case O_GREATEREQ_D: jit_rr(0, 0, 0x0F90 | CC_AE, 0, RAX); break;
+    }
+    jit_set_bool(-2);
+    jit_sp(-1);
+}
+
+//the address in sp[k] must be below the top of the stack, then it is moved to rax
+void jit_check_address(int k, int tk)
+{
+    jit_mem(0, 0, 0x8B, RAX, ST(k));
+    jit_rr(0, 1, 0x89, RBX, RCX); // mov rcx, rbx
+    jit_rr_imm(0, 1, 0xC1, 5, RCX, 3); // shr rcx, 3
+    jit_rr(0, 0, 0x39, RCX, RAX); // cmp eax, ecx
+    jit_error_unless(CC_B, jit_memory_error, tk);
+}
+
+/* the slots in registers: r15 and r8-r11 for the general purpose ones of the allocation, xmm2-xmm15
+   for the xmm ones. The loads of these slots and the constants are not written to the stack: they
+   are kept as values which the next instructions use in place, as their results are kept in rax,
+   rcx or xmm0, xmm1 and in the flags for the comparisons; the values are written to the stack by
+   the instructions which do not use them, before the targets of the jumps and before the calls */
+enum{V_GP, V_XMM, V_IMM, V_CC, V_STACK};
+
+typedef struct JitValue{
+    int kind;
+    int v; // the register, the constant, the condition code or for V_STACK the value of sp it is at
+}JitValue;
+
+int jit_gp_regs[RA_GP] = {R15, R8, R9, R10, R11};
+JitValue jit_values[2]; // the first is below, only the top one may be in rax, rcx, xmm0, xmm1 or the flags
+int nr_jit_values=0;
+char* jit_targets=NULL; // the instructions to which the code jumps
+
+//the targets of the jumps and the functions, before them the values kept out of the stack are written
+char* jit_jump_targets()
+{
+    char* targets = (char*)calloc(nr_instr, 1);
+    if(targets == NULL)
+	err("not enough memory");
+    for(int pc = 0; pc < nr_instr; pc++)
+    {
+	if(bytecode[pc].op == O_JMP || bytecode[pc].op == O_JF || bytecode[pc].op == O_JT)
+	    targets[bytecode[pc].i] = 1;
+	if(bytecode[pc].op == O_ENTER)
+	    targets[pc] = 1;
+    }
+    return targets;
+}
+
+//the register of a slot: -1 in memory, a general purpose register or 16 + an xmm register
+int jit_register(int slot)
+{
+    int r = ra_register(slot);
+    return r < 0 ? -1 : r < RA_GP ? jit_gp_regs[r] : 16 + 2 + r - RA_GP;
+}
+
+//loads or stores the register of a slot
+void jit_slot(int reg, int slot, int store)
+{
+    if(reg >= 16)
+	jit_mem(0xF2, 0, store ? 0x0F11 : 0x0F10, reg - 16, R12, 8 * slot);
+    else
+	jit_mem(0, 1, store ? 0x89 : 0x8B, reg, R12, 8 * slot);
+}
+
+//writes to their slots (or reads back) the registers live before pc: all of them or the ones the runtime does not keep
+void jit_spill(int pc, int all, int store)
+{
+    for(int c = 0; c < nr_ra; c++)
+    {
+	int r = ra_reg[ra_slot[c]];
+	if(r >= 0 && (all || r >= RA_KEPT) && pc < ra_end && ra_is_live(pc, c))
+	    jit_slot(jit_register(ra_slot[c]), ra_slot[c], store);
+    }
+}
+
+int jit_scratch(JitValue* v)
+{
+    return v->kind == V_CC || (v->kind == V_GP && v->v < RBX) || (v->kind == V_XMM && v->v < 2);
+}
+
+//the value in a general purpose register: its own one or else reg
+int jit_gp_value(JitValue* v, int reg)
+{
+    switch(v->kind)
+    {
+	case V_GP: return v->v;
+	case V_XMM: jit_rr(0x66, 1, 0x0F7E, v->v, reg); break; // movq reg, xmm
+	case V_IMM: jit_mov_imm(reg, v->v); break;
+	case V_CC: jit_rr(0, 0, 0x0F90 | v->v, 0, reg); jit_rr(0, 0, 0x0FB6, reg, reg); break; // setcc; movzx
+	case V_STACK: jit_mem(0, 1, 0x8B, reg, ST(v->v)); break;
+    }
+    return reg;
+}
+
+//the value in an xmm register: its own one or else xmm, with reg for the values of the other kinds
+int jit_xmm_value(JitValue* v, int xmm, int reg)
+{
+    if(v->kind == V_XMM)
+	return v->v;
+    if(v->kind == V_STACK)
+	jit_mem(0xF2, 0, 0x0F10, xmm, ST(v->v));
+    else
+	jit_rr(0x66, 1, 0x0F6E, xmm, jit_gp_value(v, reg)); // movq xmm, reg
+    return xmm;
+}
+
+//writes the first n values to the stack
+void jit_write_values(int n)
+{
+    for(int k = 0; k < n; k++)
+    {
+	JitValue* v = &jit_values[k];
+	if(v->kind == V_XMM)
+	    jit_mem(0xF2, 0, 0x0F11, v->v, ST(k));
+	else if(v->kind == V_IMM)
+	    jit_mem_imm(0, 0, 0xC7, 0, ST(k), v->v);
+	else
+	    jit_mem(0, 1, 0x89, jit_gp_value(v, RAX), ST(k));
+    }
+    jit_sp(n);
+    nr_jit_values -= n;
+    memmove(jit_values, jit_values + n, sizeof(JitValue) * nr_jit_values);
+}
+
+void jit_flush()
+{
+    jit_write_values(nr_jit_values);
+}
+
+void jit_push_value(int kind, int v)
+{
+    if(nr_jit_values == 2 || (nr_jit_values == 1 && jit_scratch(&jit_values[0])))
+	jit_write_values(1);
+    jit_values[nr_jit_values].kind = kind;
+    jit_values[nr_jit_values].v = v;
+    nr_jit_values++;
+}
+
+//the top value, from the stack if it is not kept
+JitValue jit_pop_value(int* in_stack)
+{
+    JitValue v;
+    if(nr_jit_values)
+	return jit_values[--nr_jit_values];
+    v.kind = V_STACK;
+    v.v = -1 - (*in_stack)++;
+    return v;
+}
+
+//the operands of a binary instruction, in_stack counts the ones which are on the stack
+void jit_operands(JitValue* a, JitValue* b, int* in_stack)
+{
+    *in_stack = 0;
+    *b = jit_pop_value(in_stack);
+    *a = jit_pop_value(in_stack);
+}
+
+//a binary instruction: the op code of reg32, r/m32 and the extension of the form with an imm32 (-1 for imul)
+void jit_binary_i(int op, int ext, int cc)
+{
+    JitValue a, b;
+    int in_stack;
+    jit_operands(&a, &b, &in_stack);
+    int dst = b.kind == V_GP && b.v == RAX ? RCX : RAX;
+    int src = jit_gp_value(&a, dst);
+    if(src != dst)
+	jit_rr(0, 0, 0x8B, dst, src); // mov dst, src
+    if(b.kind == V_STACK)
+	jit_mem(0, 0, op, dst, ST(b.v));
+    else if(b.kind == V_IMM && ext < 0)
+	jit_rr_imm(0, 0, 0x69, dst, dst, b.v); // imul dst, dst, imm32
+    else if(b.kind == V_IMM)
+	jit_rr_imm(0, 0, 0x81, ext, dst, b.v);
+    else
+	jit_rr(0, 0, op, dst, jit_gp_value(&b, RDX));
+    jit_sp(-in_stack);
+    jit_push_value(cc ? V_CC : V_GP, cc ? cc : dst);
+}
+
+//the doubles: the op code after F2 0F, or for the comparisons 2E after 66 0F with the condition code
+void jit_binary_d(int op, int cc, int swap)
+{
+    JitValue a, b;
+    int in_stack;
+    jit_operands(&a, &b, &in_stack);
+    if(swap)
+    {
+	JitValue t = a;
+	a = b;
+	b = t;
+    }
+    int dst = b.kind == V_XMM && b.v == 0 ? 1 : 0;
+    int src = jit_xmm_value(&a, dst, RAX);
+    if(src != dst)
+	jit_rr(0, 0, 0x0F28, dst, src); // movaps dst, src
+    if(b.kind == V_STACK)
+	jit_mem(cc ? 0x66 : 0xF2, 0, 0x0F00 | op, dst, ST(b.v));
+    else
+	jit_rr(cc ? 0x66 : 0xF2, 0, 0x0F00 | op, dst, jit_xmm_value(&b, 1 - dst, RAX));
+    jit_sp(-in_stack);
+    jit_push_value(cc ? V_CC : V_XMM, cc ? cc : dst);
+}
+
+//the address in eax must be below sp, moved by the given values which are not on the stack yet
+void jit_check_eax(int values, int tk)
+{
+    jit_at(0, 1, 0x8D, RCX, RBX, 8 * values); // lea rcx, [rbx + disp32]
+    jit_rr_imm(0, 1, 0xC1, 5, RCX, 3);
+    jit_rr(0, 0, 0x39, RCX, RAX);
+    jit_error_unless(CC_B, jit_memory_error, tk);
+}
+
+//the instructions which use the values kept out of the stack, returns 0 for the others
+int jit_values_instr(Instr* ins)
+{
+    JitValue v, a;
+    int in_stack = 0;
+    int reg;
+    if(!REGISTERS)
+	return 0;
+    switch(ins->op)
+    {
+	case O_LOAD_I: case O_LOAD_C: case O_LOAD_D:
+	    reg = jit_register(ins->i);
+	    if(reg < 0)
+		return 0;
+	    jit_push_value(reg >= 16 ? V_XMM : V_GP, reg & 15);
+	    return 1;
+	case O_CONST_I:
+	    jit_push_value(V_IMM, ins->i);
+	    return 1;
+
+	case O_STORE_I: case O_STORE_C: case O_STORE_D: case O_MODIFY_I: case O_MODIFY_C: case O_MODIFY_D:
+	    reg = jit_register(ins->i);
+	    if(reg < 0 && nr_jit_values == 0)
+		return 0;
+	    v = jit_pop_value(&in_stack);
+	    //the value below is written before its register changes
+	    if(nr_jit_values && reg >= 0 && jit_values[0].kind == (reg >= 16 ? V_XMM : V_GP) && jit_values[0].v == (reg & 15))
+		jit_flush();
+	    if(reg < 0)
+	    {
+		if(v.kind == V_XMM)
+		    jit_mem(0xF2, 0, 0x0F11, v.v, R12, 8 * ins->i);
+		else if(v.kind == V_IMM)
+		    jit_mem_imm(0, 1, 0xC7, 0, R12, 8 * ins->i, v.v); // mov qword fp[i], imm32
+		else
+		    jit_mem(0, 1, 0x89, jit_gp_value(&v, RAX), R12, 8 * ins->i);
+	    }
+	    else if(reg >= 16)
+	    {
+		int src = jit_xmm_value(&v, reg - 16, RAX);
+		if(src != reg - 16)
+		    jit_rr(0, 0, 0x0F28, reg - 16, src);
+	    }
+	    else if(v.kind == V_IMM)
+		jit_mov_imm(reg, v.v);
+	    else if(v.kind == V_XMM)
+		jit_rr(0x66, 1, 0x0F7E, v.v, reg);
+	    else
+	    {
+		int src = jit_gp_value(&v, reg);
+		if(src != reg)
+		    jit_rr(0, 1, 0x8B, reg, src); // mov reg, src
+	    }
+	    jit_sp(-in_stack);
+	    return 1;
+
+	case O_ADD_I: jit_binary_i(0x03, 0, 0); return 1;
+	case O_SUB_I: jit_binary_i(0x2B, 5, 0); return 1;
+	case O_MUL_I: jit_binary_i(0x0FAF, -1, 0); return 1;
+	case O_EQUAL_I: jit_binary_i(0x3B, 7, CC_E); return 1;
+	case O_NOTEQ_I: jit_binary_i(0x3B, 7, CC_NE); return 1;
+	case O_LESS_I: jit_binary_i(0x3B, 7, CC_L); return 1;
+	case O_LESSEQ_I: jit_binary_i(0x3B, 7, CC_LE); return 1;
+	case O_GREATER_I: jit_binary_i(0x3B, 7, CC_G); return 1;
+	case O_GREATEREQ_I: jit_binary_i(0x3B, 7, CC_GE); return 1;
+	case O_ADD_D: jit_binary_d(0x58, 0, 0); return 1;
+	case O_SUB_D: jit_binary_d(0x5C, 0, 0); return 1;
+	case O_MUL_D: jit_binary_d(0x59, 0, 0); return 1;
+	case O_DIV_D: jit_binary_d(0x5E, 0, 0); return 1;
+	//a < b is b > a, the unordered result clears both
+	case O_LESS_D: jit_binary_d(0x2E, CC_A, 1); return 1;
+	case O_LESSEQ_D: jit_binary_d(0x2E, CC_AE, 1); return 1;
+	case O_GREATER_D: jit_binary_d(0x2E, CC_A, 0); return 1;
+	case O_GREATEREQ_D: jit_binary_d(0x2E, CC_AE, 0); return 1;
+
+	case O_CONV_I_D:
+	    v = jit_pop_value(&in_stack);
+	    if(v.kind == V_STACK)
+		jit_mem(0xF2, 0, 0x0F2A, 0, ST(v.v)); // cvtsi2sd xmm0, dword sp[-1]
+	    else
+		jit_rr(0xF2, 0, 0x0F2A, 0, jit_gp_value(&v, RAX));
+	    jit_sp(-in_stack);
+	    jit_push_value(V_XMM, 0);
+	    return 1;
+
+	case O_SHL_I: case O_SHR_I: case O_USHR_I: case O_MULHI_I:
+	    v = jit_pop_value(&in_stack);
+	    if(ins->op == O_MULHI_I)
+	    {
+		if(v.kind == V_STACK)
+		    jit_mem(0, 1, 0x63, RAX, ST(v.v)); // movsxd rax, dword sp[v]
+		else
+		    jit_rr(0, 1, 0x63, RAX, jit_gp_value(&v, RAX));
+		jit_rr_imm(0, 1, 0x69, RAX, RAX, ins->i); // imul rax, rax, imm32
+		jit_rr_imm(0, 1, 0xC1, 7, RAX, 32); // sar rax, 32
+	    }
+	    else
+	    {
+		reg = jit_gp_value(&v, RAX);
+		if(reg != RAX)
+		    jit_rr(0, 0, 0x8B, RAX, reg);
+		jit_rr_imm(0, 0, 0xC1, ins->op == O_SHL_I ? 4 : ins->op == O_SHR_I ? 7 : 5, RAX, ins->i);
+	    }
+	    jit_sp(-in_stack);
+	    jit_push_value(V_GP, RAX);
+	    return 1;
+
+	case O_INDEX:
+	    jit_operands(&a, &v, &in_stack);
+	    if(v.kind == V_STACK)
+		jit_mem_imm(0, 0, 0x69, RAX, ST(v.v), ins->i); // imul eax, index, imm32
+	    else
+		jit_rr_imm(0, 0, 0x69, RAX, jit_gp_value(&v, RAX), ins->i);
+	    if(a.kind == V_STACK)
+		jit_mem(0, 0, 0x03, RAX, ST(a.v)); // add eax, address
+	    else if(a.kind == V_IMM)
+		jit_rr_imm(0, 0, 0x81, 0, RAX, a.v);
+	    else
+		jit_rr(0, 0, 0x03, RAX, jit_gp_value(&a, RCX));
+	    jit_sp(-in_stack);
+	    jit_push_value(V_GP, RAX);
+	    return 1;
+	case O_LOAD_AT_I: case O_LOAD_AT_C: case O_LOAD_AT_D:
+	    v = jit_pop_value(&in_stack);
+	    jit_rr(0, 0, 0x8B, RAX, jit_gp_value(&v, RAX)); // mov eax, the address: its upper half is cleared
+	    jit_check_eax(nr_jit_values + 1 - in_stack, ins->tk);
+	    if(ins->op == O_LOAD_AT_D)
+		jit_mem(0xF2, 0, 0x0F10, 0, JIT_ELEMENT, 0); // movsd xmm0, [r13 + rax * 8]
+	    else
+		jit_mem(0, 0, 0x8B, RAX, JIT_ELEMENT, 0);
+	    jit_sp(-in_stack);
+	    jit_push_value(ins->op == O_LOAD_AT_D ? V_XMM : V_GP, 0);
+	    return 1;
+	case O_MODIFY_AT_I: case O_MODIFY_AT_C: case O_MODIFY_AT_D:
+	    if(nr_jit_values == 0)
+		return 0;
+	    v = jit_pop_value(&in_stack);
+	    a = jit_pop_value(&in_stack);
+	    //the value is moved out of the registers of the check
+	    if(v.kind == V_CC || (v.kind == V_GP && v.v < RBX))
+	    {
+		v.v = jit_gp_value(&v, RDX);
+		if(v.v != RDX)
+		    jit_rr(0, 1, 0x8B, RDX, v.v);
+		v.kind = V_GP;
+		v.v = RDX;
+	    }
+	    jit_rr(0, 0, 0x8B, RAX, jit_gp_value(&a, RAX));
+	    jit_check_eax(nr_jit_values - in_stack, ins->tk);
+	    if(v.kind == V_XMM)
+		jit_mem(0xF2, 0, 0x0F11, v.v, JIT_ELEMENT, 0);
+	    else if(v.kind == V_IMM)
+		jit_mem_imm(0, 1, 0xC7, 0, JIT_ELEMENT, 0, v.v); // mov qword [r13 + rax * 8], imm32
+	    else
+		jit_mem(0, 1, 0x89, v.v, JIT_ELEMENT, 0);
+	    jit_sp(-in_stack);
+	    return 1;
+
+	case O_JF: case O_JT:
+	    if(nr_jit_values == 0 || jit_values[nr_jit_values - 1].kind == V_XMM)
+		return 0;
+	    v = jit_values[--nr_jit_values];
+	    jit_flush(); // the value below, lea keeps the flags
+	    if(v.kind == V_IMM)
+	    {
+		if((v.v != 0) == (ins->op == O_JT))
+		    jit_branch(CC_JMP, ins->i);
+		return 1;
+	    }
+	    reg = CC_NE;
+	    if(v.kind == V_CC)
+		reg = v.v;
+	    else
+		jit_rr(0, 0, 0x85, v.v, v.v); // test reg32, reg32
+	    jit_branch(ins->op == O_JT ? reg : reg ^ 1, ins->i);
+	    return 1;
+	case O_POP:
+	    for(; nr_jit_values && in_stack < ins->i; in_stack++)
+		nr_jit_values--;
+	    jit_sp(in_stack - ins->i);
+	    return 1;
+    }
+    return 0;
+}
+
+//the machine code of an instruction
+void jit_instr(Instr* ins)
+{
+    int pc = ins - bytecode;
+    if(jit_values_instr(ins))
+	return;
+    jit_flush();
+    switch(ins->op)
+    {
+	case O_STORE_I: case O_STORE_C: case O_STORE_D: case O_MODIFY_I: case O_MODIFY_C: case O_MODIFY_D:
+	    jit_mem(0, 1, 0x8B, RAX, ST(-1));
+	    jit_mem(0, 1, 0x89, RAX, R12, 8 * ins->i);
+	    jit_sp(-1);
+	    break;
+	case O_STORE_GLOBAL_I: case O_STORE_GLOBAL_C: case O_STORE_GLOBAL_D:
+	case O_MODIFY_GLOBAL_I: case O_MODIFY_GLOBAL_C: case O_MODIFY_GLOBAL_D:
+	    jit_mem(0, 1, 0x8B, RAX, ST(-1));
+	    jit_mem(0, 1, 0x89, RAX, -1, 8 * ins->i);
+	    jit_sp(-1);
+	    break;
+	case O_LOAD_I: case O_LOAD_C: case O_LOAD_D:
+	    jit_mem(0, 1, 0x8B, RAX, R12, 8 * ins->i);
+	    jit_mem(0, 1, 0x89, RAX, ST(0));
+	    jit_sp(1);
+	    break;
+	case O_LOAD_GLOBAL_I: case O_LOAD_GLOBAL_C: case O_LOAD_GLOBAL_D:
+	    jit_mem(0, 1, 0x8B, RAX, -1, 8 * ins->i);
+	    jit_mem(0, 1, 0x89, RAX, ST(0));
+	    jit_sp(1);
+	    break;
+
+	case O_ADDR:
+	    jit_rr(0, 1, 0x89, R12, RAX); // mov rax, r12
+	    jit_rr_imm(0, 1, 0xC1, 5, RAX, 3); // shr rax, 3
+	    jit_rr_imm(0, 0, 0x81, 0, RAX, ins->i); // add eax, imm32
+	    jit_mem(0, 0, 0x89, RAX, ST(0));
+	    jit_sp(1);
+	    break;
+	case O_ADDR_GLOBAL:
+	    jit_mem_imm(0, 0, 0xC7, 0, ST(0), ins->i); // mov dword sp[0], imm32
+	    jit_sp(1);
+	    break;
+	case O_INDEX:
+	    jit_mem(0, 0, 0x8B, RAX, ST(-1));
+	    jit_rr_imm(0, 0, 0x69, RAX, RAX, ins->i); // imul eax, eax, imm32
+	    jit_mem(0, 0, 0x01, RAX, ST(-2)); // add sp[-2], eax
+	    jit_sp(-1);
+	    break;
+	case O_FIELD:
+	    jit_mem_imm(0, 0, 0x81, 0, ST(-1), ins->i); // add dword sp[-1], imm32
+	    break;
+
+	case O_LOAD_AT_I: case O_LOAD_AT_C: case O_LOAD_AT_D:
+	    jit_check_address(-1, ins->tk);
+	    jit_mem(0, 1, 0x8B, RAX, JIT_ELEMENT, 0); // mov rax, [r13 + rax * 8]
+	    jit_mem(0, 1, 0x89, RAX, ST(-1));
+	    break;
+	case O_MODIFY_AT_I: case O_MODIFY_AT_C: case O_MODIFY_AT_D:
+	    jit_sp(-2);
+	    jit_check_address(0, ins->tk);
+	    jit_mem(0, 1, 0x8B, RCX, ST(1));
+	    jit_mem(0, 1, 0x89, RCX, JIT_ELEMENT, 0); // mov [r13 + rax * 8], rcx
+	    break;
+	case O_COPY:
+	    jit_spill(pc + 1, 0, 1);
+	    jit_sp(-2);
+	    jit_rr(0, 1, 0x89, RBX, RDI); // mov rdi, rbx
+	    jit_mov_imm(RSI, ins->i);
+	    jit_mov_imm(RDX, jit_token(ins->tk));
+	    jit_call(jit_copy);
+	    jit_spill(pc + 1, 0, 0);
+	    break;
+	case O_VECTOR:
+	    jit_spill(pc + 1, 0, 1);
+	    jit_sp(-4);
+	    jit_rr(0, 1, 0x89, RBX, RDI);
+	    jit_mov_imm(RSI, ins->i);
+	    jit_call(jit_vector);
+	    jit_spill(pc + 1, 0, 0);
+	    break;
+
+	case O_ADD_I: jit_arith_i(0x03, 0); break;
+	case O_ADD_C: jit_arith_i(0x03, 1); break;
+	case O_SUB_I: jit_arith_i(0x2B, 0); break;
+	case O_SUB_C: jit_arith_i(0x2B, 1); break;
+	case O_MUL_I: jit_arith_i(0x0FAF, 0); break;
+	case O_MUL_C: jit_arith_i(0x0FAF, 1); break;
+	case O_ADD_D: jit_arith_d(0x58); break;
+	case O_SUB_D: jit_arith_d(0x5C); break;
+	case O_MUL_D: jit_arith_d(0x59); break;
+	case O_DIV_D: jit_arith_d(0x5E); break;
+	case O_DIV_I: case O_DIV_C:
+	{
+	    int done = 0;
+	    jit_mem(0, 0, ins->op == O_DIV_C ? 0x0FBE : 0x8B, RCX, ST(-1)); // the divisor in ecx
+	    jit_rr(0, 0, 0x85, RCX, RCX); // test ecx, ecx
+	    jit_error_unless(CC_NE, jit_division_error, ins->tk);
+	    jit_mem(0, 0, ins->op == O_DIV_C ? 0x0FBE : 0x8B, RAX, ST(-2));
+	    if(ins->op == O_DIV_I) // INT_MIN / -1 wraps around: the quotient by -1 is neg eax
+	    {
+		jit_rr_imm(0, 0, 0x83, 7, RCX, -1); // cmp ecx, -1
+		int divide = jit_skip(CC_NE, 0);
+		jit_rr(0, 0, 0xF7, 3, RAX); // neg eax
+		done = jit_skip(CC_JMP, 0);
+		jit_skip_to(divide, 0);
+	    }
+	    jit_op(0x99); // cdq
+	    jit_rr(0, 0, 0xF7, 7, RCX); // idiv ecx
+	    if(ins->op == O_DIV_C)
+		jit_rr(0, 0, 0x0FBE, RAX, RAX);
+	    else
+		jit_skip_to(done, 0);
+	    jit_mem(0, 0, 0x89, RAX, ST(-2));
+	    jit_sp(-1);
+	    break;
+	}
+
+	case O_CONST_I:
+	    jit_mem_imm(0, 0, 0xC7, 0, ST(0), ins->i);
+	    jit_sp(1);
+	    break;
+	case O_CONST_D:
+	    {
+		long long bits;
+		memcpy(&bits, &ins->d, sizeof(bits));
+		jit_mov_imm64(RAX, bits);
+		jit_mem(0, 1, 0x89, RAX, ST(0));
+		jit_sp(1);
+	    }
+	    break;
+	case O_NEG_I: jit_mem(0, 0, 0xF7, 3, ST(-1)); break; // neg dword sp[-1]
+	case O_SHL_I: jit_mem_imm(0, 0, 0xC1, 4, ST(-1), ins->i); break; // shl dword sp[-1], i
+	case O_SHR_I: jit_mem_imm(0, 0, 0xC1, 7, ST(-1), ins->i); break; // sar
+	case O_USHR_I: jit_mem_imm(0, 0, 0xC1, 5, ST(-1), ins->i); break; // shr
+	case O_MULHI_I:
+	    jit_mem(0, 1, 0x63, RAX, ST(-1)); // movsxd rax, dword sp[-1]
+	    jit_rr_imm(0, 1, 0x69, RAX, RAX, ins->i); // imul rax, rax, imm32
+	    jit_rr_imm(0, 1, 0xC1, 7, RAX, 32); // sar rax, 32
+	    jit_mem(0, 0, 0x89, RAX, ST(-1));
+	    break;
+	case O_NEG_D:
+	    jit_mem(0, 1, 0x8B, RAX, ST(-1));
+	    jit_rr_imm(0, 1, 0x0FBA, 7, RAX, 63); // btc rax, 63
+	    jit_mem(0, 1, 0x89, RAX, ST(-1));
+	    break;
+	case O_NOT_I:
+	    jit_mem_imm(0, 0, 0x83, 7, ST(-1), 0); // cmp dword sp[-1], 0
+	    jit_rr(0, 0, 0x0F90 | CC_E, 0, RAX);
+	    jit_set_bool(-1);
+	    break;
+	case O_CONV_I_D:
+	    jit_mem(0xF2, 0, 0x0F2A, 0, ST(-1)); // cvtsi2sd xmm0, dword sp[-1]
+	    jit_mem(0xF2, 0, 0x0F11, 0, ST(-1));
+	    break;
+	case O_CONV_D_I:
+	    jit_mem(0xF2, 0, 0x0F2C, RAX, ST(-1)); // cvttsd2si eax, sp[-1]
+	    jit_mem(0, 0, 0x89, RAX, ST(-1));
+	    break;
+	case O_CONV_I_C:
+	    jit_mem(0, 0, 0x0FBE, RAX, ST(-1)); // movsx eax, byte sp[-1]
+	    jit_mem(0, 0, 0x89, RAX, ST(-1));
+	    break;
+
+	case O_EQUAL_I: jit_compare_i(CC_E); break;
+	case O_NOTEQ_I: jit_compare_i(CC_NE); break;
+	case O_LESS_I: jit_compare_i(CC_L); break;
+	case O_LESSEQ_I: jit_compare_i(CC_LE); break;
+	case O_GREATER_I: jit_compare_i(CC_G); break;
+	case O_GREATEREQ_I: jit_compare_i(CC_GE); break;
+	case O_EQUAL_D: case O_NOTEQ_D: case O_LESS_D: case O_LESSEQ_D: case O_GREATER_D: case O_GREATEREQ_D:
+	    jit_compare_d(ins->op);
+	    break;
+
+	case O_JMP: jit_branch(CC_JMP, ins->i); break;
+	case O_JF: case O_JT:
+	    jit_sp(-1);
+	    jit_mem_imm(0, 0, 0x83, 7, ST(0), 0);
+	    jit_branch(ins->op == O_JF ? CC_E : CC_NE, ins->i);
+	    break;
+
+	//the call saves the registers live after it, the return address is on the machine stack and the callee saves fp
+	case O_CALL:
+	    jit_spill(pc + 1, 1, 1);
+	    if(elf_output || asm_file != NULL) // the error of the program gets the name of the function in rax
+		jit_load_address(RAX, tokens[ins->tk].text);
+	    jit_rr_imm(0, 1, 0x81, 7, R14, MAX_CALLS); // cmp r14, MAX_CALLS
+	    jit_error_unless(CC_NE, jit_calls_error, ins->tk);
+	    jit_rr(0, 1, 0xFF, 0, R14); // inc r14
+	    if(!elf_output && asm_file == NULL) // the program has no statistics
+	    {
+		jit_bytes(2, 0x48, 0xB8);
+		jb8((long long)(size_t)&executed_calls);
+		jit_bytes(3, 0x48, 0xFF, 0x00); // inc qword [rax]
+		jit_bytes(2, 0x48, 0xB8);
+		jb8((long long)(size_t)&max_depth_calls);
+		jit_bytes(8, 0x44, 0x39, 0x30, 0x7D, 0x03, 0x44, 0x89, 0x30); // cmp [rax], r14d; jge +3; mov [rax], r14d
+	    }
+	    jit_branch(CC_CALL, ins->i);
+	    jit_rr(0, 1, 0xFF, 1, R14); // dec r14
+	    jit_spill(pc + 1, 1, 0);
+	    break;
+	//the frames with few locals are made here when the stack is big enough, else by jit_enter_frame
+	case O_ENTER:
+	    {
+		int inline_zeros = ins->i - ins->j <= 16;
+		int to_slow = 0, to_end = 0;
+		jit_push(R12, 0);
+		if(inline_zeros)
+		{
+		    jit_rr(0, 1, 0x89, RBX, R12); // mov r12, rbx
+		    jit_rr_imm(0, 1, 0x81, 0, R12, -8 * ins->j); // add r12, -8 * arguments
+		    jit_rr(0, 1, 0x89, R12, RAX); // mov rax, r12
+		    jit_rr_imm(0, 1, 0xC1, 5, RAX, 3); // shr rax, 3
+		    jit_rr_imm(0, 1, 0x81, 0, RAX, ins->i + max_stack); // add rax, slots + max_stack
+		    jit_load_address(RCX, &cap_vm_stack);
+		    jit_at(0, 0, 0x3B, RAX, RCX, 0); // cmp eax, [rcx]
+		    to_slow = jit_skip(CC_G, 1);
+		    for(int k = ins->j; k < ins->i; k++)
+			jit_mem_imm(0, 1, 0xC7, 0, R12, 8 * k, 0); // mov qword fp[k], 0
+		    to_end = jit_skip(CC_JMP, 1);
+		    jit_skip_to(to_slow, 1);
+		}
+		jit_rr(0, 1, 0x89, RBX, RDI); // mov rdi, rbx
+		jit_mov_imm(RSI, ins->i);
+		jit_mov_imm(RDX, ins->j);
+		jit_mov_imm(RCX, jit_token(ins->tk));
+		jit_call(jit_enter_frame);
+		jit_rr(0, 1, 0x89, RAX, R12); // mov r12, rax
+		jit_load_address(RAX, &vm_stack); // the stack may have been moved
+		jit_at(0, 1, 0x8B, R13, RAX, 0); // mov r13, [rax]
+		if(inline_zeros)
+		    jit_skip_to(to_end, 1);
+		jit_rr(0, 1, 0x89, R12, RBX); // mov rbx, r12
+		jit_sp(ins->i);
+		jit_spill(pc + 1, 1, 0); // the arguments and the locals in registers
+	    }
+	    break;
+	case O_LOAD_STRUCT:
+	    jit_spill(pc + 1, 0, 1);
+	    jit_rr(0, 1, 0x89, RBX, RDI);
+	    jit_mov_imm(RSI, ins->i);
+	    jit_mov_imm(RDX, jit_token(ins->tk));
+	    jit_call(jit_load_struct);
+	    jit_spill(pc + 1, 0, 0);
+	    jit_sp(ins->i - 1);
+	    break;
+	case O_RET:
+	    if(ins->i)
+	    {
+		jit_mem(0, 1, 0x8B, RAX, ST(-1));
+		jit_mem(0, 1, 0x89, RAX, R12, 0);
+		jit_rr_imm(0, 1, 0x83, 0, R12, 8); // add r12, 8
+	    }
+	    jit_rr(0, 1, 0x89, R12, RBX); // mov rbx, r12
+	    jit_push(R12, 1); // pop r12
+	    jit_op(0xC3);
+	    break;
+	case O_POP: jit_sp(-ins->i); break;
+
+	case O_PUT_I: case O_PUT_C:
+	    jit_spill(pc + 1, 0, 1);
+	    jit_mem(0, 0, 0x8B, RDI, ST(-1));
+	    jit_sp(-1);
+	    jit_call(ins->op == O_PUT_I ? (void*)jit_put_i : (void*)jit_put_c);
+	    jit_spill(pc + 1, 0, 0);
+	    break;
+	case O_PUT_D:
+	    jit_spill(pc + 1, 0, 1);
+	    jit_mem(0xF2, 0, 0x0F10, 0, ST(-1));
+	    jit_sp(-1);
+	    jit_call(jit_put_d);
+	    jit_spill(pc + 1, 0, 0);
+	    break;
+	case O_GET_I: case O_GET_C:
+	    jit_spill(pc + 1, 0, 1);
+	    jit_call(ins->op == O_GET_I ? (void*)jit_get_i : (void*)jit_get_c);
+	    jit_mem(0, 0, 0x89, RAX, ST(0));
+	    jit_sp(1);
+	    jit_spill(pc + 1, 0, 0);
+	    break;
+	case O_GET_D: case O_SECONDS:
+	    jit_spill(pc + 1, 0, 1);
+	    jit_call(ins->op == O_GET_D ? (void*)jit_get_d : (void*)seconds);
+	    jit_mem(0xF2, 0, 0x0F11, 0, ST(0));
+	    jit_sp(1);
+	    jit_spill(pc + 1, 0, 0);
+	    break;
+
+	default: err("no machine code for %s", print_op(ins->op));
+    }
+}
+
+//the machine code of the instruction at pc, after the values kept before a target
+void jit_translate(int pc)
+{
+    if(jit_targets[pc])
+	jit_flush();
+    jit_offset[pc] = jit_size;
+    jit_instr(&bytecode[pc]);
+}
+
+/* the entry from C: saves the registers of the caller, moves to the machine stack of the compiled
+   code and calls the code, or for osr jumps in the middle of it as if it was already called */
+void jit_entry()
+{
+    jit_bytes(10, 0x55, 0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57); // push rbp, rbx, r12-r15
+    jit_bytes(3, 0x48, 0x89, 0xE5); // mov rbp, rsp
+    jit_bytes(2, 0x48, 0xB8);
+    jb8((long long)(size_t)(jit_stack + JIT_STACK_SIZE));
+    jit_bytes(3, 0x48, 0x89, 0xC4); // mov rsp, rax
+    jit_bytes(9, 0x49, 0x89, 0xF4, 0x48, 0x89, 0xD3, 0x4D, 0x89, 0xC6); // mov r12, rsi; mov rbx, rdx; mov r14, r8
+    jit_bytes(2, 0x48, 0xB8);
+    jb8((long long)(size_t)&vm_stack);
+    jit_bytes(3, 0x4C, 0x8B, 0x28); // mov r13, [rax]
+    jit_bytes(5, 0x48, 0x85, 0xC9, 0x75, 0x04); // test rcx, rcx; jnz osr
+    jit_bytes(4, 0xFF, 0xD7, 0xEB, 0x0C); // call rdi; jmp done
+    jit_bytes(7, 0x48, 0x8D, 0x05, 0x05, 0x00, 0x00, 0x00); // osr: lea rax, [rip + done]
+    jit_bytes(5, 0x50, 0x41, 0x54, 0xFF, 0xE7); // push rax; push r12; jmp rdi
+    jit_bytes(6, 0x48, 0x89, 0xD8, 0x48, 0x89, 0xEC); // done: mov rax, rbx; mov rsp, rbp
+    jit_bytes(11, 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0x5D, 0xC3);
+}
+
+//maps the memory of the machine code and emits the entry, returns 0 if it is not possible
+int jit_init()
+{
+#ifdef JIT_SUPPORTED
+    jit_cap = JIT_INSTR_BYTES * nr_instr + 256;
+    jit_buffer = (unsigned char*)mmap(NULL, jit_cap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    jit_stack = (unsigned char*)mmap(NULL, JIT_STACK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(jit_buffer == MAP_FAILED || jit_stack == MAP_FAILED)
+    {
+	printf("\nThe memory for the machine code can not be mapped, the code is interpreted\n");
+	return 0;
+    }
+    jit_offset = (int*)malloc(sizeof(int) * nr_instr);
+    jit_osr = (int*)malloc(sizeof(int) * nr_instr);
+    jit_targets = jit_jump_targets();
+    if(jit_offset == NULL || jit_osr == NULL)
+	err("not enough memory");
+    for(int pc = 0; pc < nr_instr; pc++)
+	jit_offset[pc] = jit_osr[pc] = -1;
+    jit_entry();
+    jit_run = (long (*)(void*, long, long, long, long))(void*)jit_buffer;
+    //the code is never writable and executable at the same time
+    if(mprotect(jit_buffer, jit_cap, PROT_READ | PROT_EXEC) != 0)
+	err("the machine code can not be made executable");
+    return 1;
+#else
+    printf("\nThe machine code is only generated for x86-64, the code is interpreted\n");
+    return 0;
+#endif
+}
+
+//statistics of the machine code
+int jit_functions=0;
+int jit_instructions=0;
+double jit_seconds=0;
+
+/* translates the function which starts at entry, with the functions it calls which are not
+   translated yet since the machine code only calls machine code */
+void jit_compile(int entry)
+{
+    if(jit_offset[entry] >= 0)
+	return;
+    double start = seconds();
+    if(mprotect(jit_buffer, jit_cap, PROT_READ | PROT_WRITE) != 0)
+	err("the machine code can not be made writable");
+    nr_jit_patches = 0;
+    int k = -1;
+    do
+    {
+	if(k < 0 || jit_offset[jit_patches[k].target] < 0) // the first function or a call of a new one
+	{
+	    int from = k < 0 ? entry : jit_patches[k].target;
+	    int end = function_end(from);
+	    reg_alloc(from);
+	    for(int pc = from; pc < end; pc++)
+		jit_translate(pc);
+	    jit_flush();
+	    //the entries of the loops for -Tiered read the registers live at the start of the loop
+	    for(int pc = from; pc < end; pc++)
+		if(bytecode[pc].op == O_JT && bytecode[pc].i < pc && jit_osr[bytecode[pc].i] < 0)
+		{
+		    jit_osr[bytecode[pc].i] = jit_size;
+		    jit_spill(bytecode[pc].i, 1, 0);
+		    jit_branch(CC_JMP, bytecode[pc].i);
+		}
+	    jit_functions++;
+	    jit_instructions += end - from;
+	}
+	k++;
+    }while(k < nr_jit_patches);
+    for(k = 0; k < nr_jit_patches; k++)
+    {
+	int rel = jit_offset[jit_patches[k].target] - (jit_patches[k].at + 4);
+	memcpy(jit_buffer + jit_patches[k].at, &rel, 4);
+    }
+    if(mprotect(jit_buffer, jit_cap, PROT_READ | PROT_EXEC) != 0)
+	err("the machine code can not be made executable");
+    jit_seconds += seconds() - start;
+}
+
+/*						*
+ *	       Tiered Execution			*
+ *						*/
+
+/* with -Tiered the code starts interpreted and the interpreter counts the calls of each function
+   and the iterations of each loop; a function which reaches its threshold is translated to machine
+   code and its next calls run it, a loop which reaches its threshold translates its function and
+   continues in the machine code from the start of its body (on-stack replacement) */
+int call_threshold=1000;
+int loop_threshold=10000;
+int* hotness=NULL; // the calls of the function at each entry and the iterations of the loop at each back jump
+
+typedef struct TierEvent{
+    int entry; // the function translated
+    int loop; // the back jump of the loop which reached its threshold, -1 for the calls
+    int functions; // the functions translated with it
+}TierEvent;
+
+TierEvent* tier_events=NULL;
+int nr_tier_events=0;
+int cap_tier_events=0;
+
+//the function at entry reached a threshold, loop is the back jump of its hot loop or -1
+void tier_up(int entry, int loop)
+{
+    int before = jit_functions;
+    jit_compile(entry);
+    if(nr_tier_events == cap_tier_events)
+    {
+	cap_tier_events = cap_tier_events ? cap_tier_events * 2 : 16;
+	tier_events = (TierEvent*)realloc(tier_events, sizeof(TierEvent) * cap_tier_events);
+	if(tier_events == NULL)
+	    err("not enough memory");
+    }
+    tier_events[nr_tier_events].entry = entry;
+    tier_events[nr_tier_events].loop = loop;
+    tier_events[nr_tier_events].functions = jit_functions - before;
+    nr_tier_events++;
+}
+
+void print_tier_events()
+{
+    printf("\nTiered execution: functions translated after %d calls, loops after %d iterations\n", call_threshold, loop_threshold);
+    for(int k = 0; k < nr_tier_events; k++)
+    {
+	TierEvent* e = &tier_events[k];
+	printf("  %s", tokens[bytecode[e->entry].tk].text);
+	if(e->loop < 0)
+	    printf(" after %d calls", call_threshold);
+	else
+	    printf(" after %d iterations of the loop at line %d, entered by on-stack replacement", loop_threshold, tokens[bytecode[e->loop].tk].line);
+	if(e->functions > 1)
+	    printf(" (with %d functions it calls)", e->functions - 1);
+	printf("\n");
+    }
+}
+
+/* the dispatch of the op codes: with GCC and Clang each handler jumps to the handler of the next
+   instruction through a table of label addresses (computed goto), so every op code has its own
+   indirect jump which the processor predicts separately; compiling with -DSWITCH_DISPATCH (or
+   with another compiler) keeps the portable switch in a loop */
+//the record of the executed instruction, nothing is done when the trace is off
+#define NO_VALUE ((Value){.i = 0})
+#define TRACE(operand, value) do{ if(trace_ring) trace_record(ins->op, tokens[ins->tk].line, operand, nr_calls, value); }while(0)
+
+#if defined(__GNUC__) && !defined(SWITCH_DISPATCH)
+#define COMPUTED_GOTO
+#define HANDLER(op) L_##op
+#define NEXT do{ ins = &bytecode[pc++]; executed++; goto *handlers[ins->op]; }while(0)
+#define DISPATCH_NAME "computed goto"
+#else
+#define HANDLER(op) case op
+#define NEXT break
+#define DISPATCH_NAME "switch"
+#endif
+
+// finite state machine for OP codes: executes the bytecode from the first instruction until O_HALT
+int op_code_execute()
+{
+    int pc = 0;
+    int nr_calls = 0;
+    int address, height;
+    grow_vm_stack(nr_globals);
+    Value* fp = vm_stack; // the frame of the running function, the globals for the first instructions
+    Value* sp = vm_stack + nr_globals; // the first free value, the top is sp[-1]
+    long long executed = 0;
+    Instr* ins;
+#ifdef COMPUTED_GOTO
+    static void* handlers[] = {
+	[O_STORE_I] = &&L_O_STORE_I,
+	[O_STORE_C] = &&L_O_STORE_C,
+	[O_STORE_D] = &&L_O_STORE_D,
+	[O_ADD_I] = &&L_O_ADD_I,
+	[O_ADD_C] = &&L_O_ADD_C,
+	[O_ADD_D] = &&L_O_ADD_D,
+	[O_SUB_I] = &&L_O_SUB_I,
+	[O_SUB_C] = &&L_O_SUB_C,
+	[O_SUB_D] = &&L_O_SUB_D,
+	[O_LOAD_I] = &&L_O_LOAD_I,
+	[O_LOAD_C] = &&L_O_LOAD_C,
+	[O_LOAD_D] = &&L_O_LOAD_D,
+	[O_MUL_I] = &&L_O_MUL_I,
+	[O_MUL_C] = &&L_O_MUL_C,
+	[O_MUL_D] = &&L_O_MUL_D,
+	[O_DIV_I] = &&L_O_DIV_I,
+	[O_DIV_C] = &&L_O_DIV_C,
+	[O_DIV_D] = &&L_O_DIV_D,
+	[O_MODIFY_I] = &&L_O_MODIFY_I,
+	[O_MODIFY_C] = &&L_O_MODIFY_C,
+	[O_MODIFY_D] = &&L_O_MODIFY_D,
+	[O_STORE_GLOBAL_I] = &&L_O_STORE_GLOBAL_I,
+	[O_STORE_GLOBAL_C] = &&L_O_STORE_GLOBAL_C,
+	[O_STORE_GLOBAL_D] = &&L_O_STORE_GLOBAL_D,
+	[O_LOAD_GLOBAL_I] = &&L_O_LOAD_GLOBAL_I,
+	[O_LOAD_GLOBAL_C] = &&L_O_LOAD_GLOBAL_C,
+	[O_LOAD_GLOBAL_D] = &&L_O_LOAD_GLOBAL_D,
+	[O_MODIFY_GLOBAL_I] = &&L_O_MODIFY_GLOBAL_I,
+	[O_MODIFY_GLOBAL_C] = &&L_O_MODIFY_GLOBAL_C,
+	[O_MODIFY_GLOBAL_D] = &&L_O_MODIFY_GLOBAL_D,
+	[O_ADDR] = &&L_O_ADDR,
+	[O_ADDR_GLOBAL] = &&L_O_ADDR_GLOBAL,
+	[O_INDEX] = &&L_O_INDEX,
+	[O_FIELD] = &&L_O_FIELD,
+	[O_LOAD_AT_I] = &&L_O_LOAD_AT_I,
+	[O_LOAD_AT_C] = &&L_O_LOAD_AT_C,
+	[O_LOAD_AT_D] = &&L_O_LOAD_AT_D,
+	[O_MODIFY_AT_I] = &&L_O_MODIFY_AT_I,
+	[O_MODIFY_AT_C] = &&L_O_MODIFY_AT_C,
+	[O_MODIFY_AT_D] = &&L_O_MODIFY_AT_D,
+	[O_COPY] = &&L_O_COPY,
+	[O_VECTOR] = &&L_O_VECTOR,
+	[O_CONST_I] = &&L_O_CONST_I,
+	[O_CONST_D] = &&L_O_CONST_D,
+	[O_NEG_I] = &&L_O_NEG_I,
+	[O_NEG_D] = &&L_O_NEG_D,
+	[O_NOT_I] = &&L_O_NOT_I,
+	[O_SHL_I] = &&L_O_SHL_I,
+	[O_SHR_I] = &&L_O_SHR_I,
+	[O_USHR_I] = &&L_O_USHR_I,
+	[O_MULHI_I] = &&L_O_MULHI_I,
+	[O_CONV_I_D] = &&L_O_CONV_I_D,
+	[O_CONV_D_I] = &&L_O_CONV_D_I,
+	[O_CONV_I_C] = &&L_O_CONV_I_C,
+	[O_EQUAL_I] = &&L_O_EQUAL_I,
+	[O_EQUAL_D] = &&L_O_EQUAL_D,
+	[O_NOTEQ_I] = &&L_O_NOTEQ_I,
+	[O_NOTEQ_D] = &&L_O_NOTEQ_D,
+	[O_LESS_I] = &&L_O_LESS_I,
+	[O_LESS_D] = &&L_O_LESS_D,
+	[O_LESSEQ_I] = &&L_O_LESSEQ_I,
+	[O_LESSEQ_D] = &&L_O_LESSEQ_D,
+	[O_GREATER_I] = &&L_O_GREATER_I,
+	[O_GREATER_D] = &&L_O_GREATER_D,
+	[O_GREATEREQ_I] = &&L_O_GREATEREQ_I,
+	[O_GREATEREQ_D] = &&L_O_GREATEREQ_D,
+	[O_JMP] = &&L_O_JMP,
+	[O_JF] = &&L_O_JF,
+	[O_JT] = &&L_O_JT,
+	[O_CALL] = &&L_O_CALL,
+	[O_ENTER] = &&L_O_ENTER,
+	[O_LOAD_STRUCT] = &&L_O_LOAD_STRUCT,
+	[O_RET] = &&L_O_RET,
+	[O_POP] = &&L_O_POP,
+	[O_PUT_I] = &&L_O_PUT_I,
+	[O_PUT_D] = &&L_O_PUT_D,
+	[O_PUT_C] = &&L_O_PUT_C,
+	[O_GET_I] = &&L_O_GET_I,
+	[O_GET_D] = &&L_O_GET_D,
+	[O_GET_C] = &&L_O_GET_C,
+	[O_SECONDS] = &&L_O_SECONDS,
+	[O_HALT] = &&L_O_HALT
+    };
+    NEXT;
+#else
+    for(;;)
+    {
+	ins = &bytecode[pc++];
+	executed++;
+	switch(ins->op)
+	{
+#endif
+	HANDLER(O_STORE_I):	sp--; fp[ins->i].i = sp->i; TRACE(ins->i, *sp); NEXT;
+	HANDLER(O_STORE_C):	sp--; fp[ins->i].i = sp->i; TRACE(ins->i, *sp); NEXT;
+	HANDLER(O_STORE_D):	sp--; fp[ins->i].d = sp->d; TRACE(ins->i, *sp); NEXT;
+	HANDLER(O_LOAD_I):	*sp++ = fp[ins->i]; TRACE(ins->i, sp[-1]); NEXT;
+	HANDLER(O_LOAD_C):	*sp++ = fp[ins->i]; TRACE(ins->i, sp[-1]); NEXT;
+	HANDLER(O_LOAD_D):	*sp++ = fp[ins->i]; TRACE(ins->i, sp[-1]); NEXT;
+	HANDLER(O_MODIFY_I):	sp--; fp[ins->i].i = sp->i; TRACE(ins->i, *sp); NEXT;
+	HANDLER(O_MODIFY_C):	sp--; fp[ins->i].i = sp->i; TRACE(ins->i, *sp); NEXT;
+	HANDLER(O_MODIFY_D):	sp--; fp[ins->i].d = sp->d; TRACE(ins->i, *sp); NEXT;
+
+	HANDLER(O_STORE_GLOBAL_I):	sp--; vm_stack[ins->i].i = sp->i; TRACE(ins->i, *sp); NEXT;
+	HANDLER(O_STORE_GLOBAL_C):	sp--; vm_stack[ins->i].i = sp->i; TRACE(ins->i, *sp); NEXT;
+	HANDLER(O_STORE_GLOBAL_D):	sp--; vm_stack[ins->i].d = sp->d; TRACE(ins->i, *sp); NEXT;
+	HANDLER(O_LOAD_GLOBAL_I):	*sp++ = vm_stack[ins->i]; TRACE(ins->i, sp[-1]); NEXT;
+	HANDLER(O_LOAD_GLOBAL_C):	*sp++ = vm_stack[ins->i]; TRACE(ins->i, sp[-1]); NEXT;
+	HANDLER(O_LOAD_GLOBAL_D):	*sp++ = vm_stack[ins->i]; TRACE(ins->i, sp[-1]); NEXT;
+	HANDLER(O_MODIFY_GLOBAL_I):	sp--; vm_stack[ins->i].i = sp->i; TRACE(ins->i, *sp); NEXT;
+	HANDLER(O_MODIFY_GLOBAL_C):	sp--; vm_stack[ins->i].i = sp->i; TRACE(ins->i, *sp); NEXT;
+	HANDLER(O_MODIFY_GLOBAL_D):	sp--; vm_stack[ins->i].d = sp->d; TRACE(ins->i, *sp); NEXT;
+
+	HANDLER(O_ADDR): (sp++)->i = (fp - vm_stack) + ins->i; TRACE(ins->i, sp[-1]); NEXT;
+	HANDLER(O_ADDR_GLOBAL): (sp++)->i = ins->i; TRACE(ins->i, sp[-1]); NEXT;
+	HANDLER(O_INDEX): sp--; sp[-1].i += sp->i * ins->i; TRACE(ins->i, sp[-1]); NEXT;
+	HANDLER(O_FIELD): sp[-1].i += ins->i; TRACE(ins->i, sp[-1]); NEXT;
+
+	//the addresses are checked, a wrong index can not reach outside of the stack
+	HANDLER(O_LOAD_AT_I): HANDLER(O_LOAD_AT_C): HANDLER(O_LOAD_AT_D):
+			address = sp[-1].i;
+			if(address < 0 || address >= sp - vm_stack)
+			    tkerr(&tokens[ins->tk], "invalid memory access at %d", address);
+			sp[-1] = vm_stack[address];
+			TRACE(address, sp[-1]);
+			NEXT;
+
+	HANDLER(O_MODIFY_AT_I): HANDLER(O_MODIFY_AT_C): HANDLER(O_MODIFY_AT_D):
+			sp -= 2;
+			address = sp->i;
+			if(address < 0 || address >= sp - vm_stack)
+			    tkerr(&tokens[ins->tk], "invalid memory access at %d", address);
+			vm_stack[address] = sp[1];
+			TRACE(address, sp[1]);
+			NEXT;
+
+	HANDLER(O_COPY):	sp -= 2;
+			address = sp->i;
+			if(address < 0 || sp[1].i < 0 || address + ins->i > sp - vm_stack || sp[1].i + ins->i > sp - vm_stack)
+			    tkerr(&tokens[ins->tk], "invalid memory access at %d", address);
+			memmove(vm_stack + address, vm_stack + sp[1].i, sizeof(Value) * ins->i);
+			TRACE(address, sp[1]);
+			NEXT;
+
+	HANDLER(O_VECTOR):	sp -= 4;
+			sp[-1].i = vector_run(sp - 1, ins->i);
+			TRACE(0, sp[-1]);
+			NEXT;
+
+	HANDLER(O_ADD_I): sp--; sp[-1].i = (int)((unsigned)sp[-1].i + (unsigned)sp->i); TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_ADD_C): sp--; sp[-1].i = (char)(sp[-1].i + sp->i); TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_ADD_D): sp--; sp[-1].d += sp->d; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_SUB_I): sp--; sp[-1].i = (int)((unsigned)sp[-1].i - (unsigned)sp->i); TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_SUB_C): sp--; sp[-1].i = (char)(sp[-1].i - sp->i); TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_SUB_D): sp--; sp[-1].d -= sp->d; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_MUL_I): sp--; sp[-1].i = (int)((unsigned)sp[-1].i * (unsigned)sp->i); TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_MUL_C): sp--; sp[-1].i = (char)(sp[-1].i * sp->i); TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_MUL_D): sp--; sp[-1].d *= sp->d; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_DIV_I): sp--;
+			if(sp->i == 0)
+			    tkerr(&tokens[ins->tk], "division by zero");
+			if(sp->i == -1) // INT_MIN / -1 wraps around as the other operators
+			    sp[-1].i = (int)(0u - (unsigned)sp[-1].i);
+			else
+			    sp[-1].i /= sp->i;
+			TRACE(0, sp[-1]);
+			NEXT;
+	HANDLER(O_DIV_C): sp--;
+			if((char)sp->i == 0)
+			    tkerr(&tokens[ins->tk], "division by zero");
+			sp[-1].i = (char)((char)sp[-1].i / (char)sp->i);
+			TRACE(0, sp[-1]);
+			NEXT;
+	HANDLER(O_DIV_D): sp--; sp[-1].d /= sp->d; TRACE(0, sp[-1]); NEXT;
+
+	HANDLER(O_CONST_I): (sp++)->i = ins->i; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_CONST_D): (sp++)->d = ins->d; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_NEG_I): sp[-1].i = (int)(0u - (unsigned)sp[-1].i); TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_NEG_D): sp[-1].d = -sp[-1].d; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_NOT_I): sp[-1].i = !sp[-1].i; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_SHL_I): sp[-1].i = (int)((unsigned)sp[-1].i << ins->i); TRACE(ins->i, sp[-1]); NEXT;
+	HANDLER(O_SHR_I): sp[-1].i >>= ins->i; TRACE(ins->i, sp[-1]); NEXT;
+	HANDLER(O_USHR_I): sp[-1].i = (int)((unsigned)sp[-1].i >> ins->i); TRACE(ins->i, sp[-1]); NEXT;
+	HANDLER(O_MULHI_I): sp[-1].i = (int)((long long)sp[-1].i * ins->i >> 32); TRACE(ins->i, sp[-1]); NEXT;
+	HANDLER(O_CONV_I_D): sp[-1].d = sp[-1].i; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_CONV_D_I): sp[-1].i = (int)sp[-1].d; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_CONV_I_C): sp[-1].i = (char)sp[-1].i; TRACE(0, sp[-1]); NEXT;
+
+	HANDLER(O_EQUAL_I): sp--; sp[-1].i = sp[-1].i == sp->i; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_EQUAL_D): sp--; sp[-1].i = sp[-1].d == sp->d; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_NOTEQ_I): sp--; sp[-1].i = sp[-1].i != sp->i; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_NOTEQ_D): sp--; sp[-1].i = sp[-1].d != sp->d; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_LESS_I): sp--; sp[-1].i = sp[-1].i < sp->i; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_LESS_D): sp--; sp[-1].i = sp[-1].d < sp->d; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_LESSEQ_I): sp--; sp[-1].i = sp[-1].i <= sp->i; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_LESSEQ_D): sp--; sp[-1].i = sp[-1].d <= sp->d; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_GREATER_I): sp--; sp[-1].i = sp[-1].i > sp->i; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_GREATER_D): sp--; sp[-1].i = sp[-1].d > sp->d; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_GREATEREQ_I): sp--; sp[-1].i = sp[-1].i >= sp->i; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_GREATEREQ_D): sp--; sp[-1].i = sp[-1].d >= sp->d; TRACE(0, sp[-1]); NEXT;
+
+	HANDLER(O_JMP): pc = ins->i; TRACE(ins->i, NO_VALUE); NEXT;
+	HANDLER(O_JF): if(!(--sp)->i) pc = ins->i; TRACE(ins->i, *sp); NEXT;
+	HANDLER(O_JT): if((--sp)->i)
+			{
+			    //the back jump of a loop continues in the machine code of its function when there is one
+			    if(hotness != NULL && ins->i < pc && (jit_offset[ins->i] >= 0 || ++hotness[pc - 1] >= loop_threshold))
+			    {
+				if(jit_offset[ins->i] < 0)
+				    tier_up(function_entry(pc - 1), pc - 1);
+				long top = jit_run(jit_buffer + jit_osr[ins->i], (fp - vm_stack) * sizeof(Value), (sp - vm_stack) * sizeof(Value), 1, nr_calls);
+				//the function returned in the machine code, the rest of O_RET is done here
+				sp = vm_stack + top / sizeof(Value);
+				nr_calls--;
+				pc = frames[nr_calls].return_address;
+				fp = vm_stack + frames[nr_calls].fp;
+				NEXT;
+			    }
+			    pc = ins->i;
+			}
+			TRACE(ins->i, *sp);
+			NEXT;
+
+	HANDLER(O_CALL):	if(nr_calls == MAX_CALLS)
+			    tkerr(&tokens[ins->tk], "too many nested calls of %s", tokens[ins->tk].text);
+			if(hotness != NULL && jit_offset[ins->i] < 0 && ++hotness[ins->i] >= call_threshold)
+			    tier_up(ins->i, -1);
+			if(jit_offset != NULL && jit_offset[ins->i] >= 0) // the compiled function runs until its return
+			{
+			    executed_calls++;
+			    if(nr_calls + 1 > max_depth_calls)
+				max_depth_calls = nr_calls + 1;
+			    long frame = fp - vm_stack;
+			    long top = jit_run(jit_buffer + jit_offset[ins->i], frame * sizeof(Value), (sp - vm_stack) * sizeof(Value), 0, nr_calls + 1);
+			    fp = vm_stack + frame;
+			    sp = vm_stack + top / sizeof(Value);
+			    NEXT;
+			}
+			if(nr_calls == cap_frames)
+			{
+			    cap_frames = cap_frames ? cap_frames * 2 : 256;
+			    frames = (Frame*)realloc(frames, sizeof(Frame) * cap_frames);
+			    if(frames == NULL)
+				err("not enough memory");
+			}
+			frames[nr_calls].return_address = pc;
+			frames[nr_calls].fp = fp - vm_stack;
+			nr_calls++;
+			executed_calls++;
+			if(nr_calls > max_depth_calls)
+			    max_depth_calls = nr_calls;
+			pc = ins->i;
+			TRACE(ins->i, ((Value){.i = frames[nr_calls - 1].return_address}));
+			NEXT;
+
+	//the frame starts with the arguments pushed by the caller, the other slots start with zeros
+	//and the stack may be moved to make room for them
+	HANDLER(O_ENTER):	height = (sp - vm_stack) - ins->j;
+			grow_vm_stack(height + ins->i);
+			fp = vm_stack + height;
+			memset(fp + ins->j, 0, sizeof(Value) * (ins->i - ins->j));
+			sp = fp + ins->i;
+			TRACE(ins->i, NO_VALUE);
+			NEXT;
+
+	HANDLER(O_LOAD_STRUCT):	address = sp[-1].i;
+			if(address < 0 || address + ins->i > sp - vm_stack)
+			    tkerr(&tokens[ins->tk], "invalid memory access at %d", address);
+			memmove(sp - 1, vm_stack + address, sizeof(Value) * ins->i);
+			sp += ins->i - 1;
+			TRACE(address, NO_VALUE);
+			NEXT;
+
+	HANDLER(O_RET):	TRACE(ins->i, NO_VALUE);
+			if(ins->i) // the returned value replaces the frame
+			    *fp++ = sp[-1];
+			sp = fp;
+			nr_calls--;
+			pc = frames[nr_calls].return_address;
+			fp = vm_stack + frames[nr_calls].fp;
+			NEXT;
+
+	HANDLER(O_POP): sp -= ins->i; TRACE(ins->i, NO_VALUE); NEXT;
+
+	HANDLER(O_PUT_I): printf("%d\n", (--sp)->i); TRACE(0, *sp); NEXT;
+	HANDLER(O_PUT_D): printf("%lf\n", (--sp)->d); TRACE(0, *sp); NEXT;
+	HANDLER(O_PUT_C): printf("%c\n", (char)(--sp)->i); TRACE(0, *sp); NEXT;
+	HANDLER(O_GET_I): if(scanf("%d", &sp->i) != 1) sp->i = 0; sp++; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_GET_D): if(scanf("%lf", &sp->d) != 1) sp->d = 0; sp++; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_GET_C): sp->i = getchar(); if(sp->i == EOF) sp->i = 0; sp++; TRACE(0, sp[-1]); NEXT;
+	HANDLER(O_SECONDS): (sp++)->d = seconds(); TRACE(0, sp[-1]); NEXT;
+
+	HANDLER(O_HALT): TRACE(0, NO_VALUE); executed_instr = executed; return 1;
+#ifndef COMPUTED_GOTO
+	default: printf("OP CODE NOT FOUND!\n"); return 0;
+	}
+    }
+#endif
+}
+
+//print the global variables of the basic types with their slots
+void print_globals()
+{
+    for(Symbol* sy = Symbol_root; sy != NULL; sy = sy->next)
+    {
+	if(sy->line < 0 || !is_global(sy) || sy->cls != VARIABLE || !has_value(sy->type) || (sy->ir_flags & IR_UNUSED))
+	    continue;
+	printf("Name: %s = ", sy->name);
+	if(sy->type == _INT)
+	    printf("%d", vm_stack[sy->slot].i);
+	if(sy->type == _DOUBLE)
+	    printf("%lf", vm_stack[sy->slot].d);
+	if(sy->type == _CHAR)
+	    printf("'%c'",(char)(vm_stack[sy->slot].i));
+	printf(" at %d\n", sy->slot);
+    }
+}
+
+/*						*
+ *	      x86-64 Assembly Output		*
+ *						*/
+
+/* with -S the bytecode is written as x86-64 assembly for the GNU assembler, in file_to_compile.s:
+   gcc file_to_compile.s -o program makes a standalone program. Its instructions are written by the
+   templates of -Jit (see asm_file), so it works as the machine code of -Jit and does not follow
+   the calling convention of the System V ABI:
+	- the values, the arguments, the locals and the results are on a stack of values in .bss,
+	  with the globals at its bottom; the machine stack only has the return addresses and fp
+	- rbx = sp in bytes, r12 = fp in bytes, r13 = the stack of values, r14 = the calls, and the
+	  slots in registers are in r15, r8-r11 and xmm2-xmm15 as with -Jit
+	- the globals are zeros in .bss, their initializations are code run before main
+   Only the runtime at the end of the file follows the ABI, since it calls the C library: its
+   routines take the arguments of the functions of the compiler called by the machine code. */
+#define ASM_STACK_VALUES (32 << 20) // the values of the stack of the program
+#define ASM_MACHINE_STACK (64 << 20) // the machine stack, deep enough for MAX_CALLS
+
+char* asm_name=NULL; // the source file name followed by .s
+
+//writes an instruction of the assembly
+void as(const char* fmt, ...)
+{
+    va_list va;
+    va_start(va, fmt);
+    fputc('\t', asm_file);
+    vfprintf(asm_file, fmt, va);
+    fputc('\n', asm_file);
+    va_end(va);
+}
+
+//the name of the function which starts at entry
+char* asm_function(int entry)
+{
+    return tokens[bytecode[entry].tk].text;
+}
+
+//the routine of the runtime which replaces a function of the compiler, its variable, or the label of the name of a function
+const char* asm_symbol(void* host)
+{
+    void* hosts[] = {jit_enter_frame, jit_copy, jit_load_struct, jit_memory_error, jit_division_error, jit_calls_error,
+		     jit_put_i, jit_put_d, jit_put_c, jit_get_i, jit_get_d, jit_get_c, seconds, jit_vector, &vm_stack, &cap_vm_stack};
+    static const char* names[] = {"rt_enter_frame", "rt_copy", "rt_load_struct", "rt_memory_error", "rt_division_error",
+				  "rt_calls_error", "rt_put_i", "rt_put_d", "rt_put_c", "rt_get_i", "rt_get_d", "rt_get_c",
+				  "rt_seconds", "rt_vector", "rt_vm_stack", "rt_cap_vm_stack"};
+    static char label[256];
+    for(int k = 0; k < (int)(sizeof(names) / sizeof(names[0])); k++)
+	if(hosts[k] == host)
+	    return names[k];
+    snprintf(label, sizeof(label), ".Lname_%s", (char*)host);
+    return label;
+}
+
+//the predefined functions, called with the machine stack aligned as the ABI requires
+void asm_runtime()
+{
+    fprintf(asm_file, "\nrt_put_i:\n");
+    as("mov esi, edi"); as("lea rdi, .Lformat_put_i[rip]"); as("jmp rt_printf");
+    fprintf(asm_file, "rt_put_c:\n");
+    as("movsx esi, dil"); as("lea rdi, .Lformat_put_c[rip]"); as("jmp rt_printf");
+    fprintf(asm_file, "rt_put_d:\n");
+    as("lea rdi, .Lformat_put_d[rip]");
+    fprintf(asm_file, "rt_printf:\n");
+    as("sub rsp, 8"); as("mov eax, 1"); as("call printf@PLT"); as("add rsp, 8"); as("ret");
+    fprintf(asm_file, "rt_get_i:\n");
+    as("sub rsp, 24"); as("mov QWORD PTR [rsp], 0"); as("mov rsi, rsp"); as("lea rdi, .Lformat_get_i[rip]");
+    as("xor eax, eax"); as("call scanf@PLT"); as("mov eax, DWORD PTR [rsp]"); as("add rsp, 24"); as("ret");
+    fprintf(asm_file, "rt_get_d:\n");
+    as("sub rsp, 24"); as("mov QWORD PTR [rsp], 0"); as("mov rsi, rsp"); as("lea rdi, .Lformat_get_d[rip]");
+    as("xor eax, eax"); as("call scanf@PLT"); as("movsd xmm0, QWORD PTR [rsp]"); as("add rsp, 24"); as("ret");
+    fprintf(asm_file, "rt_get_c:\n");
+    as("sub rsp, 8"); as("call getchar@PLT"); as("add rsp, 8");
+    as("xor ecx, ecx"); as("cmp eax, -1"); as("cmove eax, ecx"); as("ret");
+    fprintf(asm_file, "rt_seconds:\n");
+    as("sub rsp, 24"); as("mov edi, %d", CLOCK_MONOTONIC); as("mov rsi, rsp"); as("call clock_gettime@PLT");
+    as("cvtsi2sd xmm0, QWORD PTR [rsp]"); as("cvtsi2sd xmm1, QWORD PTR [rsp+8]"); as("divsd xmm1, QWORD PTR .Lbillion[rip]");
+    as("addsd xmm0, xmm1"); as("add rsp, 24"); as("ret");
+
+    //the errors: edi = the line, esi = the address, or rsi = the name of the function
+    fprintf(asm_file, "rt_memory_error:\n");
+    as("mov edx, esi"); as("mov esi, edi"); as("lea rdi, .Lerr_memory[rip]"); as("jmp rt_error");
+    fprintf(asm_file, "rt_division_error:\n");
+    as("mov esi, edi"); as("lea rdi, .Lerr_division[rip]"); as("jmp rt_error");
+    fprintf(asm_file, "rt_calls_error:\n");
+    as("mov rdx, rsi"); as("mov esi, edi"); as("lea rdi, .Lerr_calls[rip]"); as("jmp rt_error");
+    //rdi = the message, esi = the line, rdx = the argument of the message
+    fprintf(asm_file, "rt_error:\n");
+    as("mov rcx, rdx"); as("mov edx, esi"); as("mov rsi, rdi"); as("mov edi, 2"); as("xor eax, eax");
+    as("sub rsp, 8"); as("call dprintf@PLT"); as("mov edi, 255"); as("call exit@PLT");
+
+    //jit_enter_frame: rdi = sp, esi = the slots, edx = the arguments, ecx = the line; the stack has a fixed size
+    fprintf(asm_file, "rt_enter_frame:\n");
+    as("mov rax, rdi"); as("shr rax, 3"); as("sub eax, edx"); // the height of the frame
+    as("lea r8d, [rax+rsi+%d]", max_stack); as("cmp r8d, DWORD PTR rt_cap_vm_stack[rip]"); as("jbe 1f");
+    as("mov esi, ecx"); as("lea rdi, .Lerr_stack[rip]"); as("jmp rt_error");
+    fprintf(asm_file, "1:\n");
+    as("lea r9d, [rax+rdx]"); as("lea rdi, [r13+r9*8]"); as("mov ecx, esi"); as("sub ecx, edx");
+    as("mov r8d, eax"); as("xor eax, eax"); as("rep stosq"); as("mov eax, r8d"); as("shl rax, 3"); as("ret");
+    //jit_copy: rdi = sp with the destination in sp[0] and the source in sp[1], esi = the values, edx = the line
+    fprintf(asm_file, "rt_copy:\n");
+    as("mov eax, DWORD PTR [r13+rdi]"); as("mov r9d, DWORD PTR [r13+rdi+8]");
+    as("mov r10, rdi"); as("shr r10, 3"); as("sub r10d, esi"); // the values below sp - n
+    as("cmp eax, r10d"); as("ja 1f"); as("cmp r9d, r10d"); as("ja 1f");
+    as("lea rdi, [r13+rax*8]"); as("lea rdx, [0+rsi*8]"); as("lea rsi, [r13+r9*8]"); as("jmp memmove@PLT");
+    fprintf(asm_file, "1:\n");
+    as("mov edi, edx"); as("mov esi, eax"); as("jmp rt_memory_error");
+    //jit_load_struct: the values at the address in sp[-1] replace it
+    fprintf(asm_file, "rt_load_struct:\n");
+    as("mov eax, DWORD PTR [r13+rdi-8]");
+    as("mov r10, rdi"); as("shr r10, 3"); as("sub r10d, esi");
+    as("cmp eax, r10d"); as("ja 1f");
+    as("lea rdi, [r13+rdi-8]"); as("lea rdx, [0+rsi*8]"); as("lea rsi, [r13+rax*8]"); as("jmp memmove@PLT");
+    fprintf(asm_file, "1:\n");
+    as("mov edi, edx"); as("mov esi, eax"); as("jmp rt_memory_error");
+
+    /* jit_vector: rdi = sp, esi = the op of O_VECTOR, as the routine of -Elf: r8 = the operands, r9 = the
+       values below them, r10 = the start, r11 = the op, rcx = the elements computed, rdx, rsi and rdi = d, a, b */
+    fprintf(asm_file, "rt_vector:\n");
+    as("mov eax, DWORD PTR .Lsimd_width[rip]"); as("test eax, eax"); as("jne .Lvector_width");
+    as("push rbx"); as("xor eax, eax"); as("cpuid"); as("mov r8d, eax");
+    as("mov eax, 1"); as("cpuid"); as("mov r9d, ecx"); as("xor r10d, r10d");
+    as("cmp r8d, 7"); as("jb 1f"); as("mov eax, 7"); as("xor ecx, ecx"); as("cpuid"); as("mov r10d, ebx");
+    fprintf(asm_file, "1:\n");
+    as("pop rbx"); as("mov r8d, 2");
+    as("and r9d, 0x18000000"); as("cmp r9d, 0x18000000"); as("jne 2f"); // osxsave and avx
+    as("test r10d, 0x20"); as("je 2f");
+    as("xor ecx, ecx"); as("xgetbv"); as("and eax, 6"); as("cmp eax, 6"); as("jne 2f");
+    as("mov r8d, 4");
+    fprintf(asm_file, "2:\n");
+    as("mov DWORD PTR .Lsimd_width[rip], r8d"); as("mov eax, r8d");
+    fprintf(asm_file, ".Lvector_width:\n");
+    as("mov r11d, esi"); as("lea r8, [r13+rdi-8]"); as("mov r9, rdi"); as("shr r9, 3"); as("dec r9");
+    as("movsxd r10, DWORD PTR [r8+24]"); as("movsxd rcx, DWORD PTR [r8+32]"); as("sub rcx, r10");
+    as("movsxd rdx, DWORD PTR [r8]"); as("mov DWORD PTR [r8], r10d");
+    as("mov rsi, rax"); as("neg rsi"); as("and rcx, rsi"); as("jle .Lvector_end");
+    as("add rdx, r10"); as("js .Lvector_end"); as("lea rax, [rdx+rcx]"); as("cmp rax, r9"); as("jg .Lvector_end");
+    for(int k = 1; k < 3; k++)
+    {
+	as("bt r11d, %d", 7 + k); as("jc 1f");
+	as("movsxd rax, DWORD PTR [r8+%d]", 8 * k); as("add rax, r10"); as("js .Lvector_end");
+	as("lea rsi, [rax+rcx]"); as("cmp rsi, r9"); as("jg .Lvector_end");
+	as("sub rax, rdx"); as("je 1f"); as("mov rsi, rax"); as("neg rsi"); as("cmovs rsi, rax");
+	as("cmp rsi, rcx"); as("jl .Lvector_end");
+	fprintf(asm_file, "1:\n");
+    }
+    as("lea eax, [r10+rcx]"); as("mov DWORD PTR [r8], eax");
+    as("sub rsp, 64"); as("lea rdx, [r13+rdx*8]");
+    for(int k = 1; k < 3; k++)
+    {
+	const char* reg = k == 1 ? "rsi" : "rdi";
+	as("bt r11d, %d", 7 + k); as("jnc 1f");
+	as("mov rax, QWORD PTR [r8+%d]", 8 * k);
+	for(int r = 0; r < 4; r++)
+	    as("mov QWORD PTR [rsp+%d], rax", 32 * (k - 1) + 8 * r);
+	as("lea %s, [rsp+%d]", reg, 32 * (k - 1)); as("jmp 2f");
+	fprintf(asm_file, "1:\n");
+	as("movsxd %s, DWORD PTR [r8+%d]", reg, 8 * k); as("add %s, r10", reg); as("lea %s, [r13+%s*8]", reg, reg);
+	fprintf(asm_file, "2:\n");
+    }
+    as("mov eax, DWORD PTR .Lsimd_width[rip]"); as("shl eax, 3"); as("xor r9d, r9d"); as("xor r10d, r10d");
+    as("bt r11d, 8"); as("cmovnc r9d, eax"); as("bt r11d, 9"); as("cmovnc r10d, eax");
+    as("and r11d, 255"); as("cmp DWORD PTR .Lsimd_width[rip], 4"); as("je .Lvector_avx2");
+    static const int ops[] = { O_ADD_I, O_SUB_I, O_MUL_I, O_ADD_D, O_SUB_D, O_MUL_D, O_DIV_D };
+    static const char* names[] = { "paddd", "psubd", "pmuludq", "addpd", "subpd", "mulpd", "divpd" };
+    for(int avx = 0; avx < 2; avx++)
+    {
+	if(avx)
+	    fprintf(asm_file, ".Lvector_avx2:\n");
+	for(int k = 0; k < 7; k++)
+	{
+	    as("cmp r11d, %d", ops[k]); as("jne 2f");
+	    fprintf(asm_file, "1:\n");
+	    if(avx)
+	    {
+		as("vmovupd ymm0, YMMWORD PTR [rsi]"); as("vmovupd ymm1, YMMWORD PTR [rdi]");
+		as("v%s ymm0, ymm0, ymm1", names[k]); as("vmovupd YMMWORD PTR [rdx], ymm0");
+	    }
+	    else
+	    {
+		as("movupd xmm0, XMMWORD PTR [rsi]"); as("movupd xmm1, XMMWORD PTR [rdi]");
+		as("%s xmm0, xmm1", names[k]); as("movupd XMMWORD PTR [rdx], xmm0");
+	    }
+	    as("add rdx, %d", avx ? 32 : 16); as("add rsi, r9"); as("add rdi, r10"); as("sub rcx, %d", avx ? 4 : 2);
+	    as("jne 1b");
+	    if(avx)
+		as("vzeroupper");
+	    as("jmp .Lvector_done");
+	    fprintf(asm_file, "2:\n");
+	}
+    }
+    fprintf(asm_file, ".Lvector_done:\n");
+    as("add rsp, 64");
+    fprintf(asm_file, ".Lvector_end:\n");
+    as("ret");
+
+    fprintf(asm_file, "\n\t.section .rodata\n");
+    fprintf(asm_file, ".Lformat_put_i: .string \"%%d\\n\"\n");
+    fprintf(asm_file, ".Lformat_put_c: .string \"%%c\\n\"\n");
+    fprintf(asm_file, ".Lformat_put_d: .string \"%%lf\\n\"\n");
+    fprintf(asm_file, ".Lformat_get_i: .string \"%%d\"\n");
+    fprintf(asm_file, ".Lformat_get_d: .string \"%%lf\"\n");
+    fprintf(asm_file, ".Lerr_memory: .string \"error in line %%d: invalid memory access at %%d\\n\"\n");
+    fprintf(asm_file, ".Lerr_division: .string \"error in line %%d: division by zero\\n\"\n");
+    fprintf(asm_file, ".Lerr_calls: .string \"error in line %%d: too many nested calls of %%s\\n\"\n");
+    fprintf(asm_file, ".Lerr_stack: .string \"error in line %%d: the stack of the program is full\\n\"\n");
+    fprintf(asm_file, "\t.align 8\n.Lbillion: .double 1e9\n");
+    for(int pc = 0; pc < nr_instr; pc++)
+	if(bytecode[pc].op == O_ENTER)
+	    fprintf(asm_file, ".Lname_%s: .string \"%s\"\n", asm_function(pc), asm_function(pc));
+    //the variables of the compiler which the machine code reads
+    fprintf(asm_file, "\n\t.data\n\t.align 8\nrt_vm_stack: .quad vm_stack\nrt_cap_vm_stack: .long %d\n", ASM_STACK_VALUES);
+    fprintf(asm_file, "\n\t.bss\n\t.align 4\n.Lsimd_width: .zero 4\n"); // 2 with SSE2, 4 with AVX2, 0 before cpuid
+}
+
+//writes the assembly of the bytecode, the functions start at first
+int write_assembly(int first)
+{
+    asm_file = fopen(asm_name, "w");
+    if(asm_file == NULL)
+    {
+	perror("ERROR opening the assembly file\n");
+	return 0;
+    }
+    char* targets = jit_jump_targets(); // the jumps need labels
+
+    fprintf(asm_file, "# %s\n\t.intel_syntax noprefix\n", asm_name);
+    //the globals are the bottom of the stack of the program
+    fprintf(asm_file, "\n\t.bss\n\t.align 16\nvm_stack:\n");
+    for(int n = program; n != 0; n = nodes[n].next)
+    {
+	if(nodes[n].kind != N_VAR)
+	    continue;
+	Symbol* sy = bindings[nodes[n].tk];
+	if(sy->ir_flags & IR_UNUSED) // removed by -O
+	    continue;
+	fprintf(asm_file, "g_%s:\t.zero %d\n", sy->name, 8 * symbol_slots(sy));
+    }
+    fprintf(asm_file, "\t.zero %d\n", 8 * (ASM_STACK_VALUES - nr_globals));
+    fprintf(asm_file, "\t.align 16\n\t.zero %d\nmachine_stack:\n", ASM_MACHINE_STACK);
+
+    fprintf(asm_file, "\n\t.text\n\t.globl main\nmain:\n");
+    as("push rbp"); as("push rbx"); as("push r12"); as("push r13"); as("push r14"); as("push r15");
+    as("mov rbp, rsp");
+    as("lea rsp, machine_stack[rip]");
+    as("lea r13, vm_stack[rip]");
+    as("mov ebx, %d", 8 * nr_globals);
+    as("xor r12d, r12d");
+    as("xor r14d, r14d");
+    ra_entry = -1;
+    nr_jit_values = 0;
+    for(int pc = 0; pc < nr_instr; pc++)
+    {
+	if(targets[pc])
+	    jit_flush();
+	if(pc >= first && bytecode[pc].op == O_ENTER)
+	{
+	    fprintf(asm_file, "\nf_%s:\n", asm_function(pc));
+	    reg_alloc(pc);
+	}
+	if(targets[pc])
+	    fprintf(asm_file, ".L%d:\n", pc);
+	fprintf(asm_file, "\t# %s\n", print_op(bytecode[pc].op));
+	if(bytecode[pc].op == O_HALT)
+	{
+	    jit_flush();
+	    as("jmp .Lhalt");
+	}
+	else
+	    jit_instr(&bytecode[pc]);
+    }
+    jit_flush();
+    ra_entry = -1;
+    fprintf(asm_file, "\n.Lhalt:\n");
+    as("mov rsp, rbp");
+    as("pop r15"); as("pop r14"); as("pop r13"); as("pop r12"); as("pop rbx"); as("pop rbp");
+    as("xor eax, eax");
+    as("ret");
+    asm_runtime();
+    fprintf(asm_file, "\t.section .note.GNU-stack,\"\",@progbits\n");
+    free(targets);
+    int closed = fclose(asm_file) == 0;
+    asm_file = NULL;
+    if(!closed)
+    {
+	perror("ERROR writing the assembly file\n");
+	return 0;
+    }
+    printf("\nThe assembly is in %s\n", asm_name);
+    return 1;
+}
+
+/*						*
+ *	     Static ELF64 Executables		*
+ *						*/
+
+/* with -Elf the program is written as a static x86-64 executable for Linux, in file_to_compile.out,
+   without an assembler or a linker: the bytecode is translated by the templates of -Jit and the
+   predefined functions are a small runtime encoded here, which calls the kernel directly. The
+   executable is loaded at fixed addresses, so every address is resolved by the writer:
+	ELF_TEXT	the headers, the runtime with its strings, the start and the functions
+	ELF_DATA	zeroed memory: the variables of the runtime, the buffers of the input and of
+			the output, the machine stack and the stack of values with the globals at its bottom */
+#define ELF_TEXT 0x400000
+#define ELF_HEADERS 256 // the ELF header and the program headers, the code follows them
+#define ELF_DATA 0x10000000
+#define ELF_BUFFER 4096
+#define E_STACK (ELF_DATA) // the address of the stack of values, the vm_stack of the code
+#define E_CAP (ELF_DATA + 8) // the values of the stack, the cap_vm_stack of the code
+#define E_OUT_LEN (ELF_DATA + 16) // the bytes in the buffer of the output
+#define E_IN_LEN (ELF_DATA + 24) // the bytes in the buffer of the input
+#define E_IN_POS (ELF_DATA + 32) // the next one to read
+#define E_SIMD (ELF_DATA + 40) // the simd_width of the code: 2 with SSE2, 4 with AVX2, 0 before cpuid
+#define E_OUT (ELF_DATA + 64)
+#define E_IN (E_OUT + ELF_BUFFER)
+#define E_MACHINE_STACK (E_IN + ELF_BUFFER + ASM_MACHINE_STACK) // its top, it grows down
+#define E_VALUES E_MACHINE_STACK
+#define E_END (E_VALUES + 8 * ASM_STACK_VALUES)
+
+#define ELF_LABELS 256
+#define ELF_PATCHES 512
+
+char* elf_name=NULL; // the source file name followed by .out
+
+//the labels of the runtime, the jumps to them are patched when all the code is emitted
+int elf_labels[ELF_LABELS];
+int nr_elf_labels=0;
+JitPatch elf_patches[ELF_PATCHES];
+int nr_elf_patches=0;
+
+void elf_symbol(void* host, long long address)
+{
+    elf_symbols = (ElfSymbol*)realloc(elf_symbols, sizeof(ElfSymbol) * (nr_elf_symbols + 1));
+    if(elf_symbols == NULL)
+	err("not enough memory");
+    elf_symbols[nr_elf_symbols].host = host;
+    elf_symbols[nr_elf_symbols].address = address;
+    nr_elf_symbols++;
+}
+
+int elf_has_symbol(void* host)
+{
+    for(int k = 0; k < nr_elf_symbols; k++)
+	if(elf_symbols[k].host == host)
+	    return 1;
+    return 0;
+}
+
+//the strings are in the code, before the runtime
+int elf_string(const char* s)
+{
+    int address = ELF_TEXT + jit_size;
+    do
+	jb(*s);
+    while(*s++);
+    return address;
+}
+
+/* a small encoder for the runtime: reg and rm are registers (RAX..R15 or the number of an xmm),
+   prefix is 0 or the prefix of an SSE instruction and the op code has 1 or 2 bytes */
+void elf_op(int prefix, int w, int op, int reg, int rm)
+{
+    if(prefix)
+	jb(prefix);
+    int rex = 0x40 | (w ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((rm & 8) ? 1 : 0);
+    if(rex != 0x40)
+	jb(rex);
+    if(op > 0xFF)
+	jb(op >> 8);
+    jb(op & 0xFF);
+}
+
+//op reg, rm
+void elf_rr(int prefix, int w, int op, int reg, int rm)
+{
+    elf_op(prefix, w, op, reg, rm);
+    jb(0xC0 | (reg & 7) << 3 | (rm & 7));
+}
+
+//op reg, [base + disp]
+void elf_rm(int prefix, int w, int op, int reg, int base, int disp)
+{
+    elf_op(prefix, w, op, reg, base);
+    jb(0x80 | (reg & 7) << 3 | (base & 7));
+    if((base & 7) == RSP)
+	jb(0x24);
+    jb4(disp);
+}
+
+//op reg, [address] for the variables of the runtime
+void elf_ra(int prefix, int w, int op, int reg, int address)
+{
+    elf_op(prefix, w, op, reg, 0);
+    jb(0x04 | (reg & 7) << 3);
+    jb(0x25);
+    jb4(address);
+}
+
+//the arithmetic of two registers: 0x01 add, 0x09 or, 0x29 sub, 0x31 xor, 0x39 cmp, 0x85 test, 0x89 mov
+void elf_alu(int op, int dst, int src, int w)
+{
+    elf_rr(0, w, op, src, dst);
+}
+
+//with an immediate: 0 add, 1 or, 4 and, 5 sub, 6 xor, 7 cmp
+void elf_alu_imm(int ext, int reg, int v, int w)
+{
+    elf_rr(0, w, 0x81, ext, reg);
+    jb4(v);
+}
+
+//mov reg32, imm32, the upper half of the register is cleared
+void elf_imm(int reg, int v)
+{
+    elf_op(0, 0, 0xB8 + (reg & 7), 0, reg);
+    jb4(v);
+}
+
+//movq xmm, the bits of the double
+void elf_double(int xmm, double d)
+{
+    long long bits;
+    memcpy(&bits, &d, sizeof(bits));
+    elf_op(0, 1, 0xB8 + RCX, 0, RCX); // mov rcx, imm64
+    jb8(bits);
+    elf_rr(0x66, 1, 0x0F6E, xmm, RCX);
+}
+
+void elf_push(int reg)
+{
+    elf_op(0, 0, 0x50 + (reg & 7), 0, reg);
+}
+
+void elf_pop(int reg)
+{
+    elf_op(0, 0, 0x58 + (reg & 7), 0, reg);
+}
+
+int elf_label()
+{
+    if(nr_elf_labels == ELF_LABELS)
+	err("too many labels in the runtime");
+    elf_labels[nr_elf_labels] = -1;
+    return nr_elf_labels++;
+}
+
+void elf_place(int label)
+{
+    elf_labels[label] = jit_size;
+}
+
+//a jump or a call to a label
+void elf_jump(int cc, int label)
+{
+    if(cc == CC_JMP)
+	jb(0xE9);
+    else if(cc == CC_CALL)
+	jb(0xE8);
+    else
+	jit_bytes(2, 0x0F, 0x80 | cc);
+    if(nr_elf_patches == ELF_PATCHES)
+	err("too many jumps in the runtime");
+    elf_patches[nr_elf_patches].at = jit_size;
+    elf_patches[nr_elf_patches].target = label;
+    nr_elf_patches++;
+    jb4(0);
+}
+
+//the routines of the runtime used by the start and by O_HALT
+int elf_exit=0;
+
+/* the runtime: the functions of -Jit with the same arguments, the output is buffered and written
+   at the exit, before reading the input and when the buffer is full, as stdio does for a pipe.
+   The routines keep their state in r8-r10 and on the machine stack, they only call each other */
+void elf_runtime()
+{
+    int s_error = elf_string("error in line ");
+    int s_colon = elf_string(": ");
+    int s_memory = elf_string("invalid memory access at ");
+    int s_division = elf_string("division by zero");
+    int s_calls = elf_string("too many nested calls of ");
+    int s_stack = elf_string("the stack of the program is full");
+    int s_newline = elf_string("\n");
+    for(int pc = 0; pc < nr_instr; pc++) // the names of the functions for the errors of the calls
+	if(bytecode[pc].op == O_CALL && !elf_has_symbol(tokens[bytecode[pc].tk].text))
+	    elf_symbol(tokens[bytecode[pc].tk].text, elf_string(tokens[bytecode[pc].tk].text));
+    while(jit_size % 16)
+	jb(0xCC);
+
+    int flush = elf_label(), out = elf_label(), out_u64 = elf_label(), in = elf_label(), unread = elf_label();
+    int skip = elf_label(), write2 = elf_label(), write2_i = elf_label(), error_line = elf_label(), error_end = elf_label();
+    int put_i = elf_label(), put_c = elf_label(), put_d = elf_label(), get_i = elf_label(), get_c = elf_label();
+    int get_d = elf_label(), clock = elf_label(), enter = elf_label(), copy = elf_label(), load_struct = elf_label();
+    int move = elf_label(), memory_error = elf_label(), division_error = elf_label(), calls_error = elf_label();
+    int stack_error = elf_label(), vector = elf_label();
+    elf_exit = elf_label();
+    int l1, l2, l3, l4, l5, l6;
+
+    //the output buffer to stdout
+    elf_place(flush);
+    elf_ra(0, 1, 0x8B, RDX, E_OUT_LEN); // mov rdx, [out_len]
+    elf_imm(RSI, E_OUT);
+    elf_place(l1 = elf_label());
+    elf_alu(0x85, RDX, RDX, 1);
+    elf_jump(CC_E, l2 = elf_label());
+    elf_imm(RAX, 1); // write
+    elf_imm(RDI, 1);
+    jit_bytes(2, 0x0F, 0x05); // syscall
+    elf_alu(0x85, RAX, RAX, 1);
+    elf_jump(CC_LE, l2);
+    elf_alu(0x01, RSI, RAX, 1);
+    elf_alu(0x29, RDX, RAX, 1);
+    elf_jump(CC_JMP, l1);
+    elf_place(l2);
+    elf_ra(0, 1, 0xC7, 0, E_OUT_LEN); // mov qword [out_len], 0
+    jb4(0);
+    jb(0xC3);
+
+    //the byte in al
+    elf_place(out);
+    elf_ra(0, 1, 0x8B, RCX, E_OUT_LEN);
+    elf_rm(0, 0, 0x88, RAX, RCX, E_OUT); // mov [rcx + out], al
+    elf_rr(0, 1, 0xFF, 0, RCX); // inc rcx
+    elf_ra(0, 1, 0x89, RCX, E_OUT_LEN);
+    elf_alu_imm(7, RCX, ELF_BUFFER, 1);
+    elf_jump(CC_E, flush);
+    jb(0xC3);
+
+    //the unsigned rax in decimal with at least ecx digits
+    elf_place(out_u64);
+    elf_alu_imm(5, RSP, 40, 1);
+    elf_rm(0, 1, 0x8D, R8, RSP, 32); // lea r8, [rsp + 32], the digits are stored down from it
+    elf_alu(0x89, R9, R8, 1);
+    elf_alu(0x89, R10, RCX, 0);
+    elf_place(l1 = elf_label());
+    elf_alu(0x31, RDX, RDX, 0);
+    elf_imm(RCX, 10);
+    elf_rr(0, 1, 0xF7, 6, RCX); // div rcx
+    elf_alu_imm(0, RDX, '0', 0);
+    elf_rr(0, 1, 0xFF, 1, R8); // dec r8
+    elf_rm(0, 0, 0x88, RDX, R8, 0);
+    elf_rr(0, 0, 0xFF, 1, R10);
+    elf_alu(0x85, RAX, RAX, 1);
+    elf_jump(CC_NE, l1);
+    elf_alu(0x85, R10, R10, 0);
+    elf_jump(CC_G, l1);
+    elf_place(l2 = elf_label());
+    elf_alu(0x39, R8, R9, 1);
+    elf_jump(CC_E, l3 = elf_label());
+    elf_rm(0, 0, 0x0FB6, RAX, R8, 0); // movzx eax, byte [r8]
+    elf_jump(CC_CALL, out);
+    elf_rr(0, 1, 0xFF, 0, R8);
+    elf_jump(CC_JMP, l2);
+    elf_place(l3);
+    elf_alu_imm(0, RSP, 40, 1);
+    jb(0xC3);
+
+    //the next byte of stdin in eax, -1 at the end
+    elf_place(in);
+    elf_ra(0, 1, 0x8B, RCX, E_IN_POS);
+    elf_ra(0, 1, 0x3B, RCX, E_IN_LEN); // cmp rcx, [in_len]
+    elf_jump(CC_B, l1 = elf_label());
+    elf_jump(CC_CALL, flush);
+    elf_alu(0x31, RAX, RAX, 0); // read
+    elf_alu(0x31, RDI, RDI, 0);
+    elf_imm(RSI, E_IN);
+    elf_imm(RDX, ELF_BUFFER);
+    jit_bytes(2, 0x0F, 0x05);
+    elf_alu(0x85, RAX, RAX, 1);
+    elf_jump(CC_LE, l2 = elf_label());
+    elf_ra(0, 1, 0x89, RAX, E_IN_LEN);
+    elf_alu(0x31, RCX, RCX, 0);
+    elf_place(l1);
+    elf_rm(0, 0, 0x0FB6, RAX, RCX, E_IN);
+    elf_rr(0, 1, 0xFF, 0, RCX);
+    elf_ra(0, 1, 0x89, RCX, E_IN_POS);
+    jb(0xC3);
+    elf_place(l2);
+    elf_ra(0, 1, 0xC7, 0, E_IN_LEN);
+    jb4(0);
+    elf_ra(0, 1, 0xC7, 0, E_IN_POS);
+    jb4(0);
+    elf_imm(RAX, -1);
+    jb(0xC3);
+
+    //the byte read after a number is read again
+    elf_place(unread);
+    elf_ra(0, 1, 0xFF, 1, E_IN_POS); // dec qword [in_pos]
+    jb(0xC3);
+
+    //the first byte which is not a space as isspace says
+    elf_place(skip);
+    elf_jump(CC_CALL, in);
+    elf_alu_imm(7, RAX, ' ', 0);
+    elf_jump(CC_E, skip);
+    elf_rm(0, 0, 0x8D, RCX, RAX, -'\t'); // lea ecx, [rax - '\t']
+    elf_alu_imm(7, RCX, '\r' - '\t', 0);
+    elf_jump(CC_BE, skip);
+    jb(0xC3);
+
+    //the rdx bytes at rsi to stderr
+    elf_place(write2);
+    elf_imm(RAX, 1);
+    elf_imm(RDI, 2);
+    jit_bytes(2, 0x0F, 0x05);
+    jb(0xC3);
+
+    //the signed rax to stderr
+    elf_place(write2_i);
+    elf_alu_imm(5, RSP, 40, 1);
+    elf_rm(0, 1, 0x8D, R8, RSP, 32);
+    elf_alu(0x89, R9, RAX, 1);
+    elf_alu(0x85, RAX, RAX, 1);
+    elf_jump(CC_NS, l1 = elf_label());
+    elf_rr(0, 1, 0xF7, 3, RAX); // neg rax
+    elf_place(l1);
+    elf_place(l2 = elf_label());
+    elf_alu(0x31, RDX, RDX, 0);
+    elf_imm(RCX, 10);
+    elf_rr(0, 1, 0xF7, 6, RCX);
+    elf_alu_imm(0, RDX, '0', 0);
+    elf_rr(0, 1, 0xFF, 1, R8);
+    elf_rm(0, 0, 0x88, RDX, R8, 0);
+    elf_alu(0x85, RAX, RAX, 1);
+    elf_jump(CC_NE, l2);
+    elf_alu(0x85, R9, R9, 1);
+    elf_jump(CC_NS, l3 = elf_label());
+    elf_rr(0, 1, 0xFF, 1, R8);
+    elf_rm(0, 0, 0xC6, 0, R8, 0); // mov byte [r8], '-'
+    jb('-');
+    elf_place(l3);
+    elf_alu(0x89, RSI, R8, 1);
+    elf_rm(0, 1, 0x8D, RDX, RSP, 32);
+    elf_alu(0x29, RDX, R8, 1);
+    elf_jump(CC_CALL, write2);
+    elf_alu_imm(0, RSP, 40, 1);
+    jb(0xC3);
+
+    //"error in line edi: " to stderr
+    elf_place(error_line);
+    elf_push(RDI);
+    elf_imm(RSI, s_error);
+    elf_imm(RDX, strlen("error in line "));
+    elf_jump(CC_CALL, write2);
+    elf_pop(RAX);
+    elf_rr(0, 1, 0x63, RAX, RAX); // movsxd rax, eax
+    elf_jump(CC_CALL, write2_i);
+    elf_imm(RSI, s_colon);
+    elf_imm(RDX, 2);
+    elf_jump(CC_JMP, write2);
+
+    //the end of the message, the output written so far and the exit with -1 as tkerr does
+    elf_place(error_end);
+    elf_imm(RSI, s_newline);
+    elf_imm(RDX, 1);
+    elf_jump(CC_CALL, write2);
+    elf_imm(RDI, 255);
+    //the exit with the status in edi
+    elf_place(elf_exit);
+    elf_push(RDI);
+    elf_jump(CC_CALL, flush);
+    elf_pop(RDI);
+    elf_imm(RAX, 231); // exit_group
+    jit_bytes(2, 0x0F, 0x05);
+
+    //the errors: edi = the line, esi = the address or the name of the function
+    elf_place(memory_error);
+    elf_push(RSI);
+    elf_jump(CC_CALL, error_line);
+    elf_imm(RSI, s_memory);
+    elf_imm(RDX, strlen("invalid memory access at "));
+    elf_jump(CC_CALL, write2);
+    elf_pop(RAX);
+    elf_rr(0, 1, 0x63, RAX, RAX);
+    elf_jump(CC_CALL, write2_i);
+    elf_jump(CC_JMP, error_end);
+
+    elf_place(division_error);
+    elf_jump(CC_CALL, error_line);
+    elf_imm(RSI, s_division);
+    elf_imm(RDX, strlen("division by zero"));
+    elf_jump(CC_CALL, write2);
+    elf_jump(CC_JMP, error_end);
+
+    elf_place(stack_error);
+    elf_jump(CC_CALL, error_line);
+    elf_imm(RSI, s_stack);
+    elf_imm(RDX, strlen("the stack of the program is full"));
+    elf_jump(CC_CALL, write2);
+    elf_jump(CC_JMP, error_end);
+
+    elf_place(calls_error);
+    elf_push(RSI);
+    elf_jump(CC_CALL, error_line);
+    elf_imm(RSI, s_calls);
+    elf_imm(RDX, strlen("too many nested calls of "));
+    elf_jump(CC_CALL, write2);
+    elf_pop(RSI);
+    elf_alu(0x89, RDX, RSI, 1);
+    elf_place(l1 = elf_label()); // the length of the name
+    elf_rm(0, 0, 0x80, 7, RDX, 0); // cmp byte [rdx], 0
+    jb(0);
+    elf_jump(CC_E, l2 = elf_label());
+    elf_rr(0, 1, 0xFF, 0, RDX);
+    elf_jump(CC_JMP, l1);
+    elf_place(l2);
+    elf_alu(0x29, RDX, RSI, 1);
+    elf_jump(CC_CALL, write2);
+    elf_jump(CC_JMP, error_end);
+
+    //printf("%d\n"), printf("%c\n")
+    elf_place(put_i);
+    elf_rr(0, 1, 0x63, RAX, RDI); // movsxd rax, edi
+    elf_alu(0x85, RAX, RAX, 1);
+    elf_jump(CC_NS, l1 = elf_label());
+    elf_alu(0x89, R9, RAX, 1);
+    elf_imm(RAX, '-');
+    elf_jump(CC_CALL, out);
+    elf_alu(0x89, RAX, R9, 1);
+    elf_rr(0, 1, 0xF7, 3, RAX);
+    elf_place(l1);
+    elf_imm(RCX, 1);
+    elf_jump(CC_CALL, out_u64);
+    elf_imm(RAX, '\n');
+    elf_jump(CC_JMP, out);
+
+    elf_place(put_c);
+    elf_alu(0x89, RAX, RDI, 0);
+    elf_jump(CC_CALL, out);
+    elf_imm(RAX, '\n');
+    elf_jump(CC_JMP, out);
+
+    /* printf("%lf\n"): below 2^63 the integer part is exact and the fraction, exact too, is rounded
+       to 6 digits; above it the value is an integer, written exactly as a big number */
+    elf_place(put_d);
+    elf_rr(0x66, 1, 0x0F7E, 0, RAX); // movq rax, xmm0
+    elf_alu(0x89, R9, RAX, 1);
+    elf_alu(0x85, RAX, RAX, 1);
+    elf_jump(CC_NS, l1 = elf_label());
+    elf_imm(RAX, '-');
+    elf_jump(CC_CALL, out);
+    elf_place(l1);
+    elf_alu(0x89, RAX, R9, 1);
+    elf_rr(0, 1, 0xC1, 4, RAX); // shl rax, 1; shr rax, 1: the absolute value
+    jb(1);
+    elf_rr(0, 1, 0xC1, 5, RAX);
+    jb(1);
+    elf_op(0, 1, 0xB8 + RCX, 0, RCX); // mov rcx, the bits of infinity
+    jb8(0x7FF0000000000000LL);
+    elf_alu(0x39, RAX, RCX, 1);
+    elf_jump(CC_B, l2 = elf_label());
+    elf_jump(CC_E, l3 = elf_label());
+    for(const char* s = "nan"; *s; s++)
+    {
+	elf_imm(RAX, *s);
+	elf_jump(CC_CALL, out);
+    }
+    elf_jump(CC_JMP, l4 = elf_label());
+    elf_place(l3);
+    for(const char* s = "inf"; *s; s++)
+    {
+	elf_imm(RAX, *s);
+	elf_jump(CC_CALL, out);
+    }
+    elf_jump(CC_JMP, l4);
+    elf_place(l2);
+    elf_rr(0x66, 1, 0x0F6E, 0, RAX); // movq xmm0, rax
+    elf_double(1, 9223372036854775808.0);
+    elf_rr(0x66, 0, 0x0F2E, 0, 1); // ucomisd xmm0, xmm1
+    elf_jump(CC_AE, l3 = elf_label());
+    elf_rr(0xF2, 1, 0x0F2C, RAX, 0); // cvttsd2si rax, xmm0
+    elf_rr(0xF2, 1, 0x0F2A, 1, RAX); // cvtsi2sd xmm1, rax
+    elf_rr(0xF2, 0, 0x0F5C, 0, 1); // subsd xmm0, xmm1
+    elf_double(1, 1e6);
+    elf_rr(0xF2, 0, 0x0F59, 0, 1); // mulsd xmm0, xmm1
+    elf_rr(0xF2, 1, 0x0F2D, RDX, 0); // cvtsd2si rdx, xmm0, rounded to the nearest
+    elf_alu_imm(7, RDX, 1000000, 1);
+    elf_jump(CC_NE, l5 = elf_label());
+    elf_rr(0, 1, 0xFF, 0, RAX);
+    elf_alu(0x31, RDX, RDX, 0);
+    elf_place(l5);
+    elf_push(RDX);
+    elf_imm(RCX, 1);
+    elf_jump(CC_CALL, out_u64);
+    elf_place(l6 = elf_label()); // the fraction is on the machine stack
+    elf_imm(RAX, '.');
+    elf_jump(CC_CALL, out);
+    elf_pop(RAX);
+    elf_imm(RCX, 6);
+    elf_jump(CC_CALL, out_u64);
+    elf_place(l4);
+    elf_imm(RAX, '\n');
+    elf_jump(CC_JMP, out);
+    elf_place(l3); // the mantissa times 2^exponent in limbs of 9 digits on the machine stack
+    elf_push(R15);
+    elf_alu_imm(5, RSP, 320, 1);
+    elf_alu(0x89, R8, RAX, 1);
+    elf_rr(0, 1, 0xC1, 5, R8); // shr r8, 52
+    jb(52);
+    elf_alu_imm(5, R8, 1075, 0);
+    elf_op(0, 1, 0xB8 + RCX, 0, RCX);
+    jb8((1LL << 52) - 1);
+    elf_alu(0x21, RAX, RCX, 1); // and rax, rcx
+    elf_rr(0, 1, 0x0FBA, 5, RAX); // bts rax, 52
+    jb(52);
+    elf_alu(0x31, RDX, RDX, 0);
+    elf_imm(RCX, 1000000000);
+    elf_rr(0, 1, 0xF7, 6, RCX);
+    elf_rm(0, 1, 0x89, RDX, RSP, 0);
+    elf_rm(0, 1, 0x89, RAX, RSP, 8);
+    elf_imm(R10, 2);
+    elf_place(l5 = elf_label()); // doubled exponent times
+    elf_alu(0x89, RSI, RSP, 1);
+    elf_alu(0x89, RCX, R10, 0);
+    elf_alu(0x31, RDX, RDX, 0);
+    elf_place(l1 = elf_label());
+    elf_rm(0, 1, 0x8B, RAX, RSI, 0);
+    elf_alu(0x01, RAX, RAX, 1);
+    elf_alu(0x01, RAX, RDX, 1);
+    elf_alu(0x31, RDX, RDX, 0);
+    elf_alu_imm(7, RAX, 1000000000, 1);
+    elf_jump(CC_B, l2 = elf_label());
+    elf_alu_imm(5, RAX, 1000000000, 1);
+    elf_imm(RDX, 1);
+    elf_place(l2);
+    elf_rm(0, 1, 0x89, RAX, RSI, 0);
+    elf_alu_imm(0, RSI, 8, 1);
+    elf_rr(0, 0, 0xFF, 1, RCX);
+    elf_jump(CC_NE, l1);
+    elf_alu(0x85, RDX, RDX, 0);
+    elf_jump(CC_E, l2 = elf_label());
+    elf_rm(0, 1, 0xC7, 0, RSI, 0); // mov qword [rsi], 1
+    jb4(1);
+    elf_rr(0, 0, 0xFF, 0, R10);
+    elf_place(l2);
+    elf_rr(0, 0, 0xFF, 1, R8);
+    elf_jump(CC_NE, l5);
+    elf_alu(0x89, R15, R10, 1); // r15 = the highest limb
+    elf_rr(0, 1, 0xC1, 4, R15);
+    jb(3);
+    elf_alu(0x01, R15, RSP, 1);
+    elf_alu_imm(5, R15, 8, 1);
+    elf_rm(0, 1, 0x8B, RAX, R15, 0);
+    elf_imm(RCX, 1);
+    elf_jump(CC_CALL, out_u64);
+    elf_place(l1 = elf_label());
+    elf_alu(0x39, R15, RSP, 1);
+    elf_jump(CC_E, l2 = elf_label());
+    elf_alu_imm(5, R15, 8, 1);
+    elf_rm(0, 1, 0x8B, RAX, R15, 0);
+    elf_imm(RCX, 9);
+    elf_jump(CC_CALL, out_u64);
+    elf_jump(CC_JMP, l1);
+    elf_place(l2);
+    elf_alu_imm(0, RSP, 320, 1);
+    elf_pop(R15);
+    jit_bytes(2, 0x6A, 0x00); // push 0, the fraction
+    elf_jump(CC_JMP, l6);
+
+    //scanf("%d"), 0 when there is no number
+    elf_place(get_i);
+    elf_jump(CC_CALL, skip);
+    elf_alu(0x31, R8, R8, 0); // the value
+    elf_alu(0x31, R9, R9, 0); // the sign
+    elf_alu(0x31, R10, R10, 0); // the digits
+    elf_alu_imm(7, RAX, '-', 0);
+    elf_jump(CC_NE, l1 = elf_label());
+    elf_imm(R9, 1);
+    elf_jump(CC_CALL, in);
+    elf_jump(CC_JMP, l2 = elf_label());
+    elf_place(l1);
+    elf_alu_imm(7, RAX, '+', 0);
+    elf_jump(CC_NE, l2);
+    elf_jump(CC_CALL, in);
+    elf_place(l2);
+    elf_rm(0, 0, 0x8D, RCX, RAX, -'0');
+    elf_alu_imm(7, RCX, 9, 0);
+    elf_jump(CC_A, l3 = elf_label());
+    elf_rr(0, 0, 0x6B, R8, R8); // imul r8d, r8d, 10
+    jb(10);
+    elf_alu(0x01, R8, RCX, 0);
+    elf_rr(0, 0, 0xFF, 0, R10);
+    elf_jump(CC_CALL, in);
+    elf_jump(CC_JMP, l2);
+    elf_place(l3);
+    elf_alu_imm(7, RAX, -1, 0);
+    elf_jump(CC_E, l4 = elf_label());
+    elf_jump(CC_CALL, unread);
+    elf_place(l4);
+    elf_alu(0x31, RAX, RAX, 0);
+    elf_alu(0x85, R10, R10, 0);
+    elf_jump(CC_E, l5 = elf_label());
+    elf_alu(0x89, RAX, R8, 0);
+    elf_alu(0x85, R9, R9, 0);
+    elf_jump(CC_E, l5);
+    elf_rr(0, 0, 0xF7, 3, RAX);
+    elf_place(l5);
+    jb(0xC3);
+
+    //getchar(), 0 at the end
+    elf_place(get_c);
+    elf_jump(CC_CALL, in);
+    elf_alu_imm(7, RAX, -1, 0);
+    elf_jump(CC_NE, l1 = elf_label());
+    elf_alu(0x31, RAX, RAX, 0);
+    elf_place(l1);
+    jb(0xC3);
+
+    /* scanf("%lf"): the first 17 digits are the integer in r8, r10 is the exponent of 10 and r9 has
+       the sign (1), the digits seen (2) and the sign of the exponent (4); the result is the integer
+       multiplied or divided by powers of 10 up to 1e22, which are exact. inf, infinity and nan are
+       read in any case as strtod reads them, but not nan(chars) nor the hexadecimal numbers; a number
+       is read exactly when its first 17 digits are all its digits and its exponent of 10 is at most
+       22 away from them, otherwise it may differ from the one of strtod in the last bit, mostly near
+       DBL_MAX and among the subnormal numbers */
+    int infinity = elf_label(), not_number = elf_label(), no_number = elf_label(), sign = elf_label();
+    elf_place(get_d);
+    elf_jump(CC_CALL, skip);
+    elf_alu(0x31, R8, R8, 0);
+    elf_alu(0x31, R9, R9, 0);
+    elf_alu(0x31, R10, R10, 0);
+    elf_alu_imm(7, RAX, '-', 0);
+    elf_jump(CC_NE, l1 = elf_label());
+    elf_imm(R9, 1);
+    elf_jump(CC_CALL, in);
+    elf_jump(CC_JMP, l2 = elf_label());
+    elf_place(l1);
+    elf_alu_imm(7, RAX, '+', 0);
+    elf_jump(CC_NE, l2);
+    elf_jump(CC_CALL, in);
+    elf_place(l2);
+    elf_alu(0x89, RCX, RAX, 0);
+    elf_alu_imm(1, RCX, 0x20, 0);
+    elf_alu_imm(7, RCX, 'i', 0);
+    elf_jump(CC_E, infinity);
+    elf_alu_imm(7, RCX, 'n', 0);
+    elf_jump(CC_E, not_number);
+    l2 = elf_label();
+    for(int fraction = 0; fraction < 2; fraction++) // the digits before and after the point
+    {
+	elf_place(l2);
+	elf_rm(0, 0, 0x8D, RCX, RAX, -'0');
+	elf_alu_imm(7, RCX, 9, 0);
+	elf_jump(CC_A, l3 = elf_label());
+	elf_alu_imm(1, R9, 2, 0);
+	elf_op(0, 1, 0xB8 + RDX, 0, RDX); // mov rdx, 1e17
+	jb8(100000000000000000LL);
+	elf_alu(0x39, R8, RDX, 1);
+	elf_jump(CC_AE, l4 = elf_label());
+	elf_rr(0, 1, 0x6B, R8, R8); // imul r8, r8, 10
+	jb(10);
+	elf_alu(0x01, R8, RCX, 1);
+	if(fraction)
+	    elf_rr(0, 0, 0xFF, 1, R10);
+	elf_jump(CC_JMP, l5 = elf_label());
+	elf_place(l4);
+	if(!fraction)
+	    elf_rr(0, 0, 0xFF, 0, R10);
+	elf_place(l5);
+	elf_jump(CC_CALL, in);
+	elf_jump(CC_JMP, l2);
+	elf_place(l3);
+	if(!fraction)
+	{
+	    elf_alu_imm(7, RAX, '.', 0);
+	    elf_jump(CC_NE, l6 = elf_label());
+	    elf_jump(CC_CALL, in);
+	    l2 = elf_label();
+	}
+    }
+    elf_place(l6);
+    elf_alu(0x89, RCX, RAX, 0); // the exponent after e or E, when there are digits
+    elf_alu_imm(1, RCX, 0x20, 0);
+    elf_alu_imm(7, RCX, 'e', 0);
+    elf_jump(CC_NE, l1 = elf_label());
+    elf_rr(0, 0, 0xF7, 0, R9); // test r9d, 2
+    jb4(2);
+    elf_jump(CC_E, l1);
+    elf_jump(CC_CALL, in);
+    jit_bytes(2, 0x6A, 0x00); // push 0, the exponent
+    elf_alu_imm(7, RAX, '-', 0);
+    elf_jump(CC_NE, l2 = elf_label());
+    elf_alu_imm(1, R9, 4, 0);
+    elf_jump(CC_CALL, in);
+    elf_jump(CC_JMP, l3 = elf_label());
+    elf_place(l2);
+    elf_alu_imm(7, RAX, '+', 0);
+    elf_jump(CC_NE, l3);
+    elf_jump(CC_CALL, in);
+    elf_place(l3);
+    elf_rm(0, 0, 0x8D, RCX, RAX, -'0');
+    elf_alu_imm(7, RCX, 9, 0);
+    elf_jump(CC_A, l4 = elf_label());
+    elf_rm(0, 1, 0x8B, RDX, RSP, 0);
+    elf_rr(0, 0, 0x6B, RDX, RDX);
+    jb(10);
+    elf_alu(0x01, RDX, RCX, 0);
+    elf_alu_imm(7, RDX, 9999, 0);
+    elf_jump(CC_LE, l5 = elf_label());
+    elf_imm(RDX, 9999);
+    elf_place(l5);
+    elf_rm(0, 1, 0x89, RDX, RSP, 0);
+    elf_jump(CC_CALL, in);
+    elf_jump(CC_JMP, l3);
+    elf_place(l4);
+    elf_pop(RDX);
+    elf_rr(0, 0, 0xF7, 0, R9);
+    jb4(4);
+    elf_jump(CC_E, l5 = elf_label());
+    elf_rr(0, 0, 0xF7, 3, RDX);
+    elf_place(l5);
+    elf_alu(0x01, R10, RDX, 0);
+    elf_place(l1);
+    elf_alu_imm(7, RAX, -1, 0);
+    elf_jump(CC_E, l2 = elf_label());
+    elf_jump(CC_CALL, unread);
+    elf_place(l2);
+    elf_rr(0x66, 0, 0x0F57, 0, 0); // xorpd xmm0, xmm0
+    elf_rr(0, 0, 0xF7, 0, R9);
+    jb4(2);
+    elf_jump(CC_E, l1 = elf_label());
+    elf_rr(0xF2, 1, 0x0F2A, 0, R8); // cvtsi2sd xmm0, r8
+    elf_double(1, 10.0);
+    elf_alu(0x85, R10, R10, 0);
+    elf_jump(CC_E, l3 = elf_label());
+    elf_jump(CC_G, l4 = elf_label());
+    elf_rr(0, 0, 0xF7, 3, R10);
+    for(int up = 0; up < 2; up++) // divided, then multiplied
+    {
+	if(up)
+	    elf_place(l4);
+	elf_place(l5 = elf_label()); // xmm2 = 10^r11 with r11 up to 22
+	elf_double(2, 1.0);
+	elf_alu(0x31, R11, R11, 0);
+	elf_place(l6 = elf_label());
+	elf_rr(0xF2, 0, 0x0F59, 2, 1); // mulsd xmm2, xmm1
+	elf_rr(0, 0, 0xFF, 0, R11);
+	elf_rr(0, 0, 0xFF, 1, R10);
+	elf_jump(CC_E, l2 = elf_label());
+	elf_alu_imm(7, R11, 22, 0);
+	elf_jump(CC_NE, l6);
+	elf_rr(0xF2, 0, up ? 0x0F59 : 0x0F5E, 0, 2);
+	elf_jump(CC_JMP, l5);
+	elf_place(l2);
+	elf_rr(0xF2, 0, up ? 0x0F59 : 0x0F5E, 0, 2);
+	if(!up)
+	    elf_jump(CC_JMP, l3);
+    }
+    elf_place(l3);
+    elf_place(sign);
+    elf_rr(0, 0, 0xF7, 0, R9);
+    jb4(1);
+    elf_jump(CC_E, l1);
+    elf_rr(0x66, 1, 0x0F7E, 0, RAX);
+    elf_rr(0, 1, 0x0FBA, 7, RAX); // btc rax, 63
+    jb(63);
+    elf_rr(0x66, 1, 0x0F6E, 0, RAX);
+    elf_place(l1);
+    jb(0xC3);
+    //the letters of inf, infinity and nan after the first one, in any case
+    elf_place(infinity);
+    for(const char* s = "nf?nity"; *s; s++)
+    {
+	elf_jump(CC_CALL, in);
+	elf_alu(0x89, RCX, RAX, 0);
+	elf_alu_imm(1, RCX, 0x20, 0);
+	if(*s == '?') // inf alone, the byte after it is read again
+	{
+	    elf_alu_imm(7, RCX, 'i', 0);
+	    elf_jump(CC_NE, l1 = elf_label());
+	    continue;
+	}
+	elf_alu_imm(7, RCX, *s, 0);
+	elf_jump(CC_NE, no_number);
+    }
+    elf_imm(RAX, -1);
+    elf_place(l1);
+    elf_alu_imm(7, RAX, -1, 0);
+    elf_jump(CC_E, l2 = elf_label());
+    elf_jump(CC_CALL, unread);
+    elf_place(l2);
+    elf_double(0, INFINITY);
+    elf_jump(CC_JMP, sign);
+    elf_place(not_number);
+    for(const char* s = "an"; *s; s++)
+    {
+	elf_jump(CC_CALL, in);
+	elf_alu(0x89, RCX, RAX, 0);
+	elf_alu_imm(1, RCX, 0x20, 0);
+	elf_alu_imm(7, RCX, *s, 0);
+	elf_jump(CC_NE, no_number);
+    }
+    elf_double(0, NAN);
+    elf_jump(CC_JMP, sign);
+    //a letter which differs is read, as by the scanf of glibc: no number, 0 as when scanf fails
+    elf_place(no_number);
+    elf_rr(0x66, 0, 0x0F57, 0, 0); // xorpd xmm0, xmm0
+    jb(0xC3);
+
+    //the seconds of CLOCK_MONOTONIC
+    elf_place(clock);
+    elf_alu_imm(5, RSP, 24, 1);
+    elf_imm(RAX, 228); // clock_gettime
+    elf_imm(RDI, CLOCK_MONOTONIC);
+    elf_alu(0x89, RSI, RSP, 1);
+    jit_bytes(2, 0x0F, 0x05);
+    elf_rm(0xF2, 1, 0x0F2A, 0, RSP, 0); // cvtsi2sd xmm0, [rsp]
+    elf_rm(0xF2, 1, 0x0F2A, 1, RSP, 8);
+    elf_double(2, 1e9);
+    elf_rr(0xF2, 0, 0x0F5E, 1, 2);
+    elf_rr(0xF2, 0, 0x0F58, 0, 1); // addsd xmm0, xmm1
+    elf_alu_imm(0, RSP, 24, 1);
+    jb(0xC3);
+
+    //jit_enter_frame: the stack is not moved, it has a fixed size
+    elf_place(enter);
+    elf_alu(0x89, RAX, RDI, 1);
+    elf_rr(0, 1, 0xC1, 5, RAX); // shr rax, 3
+    jb(3);
+    elf_alu(0x29, RAX, RDX, 0); // the height of the frame
+    elf_alu(0x89, R8, RAX, 0);
+    elf_alu(0x01, R8, RSI, 0);
+    elf_alu_imm(0, R8, max_stack, 0);
+    elf_ra(0, 0, 0x3B, R8, E_CAP);
+    elf_jump(CC_BE, l1 = elf_label());
+    elf_alu(0x89, RDI, RCX, 0);
+    elf_jump(CC_JMP, stack_error);
+    elf_place(l1);
+    elf_alu(0x89, R9, RAX, 0);
+    elf_alu(0x01, R9, RDX, 0);
+    elf_rr(0, 1, 0xC1, 4, R9); // shl r9, 3
+    jb(3);
+    elf_alu(0x89, RDI, R13, 1);
+    elf_alu(0x01, RDI, R9, 1);
+    elf_alu(0x89, RCX, RSI, 0);
+    elf_alu(0x29, RCX, RDX, 0);
+    elf_alu(0x89, R8, RAX, 0);
+    elf_alu(0x31, RAX, RAX, 0);
+    jit_bytes(3, 0xF3, 0x48, 0xAB); // rep stosq
+    elf_alu(0x89, RAX, R8, 0);
+    elf_rr(0, 1, 0xC1, 4, RAX);
+    jb(3);
+    jb(0xC3);
+
+    //memmove of rcx values from rsi to rdi
+    elf_place(move);
+    elf_alu(0x39, RDI, RSI, 1);
+    elf_jump(CC_BE, l1 = elf_label());
+    elf_alu(0x89, RAX, RCX, 1);
+    elf_rr(0, 1, 0xC1, 4, RAX);
+    jb(3);
+    elf_alu_imm(5, RAX, 8, 1);
+    elf_alu(0x01, RDI, RAX, 1);
+    elf_alu(0x01, RSI, RAX, 1);
+    jb(0xFD); // std
+    jit_bytes(3, 0xF3, 0x48, 0xA5); // rep movsq
+    jb(0xFC); // cld
+    jb(0xC3);
+    elf_place(l1);
+    jit_bytes(3, 0xF3, 0x48, 0xA5);
+    jb(0xC3);
+
+    //jit_copy: the destination in sp[0] and the source in sp[1]
+    elf_place(copy);
+    elf_alu(0x89, R8, R13, 1);
+    elf_alu(0x01, R8, RDI, 1);
+    elf_rm(0, 0, 0x8B, RAX, R8, 0);
+    elf_rm(0, 0, 0x8B, R9, R8, 8);
+    elf_alu(0x89, R10, RDI, 1);
+    elf_rr(0, 1, 0xC1, 5, R10);
+    jb(3);
+    elf_alu(0x29, R10, RSI, 0); // the values below sp - n
+    elf_alu(0x39, RAX, R10, 0);
+    elf_jump(CC_A, l1 = elf_label());
+    elf_alu(0x39, R9, R10, 0);
+    elf_jump(CC_A, l1);
+    elf_alu(0x89, RCX, RSI, 0);
+    elf_rr(0, 1, 0xC1, 4, RAX);
+    jb(3);
+    elf_rr(0, 1, 0xC1, 4, R9);
+    jb(3);
+    elf_alu(0x89, RDI, R13, 1);
+    elf_alu(0x01, RDI, RAX, 1);
+    elf_alu(0x89, RSI, R13, 1);
+    elf_alu(0x01, RSI, R9, 1);
+    elf_jump(CC_JMP, move);
+    elf_place(l1);
+    elf_alu(0x89, RDI, RDX, 0);
+    elf_alu(0x89, RSI, RAX, 0);
+    elf_jump(CC_JMP, memory_error);
+
+    //jit_load_struct: the values at the address in sp[-1] replace it
+    elf_place(load_struct);
+    elf_alu(0x89, R8, R13, 1);
+    elf_alu(0x01, R8, RDI, 1);
+    elf_rm(0, 0, 0x8B, RAX, R8, -8);
+    elf_alu(0x89, R10, RDI, 1);
+    elf_rr(0, 1, 0xC1, 5, R10);
+    jb(3);
+    elf_alu(0x29, R10, RSI, 0);
+    elf_alu(0x39, RAX, R10, 0);
+    elf_jump(CC_A, l1 = elf_label());
+    elf_alu(0x89, RCX, RSI, 0);
+    elf_rm(0, 1, 0x8D, RDI, R8, -8);
+    elf_rr(0, 1, 0xC1, 4, RAX);
+    jb(3);
+    elf_alu(0x89, RSI, R13, 1);
+    elf_alu(0x01, RSI, RAX, 1);
+    elf_jump(CC_JMP, move);
+    elf_place(l1);
+    elf_alu(0x89, RDI, RDX, 0);
+    elf_alu(0x89, RSI, RAX, 0);
+    elf_jump(CC_JMP, memory_error);
+
+    /* jit_vector: the AVX2 of the processor is asked once with cpuid, both the processor and the
+       system must have it. r8 = the operands, r9 = the values below them, r10 = the start, r11 = the op */
+    elf_place(vector);
+    elf_ra(0, 0, 0x8B, RAX, E_SIMD);
+    elf_alu(0x85, RAX, RAX, 0);
+    elf_jump(CC_NE, l1 = elf_label());
+    elf_push(RBX);
+    elf_alu(0x31, RAX, RAX, 0);
+    jit_bytes(2, 0x0F, 0xA2); // cpuid, the highest leaf
+    elf_alu(0x89, R8, RAX, 0);
+    elf_imm(RAX, 1);
+    jit_bytes(2, 0x0F, 0xA2);
+    elf_alu(0x89, R9, RCX, 0);
+    elf_alu(0x31, R10, R10, 0);
+    elf_alu_imm(7, R8, 7, 0);
+    elf_jump(CC_B, l2 = elf_label());
+    elf_imm(RAX, 7);
+    elf_alu(0x31, RCX, RCX, 0);
+    jit_bytes(2, 0x0F, 0xA2);
+    elf_alu(0x89, R10, RBX, 0);
+    elf_place(l2);
+    elf_pop(RBX);
+    elf_imm(R8, 2);
+    elf_alu_imm(4, R9, 0x18000000, 0); // osxsave and avx
+    elf_alu_imm(7, R9, 0x18000000, 0);
+    elf_jump(CC_NE, l2 = elf_label());
+    elf_rr(0, 0, 0xF7, 0, R10); // test r10d, avx2
+    jb4(0x20);
+    elf_jump(CC_E, l2);
+    elf_alu(0x31, RCX, RCX, 0);
+    jit_bytes(3, 0x0F, 0x01, 0xD0); // xgetbv, the registers saved by the system
+    elf_alu_imm(4, RAX, 6, 0);
+    elf_alu_imm(7, RAX, 6, 0);
+    elf_jump(CC_NE, l2);
+    elf_imm(R8, 4);
+    elf_place(l2);
+    elf_alu(0x89, RAX, R8, 0);
+    elf_ra(0, 0, 0x89, RAX, E_SIMD);
+    elf_place(l1);
+    elf_alu(0x89, R11, RSI, 0);
+    elf_alu(0x89, R8, R13, 1);
+    elf_alu(0x01, R8, RDI, 1);
+    elf_alu_imm(5, R8, 8, 1);
+    elf_alu(0x89, R9, RDI, 1);
+    elf_rr(0, 1, 0xC1, 5, R9); // shr r9, 3
+    jb(3);
+    elf_rr(0, 1, 0xFF, 1, R9);
+    elf_rm(0, 1, 0x63, R10, R8, 24); // movsxd r10, the start
+    elf_rm(0, 1, 0x63, RCX, R8, 32);
+    elf_alu(0x29, RCX, R10, 1);
+    elf_rm(0, 1, 0x63, RDX, R8, 0);
+    elf_rm(0, 0, 0x89, R10, R8, 0); // the result when nothing is computed
+    elf_alu(0x89, RSI, RAX, 1);
+    elf_rr(0, 1, 0xF7, 3, RSI); // neg rsi
+    elf_alu(0x21, RCX, RSI, 1); // rcx = the elements computed, a multiple of the width
+    elf_jump(CC_LE, l3 = elf_label());
+    elf_alu(0x01, RDX, R10, 1);
+    elf_jump(CC_S, l3);
+    elf_alu(0x89, RAX, RDX, 1);
+    elf_alu(0x01, RAX, RCX, 1);
+    elf_alu(0x39, RAX, R9, 1);
+    elf_jump(CC_G, l3);
+    for(int k = 1; k < 3; k++) // the vectors a and b
+    {
+	elf_rr(0, 0, 0x0FBA, 4, R11); // bt r11d, scalar
+	jb(7 + k);
+	elf_jump(CC_B, l1 = elf_label());
+	elf_rm(0, 1, 0x63, RAX, R8, 8 * k);
+	elf_alu(0x01, RAX, R10, 1);
+	elf_jump(CC_S, l3);
+	elf_alu(0x89, RSI, RAX, 1);
+	elf_alu(0x01, RSI, RCX, 1);
+	elf_alu(0x39, RSI, R9, 1);
+	elf_jump(CC_G, l3);
+	elf_alu(0x29, RAX, RDX, 1);
+	elf_jump(CC_E, l1);
+	elf_alu(0x89, RSI, RAX, 1);
+	elf_rr(0, 1, 0xF7, 3, RSI);
+	elf_rr(0, 1, 0x0F48, RSI, RAX); // cmovs rsi, rax: the distance to d
+	elf_alu(0x39, RSI, RCX, 1);
+	elf_jump(CC_L, l3);
+	elf_place(l1);
+    }
+    elf_alu(0x89, RAX, R10, 0); // the index reached
+    elf_alu(0x01, RAX, RCX, 0);
+    elf_rm(0, 0, 0x89, RAX, R8, 0);
+    elf_alu_imm(5, RSP, 64, 1);
+    elf_rr(0, 1, 0xC1, 4, RDX);
+    jb(3);
+    elf_alu(0x01, RDX, R13, 1);
+    for(int k = 1; k < 3; k++) // rsi = a and rdi = b, a value is repeated 4 times on the machine stack
+    {
+	int reg = k == 1 ? RSI : RDI;
+	elf_rr(0, 0, 0x0FBA, 4, R11);
+	jb(7 + k);
+	elf_jump(CC_AE, l1 = elf_label());
+	elf_rm(0, 1, 0x8B, RAX, R8, 8 * k);
+	for(int r = 0; r < 4; r++)
+	    elf_rm(0, 1, 0x89, RAX, RSP, 32 * (k - 1) + 8 * r);
+	elf_rm(0, 1, 0x8D, reg, RSP, 32 * (k - 1));
+	elf_jump(CC_JMP, l2 = elf_label());
+	elf_place(l1);
+	elf_rm(0, 1, 0x63, reg, R8, 8 * k);
+	elf_alu(0x01, reg, R10, 1);
+	elf_rr(0, 1, 0xC1, 4, reg);
+	jb(3);
+	elf_alu(0x01, reg, R13, 1);
+	elf_place(l2);
+    }
+    elf_ra(0, 0, 0x8B, RAX, E_SIMD); // r9 and r10 = the bytes a and b grow by
+    elf_rr(0, 0, 0xC1, 4, RAX);
+    jb(3);
+    elf_alu(0x31, R9, R9, 0);
+    elf_alu(0x31, R10, R10, 0);
+    for(int k = 1; k < 3; k++)
+    {
+	elf_rr(0, 0, 0x0FBA, 4, R11);
+	jb(7 + k);
+	elf_rr(0, 0, 0x0F43, k == 1 ? R9 : R10, RAX); // cmovae
+    }
+    elf_alu_imm(4, R11, 0xFF, 0);
+    elf_ra(0, 0, 0x83, 7, E_SIMD); // cmp dword [simd], 4
+    jb(4);
+    elf_jump(CC_E, l4 = elf_label());
+    static const int ops[][2] = { {O_ADD_I, 0xFE}, {O_SUB_I, 0xFA}, {O_MUL_I, 0xF4}, // paddd, psubd, pmuludq
+	{O_ADD_D, 0x58}, {O_SUB_D, 0x5C}, {O_MUL_D, 0x59}, {O_DIV_D, 0x5E} };
+    int done = elf_label();
+    for(int avx = 0; avx < 2; avx++)
+    {
+	if(avx)
+	    elf_place(l4);
+	for(int k = 0; k < 7; k++)
+	{
+	    elf_alu_imm(7, R11, ops[k][0], 0);
+	    elf_jump(CC_NE, l1 = elf_label());
+	    elf_place(l2 = elf_label());
+	    if(avx) // vmovupd ymm0, [rsi]; vmovupd ymm1, [rdi]; vop ymm0, ymm0, ymm1; vmovupd [rdx], ymm0
+		jit_bytes(16, 0xC5, 0xFD, 0x10, 0x06, 0xC5, 0xFD, 0x10, 0x0F, 0xC5, 0xFD, ops[k][1], 0xC1, 0xC5, 0xFD, 0x11, 0x02);
+	    else // movupd xmm0, [rsi]; movupd xmm1, [rdi]; op xmm0, xmm1; movupd [rdx], xmm0
+		jit_bytes(16, 0x66, 0x0F, 0x10, 0x06, 0x66, 0x0F, 0x10, 0x0F, 0x66, 0x0F, ops[k][1], 0xC1, 0x66, 0x0F, 0x11, 0x02);
+	    elf_alu_imm(0, RDX, avx ? 32 : 16, 1);
+	    elf_alu(0x01, RSI, R9, 1);
+	    elf_alu(0x01, RDI, R10, 1);
+	    elf_alu_imm(5, RCX, avx ? 4 : 2, 1);
+	    elf_jump(CC_NE, l2);
+	    if(avx)
+		jit_bytes(3, 0xC5, 0xF8, 0x77); // vzeroupper
+	    elf_jump(CC_JMP, done);
+	    elf_place(l1);
+	}
+    }
+    elf_place(done);
+    elf_alu_imm(0, RSP, 64, 1);
+    elf_place(l3);
+    jb(0xC3);
+
+    //the functions of the compiler called by the machine code and their variables
+    void* hosts[] = {jit_enter_frame, jit_copy, jit_load_struct, jit_memory_error, jit_division_error,
+		     jit_calls_error, jit_put_i, jit_put_d, jit_put_c, jit_get_i, jit_get_d, jit_get_c, seconds, jit_vector};
+    int routines[] = {enter, copy, load_struct, memory_error, division_error,
+		      calls_error, put_i, put_d, put_c, get_i, get_d, get_c, clock, vector};
+    for(int k = 0; k < (int)(sizeof(routines) / sizeof(int)); k++)
+	elf_symbol(hosts[k], ELF_TEXT + elf_labels[routines[k]]);
+    elf_symbol(&vm_stack, E_STACK);
+    elf_symbol(&cap_vm_stack, E_CAP);
+}
+
+//writes the executable of the bytecode, the functions start at first
+int write_elf(int first)
+{
+    double start = seconds();
+    jit_cap = JIT_INSTR_BYTES * nr_instr + (1 << 16);
+    jit_buffer = (unsigned char*)calloc(jit_cap, 1);
+    jit_offset = (int*)malloc(sizeof(int) * nr_instr);
+    jit_targets = jit_jump_targets();
+    if(jit_buffer == NULL || jit_offset == NULL)
+	err("not enough memory");
+    ra_entry = -1;
+    elf_output = 1;
+    jit_size = ELF_HEADERS;
+    nr_jit_patches = 0;
+    elf_runtime();
+
+    //the start: the stacks, the registers of the code and the global initializations
+    while(jit_size % 16)
+	jb(0xCC);
+    int entry = jit_size;
+    elf_op(0, 1, 0xB8 + RSP, 0, RSP); // mov rsp, imm64
+    jb8(E_MACHINE_STACK);
+    elf_imm(R13, E_VALUES);
+    elf_ra(0, 1, 0x89, R13, E_STACK);
+    elf_ra(0, 0, 0xC7, 0, E_CAP); // mov dword [cap], imm32
+    jb4(ASM_STACK_VALUES);
+    elf_imm(RBX, 8 * nr_globals);
+    elf_alu(0x31, R12, R12, 0);
+    elf_alu(0x31, R14, R14, 0);
+    for(int pc = 0; pc < nr_instr; pc++)
+    {
+	if(pc >= first && bytecode[pc].op == O_ENTER)
+	{
+	    jit_flush();
+	    while(jit_size % 16)
+		jb(0xCC);
+	    reg_alloc(pc);
+	}
+	if(bytecode[pc].op == O_HALT)
+	{
+	    jit_flush();
+	    jit_offset[pc] = jit_size;
+	    elf_alu(0x31, RDI, RDI, 0);
+	    elf_jump(CC_JMP, elf_exit);
+	}
+	else
+	    jit_translate(pc);
+    }
+    for(int k = 0; k < nr_jit_patches; k++)
+    {
+	int rel = jit_offset[jit_patches[k].target] - (jit_patches[k].at + 4);
+	memcpy(jit_buffer + jit_patches[k].at, &rel, 4);
+    }
+    for(int k = 0; k < nr_elf_patches; k++)
+    {
+	int rel = elf_labels[elf_patches[k].target] - (elf_patches[k].at + 4);
+	memcpy(jit_buffer + elf_patches[k].at, &rel, 4);
+    }
+
+    //the headers: the code and the zeroed memory are loaded, the stack of the process is not executable
+    Elf64_Ehdr header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.e_ident, ELFMAG, SELFMAG);
+    header.e_ident[EI_CLASS] = ELFCLASS64;
+    header.e_ident[EI_DATA] = ELFDATA2LSB;
+    header.e_ident[EI_VERSION] = EV_CURRENT;
+    header.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+    header.e_type = ET_EXEC;
+    header.e_machine = EM_X86_64;
+    header.e_version = EV_CURRENT;
+    header.e_entry = ELF_TEXT + entry;
+    header.e_phoff = sizeof(Elf64_Ehdr);
+    header.e_ehsize = sizeof(Elf64_Ehdr);
+    header.e_phentsize = sizeof(Elf64_Phdr);
+    header.e_phnum = 3;
+    Elf64_Phdr segments[3];
+    memset(segments, 0, sizeof(segments));
+    segments[0].p_type = PT_LOAD;
+    segments[0].p_flags = PF_R | PF_X;
+    segments[0].p_vaddr = segments[0].p_paddr = ELF_TEXT;
+    segments[0].p_filesz = segments[0].p_memsz = jit_size;
+    segments[0].p_align = 0x1000;
+    segments[1].p_type = PT_LOAD;
+    segments[1].p_flags = PF_R | PF_W;
+    segments[1].p_vaddr = segments[1].p_paddr = ELF_DATA;
+    segments[1].p_memsz = E_END - ELF_DATA;
+    segments[1].p_align = 0x1000;
+    segments[2].p_type = PT_GNU_STACK;
+    segments[2].p_flags = PF_R | PF_W;
+    segments[2].p_align = 16;
+    memcpy(jit_buffer, &header, sizeof(header));
+    memcpy(jit_buffer + sizeof(header), segments, sizeof(segments));
+
+    FILE* f = fopen(elf_name, "wb");
+    int written = f != NULL && fwrite(jit_buffer, 1, jit_size, f) == (size_t)jit_size;
+    if(f != NULL && fclose(f) != 0)
+	written = 0;
+    if(!written || chmod(elf_name, 0755) != 0)
+	perror("ERROR writing the executable\n");
+    else if(STATISTICS)
+	printf("\nThe executable is in %s (%d bytes written in %lf seconds)\n", elf_name, jit_size, seconds() - start);
+    else
+	printf("\nThe executable is in %s\n", elf_name);
+
+    //the machine code of -Jit starts again
+    free(jit_buffer);
+    free(jit_offset);
+    free(jit_targets);
+    jit_buffer = NULL;
+    jit_offset = NULL;
+    jit_targets = NULL;
+    ra_entry = -1;
+    jit_size = jit_cap = 0;
+    nr_jit_patches = 0;
+    elf_output = 0;
+    return written;
+}
+
+/*						*
+ *		   C Output			*
+ *						*/
+
+/* with -EmitC the checked program is written as portable C in file_to_compile.gen.c, which includes
+   the predefined functions from mc_runtime.h written next to it: cc -O2 file_to_compile.gen.c makes a
+   program which behaves as the bytecode. The language evaluates from left to right, so a value which
+   a later call could change is kept in a temporary first; the ints wrap around as in the virtual
+   machine and the locals start with zeros. The depth of the calls is limited by the C stack. */
+const char* c_runtime =
+    "/* the runtime of the C written by MyCompiler -EmitC */\n"
+    "#ifndef MC_RUNTIME_H\n"
+    "#define MC_RUNTIME_H\n"
+    "#define _POSIX_C_SOURCE 199309L\n"
+    "#include <stdio.h>\n"
+    "#include <stdlib.h>\n"
+    "#include <time.h>\n"
+    "\n"
+    "/* the arithmetic of the ints wraps around */\n"
+    "static inline int mc_add(int a, int b) { return (int)((unsigned)a + (unsigned)b); }\n"
+    "static inline int mc_sub(int a, int b) { return (int)((unsigned)a - (unsigned)b); }\n"
+    "static inline int mc_mul(int a, int b) { return (int)((unsigned)a * (unsigned)b); }\n"
+    "static inline int mc_neg(int a) { return (int)(0u - (unsigned)a); }\n"
+    "\n"
+    "static inline void mc_error(int line, const char* message)\n"
+    "{\n"
+    "    fprintf(stderr, \"error in line %d: %s\\n\", line, message);\n"
+    "    exit(-1);\n"
+    "}\n"
+    "\n"
+    "static inline int mc_div(int a, int b, int line)\n"
+    "{\n"
+    "    if(b == 0)\n"
+    "        mc_error(line, \"division by zero\");\n"
+    "    return b == -1 ? mc_neg(a) : a / b;\n"
+    "}\n"
+    "\n"
+    "static inline void mc_put_i(int v) { printf(\"%d\\n\", v); }\n"
+    "static inline void mc_put_d(double v) { printf(\"%lf\\n\", v); }\n"
+    "static inline void mc_put_c(int v) { printf(\"%c\\n\", (char)v); }\n"
+    "static inline int mc_get_i(void) { int v; return scanf(\"%d\", &v) == 1 ? v : 0; }\n"
+    "static inline double mc_get_d(void) { double v; return scanf(\"%lf\", &v) == 1 ? v : 0; }\n"
+    "static inline int mc_get_c(void) { int v = getchar(); return v == EOF ? 0 : v; }\n"
+    "\n"
+    "static inline double mc_seconds(void)\n"
+    "{\n"
+    "    struct timespec now;\n"
+    "    clock_gettime(CLOCK_MONOTONIC, &now);\n"
+    "    return now.tv_sec + now.tv_nsec / 1e9;\n"
+    "}\n"
+    "#endif\n";
+
+FILE* c_file=NULL;
+char* c_name=NULL; // the source file name followed by .gen.c
+int c_indent=0;
+Symbol* c_function=NULL; // the function being written, NULL for the initializations of the globals
+int nr_c_temps=0;
+
+//the names of the arguments and the locals of the function: v_x, or v1_x, v2_x for a name declared again, which no name v_ of the source can be
+Symbol** c_locals=NULL;
+int nr_c_locals=0;
+int cap_c_locals=0;
+int* c_name_uses=NULL; // by the handle of the name: the locals of the function with this name
+
+//a value of the expression being written, where the stack of the virtual machine would have it
+typedef struct CValue{
+    char* text;
+    int type; // of the value or of the variable
+    char* struct_name;
+    int object; // the text is a variable, an element or a field instead of a value
+    int array; // the object is a vector
+    int stable; // no call changes it: the constants, the temporaries, the locals and the addresses made of them
+    int effects; // it has a call, which is done before the values computed after it
+}CValue;
+
+#define C_LONG_TEXT 400
+
+CValue* c_stack=NULL;
+int nr_c_stack=0;
+int cap_c_stack=0;
+
+//the AND/OR with a call in the right operand become an if, with their value in a temporary
+int* c_wanted=NULL;
+int* c_logic=NULL; // at the left operand: the AND/OR
+int* c_logic_temp=NULL; // at the AND/OR: its temporary
+int cap_c_wanted=0;
+
+//a new string made as printf
+char* c_format(const char* fmt, ...)
+{
+    va_list va;
+    va_start(va, fmt);
+    int size = vsnprintf(NULL, 0, fmt, va);
+    va_end(va);
+    char* s = (char*)malloc(size + 1);
+    if(s == NULL)
+	err("not enough memory");
+    va_start(va, fmt);
+    vsnprintf(s, size + 1, fmt, va);
+    va_end(va);
+    return s;
+}
+
+void c_line(const char* fmt, ...)
+{
+    for(int k = 0; k < c_indent; k++)
+	fputs("    ", c_file);
+    va_list va;
+    va_start(va, fmt);
+    vfprintf(c_file, fmt, va);
+    va_end(va);
+    fputc('\n', c_file);
+}
+
+char* c_type(int type, char* struct_name)
+{
+    switch(type)
+    {
+	case _INT: return c_format("int");
+	case _DOUBLE: return c_format("double");
+	case _CHAR: return c_format("signed char");
+	case _STRUCT: return c_format("struct s_%s", struct_name);
+	default: return c_format("void");
+    }
+}
+
+char* c_symbol_name(Symbol* sy)
+{
+    if(sy->cls == FUNCTION)
+	return c_format("f_%s", sy->name);
+    if(is_global(sy))
+	return c_format("g_%s", sy->name);
+    if(sy->c_name != NULL)
+	return c_format("%s", sy->c_name);
+    err("the variable %s has no name in C", sy->name);
+    return NULL;
+}
+
+//an argument or a local gets its name in the function
+void c_local(Symbol* sy)
+{
+    if(nr_c_locals == cap_c_locals)
+    {
+	cap_c_locals = cap_c_locals ? cap_c_locals * 2 : 64;
+	c_locals = (Symbol**)realloc(c_locals, sizeof(Symbol*) * cap_c_locals);
+	if(c_locals == NULL)
+	    err("not enough memory");
+    }
+    if(c_name_uses == NULL) // the names are all interned before the C is written
+    {
+	c_name_uses = (int*)calloc(nr_names, sizeof(int));
+	if(c_name_uses == NULL)
+	    err("not enough memory");
+    }
+    int same = c_name_uses[sy->name_id]++;
+    c_locals[nr_c_locals++] = sy;
+    sy->c_name = same ? c_format("v%d_%s", same, sy->name) : c_format("v_%s", sy->name);
+}
+
+void c_forget_locals()
+{
+    for(int k = 0; k < nr_c_locals; k++)
+    {
+	c_name_uses[c_locals[k]->name_id] = 0;
+	free(c_locals[k]->c_name);
+	c_locals[k]->c_name = NULL;
+    }
+    nr_c_locals = 0;
+}
+
+//the declaration of a variable, an argument or a field with the given name
+char* c_declaration(Symbol* sy, const char* name)
+{
+    char* type = c_type(sy->type, type_struct_name(sy));
+    char* s;
+    if(sy->cls == FUNCTION_ARGUMENT_VECTOR)
+	s = c_format("%s* %s", type, name);
+    else if(sy->cls == VECTOR || sy->cls == STRUCT_FIELD_VECTOR)
+	s = c_format("%s %s[%d]", type, name, symbol_slots(sy) / element_slots(sy));
+    else
+	s = c_format("%s %s", type, name);
+    free(type);
+    return s;
+}
+
+char* c_constant(Token* tk)
+{
+    switch(tk->code)
+    {
+	case CT_REAL:
+	{
+	    char* s = c_format("%.15g", tk->r);
+	    if(strtod(s, NULL) != tk->r)
+	    {
+		free(s);
+		s = c_format("%.17g", tk->r);
+	    }
+	    if(strpbrk(s, ".en") == NULL) // still a double
+	    {
+		char* d = c_format("%s.0", s);
+		free(s);
+		s = d;
+	    }
+	    return s;
+	}
+	case CT_CHAR:
+	    if(isprint((int)tk->i) && tk->i != '\'' && tk->i != '\\')
+		return c_format("'%c'", (int)tk->i);
+	    return c_format("%d", (int)tk->i);
+	case CT_STRING: return c_format("0"); // the strings are not stored
+	default:
+	    if((int)tk->i == -2147483647 - 1)
+		return c_format("(-2147483647 - 1)");
+	    return c_format("%d", (int)tk->i);
+    }
+}
+
+/* the unstable values on the stack from the given one are written to temporaries, in the order in
+   which they were computed; an object is kept by its address */
+void c_keep(int from, int to)
+{
+    for(int k = from; k < to; k++)
+    {
+	CValue* v = &c_stack[k];
+	if(v->stable)
+	    continue;
+	if(!has_value(v->type) && v->type != _STRUCT && !v->object) // the calls without value are done now
+	{
+	    c_line("%s;", v->text);
+	    free(v->text);
+	    v->text = c_format("0");
+	}
+	else
+	{
+	    char* type = c_type(v->type, v->struct_name);
+	    int t = ++nr_c_temps;
+	    if(v->array)
+		c_line("%s* t%d = %s;", type, t, v->text);
+	    else if(v->object)
+		c_line("%s* t%d = &%s;", type, t, v->text);
+	    else
+		c_line("%s t%d = %s;", type, t, v->text);
+	    free(type);
+	    free(v->text);
+	    v->text = v->object && !v->array ? c_format("(*t%d)", t) : c_format("t%d", t);
+	}
+	v->stable = 1;
+	v->effects = 0;
+    }
+}
+
+//a value is added after the calls before it are done, when it may be changed by them
+void c_push(char* text, int type, char* struct_name, int object, int array, int stable, int effects)
+{
+    if(!stable)
+    {
+	for(int k = 0; k < nr_c_stack; k++)
+	    if(c_stack[k].effects)
+		c_keep(k, k + 1);
+    }
+    if(nr_c_stack == cap_c_stack)
+    {
+	cap_c_stack = cap_c_stack ? cap_c_stack * 2 : 64;
+	c_stack = (CValue*)realloc(c_stack, sizeof(CValue) * cap_c_stack);
+	if(c_stack == NULL)
+	    err("not enough memory");
+    }
+    CValue* v = &c_stack[nr_c_stack++];
+    v->text = text;
+    v->type = type;
+    v->struct_name = struct_name;
+    v->object = object;
+    v->array = array;
+    v->stable = stable;
+    v->effects = effects;
+    if(!array && strlen(text) > C_LONG_TEXT) // the long expressions are cut in statements
+    {
+	c_keep(0, nr_c_stack - 1);
+	v->stable = 0;
+	c_keep(nr_c_stack - 1, nr_c_stack);
+    }
+}
+
+CValue c_pop()
+{
+    return c_stack[--nr_c_stack];
+}
+
+int c_has_call(int expr)
+{
+    for(int n = nodes[expr].b; n <= nodes[expr].a; n++)
+	if(nodes[n].kind == N_CALL)
+	    return 1;
+    return 0;
+}
+
+//the call is done after the values before its arguments
+void c_call(int n)
+{
+    Symbol* f = node_symbol(n);
+    int args = nr_c_stack - nodes[n].c;
+    c_keep(0, args);
+    char* list = c_format("");
+    for(int k = args; k < nr_c_stack; k++)
+    {
+	char* s = c_format(k > args ? "%s, %s" : "%s%s", list, c_stack[k].text);
+	free(list);
+	free(c_stack[k].text);
+	list = s;
+    }
+    nr_c_stack = args;
+    char* text;
+    if(f->line >= 0)
+	text = c_format("f_%s(%s)", f->name, list);
+    else
+    {
+	switch(f->name_id)
+	{
+	    case NAME_PUT_I: text = c_format("mc_put_i(%s)", list); break;
+	    case NAME_PUT_D: text = c_format("mc_put_d(%s)", list); break;
+	    case NAME_PUT_C: text = c_format("mc_put_c(%s)", list); break;
+	    case NAME_GET_I: text = c_format("mc_get_i()"); break;
+	    case NAME_GET_D: text = c_format("mc_get_d()"); break;
+	    case NAME_GET_C: text = c_format("mc_get_c()"); break;
+	    case NAME_SECONDS: text = c_format("mc_seconds()"); break;
+	    default: text = c_format("(void)(%s)", nodes[n].c ? list : "0"); break; // put_s and get_s
+	}
+    }
+    free(list);
+    c_push(text, nodes[n].type, f->struct_name, 0, 0, 0, 1);
+}
+
+//the left operand of an AND/OR with a call in its right operand is done: the right one is in an if
+void c_logic_start(int logic, int first)
+{
+    c_keep(0, nr_c_stack);
+    CValue left = c_pop();
+    int t = ++nr_c_temps;
+    c_logic_temp[logic - first] = t;
+    c_line("int t%d = %s != 0;", t, left.text);
+    free(left.text);
+    c_line(node_tk(logic)->code == AND ? "if(t%d)" : "if(!t%d)", t);
+    c_line("{");
+    c_indent++;
+}
+
+void c_logic_end(int logic, int first)
+{
+    int t = c_logic_temp[logic - first];
+    CValue right = c_pop();
+    c_line("t%d = %s != 0;", t, right.text);
+    free(right.text);
+    c_indent--;
+    c_line("}");
+    c_push(c_format("t%d", t), _INT, NULL, 0, 0, 1, 0);
+}
+
+//the C of an operator or a term, its operands are on the stack
+void c_term(int n, int want, int first)
+{
+    Token* tk = node_tk(n);
+    switch(nodes[n].kind)
     {
-	while(tk->code!=SEMICOLON && tk->code != ASSIGN)
+	case N_CONST: c_push(c_constant(tk), nodes[n].type, NULL, 0, 0, 1, 0); break;
+	case N_NAME:
+	{
+	    Symbol* sy = bindings[nodes[n].tk];
+	    char* name = c_symbol_name(sy);
+	    if(sy->cls == VECTOR || sy->cls == FUNCTION_ARGUMENT_VECTOR)
+		c_push(name, sy->type, sy->struct_name, 1, 1, 1, 0);
+	    else if(want == ADDRESS || !has_value(sy->type))
+		c_push(name, sy->type, sy->struct_name, 1, 0, 1, 0);
+	    else
+		c_push(name, sy->type, NULL, 0, 0, !is_global(sy), 0);
+	    break;
+	}
+	case N_INDEX:
+	{
+	    CValue index = c_pop();
+	    CValue vector = c_pop();
+	    Symbol* sy = node_symbol(n);
+	    char* text = c_format("%s[%s]", vector.text, index.text);
+	    int effects = vector.effects || index.effects;
+	    if(want == ADDRESS || !has_value(nodes[n].type))
+		c_push(text, nodes[n].type, type_struct_name(sy), 1, 0, vector.stable && index.stable, effects);
+	    else
+		c_push(text, nodes[n].type, NULL, 0, 0, 0, effects);
+	    free(index.text);
+	    free(vector.text);
+	    break;
+	}
+	case N_FIELD:
 	{
-	    if(tk->code == ID) // int/char/double x
+	    CValue structure = c_pop();
+	    Symbol* sy = bindings[nodes[n].tk];
+	    char* text = c_format("%s.m_%s", structure.text, sy->name);
+	    if(sy->cls == STRUCT_FIELD_VECTOR)
+		c_push(text, sy->type, type_struct_name(sy), 1, 1, structure.stable, structure.effects);
+	    else if(want == ADDRESS || !has_value(sy->type))
+		c_push(text, sy->type, type_struct_name(sy), 1, 0, structure.stable, structure.effects);
+	    else
+		c_push(text, sy->type, NULL, 0, 0, 0, structure.effects);
+	    free(structure.text);
+	    break;
+	}
+	case N_CALL: c_call(n); break;
+	case N_CAST:
+	    if(has_value(nodes[n].type))
 	    {
-		if(tk->next->code == ASSIGN) // int/char/double x =
-		{
-		    if(find_symbol(tk)->type == _INT)
-		    {
-			int value_int = 0;
-			if(tk->next->next->next->code != SEMICOLON && tk->next->next->next->code != COMMA)
-			    value_int = (int) op_code_execute(next_op(tk->next->next->next, _INT),tk->next->next, 0, 0, 0); //int x=a+/-*5
-			else
-			    value_int = (int) get_value_token(tk->next->next, _INT, 1);  //int x=a;
-			correct = op_code_execute(O_STORE_I, tk, 1, value_int, 0); //store the value
-		    }
-			    //same for the rest down here
-		    if(find_symbol(tk)->type == _DOUBLE)
+		CValue v = c_pop();
+		char* type = c_type(nodes[n].type, NULL);
+		c_push(c_format("((%s)%s)", type, v.text), nodes[n].type, NULL, 0, 0, v.stable, v.effects);
+		free(type);
+		free(v.text);
+	    }
+	    break;
+	case N_UNARY:
+	{
+	    CValue v = c_pop();
+	    char* text;
+	    if(tk->code == NOT)
+		text = c_format("(!%s)", v.text);
+	    else if(nodes[n].type == _DOUBLE)
+		text = c_format("(-%s)", v.text);
+	    else if(nodes[n].type == _CHAR) // -c is a char again
+		text = c_format("((signed char)mc_neg(%s))", v.text);
+	    else
+		text = c_format("mc_neg(%s)", v.text);
+	    c_push(text, nodes[n].type, NULL, 0, 0, v.stable, v.effects);
+	    free(v.text);
+	    break;
+	}
+	case N_BINARY:
+	{
+	    if((tk->code == AND || tk->code == OR) && c_logic_temp[n - first])
+	    {
+		c_logic_end(n, first);
+		break;
+	    }
+	    CValue b = c_pop();
+	    CValue a = c_pop();
+	    char* text;
+	    int stable = a.stable && b.stable;
+	    switch(tk->code)
+	    {
+		case AND: text = c_format("(%s && %s)", a.text, b.text); break;
+		case OR: text = c_format("(%s || %s)", a.text, b.text); break;
+		case EQUAL: text = c_format("(%s == %s)", a.text, b.text); break;
+		case NOTEQ: text = c_format("(%s != %s)", a.text, b.text); break;
+		case LESS: text = c_format("(%s < %s)", a.text, b.text); break;
+		case LESSEQ: text = c_format("(%s <= %s)", a.text, b.text); break;
+		case GREATER: text = c_format("(%s > %s)", a.text, b.text); break;
+		case GREATEREQ: text = c_format("(%s >= %s)", a.text, b.text); break;
+		default:
+		    if(nodes[n].type == _DOUBLE)
 		    {
-			double value_float = 0;
-			if(tk->next->next->next->code != SEMICOLON && tk->next->next->next->code != COMMA)
-			    value_float = (double) op_code_execute(next_op(tk->next->next->next, _DOUBLE),tk->next->next, 0, 0, 0);
-			else
-			    value_float = (double) get_value_token(tk->next->next, _DOUBLE, 1);
-			correct = op_code_execute(O_STORE_D, tk, 1, 0, value_float);
+			const char* op = tk->code == ADD ? "+" : tk->code == SUB ? "-" : tk->code == MUL ? "*" : "/";
+			text = c_format("(%s %s %s)", a.text, op, b.text);
 		    }
-		    if(find_symbol(tk)->type == _CHAR)
+		    else if(tk->code == DIV) // its error comes before the calls after it
 		    {
-			char value_char = 0;
-			if(tk->next->next->next->code != SEMICOLON && tk->next->next->next->code != COMMA)
-			    value_char = (char) op_code_execute(next_op(tk->next->next->next, _CHAR),tk->next->next, 0, 0, 0);
-			else
-			    value_char = (char) get_value_token(tk->next->next, _CHAR, 1);
-			correct = op_code_execute(O_STORE_C, tk, 1, value_char, 0);
+			text = c_format("mc_div(%s, %s, %d)", a.text, b.text, tk->line);
+			stable = 0;
 		    }
-		}
-		else //uninitialized variables
+		    else
+			text = c_format("%s(%s, %s)", tk->code == ADD ? "mc_add" : tk->code == SUB ? "mc_sub" : "mc_mul", a.text, b.text);
+		    break;
+	    }
+	    c_push(text, nodes[n].type, NULL, 0, 0, stable, a.effects || b.effects);
+	    free(a.text);
+	    free(b.text);
+	    break;
+	}
+    }
+    if(want == _STRUCT) // a structure passed by value is copied when it is computed
+    {
+	c_stack[nr_c_stack - 1].object = 0;
+	c_stack[nr_c_stack - 1].stable = 0;
+    }
+}
+
+//the C of an expression on the stack, the statements it needs are written before
+void c_expr(int expr, int want)
+{
+    int first = nodes[expr].b;
+    int root = nodes[expr].a;
+    int size = root - first + 1;
+    if(cap_c_wanted < size)
+    {
+	cap_c_wanted = size * 2;
+	c_wanted = (int*)realloc(c_wanted, sizeof(int) * cap_c_wanted);
+	c_logic = (int*)realloc(c_logic, sizeof(int) * cap_c_wanted);
+	c_logic_temp = (int*)realloc(c_logic_temp, sizeof(int) * cap_c_wanted);
+	if(c_wanted == NULL || c_logic == NULL || c_logic_temp == NULL)
+	    err("not enough memory");
+    }
+    for(int n = first; n <= root; n++)
+    {
+	c_wanted[n - first] = KEEP_TYPE;
+	c_logic[n - first] = c_logic_temp[n - first] = 0;
+    }
+    c_wanted[root - first] = want;
+    for(int n = first; n <= root; n++)
+    {
+	switch(nodes[n].kind)
+	{
+	    case N_INDEX: case N_FIELD:
+		c_wanted[nodes[n].a - first] = ADDRESS;
+		break;
+	    case N_BINARY:
+		if(node_tk(n)->code == AND || node_tk(n)->code == OR)
 		{
-		    if(find_symbol(tk)->type == _INT)
-			correct = op_code_execute(O_STORE_I, tk, 0, 0, 0);
-		    if(find_symbol(tk)->type == _DOUBLE)
-			correct = op_code_execute(O_STORE_D, tk, 1, 0, 0);
-		    if(find_symbol(tk)->type == _CHAR)
-			correct = op_code_execute(O_STORE_C, tk, 0, 0, 0);
+		    for(int k = nodes[n].a + 1; k <= nodes[n].b; k++)
+			if(nodes[k].kind == N_CALL)
+			    c_logic[nodes[n].a - first] = n;
 		}
+		break;
+	    case N_CALL:
+	    {
+		Symbol* f = node_symbol(n);
+		int index = 0;
+		for(int arg = nodes[n].a; arg != 0; arg = nodes[arg].next, index++)
+		    if(f->args[index]->cls == FUNCTION_ARGUMENT && f->args[index]->type == _STRUCT)
+			c_wanted[arg - first] = _STRUCT;
+		break;
 	    }
-	    if(!correct)
-		return 0;
-	    NEXT_TK
-	    tk=tk->next;
 	}
     }
+    for(int n = first; n <= root; n++)
+    {
+	c_term(n, c_wanted[n - first], first);
+	if(c_logic[n - first])
+	    c_logic_start(c_logic[n - first], first);
+    }
+}
+
+CValue c_value(int expr, int want)
+{
+    c_expr(expr, want);
+    return c_pop();
+}
+
+void c_nodes(int n);
+
+//the body of an if or of a loop is always a block
+void c_body(int n, int modification)
+{
+    c_line("{");
+    c_indent++;
+    if(nodes[n].kind == N_BLOCK && nodes[n].next == 0)
+	c_nodes(nodes[n].a);
+    else
+	c_nodes(n);
+    c_nodes(modification);
+    c_indent--;
+    c_line("}");
+}
+
+//x = y = value: y receives the value, then x receives y
+void c_assign(int n)
+{
+    int dest = nodes[nodes[n].a].a;
+    Symbol* sy = node_symbol(dest);
+    int value = nodes[n].b;
+    if(nodes[value].kind == N_ASSIGN)
+    {
+	c_assign(value);
+	value = nodes[value].a;
+    }
+    if(nodes[dest].kind == N_NAME && has_value(sy->type) && (sy->cls == VARIABLE || sy->cls == FUNCTION_ARGUMENT))
+    {
+	CValue v = c_value(value, sy->type);
+	char* name = c_symbol_name(sy);
+	c_line("%s = %s;", name, v.text);
+	free(name);
+	free(v.text);
+	return;
+    }
+    c_expr(nodes[n].a, ADDRESS);
+    c_expr(value, nodes[dest].type);
+    CValue v = c_pop();
+    CValue d = c_pop();
+    if(has_value(nodes[dest].type) || pushes_value(nodes[value].a))
+	c_line("%s = %s;", d.text, v.text);
+    else // a structure is not returned, only the call is done
+	c_line("%s;", v.text);
+    free(v.text);
+    free(d.text);
+}
+
+/* the loops with a call in the condition compute it at the start of the body:
+   while(cond) body;  is  for(;;) { the statements of cond; if(!cond) break; body } */
+void c_loop(int cond, int body, int modification)
+{
+    if(cond == 0 || !c_has_call(cond))
+    {
+	CValue v = cond ? c_value(cond, TRUTH) : (CValue){.text = c_format("1")};
+	c_line("while(%s)", v.text);
+	free(v.text);
+	c_body(body, modification);
+	return;
+    }
+    c_line("for(;;)");
+    c_line("{");
+    c_indent++;
+    CValue v = c_value(cond, TRUTH);
+    c_line("if(!%s)", v.text);
+    free(v.text);
+    c_indent++;
+    c_line("break;");
+    c_indent--;
+    c_body(body, modification);
+    c_indent--;
+    c_line("}");
+}
 
-    //modify variables - already in stack but we need to change their value
-    if(tk->code == ID && (find_symbol(tk)->cls == VARIABLE) && !(tk->prev->code==INT || tk->prev->code==CHAR || tk->prev->code==DOUBLE)) // x 
+void c_node(int n)
+{
+    switch(nodes[n].kind)
     {
-	if(tk->next->code == ASSIGN) // x = 
+	case N_VAR:
 	{
-	    // we go based on the type
-	    if(find_symbol(tk)->type == _INT)
+	    Symbol* sy = bindings[nodes[n].tk];
+	    if(sy->cls != VARIABLE || !has_value(sy->type) || (nodes[n].b == 0 && is_global(sy)))
+		break;
+	    char* name = c_symbol_name(sy);
+	    if(nodes[n].b != 0)
 	    {
-		int value_int = 0;
-		if(tk->next->next->next->code != SEMICOLON) // x = f
-		{
-		    if(tk->next->next->code == ID && tk->next->next->next->code == LPAR) // x = f(
-		    {
-			//we assign it a function => update the crtTk
-			while(!consume(RACC))
-				NEXT_TK
-			//load and execute the function
-			op_code_execute(O_LOAD_F,tk->next->next,0, 0, 0);
-			//store the return value
-			value_int = (int) op_code_execute(O_LOAD_I,tk->next->next, 1, 0, 0);
-		    }
-		    else
-			value_int = (int) op_code_execute(next_op(tk->next->next->next, _INT),tk->next->next, 0, 0, 0); // x = 5+-*/g
-		}
-		else
-		    value_int = (int) get_value_token(tk->next->next, _INT, 1); // x = a;
-		//here we update the entry in the stack
-		correct = op_code_execute(O_MODIFY_I, tk, 0, value_int, 0);
+		CValue v = c_value(nodes[n].b, sy->type);
+		c_line("%s = %s;", name, v.text);
+		free(v.text);
 	    }
-		    //analog like we did up here for DOUBLE & CHAR
-	    if(find_symbol(tk)->type == _DOUBLE)
+	    else // the declaration sets it to zero again in a loop
+		c_line("%s = 0;", name);
+	    free(name);
+	    break;
+	}
+	case N_ASSIGN: c_assign(n); break;
+	case N_RETURN:
+	{
+	    int type = c_function->type;
+	    CValue v = {.text = NULL};
+	    if(nodes[n].a != 0)
+		v = c_value(nodes[n].a, has_value(type) ? type : KEEP_TYPE);
+	    if(has_value(type))
+		c_line("return %s;", v.text != NULL ? v.text : "0");
+	    else
 	    {
-		double value_float = 0;
-		if(tk->next->next->next->code != SEMICOLON && tk->next->next->next->code != COMMA)
-		{
-		    if(tk->next->next->code == ID && tk->next->next->next->code == LPAR)
-		    {
-			while(!consume(RACC))
-				NEXT_TK
-			op_code_execute(O_LOAD_F,tk->next->next,0, 0, 0);
-		    	value_float = (double) op_code_execute(O_LOAD_D,tk->next->next, 1, 0, 0);
-		    }
-		    else
-			value_float = (double) op_code_execute(next_op(tk->next->next->next, _DOUBLE),tk->next->next, 0, 0, 0);
-		}
-		else
-		    value_float = (double) get_value_token(tk->next->next, _DOUBLE, 1);
-		correct = op_code_execute(O_MODIFY_D, tk, 0, 0, value_float);
+		if(v.effects)
+		    c_line("%s;", v.text);
+		c_line("return;");
 	    }
-	    if(find_symbol(tk)->type == _CHAR)
+	    free(v.text);
+	    break;
+	}
+	case N_EXPR:
+	{
+	    CValue v = c_value(n, KEEP_TYPE);
+	    c_line(v.effects ? "%s;" : "(void)%s;", v.text);
+	    free(v.text);
+	    break;
+	}
+	case N_BLOCK:
+	    c_line("{");
+	    c_indent++;
+	    c_nodes(nodes[n].a);
+	    c_indent--;
+	    c_line("}");
+	    break;
+	case N_IF:
+	{
+	    CValue v = c_value(nodes[n].a, TRUTH);
+	    c_line("if(%s)", v.text);
+	    free(v.text);
+	    c_body(nodes[n].b, 0);
+	    if(nodes[n].c != 0)
 	    {
-		char value_char = 0;
-		if(tk->next->next->next->code != SEMICOLON && tk->next->next->next->code != COMMA)
-		{
-		    if(tk->next->next->code == ID && tk->next->next->next->code == LPAR)
-		    {
-			while(!consume(RACC))
-				NEXT_TK
-			op_code_execute(O_LOAD_F,tk->next->next,0, 0, 0);
-			value_char = (char) op_code_execute(O_LOAD_C,tk->next->next, 1, 0, 0);
-		    }
-		    else
-		    	value_char = (char) op_code_execute(next_op(tk->next->next->next, _CHAR),tk->next->next, 0, 0, 0);
-		}
-		else
-		    value_char = (char) get_value_token(tk->next->next, _CHAR, 1);
-		correct = op_code_execute(O_MODIFY_C, tk, 0, value_char, 0);
+		c_line("else");
+		c_body(nodes[n].c, 0);
 	    }
-	if(!correct)
-		return 0;
+	    break;
 	}
+	case N_WHILE: c_loop(nodes[n].a, nodes[n].b, 0); break;
+	case N_FOR:
+	    c_nodes(nodes[n].a);
+	    c_loop(nodes[n].b, nodes[n].d, nodes[n].c);
+	    break;
+	case N_BREAK: c_line("break;"); break;
     }
+}
 
-    return correct;
+void c_nodes(int n)
+{
+    for(; n != 0; n = nodes[n].next)
+	c_node(n);
 }
 
-// the main function to generate code
-int Generate_code()
+//the locals are declared at the start of the function with zeros, as in the frame of the virtual machine
+void c_declare_locals(int n)
 {
-    crtTk=root;
-    int correct=1;
-    while(crtTk != NULL)
+    for(; n != 0; n = nodes[n].next)
     {
-	correct = op_code_find(crtTk);
-	NEXT_TK
+	switch(nodes[n].kind)
+	{
+	    case N_VAR:
+	    {
+		Symbol* sy = bindings[nodes[n].tk];
+		c_local(sy);
+		char* declaration = c_declaration(sy, sy->c_name);
+		c_line(sy->cls == VARIABLE && has_value(sy->type) ? "%s = 0;" : "%s = {0};", declaration);
+		free(declaration);
+		break;
+	    }
+	    case N_BLOCK: c_declare_locals(nodes[n].a); break;
+	    case N_IF: c_declare_locals(nodes[n].b); c_declare_locals(nodes[n].c); break;
+	    case N_WHILE: c_declare_locals(nodes[n].b); break;
+	    case N_FOR: c_declare_locals(nodes[n].a); c_declare_locals(nodes[n].d); break;
+	}
     }
-    printf("\n\n");
-    print_stack();
-    return correct;
 }
 
-int main(int argc, char* argv[]) {
+//the header of a function, its arguments get their names
+char* c_prototype(int n)
+{
+    Symbol* f = bindings[nodes[n].tk];
+    c_forget_locals();
+    char* type = c_type(has_value(f->type) ? f->type : _VOID, NULL); // the structures are not returned
+    char* s = c_format("static %s f_%s(", type, f->name);
+    free(type);
+    for(int arg = nodes[n].a; arg != 0; arg = nodes[arg].next)
+    {
+	Symbol* sy = bindings[nodes[arg].tk];
+	c_local(sy);
+	char* declaration = c_declaration(sy, sy->c_name);
+	char* t = c_format("%s%s%s", s, declaration, nodes[arg].next ? ", " : "");
+	free(declaration);
+	free(s);
+	s = t;
+    }
+    char* t = c_format(nodes[n].a ? "%s)" : "%svoid)", s);
+    free(s);
+    return t;
+}
 
-    int help=0;
+void c_func(int n)
+{
+    c_function = bindings[nodes[n].tk];
+    nr_c_temps = 0;
+    char* prototype = c_prototype(n);
+    c_line("%s", prototype);
+    free(prototype);
+    c_line("{");
+    c_indent++;
+    c_declare_locals(nodes[nodes[n].b].a);
+    c_nodes(nodes[nodes[n].b].a);
+    int last = nodes[nodes[n].b].a;
+    while(last != 0 && nodes[last].next != 0)
+	last = nodes[last].next;
+    if(has_value(c_function->type) && (last == 0 || nodes[last].kind != N_RETURN)) // a function without return gives zero
+	c_line("return 0;");
+    c_indent--;
+    c_line("}\n");
+    c_function = NULL;
+}
 
-    if(argc>=3)
+//writes the C of the program and the runtime next to it
+int write_c()
+{
+    const char* slash = strrchr(c_name, '/');
+    char* runtime_name = c_format("%.*smc_runtime.h", slash ? (int)(slash - c_name + 1) : 0, c_name);
+    FILE* runtime = fopen(runtime_name, "w");
+    c_file = fopen(c_name, "w");
+    free(runtime_name);
+    if(runtime == NULL || c_file == NULL || fputs(c_runtime, runtime) < 0 || fclose(runtime) != 0)
     {
-	if(strcmp(argv[2],"-DEBUG")==0)
-	    DEVELOPER_OPTIONS = 1;
-	else
-	if(strcmp(argv[2],"-NoWarnings")==0)
-	    WARNINGS = 0;
-	else
-	if(strcmp(argv[2],"-Code")==0)
-	    GENERATE_CODE = 1;
-	else
-	    help=1;
+	perror("ERROR writing the C files\n");
+	return 0;
+    }
+    fprintf(c_file, "/* %s */\n#include \"mc_runtime.h\"\n\n", c_name);
+    for(int n = program; n != 0; n = nodes[n].next)
+    {
+	if(nodes[n].kind != N_STRUCT)
+	    continue;
+	c_line("struct s_%s", node_tk(n)->text);
+	c_line("{");
+	c_indent++;
+	for(int field = nodes[n].a; field != 0; field = nodes[field].next)
+	{
+	    Symbol* sy = bindings[nodes[field].tk];
+	    char* name = c_format("m_%s", sy->name);
+	    char* declaration = c_declaration(sy, name);
+	    c_line("%s;", declaration);
+	    free(declaration);
+	    free(name);
+	}
+	c_indent--;
+	c_line("};\n");
+    }
+    for(int n = program; n != 0; n = nodes[n].next)
+    {
+	if(nodes[n].kind != N_VAR)
+	    continue;
+	Symbol* sy = bindings[nodes[n].tk];
+	char* name = c_symbol_name(sy);
+	char* declaration = c_declaration(sy, name);
+	c_line("static %s;", declaration);
+	free(declaration);
+	free(name);
+    }
+    fputc('\n', c_file);
+    for(int n = program; n != 0; n = nodes[n].next)
+    {
+	if(nodes[n].kind != N_FUNC)
+	    continue;
+	char* prototype = c_prototype(n);
+	c_line("%s;", prototype);
+	free(prototype);
+    }
+    fputc('\n', c_file);
+    for(int n = program; n != 0; n = nodes[n].next)
+	if(nodes[n].kind == N_FUNC)
+	    c_func(n);
+
+    //the globals are initialized in their order, then main is called
+    c_line("int main(void)");
+    c_line("{");
+    c_indent++;
+    c_forget_locals();
+    nr_c_temps = 0;
+    Symbol* main_function = NULL;
+    for(int n = program; n != 0; n = nodes[n].next)
+    {
+	if(nodes[n].kind == N_VAR)
+	    c_node(n);
+	else if(nodes[n].kind == N_FUNC && node_tk(n)->name_id == NAME_MAIN)
+	    main_function = bindings[nodes[n].tk];
+    }
+    if(main_function != NULL)
+	c_line("f_main();");
+    c_line("return 0;");
+    c_indent--;
+    c_line("}");
+    c_forget_locals();
+    if(fclose(c_file) != 0)
+    {
+	perror("ERROR writing the C file\n");
+	return 0;
     }
+    printf("\nThe C program is in %s\n", c_name);
+    return 1;
+}
 
-    if(argc>=4)
+// the main function to generate code: the program is compiled to bytecode, written as assembly
+// with -S, as an executable with -Elf, as C with -EmitC and executed with -Code
+int Generate_code()
+{
+    //under -O the functions go through the SSA form and its passes first, which remove the
+    //globals never read
+    if(OPTIMIZE)
     {
-	if(strcmp(argv[3],"-DEBUG")==0)
-	    DEVELOPER_OPTIONS = 1;
-	else
-	if(strcmp(argv[3],"-NoWarnings")==0)
-	    WARNINGS = 0;
-	else
-	if(strcmp(argv[3],"-Code")==0)
-	    GENERATE_CODE = 1;
-	else
-	    help=1;
+	//the fields get their slots here, the globals which would give them are placed after the passes
+	for(int n = program; n != 0; n = nodes[n].next)
+	{
+	    if(nodes[n].kind == N_STRUCT)
+		struct_slots(node_tk(n)->text);
+	}
+	for(int n = program; n != 0; n = nodes[n].next)
+	{
+	    if(nodes[n].kind == N_FUNC)
+		ir_lower_func(n);
+	}
+	ir_find_stored_globals();
+	ir_run_pipeline();
+    }
+    //the global variables and the call of main
+    Symbol* main_function = NULL;
+    for(int n = program; n != 0; n = nodes[n].next)
+    {
+	if(nodes[n].kind == N_VAR && !(bindings[nodes[n].tk]->ir_flags & IR_UNUSED))
+	    gen_var(n);
+	else if(nodes[n].kind == N_FUNC && node_tk(n)->name_id == NAME_MAIN)
+	    main_function = bindings[nodes[n].tk];
     }
+    if(main_function != NULL)
+    {
+	emit(O_CALL, nodes[main_function->node].tk, 0);
+	if(has_value(main_function->type))
+	    emit(O_POP, nodes[main_function->node].tk, 1);
+    }
+    emit(O_HALT, program != 0 ? nodes[program].tk : 0, 0); // an empty program has no nodes
 
-    if(argc>=5)
+    int first_function = nr_instr;
+    if(OPTIMIZE)
     {
-	if(strcmp(argv[4],"-DEBUG")==0)
-	    DEVELOPER_OPTIONS = 1;
-	else
-	if(strcmp(argv[4],"-NoWarnings")==0)
-	    WARNINGS = 0;
+	for(int k = 0; k < nr_ir_functions; k++)
+	    ir_generate(&ir_functions[k]);
+	if(STATISTICS)
+	    print_passes();
+	ir_free();
+    }
+    else
+	for(int n = program; n != 0; n = nodes[n].next)
+	{
+	    if(nodes[n].kind == N_FUNC)
+		gen_func(n);
+	}
+    //the calls get the addresses of the functions
+    for(int pc = 0; pc < nr_instr; pc++)
+    {
+	if(bytecode[pc].op == O_CALL)
+	    bytecode[pc].i = bindings[bytecode[pc].tk]->entry;
+    }
+    if(DEVELOPER_OPTIONS)
+	print_bytecode();
+    if(ASSEMBLY && !write_assembly(first_function))
+	return 0;
+    if(ELF_EXECUTABLE && !write_elf(first_function))
+	return 0;
+    if(EMIT_C && !write_c())
+	return 0;
+    if(!GENERATE_CODE)
+	return 1;
+
+    //the trace records the interpreted instructions, so the functions are not compiled with it
+    if((JIT || TIERED) && !TRACE && jit_init())
+    {
+	if(JIT)
+	{
+	    for(int pc = first_function; pc < nr_instr; pc++)
+		if(bytecode[pc].op == O_ENTER)
+		    jit_compile(pc);
+	}
 	else
-	if(strcmp(argv[4],"-Code")==0)
-	    GENERATE_CODE = 1;
+	{
+	    hotness = (int*)calloc(nr_instr, sizeof(int));
+	    if(hotness == NULL)
+		err("not enough memory");
+	}
+    }
+    if(TRACE)
+	trace_open(trace_name);
+    double start = seconds();
+    int correct = op_code_execute();
+    double duration = seconds() - start;
+    trace_close();
+    if(DEVELOPER_OPTIONS)
+    {
+	printf("\n\n");
+	print_globals();
+    }
+    if(STATISTICS)
+    {
+	if(hotness != NULL)
+	    print_tier_events();
+	if(jit_offset != NULL)
+	    printf("\nTranslated %d functions (%d instructions) to %d bytes of x86-64 code in %lf seconds, %d variables in registers\n", jit_functions, jit_instructions, jit_size, jit_seconds, ra_registers);
+	if(jit_offset != NULL) // the instructions of the machine code are not counted
+	    printf("\nExecuted in %lf seconds, %lld instructions interpreted\nCalls: %lld, the deepest %d\n", duration, executed_instr, executed_calls, max_depth_calls);
 	else
+	{
+	    printf("\nExecuted %lld instructions in %lf seconds (%.2lf ns per instruction, " DISPATCH_NAME " dispatch)\n", executed_instr, duration, executed_instr ? duration * 1e9 / executed_instr : 0);
+	    printf("Calls: %lld, the deepest %d", executed_calls, max_depth_calls);
+	    if(executed_calls)
+		printf(" (%.2lf instructions per call)", (double)executed_instr / executed_calls);
+	    printf("\n");
+	}
+    }
+    return correct;
+}
+
+//print the options of the compiler
+void print_options()
+{
+    printf("Options: \n\t'-DEBUG' = used to show more informations about the compiling process\n");
+    printf("\t'-NoWarnings' = used to hide the warnings\n");
+    printf("\t'-Code' = used to generate and execute the code\n");
+    printf("\t'-NoMmap' = used to read the file line by line instead of mapping it in memory\n");
+    printf("\t'-Stats' = used to show the instructions and calls executed and their time\n");
+    printf("\t'-Trace' = used to record every executed instruction in the file_to_compile.trace\n");
+    printf("\t'-DumpTrace' = used to print a .trace file given instead of the file to compile\n");
+    printf("\t'-S' = used to write the x86-64 assembly of the program in file_to_compile.s, with the registers and the stack of values of -Jit instead of the C calling convention\n");
+    printf("\t'-Elf' = used to write a static x86-64 Linux executable of the program in file_to_compile.out\n");
+    printf("\t'-EmitC' = used to write the program as C in file_to_compile.gen.c, with mc_runtime.h\n");
+    printf("\t'-O' = used to compile the functions through the SSA form and its passes\n");
+    printf("\t'-Passes=a,b' = the passes of -O in order (inline,sccp,licm,iv,globaldce,dce,vectorize,cfg), from: verify, inline, sccp, licm, iv, sr, vectorize, globaldce, dce, cfg\n");
+    printf("\t'-InlineSize=N' = the most instructions of a function inlined by -O (20)\n");
+    printf("\t'-DumpIr' = used to print the SSA form after the lowering and after each pass, '-DumpIr=pass' after one of them\n");
+    printf("\t'-Jit' = used to translate the functions to x86-64 machine code before executing them\n");
+    printf("\t'-Tiered' = used to translate only the functions and loops which run often\n");
+    printf("\t'-CallThreshold=N' = the calls after which -Tiered translates a function (1000)\n");
+    printf("\t'-LoopThreshold=N' = the iterations after which -Tiered translates a loop (10000)\n");
+    printf("\t'-NoRegisters' = used to keep every variable of the machine code and the assembly in the memory of its frame\n");
+}
+
+//set the option given in the command line, returns 0 if the option does not exist
+int set_option(char* option)
+{
+    if(strcmp(option,"-DEBUG")==0)
+	DEVELOPER_OPTIONS = 1;
+    else
+    if(strcmp(option,"-NoWarnings")==0)
+	WARNINGS = 0;
+    else
+    if(strcmp(option,"-Code")==0)
+	GENERATE_CODE = 1;
+    else
+    if(strcmp(option,"-NoMmap")==0)
+	MMAP_LEXER = 0;
+    else
+    if(strcmp(option,"-Stats")==0)
+	STATISTICS = 1;
+    else
+    if(strcmp(option,"-Trace")==0)
+	TRACE = 1;
+    else
+    if(strcmp(option,"-DumpTrace")==0)
+	DUMP_TRACE = 1;
+    else
+    if(strcmp(option,"-S")==0)
+	ASSEMBLY = 1;
+    else
+    if(strcmp(option,"-Elf")==0)
+	ELF_EXECUTABLE = 1;
+    else
+    if(strcmp(option,"-EmitC")==0)
+	EMIT_C = 1;
+    else
+    if(strcmp(option,"-O")==0)
+	OPTIMIZE = 1;
+    else
+    if(strncmp(option,"-Passes=",8)==0)
+    {
+	OPTIMIZE = 1;
+	if(!ir_check_pipeline(option + 8))
+	    return 0;
+	ir_pipeline = option + 8;
+    }
+    else
+    if(strncmp(option,"-DumpIr",7)==0 && (option[7] == '\0' || option[7] == '='))
+    {
+	OPTIMIZE = 1;
+	ir_dump = option[7] ? option + 8 : "";
+    }
+    else
+    if(strncmp(option,"-InlineSize=",12)==0)
+	return sscanf(option + 12, "%d", &inline_size) == 1 && inline_size >= 0;
+    else
+    if(strcmp(option,"-Jit")==0)
+	JIT = 1;
+    else
+    if(strcmp(option,"-Tiered")==0)
+	TIERED = 1;
+    else
+    if(strncmp(option,"-CallThreshold=",15)==0)
+	return sscanf(option + 15, "%d", &call_threshold) == 1 && call_threshold > 0;
+    else
+    if(strncmp(option,"-LoopThreshold=",15)==0)
+	return sscanf(option + 15, "%d", &loop_threshold) == 1 && loop_threshold > 0;
+    else
+    if(strcmp(option,"-NoRegisters")==0)
+	REGISTERS = 0;
+    else
+	return 0;
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+
+    int help=0;
+
+    for(int i=2; i<argc; i++)
+    {
+	if(!set_option(argv[i]))
 	    help=1;
     }
 
     char *file;
-    if(argc < 2 || argc > 4)
+    if(argc < 2)
     {
 	printf("Wrong format!\nCorrect format: ./exe file_to_compile -options\n");
-	printf("Options: \n\t'-DEBUG' = used to show more informations about the compiling process\n");
-	printf("\t'-NoWarnings' = used to hide the warnings\n");
+	print_options();
 	return -1;
     }
 
     if(help)
     {
 	printf("I saw you used an option wrong, this could maybe help you? :D\n");
-	printf("Options: \n\t'-DEBUG' = used to show more informations about the compiling process\n");
-	printf("\t'-NoWarnings' = used to hide the warnings\n");
-
+	print_options();
     }
 
     file = argv[1];
-    source = fopen(file, "r");
-    if (source == NULL)
-	perror("ERROR opening the file\n");
+    if(DUMP_TRACE)
+	return dump_trace(file);
+    if(TRACE)
+    {
+	trace_name = (char*)malloc(strlen(file) + 7);
+	if(trace_name == NULL)
+	    err("not enough memory");
+	sprintf(trace_name, "%s.trace", file);
+    }
+    if(ASSEMBLY)
+    {
+	asm_name = (char*)malloc(strlen(file) + 3);
+	if(asm_name == NULL)
+	    err("not enough memory");
+	sprintf(asm_name, "%s.s", file);
+    }
+    if(ELF_EXECUTABLE)
+    {
+	elf_name = (char*)malloc(strlen(file) + 5);
+	if(elf_name == NULL)
+	    err("not enough memory");
+	sprintf(elf_name, "%s.out", file);
+    }
+    if(EMIT_C)
+    {
+	c_name = (char*)malloc(strlen(file) + 7);
+	if(c_name == NULL)
+	    err("not enough memory");
+	sprintf(c_name, "%s.gen.c", file);
+    }
+    if(MMAP_LEXER)
+	src_map = map_source(file);
+    if(src_map == NULL) // not a regular file or empty, we read it line by line
+    {
+	source = fopen(file, "r");
+	if (source == NULL)
+	{
+	    perror("ERROR opening the file\n");
+	    return -1;
+	}
+    }
 
     //LEXICAL ANALYZER
+    init_names();
     getNextToken();
+    close_spans();
     if(DEVELOPER_OPTIONS)
     {
 	printf("\n");
@@ -3707,6 +12921,8 @@ int main(int argc, char* argv[]) {
     if(syntactical_analyzer()==1)
     {
 	printf("\n\n\nSyntax is correct\n\n\n");
+	if(DEVELOPER_OPTIONS)
+	    print_Tree();
     }
     else
     {
@@ -3725,6 +12941,13 @@ int main(int argc, char* argv[]) {
 	return -1;
     }
 
+    //Name Resolution
+    if(resolve_names()!=1)
+    {
+	printf("\nName Resolution Error\n\n\n");
+	return -1;
+    }
+
     //Type Analysis
     if(type_analysis()==1)
     {
@@ -3737,7 +12960,7 @@ int main(int argc, char* argv[]) {
     }
 
     //Code Generation
-    if(GENERATE_CODE)
+    if(GENERATE_CODE || ASSEMBLY || ELF_EXECUTABLE || EMIT_C)
     {
 	if(Generate_code()==1)
 	{
@@ -3752,10 +12975,12 @@ int main(int argc, char* argv[]) {
     else
     {
 	printf("Code not generated due to option not selected\n");
-	printf("If you want code generation on the selected file please use the option '-Code'\n");
+	printf("If you want code generation on the selected file please use the option '-Code', '-S', '-Elf' or '-EmitC'\n");
     }
 
 
-    fclose(source);
+    if(source != NULL)
+	fclose(source);
+    unmap_source();
     return 0;
 }
@@ -0,0 +1,30 @@
+struct Q { int a; double b; };
+struct P { int a; int v[3]; char c; };
+struct P arr[4];
+char str[8];
+int sum(struct P p) { return p.a + p.v[0] + p.v[2] + p.c; }
+double avg(double v[], int n) { int i; double s; s = 0.0; for(i=0;i<n;i=i+1) s = s + v[i]; return s / n; }
+int cnt(char s[]) { int i; i = 0; while(s[i] != 0) i = i + 1; return i; }
+int clamp(int x) { if (x < 0) return 0; if (x > 100) return 100; return x; }
+double dd[5];
+void main()
+{
+    int i; struct P loc;
+    for(i=0;i<4;i=i+1) { arr[i].a = i*10; arr[i].v[0] = i; arr[i].v[2] = 0-i; arr[i].c = 'a' + i; }
+    loc = arr[2];
+    loc.v[1] = 99;
+    put_i(sum(loc));
+    put_i(sum(arr[3]));
+    put_i(arr[2].v[1]);
+    
+    for(i=0;i<5;i=i+1) dd[i] = i * 1.5;
+    put_d(avg(dd, 5));
+    str[0] = 'h'; str[1] = 'i'; str[2] = 0;
+    put_i(cnt(str));
+    put_i(clamp(0-5) + clamp(50) + clamp(500));
+    put_c(arr[1].c);
+    put_i(3.5 > 3);
+    put_i((char)300);
+    put_d(7 / 2);
+    put_d(7 / 2.0);
+}
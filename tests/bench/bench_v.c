@@ -0,0 +1,17 @@
+double x[100000];
+double y[100000];
+double z[100000];
+int main()
+{
+    int i;
+    for(i = 0; i < 100000; i = i + 1) { x[i] = i * 0.001; y[i] = 1.5; }
+    int r;
+    for(r = 0; r < 500; r = r + 1)
+    {
+        for(i = 0; i < 100000; i = i + 1) z[i] = x[i] * y[i];
+        for(i = 0; i < 100000; i = i + 1) z[i] = z[i] + 0.25;
+        for(i = 0; i < 100000; i = i + 1) x[i] = x[i] - 0.0001;
+    }
+    put_d(z[99999]); put_d(x[12345]);
+    return 0;
+}
@@ -0,0 +1,10 @@
+int fib(int n)
+{
+    if(n < 2)
+        return n;
+    return fib(n - 1) + fib(n - 2);
+}
+void main()
+{
+    put_i(fib(32));
+}
@@ -0,0 +1,15 @@
+void main()
+{
+    int i;
+    int s;
+    double d;
+    s = 0;
+    d = 0.0;
+    for(i = 0; i < 20000000; i = i + 1)
+    {
+        s = s + i * 2 - i / 3;
+        d = d + 0.5;
+    }
+    put_i(s);
+    put_d(d);
+}
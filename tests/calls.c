@@ -0,0 +1,35 @@
+struct P { int x; double y; };
+int calls;
+int depth(int n)
+{
+    calls = calls + 1;
+    return n > 0 && depth(n - 1) >= 0;
+}
+int sum(int a, int b, double c)
+{
+    return a + b + (int)c;
+}
+double mid(struct P p, int k)
+{
+    p.x = 100;
+    return p.y * k;
+}
+int first(int v[], int i)
+{
+    return v[i];
+}
+int w[4];
+void main()
+{
+    struct P q;
+    q.x = 1;
+    q.y = 2.5;
+    put_i(depth(5));
+    put_i(calls);
+    put_i(sum(1, 2, 3.9));
+    put_d(mid(q, 4));
+    put_i(q.x);
+    w[2] = 42;
+    put_i(first(w, 2));
+    put_i(depth(200000));
+}
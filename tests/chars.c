@@ -0,0 +1,28 @@
+char gc;
+char f(char a, int b) { return a + b; }
+void main()
+{
+    char c; char d; int i; double x;
+    c = 200; put_i(c);
+    d = c + 100; put_i(d);
+    i = c * 3; put_i(i);
+    c = 'a'; d = c * 4; put_i(d);
+    put_i(f(120, 10));
+    put_i(f('z', 200) / 3);
+    x = c; put_d(x / 7);
+    c = 3.9; put_i(c);
+    c = 0 - 2.5; put_i(c);
+    c = 127; c = c + 1; put_i(c);
+    gc = 250; put_i(gc + 10);
+    d = 0 - 128; put_i(d / (0 - 1));
+    c = 7; d = 0 - 2; put_i(c / d);
+    put_i((char)(c * 100));
+    i = 0 - 2147483647 - 1; put_i(i / 3);
+    put_i(c == 7.0);
+    x = 1e10; put_i(x > 2147483647);
+    put_d(c / 2);
+    put_d(c / 2.0);
+    put_i(!c);
+    put_i(-c);
+    c = -c; put_i(c);
+}
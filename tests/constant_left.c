@@ -0,0 +1,18 @@
+int main()
+{
+    int i;
+    int n;
+    for(i = 0; 10 > i; i = i + 4)
+	put_i(i);
+    put_i(i);
+    i = 0;
+    while(1 < 10 - i)
+	i = i + 1;
+    put_i(i);
+    n = 0;
+    for(i = 20; 3 <= i; i = i - 3)
+	n = n + i;
+    put_i(i);
+    put_i(n);
+    return 0;
+}
@@ -0,0 +1,29 @@
+int g1 = 5;
+int g2 = 7;
+int used = 3;
+int v[10];
+int w[10];
+struct P{ int x; int y; };
+struct P gp;
+int side(int a){ put_i(a); return a; }
+int g3 = side(9);
+int dead(int a){ return a * 2; }
+int deadchain(int a){ return dead(a) + 1; }
+int sq(int a){ return a * a; }
+int main()
+{
+    int k = 0;
+    int loc[5];
+    struct P p;
+    int i = 0;
+    while(i < 10) { v[i] = i; w[i] = i * i; loc[i - (i / 5) * 5] = i; i = i + 1; }
+    p.x = 4; p.y = 5;
+    gp.x = 1;
+    g2 = 9;
+    k = 100 / used;
+    int z = 7 / (used - 3 + 1);
+    put_i(sq(v[3]));
+    put_i(g1);
+    put_i(k);
+    return 0;
+}
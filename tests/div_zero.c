@@ -0,0 +1,7 @@
+int z;
+void main()
+{
+ int i;
+ for(i=0;i<100000;i=i+1) z=z+1;
+ put_i(10/(z-z));
+}
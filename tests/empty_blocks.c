@@ -0,0 +1,31 @@
+int DEBUG = 0;
+int f(int n)
+{
+    int i;
+    int s;
+    s = 0;
+    for(i = 0; i < n; i = i + 1)
+    {
+        if(DEBUG) { n = n; } else { n = n; }
+        if(i > 3) { if(i > 5) { n = n; } else { s = s + 1; } } else { n = n; }
+        while(0) { s = s + 100; }
+    }
+    while(1)
+    {
+        if(s > 2)
+            break;
+        s = s + 1;
+    }
+    return s;
+}
+void main()
+{
+    int k;
+    k = 0;
+    if(DEBUG) put_i(1); else if(DEBUG) put_i(2); else if(DEBUG) put_i(3); else k = 4;
+    if(k > 0) { k = k; } else { k = k; }
+    while(k < 10) { if(k) { k = k; } k = k + 1; }
+    put_i(k);
+    put_i(f(8));
+    put_i(f(0));
+}
@@ -0,0 +1,7 @@
+int v[3];
+int f(int a) { return a; }
+void main()
+{
+ int x;
+ x = v(1) + x(2);
+}
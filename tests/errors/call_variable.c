@@ -0,0 +1,8 @@
+int v[3];
+int f(int a) { return a; }
+void main()
+{
+    int x;
+    x();
+    put_i(f(1));
+}
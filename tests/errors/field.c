@@ -0,0 +1,9 @@
+struct Q { int a; double b; };
+struct P { int x; struct Q q[3]; char c; };
+struct P g;
+struct P h[2];
+int k;
+void main()
+{
+ put_i(g.q[1].a);
+}
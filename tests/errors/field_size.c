@@ -0,0 +1,5 @@
+struct S { int a[0]; };
+void main()
+{
+ put_i(1);
+}
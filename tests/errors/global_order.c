@@ -0,0 +1,8 @@
+int f() { return N; }
+int M = f();
+int N = 1000;
+void main()
+{
+    put_i(M);
+    put_i(N);
+}
@@ -0,0 +1,6 @@
+int x;
+double x;
+void main()
+{
+    put_i(x);
+}
@@ -0,0 +1,5 @@
+int v[0];
+void main()
+{
+ put_i(1);
+}
@@ -0,0 +1,41 @@
+int fib(int n)
+{
+    if(n < 2)
+        return n;
+    return fib(n-1) + fib(n-2);
+}
+struct P { int x; double y; };
+struct P gp;
+int g;
+int v[10];
+double dv[100];
+double da[100];
+double db[100];
+int sq(int a) { return a*a; }
+void main()
+{
+    int i;
+    int s;
+    double d;
+    put_i(fib(20));
+    gp.x = 3;
+    gp.y = 2.5;
+    put_i(gp.x);
+    put_d(gp.y);
+    i = 0;
+    s = 0;
+    while(i < 10) { v[i] = i*i; i = i + 1; }
+    for(i=0; i<10; i=i+1) { s = s + v[i]; if(s > 100) break; }
+    put_i(s);
+    i = 0;
+    while(i < 100) { da[i] = i; db[i] = 2.0*i; i = i + 1; }
+    i = 0;
+    while(i < 100) { dv[i] = da[i] + db[i]; i = i + 1; }
+    d = 0.0;
+    for(i=0;i<100;i=i+1) d = d + dv[i];
+    put_d(d);
+    put_i(sq(7) + 7/2 - 3*4);
+    put_c('A');
+    put_s("hello");
+
+}
@@ -0,0 +1,45 @@
+int N = 1000;
+double SCALE = -2.5;
+int counter;
+int f(int x)
+{
+    int k;
+    int debug;
+    k = 3 * 4 + 2;
+    debug = 0;
+    if(debug)
+        put_i(999);
+    if(k > 10 && 1)
+        x = x + k;
+    else
+        x = x - k;
+    return x * (N / 10);
+}
+void main()
+{
+    int i;
+    int s;
+    double d;
+    char c;
+    s = 0;
+    d = 0.0;
+    c = 'a' + 1;
+    for(i = 0; i < N; i = i + 1)
+    {
+        s = s + (N * 2 + 7) / 3 - i;
+        d = d + SCALE * 2;
+    }
+    put_i(s);
+    put_d(d);
+    put_c(c);
+    put_i(f(2));
+    put_i(7 / 2 + 1);
+    put_d(7 / 2.0);
+    put_i((int)3.9);
+    put_i(0 / 1);
+    counter = 2147483647;
+    put_i(2147483647 + 1);
+    put_i(-(-2147483647 - 1));
+    put_i((char)300);
+    put_i((char)200 + (char)100);
+}
@@ -0,0 +1 @@
+void main() { int k; k = 0; while (k < 14) { put_d(get_d()); k = k + 1; } }
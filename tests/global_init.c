@@ -0,0 +1,8 @@
+int N = 1000;
+int f() { return N; }
+int M = f();
+void main()
+{
+    put_i(M);
+    put_i(N);
+}
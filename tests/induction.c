@@ -0,0 +1,17 @@
+void main()
+{
+    int i; int s;
+    for(i=10;i<5;i=i+1) { s = 0; } put_i(i);
+    for(i=0;i<10;i=i+3) { s = 0; } put_i(i);
+    for(i=0;i<=10;i=i+3) { s = 0; } put_i(i);
+    for(i=0;i>0-5;i=i-2) { s = 0; } put_i(i);
+    for(i=0;i!=9;i=i+3) { s = 0; } put_i(i);
+    for(i=2147483640;i>0;i=i+1) { s = 0; } put_i(i);
+    for(i=5;i>=5;i=i+1) { if (i > 7) break; } put_i(i);
+    for(i=0;i<10;i=i+1) { s = i; } put_i(i);
+    i = 0; while(i < 7) i = i + 2; put_i(i);
+    i = 3; while(i < 3) i = i + 2; put_i(i);
+    for(i=0;1 < 10 - i;i=i+1) { s = 0; } put_i(i);
+    for(i=0;10 > i;i=i+4) { s = 0; } put_i(i);
+    for(i=100;i>=0-3;i=i-7) { s = 0; } put_i(i);
+}
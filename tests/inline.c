@@ -0,0 +1,24 @@
+int v[10];
+int get(int a[], int i){ return a[i]; }
+double half(double x){ return x / 2; }
+int sq(int a){ return a * a; }
+int absv(int a){ if(a < 0) return -a; return a; }
+int sum4(int a, int b, int c, int d){ return sq(a) + sq(b) + sq(c) + sq(d); }
+char up(char c){ if(c >= 'a') return c - 32; return c; }
+void show(int a){ put_i(a); }
+int fact(int n){ if(n < 2) return 1; return n * fact(n - 1); }
+int clamp(int a, int lo, int hi){ while(a > hi) a = a - 1; if(a < lo) return lo; return a; }
+int main()
+{
+    int i = 0;
+    while(i < 10) { v[i] = sq(i) - 20; i = i + 1; }
+    i = 0;
+    while(i < 10) { show(absv(get(v, i))); i = i + 1; }
+    put_d(half(5));
+    put_i(sum4(1, 2, 3, 4));
+    put_c(up('q'));
+    put_i(fact(6));
+    put_i(clamp(50, 0, 40));
+    put_i(clamp(-3, 0, 40));
+    return sq(3);
+}
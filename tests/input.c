@@ -0,0 +1,37 @@
+struct P { int a; double d; char c[3]; };
+struct P g;
+struct P h[2];
+double v[4];
+char s[5];
+double avg(double x, double y) { return (x + y) / 2.0; }
+char up(char c) { return c - 32; }
+int cnt(struct P p) { return p.a + p.c[1]; }
+void main()
+{
+    int i; double d; char c;
+    g.a = 7; g.d = 2.5; g.c[1] = 'b';
+    h[1] = g;
+    put_i(cnt(h[1]));
+    put_d(h[1].d * -3.0);
+    d = 0.0;
+    for(i = 0; i < 4; i = i + 1) { v[i] = i / 2.0; d = d + v[i]; }
+    put_d(d);
+    put_d(avg(d, 1));
+    put_i(d);
+    c = 'a';
+    put_c(up(c));
+    c = c + 200;
+    put_i(c);
+    put_c(c / 2);
+    put_i(!i);
+    put_i(d < 3.0 && d >= 3.0 || d != 3.0);
+    put_i(d == 3.0);
+    put_i(d > 2.9 && d <= 3.0);
+    put_i(-i * 7 / 3);
+    put_i(get_i() + 1);
+    put_d(get_d() * 2);
+    put_c(get_c());
+    s[0] = 'x';
+    while(1) { if(i > 10) break; i = i + 3; }
+    put_i(i);
+}
@@ -0,0 +1,11 @@
+void main()
+{
+    int a; double d; char c; int b;
+    a = get_i();
+    d = get_d();
+    c = get_c();
+    c = get_c();
+    b = get_i();
+    put_i(a); put_d(d); put_c(c); put_i(b);
+    put_d(d * 3.0);
+}
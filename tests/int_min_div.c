@@ -0,0 +1,19 @@
+int q(int a, int b) { return a / b; }
+void main()
+{
+    int i; int m; char c;
+    m = 0 - 1;
+    i = 0 - 2147483647 - 1;
+    put_i(5);
+    put_i(q(i, m));
+    put_i(i / m);
+    put_i(i / (0 - 1));
+    put_i((0 - 2147483647 - 1) / (0 - 1));
+    put_i(7 / m);
+    put_i(i / 2);
+    c = 0 - 128;
+    put_i(c / m);
+    for(m = 0 - 3; m < 0; m = m + 1)
+        put_i(i / m);
+    put_i(6);
+}
@@ -0,0 +1,92 @@
+struct P { int a; double b; char c; };
+struct P g;
+int v[10];
+int calls;
+int bump(int x) { calls = calls + 1; g.a = g.a + x; return x; }
+int sum(struct P p, int k) { return p.a + k; }
+int logic(int a, int b)
+{
+    int r;
+    r = a && b;
+    r = r + (a || bump(b)) * 10;
+    r = r + !(a && !b) * 100;
+    return r;
+}
+double mix(double d, int i, char c)
+{
+    char e;
+    e = -c;
+    if(d > 1.5 && i < 3 || c == 'x')
+        return d * i + e;
+    return -d;
+}
+void loops()
+{
+    int i;
+    int j;
+    int t;
+    t = 0;
+    for(i = 0; i < 10; i = i + 1)
+    {
+        j = 0;
+        while(1)
+        {
+            if(j > i)
+                break;
+            t = t + j;
+            j = j + 1;
+        }
+        v[i] = t;
+        if(t > 100)
+            break;
+    }
+    put_i(t);
+    put_i(i);
+    while(1)
+    {
+        t = t - 7;
+        if(t < 0)
+            break;
+    }
+    put_i(t);
+}
+void swap()
+{
+    int a;
+    int b;
+    int c;
+    int n;
+    a = 1;
+    b = 2;
+    n = 0;
+    while(n < 5)
+    {
+        c = a;
+        a = b;
+        b = c;
+        n = n + 1;
+    }
+    put_i(a * 10 + b);
+}
+void main()
+{
+    struct P q;
+    int i;
+    g.a = 5;
+    q.a = 3;
+    put_i(sum(g, bump(4)));
+    put_i(sum(q, bump(1)) + sum(g, 0));
+    for(i = 0; i < 4; i = i + 1)
+        put_i(logic(i / 2, i - (i / 2) * 2));
+    put_d(mix(2.5, 2, 'a'));
+    put_d(mix(0.5, 7, 'x'));
+    put_d(mix(0.5, 7, 'y'));
+    loops();
+    put_i(v[3] + v[9]);
+    swap();
+    put_i(calls);
+    i = 7;
+    i = i && calls;
+    put_i(i);
+    put_c((char)(65 + calls));
+}
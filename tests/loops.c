@@ -0,0 +1,29 @@
+int v[100];
+int n = 10;
+struct P{ int x; int y; };
+int main()
+{
+    int i = 0;
+    int s = 0;
+    int k = n * 3;
+    struct P p;
+    p.x = 7;
+    while(i < 30) { v[i] = i * 4 + k * 2 + p.x; i = i + 1; }
+    put_i(i);
+    int j = 50;
+    while(j > 3) { s = s + j * k; j = j - 7; }
+    put_i(j); put_i(s);
+    int a = 0; int b = 0;
+    while(a <= 20) { b = 0; while(b < a) { s = s + (a + 1) * (b * 3); b = b + 2; } a = a + 3; }
+    put_i(a); put_i(b); put_i(s);
+    i = 0;
+    while(i < 30) { put_i(v[i]); i = i + 5; }
+    double d = 0;
+    int q = 1;
+    while(q < 1000) { d = d + q * 0.5; q = q * 2; }
+    put_d(d); put_i(q);
+    i = 0;
+    while(i < 10) { if(i == 5) break; i = i + 1; }
+    put_i(i);
+    return 0;
+}
@@ -0,0 +1,8 @@
+int f(int n)
+{
+ return f(n+1);
+}
+void main()
+{
+ put_i(f(0));
+}
@@ -0,0 +1,28 @@
+int a[5];
+struct S { int v[3]; double d; };
+struct S s1;
+struct S s2;
+int f(int x, double y) { if (x > 3) return x; return (int)y + x; }
+double h(int n) { double r; int i; r = 1.0; for(i=0;i<n;i=i+1) r = r*2.0; return r; }
+void main()
+{
+    int i; int j; int k; char c;
+    c = 'z';
+    c = c + 10;
+    put_i(c);
+    put_i(f(2, 3.7));
+    put_i(f(5, 3.7));
+    put_d(h(10));
+    s1.v[1] = 42; s1.d = 1.5;
+    s2 = s1;
+    put_i(s2.v[1]);
+    put_d(s2.d);
+    k = 0;
+    for(i=0;i<10;i=i+1) { for(j=0;j<10;j=j+1) { if (j == 5) break; k = k + i*j; } }
+    put_i(k);
+    put_i(!0 && (1 || 0));
+    put_i(2147483647 + 1);
+    put_d(1.0/3.0);
+    put_i(-7/2);
+    put_i((int)-2.9);
+}
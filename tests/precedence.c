@@ -0,0 +1,21 @@
+void main()
+{
+    int a; int b; double d;
+    put_i(1 - 2 - 3);
+    put_i(100 / 10 / 5);
+    put_i(2 * 3 + 4 * 5);
+    put_i(1 < 2 == 1);
+    put_i(!1 + 1);
+    put_i(-2 * 3 - -4);
+    put_i(1 || 0 && 0);
+    put_i((1 || 0) && 0);
+    put_i(3 > 2 > 1);
+    put_i(1 + 2 * 3 - 4 / 2 * 3);
+    a = b = 3;
+    put_i(a + b);
+    d = (double)7 / 2;
+    put_d(d);
+    put_i(!(2 < 1) * 5);
+    put_i(- - 3);
+    put_i(2 - (3 - (4 - 5)));
+}
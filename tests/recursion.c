@@ -0,0 +1,70 @@
+int ack(int m, int n)
+{
+    if(m == 0)
+        return n + 1;
+    if(n == 0)
+        return ack(m - 1, 1);
+    return ack(m - 1, ack(m, n - 1));
+}
+int find(int v[], int n, int x)
+{
+    int i;
+    for(i = 0; i < n; i = i + 1)
+    {
+        if(v[i] == x)
+            return i;
+    }
+    return -1;
+}
+int primes(int limit)
+{
+    int n;
+    int count;
+    count = 0;
+    for(n = 2; n < limit; n = n + 1)
+    {
+        int d;
+        int prime;
+        prime = 1;
+        d = 2;
+        while(d * d <= n)
+        {
+            if(n / d * d == n)
+            {
+                prime = 0;
+                break;
+            }
+            d = d + 1;
+        }
+        if(prime)
+            count = count + 1;
+        else
+            count = count;
+    }
+    return count;
+}
+int v[10];
+void main()
+{
+    int i;
+    double x;
+    for(i = 0; i < 10; i = i + 1)
+        v[i] = i * 3;
+    put_i(find(v, 10, 21));
+    put_i(find(v, 10, 22));
+    put_i(ack(2, 3));
+    put_i(primes(100));
+    x = 0.0;
+    while(x < 1.0)
+        x = x + 0.25;
+    put_d(x);
+    i = 0;
+    while(1)
+    {
+        i = i + 1;
+        if(i > 5)
+            break;
+    }
+    put_i(i);
+    if(x) put_c('y'); else put_c('n');
+}
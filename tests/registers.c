@@ -0,0 +1,14 @@
+double h(double x) { return x * 2.0; }
+void main()
+{
+    int i; int a; int b; int c; int d; int e; int f; int s; double x; double y; double z;
+    a = 1; b = 2; c = 3; d = 4; e = 5; f = 6; s = 0; x = 0.5; y = 1.5; z = 2.5;
+    for(i=0;i<5;i=i+1) {
+        s = s + get_i() * a + b * c + d * e + f;
+        x = x + get_d() + y * z;
+        a = a + 1; b = b + 2; c = c + 3; d = d + 1; e = e - 1; f = f * 2;
+        y = h(y) + z; z = z + seconds() * 0.0;
+        put_i(s); put_d(x); put_d(y);
+    }
+    put_i(a + b + c + d + e + f);
+}
@@ -0,0 +1,194 @@
+#!/bin/bash
+# The programs of tests/ are run by the interpreter and by every backend, which must print the same:
+#	tests/run.sh		builds MyCompiler.c and compares the outputs
+#	tests/run.sh -bench	times the programs of tests/bench in every backend, with their compilation
+# MC=path uses a compiler already built, the one built with -DSWITCH_DISPATCH is always made from the
+# source, both with CFLAGS (by default -O2 -Wall -Wextra -Werror). A program reads NAME.in when there
+# is one and prints NAME.expect with the interpreter; the programs of tests/errors must be rejected
+# without a crash. The traces of tests/trace, printed by
+# -DumpTrace, must be NAME.expect.
+tests=$(cd "$(dirname "$0")" && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+CC=${CC:-cc}
+# the compiler must build without warnings, which stop the tests
+CFLAGS=${CFLAGS:--O2 -Wall -Wextra -Werror}
+if [ -z "$MC" ]; then
+    MC=$work/mc
+    $CC $CFLAGS -o "$MC" "$tests/../MyCompiler.c" -lm || exit 1
+fi
+# the virtual machine without the computed goto
+MC_SWITCH=$work/mc_switch
+$CC $CFLAGS -DSWITCH_DISPATCH -o "$MC_SWITCH" "$tests/../MyCompiler.c" -lm || exit 1
+
+# the output of the program, without the messages of the compiler and the empty lines
+program_output()
+{
+    grep -v -x -e '' -e 'Syntax is correct' -e 'Domain Analysis & Table of Symbols is correct' \
+	-e 'Type Analysis is correct' -e 'Code Generation is correct & completed' "$1"
+}
+
+# runs $name.c with the mode $1 and the options after it, leaving $work/out, $work/err and $work/status
+run_mode()
+{
+    local mode=$1 prog
+    shift
+    rm -f "$work/$name.c.s" "$work/$name.c.out" "$work/$name.c.gen.c" "$work/prog"
+    case $mode in
+	vm) prog="$MC $name.c -NoWarnings $*" ;;
+	switch) prog="$MC_SWITCH $name.c -NoWarnings $*" ;;
+	asm) "$MC" "$name.c" -NoWarnings -S "$@" > /dev/null 2>&1 && $CC -o prog "$name.c.s" 2> /dev/null && prog=./prog ;;
+	elf) "$MC" "$name.c" -NoWarnings -Elf "$@" > /dev/null 2>&1 && prog="./$name.c.out" ;;
+	c) "$MC" "$name.c" -NoWarnings -EmitC "$@" > /dev/null 2>&1 && $CC -O2 -o prog "$name.c.gen.c" -lm 2> /dev/null && prog=./prog ;;
+    esac
+    if [ -z "$prog" ]; then
+	echo "no program" > "$work/out"
+	: > "$work/err"
+	echo 0 > "$work/status"
+	return
+    fi
+    timeout 60 $prog < "$input" > "$work/raw" 2> "$work/err"
+    echo $? > "$work/status"
+    program_output "$work/raw" > "$work/out"
+}
+
+# the default passes of -O with sr, which turns the products and the quotients by constants into shifts
+sr_pipeline=inline,sccp,licm,iv,sr,globaldce,dce,vectorize,cfg
+modes=(
+    "vm -Code"
+    "vm -Code -NoMmap"
+    "vm -Code -Trace"
+    "vm -Code -O"
+    "switch -Code"
+    "vm -Code -O -InlineSize=0"
+    "vm -Code -O -InlineSize=500"
+    "vm -Code -O -Passes=$sr_pipeline"
+    "vm -Code -Jit"
+    "vm -Code -Jit -O"
+    "vm -Code -Jit -NoRegisters"
+    "vm -Code -Jit -O -Passes=$sr_pipeline"
+    "vm -Code -Tiered -CallThreshold=1 -LoopThreshold=2"
+    "vm -Code -Tiered -O -CallThreshold=3 -LoopThreshold=5"
+    "asm"
+    "asm -O"
+    "elf"
+    "elf -O"
+    "elf -O -Passes=$sr_pipeline"
+    "c"
+    "c -O"
+)
+
+if [ "$1" = -bench ]; then
+    cd "$work"
+    TIMEFORMAT=%R
+    # long functions, of if/else which -O folds and of calls which it inlines: the passes must stay linear in their size
+    {
+	echo 'void main() { int s; s = 0;'
+	for((k = 0; k < 4000; k++)); do echo " if (s > $k) s = s - 1; else s = s + 2;"; done
+	echo ' put_i(s); }'
+    } > "$work/chain.c"
+    {
+	echo 'int sq(int a) { if (a > 100) return a; return a * a; }'
+	echo 'void main() { int s; s = 0;'
+	for((k = 0; k < 6000; k++)); do echo " s = s + sq($((k % 7)));"; done
+	echo ' put_i(s); }'
+    } > "$work/calls.c"
+    # many locals, which -EmitC names in linear time
+    {
+	echo 'void main() {'
+	for((k = 0; k < 30000; k++)); do echo " int a$k;"; done
+	for((k = 0; k < 30000; k++)); do echo " a$k = $k;"; done
+	echo ' put_i(a7); }'
+    } > "$work/locals.c"
+    for f in "$tests"/bench/*.c "$work/chain.c" "$work/calls.c" "$work/locals.c"; do
+	name=$(basename "$f" .c)
+	[ -f "$name.c" ] || cp "$f" "$name.c"
+	input=/dev/null
+	for m in "${modes[@]}"; do
+	    printf '%-10s %-60s' "$name" "$m"
+	    { time run_mode $m; } 2>&1
+	done
+    done
+    exit 0
+fi
+
+# the C of -EmitC has no limit on the depth of the calls but the one of the C stack
+unchecked="nested_calls:c"
+
+# a main which grows the SSA form of -O past its first arrays, with the stores of globals, elements,
+# structures and the structure arguments kept before a later call
+generated=$work/generated
+mkdir "$generated"
+{
+    echo 'struct P { int x; int y; };'
+    echo 'int g; int h; int v[4]; struct P p; struct P q;'
+    echo 'int f(struct P a, int b) { return a.x + b; }'
+    echo 'void main() { int s; s = 0;'
+    for((k = 0; k < 6000; k++)); do echo " g = g + 1; h = h + 2;"; done
+    for((k = 0; k < 2000; k++)); do echo " v[1] = v[1] + 3; q = p; s = s + f(p, f(p, 1)); p.x = p.x + 1;"; done
+    echo ' put_i(g); put_i(h); put_i(v[1]); put_i(s); put_i(q.x); }'
+} > "$generated/long_main.c"
+printf '%s\n' 6000 12000 6000 4000000 1999 > "$generated/long_main.expect"
+
+cd "$work"
+failures=0
+for f in "$tests"/*.c "$generated"/*.c; do
+    name=$(basename "$f" .c)
+    dir=$(dirname "$f")
+    cp "$f" "$name.c"
+    input=/dev/null
+    [ -f "$dir/$name.in" ] && input=$dir/$name.in
+    for m in "${modes[@]}"; do
+	case " $unchecked " in *" $name:${m%% *} "*) continue ;; esac
+	run_mode $m
+	if [ "$m" = "vm -Code" ]; then
+	    if ! cmp -s "$work/out" "$dir/$name.expect"; then
+		echo "FAIL $name ($m): not the output of $name.expect"
+		failures=$((failures + 1))
+	    fi
+	    mv "$work/out" "$work/out.vm"; mv "$work/err" "$work/err.vm"; mv "$work/status" "$work/status.vm"
+	elif ! cmp -s "$work/out" "$work/out.vm" || ! cmp -s "$work/err" "$work/err.vm" || ! cmp -s "$work/status" "$work/status.vm"; then
+	    echo "FAIL $name ($m): exit $(cat "$work/status") instead of $(cat "$work/status.vm")"
+	    diff "$work/out.vm" "$work/out" | head -5
+	    diff "$work/err.vm" "$work/err" | head -5
+	    failures=$((failures + 1))
+	fi
+    done
+done
+
+for f in "$tests"/errors/*.c; do
+    name=$(basename "$f" .c)
+    cp "$f" "$name.c"
+    for options in -Code "-Code -O" "-Code -Jit" -S "-S -O" -Elf "-Elf -O" -EmitC; do
+	timeout 60 "$MC" "$name.c" -NoWarnings $options < /dev/null > /dev/null 2>&1
+	status=$?
+	if [ $status = 0 ] || { [ $status -ge 124 ] && [ $status != 255 ]; }; then
+	    echo "FAIL errors/$name ($options): exit $status"
+	    failures=$((failures + 1))
+	fi
+    done
+done
+
+for f in "$tests"/trace/*.c; do
+    name=$(basename "$f" .c)
+    cp "$f" "$name.c"
+    rm -f "$name.c.trace"
+    timeout 60 "$MC" "$name.c" -NoWarnings -Code -Trace < /dev/null > /dev/null 2>&1
+    "$MC" "$name.c.trace" -DumpTrace > "$work/out" 2>&1
+    if ! cmp -s "$work/out" "$tests/trace/$name.expect"; then
+	echo "FAIL trace/$name: not the trace of $name.expect"
+	diff "$tests/trace/$name.expect" "$work/out" | head -5
+	failures=$((failures + 1))
+    fi
+    # a file which is not a trace is refused
+    if "$MC" "$name.c" -DumpTrace > /dev/null 2>&1; then
+	echo "FAIL trace/$name: -DumpTrace read the source as a trace"
+	failures=$((failures + 1))
+    fi
+done
+
+if [ $failures != 0 ]; then
+    echo "$failures failures"
+    exit 1
+fi
+echo "all the tests passed"
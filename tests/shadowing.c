@@ -0,0 +1,28 @@
+int f(int x, int x_1)
+{
+    int v;
+    v = x * 10 + x_1;
+    if(v > 0)
+    {
+        int x;
+        x = 7;
+        v = v * 10 + x;
+    }
+    return v + x;
+}
+void main()
+{
+    int x;
+    int x_1;
+    x = 1;
+    if(x > 0)
+    {
+        int x;
+        x = 2;
+        put_i(x);
+    }
+    x_1 = 3;
+    put_i(x);
+    put_i(x_1);
+    put_i(f(4, 5));
+}
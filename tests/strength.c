@@ -0,0 +1,55 @@
+// the products and the quotients by constants, which -Passes with sr turns into shifts and multiplications
+int v[17];
+void main()
+{
+    int k; int s; char c;
+    v[0] = 0 - 2147483647 - 1;
+    v[1] = 0 - 2147483647;
+    v[2] = 0 - 1000000007;
+    v[3] = 0 - 100;
+    v[4] = 0 - 7;
+    v[5] = 0 - 3;
+    v[6] = 0 - 2;
+    v[7] = 0 - 1;
+    v[8] = 0;
+    v[9] = 1;
+    v[10] = 2;
+    v[11] = 3;
+    v[12] = 7;
+    v[13] = 100;
+    v[14] = 1000000007;
+    v[15] = 2147483646;
+    v[16] = 2147483647;
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (2); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (3); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (4); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (5); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (6); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (7); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (8); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (10); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (16); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (100); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (641); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (1024); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (1000000007); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (1073741824); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (2147483647); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (0 - 2); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (0 - 3); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (0 - 5); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (0 - 7); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (0 - 8); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (0 - 1024); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (0 - 1000000007); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (0 - 1073741824); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] / (0 - 2147483647); put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] * (2) + (2) * k; put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] * (8) + (8) * k; put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] * (1073741824) + (1073741824) * k; put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] * (0 - 2147483647 - 1) + (0 - 2147483647 - 1) * k; put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] * (0 - 4) + (0 - 4) * k; put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] * (0 - 1073741824) + (0 - 1073741824) * k; put_i(s);
+    s = 0; for(k = 0; k < 17; k = k + 1) s = s * 31 + v[k] * (12) + (12) * k; put_i(s);
+    c = 0 - 100; put_c(c / 4 + 'a'); c = 100; put_c(c / 8 + 'a'); put_c(c * 2 / 8 + 'a');
+}
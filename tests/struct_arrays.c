@@ -0,0 +1,9 @@
+struct S{ int n; double v[3]; int w[3]; };
+struct S s;
+int main()
+{
+    int i = 0;
+    while(i < 3) { s.v[i] = i * 1.25; s.w[i] = i * i; i = i + 1; }
+    put_d(s.v[2]); put_i(s.w[2]);
+    return 0;
+}
@@ -0,0 +1,32 @@
+struct P { int x; double q[3]; char c; };
+struct P g;
+struct P h[2];
+int k;
+double z = 2.5;
+void main()
+{
+    struct P l;
+    int i;
+    i = 2;
+    g.x = 7;
+    g.q[i] = 1.25;
+    g.q[1] = 9;
+    g.c = 'w';
+    h[1] = g;
+    l = h[1];
+    k = l.q[1] + l.x;
+    put_i(k);
+    put_d(l.q[2] + z);
+    put_c(h[1].c);
+    if(1)
+    {
+        int t;
+        t = 4;
+        put_i(t);
+    }
+    if(1)
+    {
+        double u;
+        put_d(u);
+    }
+}
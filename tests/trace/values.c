@@ -0,0 +1,18 @@
+int n;
+char c;
+double d;
+int twice(int a)
+{
+    return a + a;
+}
+void main()
+{
+    int i;
+    c = 'k';
+    d = 1.5;
+    for(i = 0; i < 2; i = i + 1)
+        n = n + twice(i);
+    put_i(n);
+    put_c(c);
+    put_d(d * 2.0);
+}
@@ -0,0 +1,17 @@
+int a[64]; int b[64]; int c[64]; int t[200];
+double x[64];
+void main()
+{
+    int i; int n; int s;
+    i = 0; while(i < 64) { a[i] = 0 - i - 1; b[i] = 3; t[i] = i; i = i + 1; }
+    n = 64;
+    i = 0; while(i < n) { c[i] = a[i] * b[i]; i = i + 1; }
+    s = 0;
+    i = 0; while(i < 64) { s = s + t[c[i] + 192]; x[i] = c[i]; i = i + 1; }
+    put_i(s);
+    put_d(x[5]);
+    put_i(c[7] < 0);
+    i = 0; while(i < n) { c[i] = a[i] + b[i]; i = i + 1; }
+    put_i(t[0 - c[40]]);
+    put_d(x[63] + c[63]);
+}
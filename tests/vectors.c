@@ -0,0 +1,20 @@
+int a[100]; int b[100]; int c[100];
+double x[100]; double y[100]; double z[100];
+void main()
+{
+    int i; int n; int s;
+    i = 0;
+    while(i < 100) { a[i] = i - 50; b[i] = 3*i + 1; x[i] = i * 0.5; y[i] = 2.0 - i; i = i + 1; }
+    n = 99;
+    i = 0;
+    while(i < n) { c[i] = a[i] * b[i]; i = i + 1; }
+    i = 0;
+    while(i < n) { z[i] = x[i] / y[i]; i = i + 1; }
+    i = 0;
+    while(i < n) { a[i] = a[i] - 7; i = i + 1; }
+    s = 0;
+    for(i=0;i<100;i=i+1) { s = s + c[i] + a[i]; put_d(z[i]); }
+    put_i(s);
+    put_i(c[98] / 3);
+    put_i(c[97] < 0);
+}
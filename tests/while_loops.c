@@ -0,0 +1,20 @@
+int a[50]; int b[50];
+int first(int k) { int i; for(i=0;i<50;i=i+1) { if (a[i] == k) return i; } return 0 - 1; }
+int w(int n) { int i; i = 0; while(1) { i = i + 3; if (i > n) break; } return i; }
+int z(int n) { int i; int s; s = 0; i = n; while(i) { s = s + i; i = i - 1; } return s; }
+void main()
+{
+    int i; int j; int s;
+    for(i=0;i<50;i=i+1) { a[i] = 0; }
+    for(i=0;i<50;i=i+1) { a[i] = i * 7; b[i] = 0; }
+    put_i(first(70)); put_i(first(71)); put_i(w(10)); put_i(z(10));
+    s = 0;
+    for(i=0;i<10;i=i+1) for(j=i;j<10;j=j+1) s = s + i * j;
+    put_i(s); put_i(i); put_i(j);
+    i = 0; while(i < 50) { b[i] = a[i] + 1; if (b[i] > 100) break; i = i + 1; }
+    put_i(i); put_i(b[14]); put_i(b[15]);
+    i = 49; while(i >= 0) { b[i] = a[i] - i; i = i - 1; } put_i(i); put_i(b[49]);
+    i = 0; while(i < 50) { b[i] = a[i] * 2; i = i + 2; } put_i(i); put_i(b[48]); put_i(b[49]);
+    i = 5; while(i < 50) { b[i] = b[i - 1] + a[i]; i = i + 1; } put_i(b[49]);
+    i = 0; while(i < 49) { b[i + 1] = b[i] + 1; i = i + 1; } put_i(b[49]);
+}